@@ -15,6 +15,11 @@
 
 namespace MaxOS::common {
 
+	constexpr uint8_t CURSOR_SIZE = 7;  ///< The width and height of the mouse cursor in pixels
+
+	typedef void (*fill_span_t)(uint8_t* destination, uint32_t count, uint32_t colour);             ///< Writes a run of one colour into a row of the framebuffer
+	typedef void (*blit_span_t)(uint8_t* destination, const uint32_t* source, uint32_t count);      ///< Copies a run of pixels (one per uint32_t, already in the context's format) into a row of the framebuffer
+
 	/**
 	 * @class GraphicsContext
 	 * @brief Draws pixels to the screen, and handles drawing lines, rectangles and circles
@@ -32,6 +37,20 @@ namespace MaxOS::common {
 			Colour m_colour_pallet[256];     ///<  The colour pallet for 8 bit color depth @todo make const
 
 			uint64_t* m_framebuffer_address { nullptr }; ///< The address of the framebuffer
+			uint32_t m_pitch { 0 };                      ///< The number of bytes between the start of each row of the framebuffer (0 if it can't be written to directly)
+
+			uint64_t* m_front_buffer { nullptr };        ///< The framebuffer on the screen when drawing into a back buffer in system memory, nullptr if drawing straight to the screen
+			int32_t m_cursor_x { 0 };                    ///< The x coordinate of the centre of the mouse cursor
+			int32_t m_cursor_y { 0 };                    ///< The y coordinate of the centre of the mouse cursor
+			bool m_cursor_visible { false };             ///< Should the cursor be drawn when the back buffer is presented
+
+			fill_span_t m_fill_span { nullptr };         ///< Fills a row at the current color depth, nullptr if the framebuffer isn't linear
+			blit_span_t m_blit_span { nullptr };         ///< Copies a row at the current color depth, nullptr if the framebuffer isn't linear
+
+			void select_span_functions();
+			uint8_t* row_address(int32_t y, int32_t& row_step);
+			bool clip(int32_t& x, int32_t& y, int32_t& width, int32_t& height) const;
+			void present_row(uint8_t* destination, const uint8_t* source, int32_t x, int32_t y, int32_t width);
 
 			virtual void render_pixel(uint32_t x, uint32_t y, uint32_t colour);
 			virtual void render_pixel_8_bit(uint32_t x, uint32_t y, uint8_t colour);
@@ -79,6 +98,20 @@ namespace MaxOS::common {
 			void fill_circle(uint32_t x0, uint32_t y0, uint32_t radius, const Colour& colour);
 			void fill_circle(uint32_t x0, uint32_t y0, uint32_t radius, uint32_t colour);
 
+			void fill_span(int32_t x, int32_t y, int32_t length, const Colour& colour);
+			void fill_span(int32_t x, int32_t y, int32_t length, uint32_t colour);
+
+			void fill_rect(int32_t x, int32_t y, int32_t width, int32_t height, const Colour& colour);
+			void fill_rect(int32_t x, int32_t y, int32_t width, int32_t height, uint32_t colour);
+
+			void blit(int32_t x, int32_t y, const uint32_t* pixels, int32_t width, int32_t height, int32_t stride);
+			void copy_rect(int32_t source_x, int32_t source_y, int32_t width, int32_t height, int32_t destination_x, int32_t destination_y);
+
+			bool enable_back_buffer();
+			[[nodiscard]] bool has_back_buffer() const;
+			void present(int32_t x, int32_t y, int32_t width, int32_t height);
+			void move_cursor(int32_t x, int32_t y);
+
 	};
 
 }
@@ -0,0 +1,506 @@
+/**
+ * @file hashmap.h
+ * @brief Defines a HashMap class for storing key-value pairs with constant time lookup
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+ */
+
+#ifndef MAXOS_COMMON_HASHMAP_H
+#define MAXOS_COMMON_HASHMAP_H
+
+#include <cstdint>
+#include <cstddef>
+#include <common/pair.h>
+#include <common/string.h>
+
+
+namespace MaxOS::common {
+
+	/**
+	 * @brief Mixes the bits of a 64 bit value so that nearby keys spread across the table (splitmix64 finaliser)
+	 *
+	 * @param value The value to mix
+	 * @return The mixed value
+	 */
+	inline uint64_t hash_mix(uint64_t value) {
+
+		value ^= value >> 30;
+		value *= 0xBF58476D1CE4E5B9;
+		value ^= value >> 27;
+		value *= 0x94D049BB133111EB;
+		value ^= value >> 31;
+		return value;
+	}
+
+	/**
+	 * @brief Hashes a block of bytes (FNV-1a)
+	 *
+	 * @param data The bytes to hash
+	 * @param length How many bytes to hash
+	 * @return The hash of the bytes
+	 */
+	inline uint64_t hash_bytes(const void* data, size_t length) {
+
+		auto bytes = (const uint8_t*) data;
+		uint64_t hash = 0xCBF29CE484222325;
+		for(size_t i = 0; i < length; ++i) {
+			hash ^= bytes[i];
+			hash *= 0x100000001B3;
+		}
+
+		return hash;
+	}
+
+	/**
+	 * @class Hasher
+	 * @brief Produces the hash of a key. Works for any integral, enum or pointer key, specialise for other types
+	 *
+	 * @tparam Key The key type
+	 */
+	template<class Key> struct Hasher {
+
+		/**
+		 * @brief Hash the key
+		 *
+		 * @param key The key to hash
+		 * @return The hash of the key
+		 */
+		static uint64_t hash(Key const& key) { return hash_mix((uint64_t) key); }
+	};
+
+	/**
+	 * @class Hasher<String>
+	 * @brief Hashes the characters of a string
+	 */
+	template<> struct Hasher<String> {
+
+		/**
+		 * @brief Hash the string
+		 *
+		 * @param key The string to hash
+		 * @return The hash of the characters in the string
+		 */
+		static uint64_t hash(String const& key) { return hash_bytes(key.c_str(), ::strlen(key.c_str())); }
+	};
+
+	/// The smallest number of slots a HashMap will allocate
+	constexpr uint32_t HASHMAP_MIN_CAPACITY = 8;
+
+	/**
+	 * @class HashMap
+	 * @brief A map of key-value pairs stored in an open addressed (linear probing) table for O(1) lookup
+	 *
+	 * @tparam Key The key type, must be comparable with == and hashable by Hasher
+	 * @tparam Value The value type
+	 */
+	template<class Key, class Value> class HashMap {
+
+		private:
+
+			/**
+			 * @enum SlotState
+			 * @brief The state of a slot in the table
+			 */
+			enum class SlotState : uint8_t {
+				EMPTY,
+				USED,
+				DELETED,
+			};
+
+			Pair<Key, Value>* m_slots = nullptr;
+			SlotState* m_states = nullptr;
+			uint32_t m_capacity = 0;
+			uint32_t m_size = 0;
+			uint32_t m_deleted = 0;
+
+			[[nodiscard]] uint32_t slot_of(Key const& key) const;
+			void rehash(uint32_t capacity);
+
+		public:
+
+			/**
+			 * @class iterator
+			 * @brief Iterates over the used slots in the table
+			 */
+			class iterator {
+
+				friend class HashMap;
+
+				private:
+					const HashMap* m_map;
+					uint32_t m_index;
+
+					/**
+					 * @brief Move the iterator forward until it is on a used slot or the end
+					 */
+					void skip() { while(m_index < m_map->m_capacity && m_map->m_states[m_index] != SlotState::USED) m_index++; }
+
+				public:
+
+					/**
+					 * @brief Create an iterator at a slot in a map, moved forward to the next used slot
+					 *
+					 * @param map The map being iterated
+					 * @param index The slot to start at
+					 */
+					iterator(const HashMap* map, uint32_t index) : m_map(map), m_index(index) { skip(); }
+
+					Pair<Key, Value>& operator *() const { return m_map->m_slots[m_index]; }           ///< Access the pair @return The pair
+					Pair<Key, Value>* operator ->() const { return &m_map->m_slots[m_index]; }         ///< Access the pair @return The pair
+					iterator& operator ++() { m_index++; skip(); return *this; }                      ///< Move to the next pair @return This iterator
+					bool operator ==(iterator const& other) const { return m_index == other.m_index; } ///< Compare the position @return True if same
+					bool operator !=(iterator const& other) const { return m_index != other.m_index; } ///< Compare the position @return True if different
+			};
+
+			HashMap();
+			HashMap(const HashMap& other);
+			~HashMap();
+
+			HashMap& operator =(const HashMap& other);
+			Value& operator [](Key const& key);
+
+			[[nodiscard]] bool empty() const;
+			[[nodiscard]] uint32_t size() const;
+
+			iterator begin() const;
+			iterator end() const;
+			iterator find(Key const& key) const;
+			[[nodiscard]] bool contains(Key const& key) const;
+
+			void insert(Key const& key, Value const& value);
+			bool erase(Key const& key);
+			void erase(iterator position);
+			void clear();
+
+			void reserve(uint32_t amount);
+	};
+
+	/// ______________ TEMPLATE IMPLEMENTATION ______________
+	template<class Key, class Value> HashMap<Key, Value>::HashMap() = default;
+
+	/**
+	 * @brief Copy constructor for HashMap, re-inserts every pair from the other map
+	 *
+	 * @tparam Key The key type
+	 * @tparam Value The value type
+	 * @param other The map to copy from
+	 */
+	template<class Key, class Value> HashMap<Key, Value>::HashMap(const HashMap& other) {
+		*this = other;
+	}
+
+	/**
+	 * @brief Destructor for HashMap, frees the table
+	 *
+	 * @tparam Key The key type
+	 * @tparam Value The value type
+	 */
+	template<class Key, class Value> HashMap<Key, Value>::~HashMap() {
+
+		delete[] m_slots;
+		delete[] m_states;
+	}
+
+	/**
+	 * @brief Assignment by copy, the table is rebuilt from the other map's pairs
+	 *
+	 * @tparam Key The key type
+	 * @tparam Value The value type
+	 * @param other The map to copy from
+	 * @return This map
+	 */
+	template<class Key, class Value> HashMap<Key, Value>& HashMap<Key, Value>::operator =(const HashMap& other) {
+
+		// Setting to itself?
+		if(this == &other)
+			return *this;
+
+		clear();
+		reserve(other.m_size);
+		for(auto& pair : other)
+			insert(pair.first, pair.second);
+
+		return *this;
+	}
+
+	/**
+	 * @brief Gets the value stored for a key, inserting a default value if it is not present
+	 *
+	 * @tparam Key The key type
+	 * @tparam Value The value type
+	 * @param key The key to search for
+	 * @return The value of the key
+	 */
+	template<class Key, class Value> Value& HashMap<Key, Value>::operator [](Key const& key) {
+
+		auto it = find(key);
+		if(it == end()) {
+			insert(key, Value());
+			it = find(key);
+		}
+
+		return it->second;
+	}
+
+	/**
+	 * @brief Returns whether the map is empty
+	 *
+	 * @tparam Key The key type
+	 * @tparam Value The value type
+	 * @return Whether the map is empty
+	 */
+	template<class Key, class Value> bool HashMap<Key, Value>::empty() const {
+		return m_size == 0;
+	}
+
+	/**
+	 * @brief The number of pairs stored in the map
+	 *
+	 * @tparam Key The key type
+	 * @tparam Value The value type
+	 * @return The number of pairs
+	 */
+	template<class Key, class Value> uint32_t HashMap<Key, Value>::size() const {
+		return m_size;
+	}
+
+	/**
+	 * @brief Returns an iterator at the first pair in the map
+	 *
+	 * @tparam Key The key type
+	 * @tparam Value The value type
+	 * @return The first pair
+	 */
+	template<class Key, class Value> typename HashMap<Key, Value>::iterator HashMap<Key, Value>::begin() const {
+		return iterator(this, 0);
+	}
+
+	/**
+	 * @brief Returns an iterator past the last slot in the map
+	 *
+	 * @tparam Key The key type
+	 * @tparam Value The value type
+	 * @return The end of the map
+	 */
+	template<class Key, class Value> typename HashMap<Key, Value>::iterator HashMap<Key, Value>::end() const {
+		return iterator(this, m_capacity);
+	}
+
+	/**
+	 * @brief Finds the slot a key is stored in
+	 *
+	 * @tparam Key The key type
+	 * @tparam Value The value type
+	 * @param key The key to search for
+	 * @return The index of the slot or m_capacity if the key is not in the map
+	 */
+	template<class Key, class Value> uint32_t HashMap<Key, Value>::slot_of(Key const& key) const {
+
+		// Nothing stored
+		if(m_size == 0)
+			return m_capacity;
+
+		// Probe until an empty slot ends the chain
+		uint32_t mask = m_capacity - 1;
+		uint32_t index = (uint32_t) Hasher<Key>::hash(key) & mask;
+		for(uint32_t probes = 0; probes < m_capacity; ++probes) {
+
+			if(m_states[index] == SlotState::EMPTY)
+				break;
+
+			if(m_states[index] == SlotState::USED && m_slots[index].first == key)
+				return index;
+
+			index = (index + 1) & mask;
+		}
+
+		return m_capacity;
+	}
+
+	/**
+	 * @brief Finds a pair in the map based on the key
+	 *
+	 * @tparam Key The key type
+	 * @tparam Value The value type
+	 * @param key The key to search for
+	 * @return The iterator of the pair, or the end iterator if not found
+	 */
+	template<class Key, class Value> typename HashMap<Key, Value>::iterator HashMap<Key, Value>::find(Key const& key) const {
+		return iterator(this, slot_of(key));
+	}
+
+	/**
+	 * @brief Checks if a key is stored in the map
+	 *
+	 * @tparam Key The key type
+	 * @tparam Value The value type
+	 * @param key The key to search for
+	 * @return True if the key is present
+	 */
+	template<class Key, class Value> bool HashMap<Key, Value>::contains(Key const& key) const {
+		return slot_of(key) != m_capacity;
+	}
+
+	/**
+	 * @brief Updates the value of a pair, or adds a new pair if the key does not exist
+	 *
+	 * @tparam Key The key type
+	 * @tparam Value The value type
+	 * @param key The key of the pair
+	 * @param value The value of the pair
+	 */
+	template<class Key, class Value> void HashMap<Key, Value>::insert(Key const& key, Value const& value) {
+
+		// Already stored, update it
+		uint32_t existing = slot_of(key);
+		if(existing != m_capacity) {
+			m_slots[existing].second = value;
+			return;
+		}
+
+		// Keep the load (including deleted slots) under 3/4 so probe chains stay short
+		if((m_size + m_deleted + 1) * 4 > m_capacity * 3) {
+
+			// Only grow if the live pairs fill over half the table, otherwise clearing the deleted markers is enough
+			uint32_t capacity = m_capacity < HASHMAP_MIN_CAPACITY ? HASHMAP_MIN_CAPACITY : m_capacity;
+			if((m_size + 1) * 2 > capacity)
+				capacity *= 2;
+
+			rehash(capacity);
+		}
+
+		// Find the first free slot in the chain
+		uint32_t mask = m_capacity - 1;
+		uint32_t index = (uint32_t) Hasher<Key>::hash(key) & mask;
+		while (m_states[index] == SlotState::USED)
+			index = (index + 1) & mask;
+
+		// Store it
+		if(m_states[index] == SlotState::DELETED)
+			m_deleted--;
+
+		m_slots[index].first = key;
+		m_slots[index].second = value;
+		m_states[index] = SlotState::USED;
+		m_size++;
+	}
+
+	/**
+	 * @brief Removes a pair from the map
+	 *
+	 * @tparam Key The key type
+	 * @tparam Value The value type
+	 * @param key The key of the pair to remove
+	 * @return True if a pair was removed
+	 */
+	template<class Key, class Value> bool HashMap<Key, Value>::erase(Key const& key) {
+
+		uint32_t index = slot_of(key);
+		if(index == m_capacity)
+			return false;
+
+		erase(iterator(this, index));
+		return true;
+	}
+
+	/**
+	 * @brief Removes the pair at the specified position
+	 *
+	 * @tparam Key The key type
+	 * @tparam Value The value type
+	 * @param position The iterator of the pair to remove
+	 */
+	template<class Key, class Value> void HashMap<Key, Value>::erase(iterator position) {
+
+		if(position.m_index >= m_capacity)
+			return;
+
+		// Leave a marker so that probe chains passing through this slot are not broken
+		m_slots[position.m_index] = Pair<Key, Value>();
+		m_states[position.m_index] = SlotState::DELETED;
+		m_size--;
+		m_deleted++;
+	}
+
+	/**
+	 * @brief Removes all pairs from the map, keeping the allocated table
+	 *
+	 * @tparam Key The key type
+	 * @tparam Value The value type
+	 */
+	template<class Key, class Value> void HashMap<Key, Value>::clear() {
+
+		for(uint32_t i = 0; i < m_capacity; ++i) {
+			if(m_states[i] == SlotState::USED)
+				m_slots[i] = Pair<Key, Value>();
+			m_states[i] = SlotState::EMPTY;
+		}
+
+		m_size = 0;
+		m_deleted = 0;
+	}
+
+	/**
+	 * @brief Reserves space so that an amount of pairs can be stored without rehashing
+	 *
+	 * @tparam Key The key type
+	 * @tparam Value The value type
+	 * @param amount The amount of pairs to reserve space for
+	 */
+	template<class Key, class Value> void HashMap<Key, Value>::reserve(uint32_t amount) {
+
+		// Grow until the amount fits under the load factor
+		uint32_t capacity = m_capacity < HASHMAP_MIN_CAPACITY ? HASHMAP_MIN_CAPACITY : m_capacity;
+		while (amount * 4 > capacity * 3)
+			capacity *= 2;
+
+		if(capacity != m_capacity)
+			rehash(capacity);
+	}
+
+	/**
+	 * @brief Moves every pair into a new table of a given size, dropping deleted markers
+	 *
+	 * @tparam Key The key type
+	 * @tparam Value The value type
+	 * @param capacity The new number of slots, must be a power of two
+	 */
+	template<class Key, class Value> void HashMap<Key, Value>::rehash(uint32_t capacity) {
+
+		// Swap in the new table
+		Pair<Key, Value>* old_slots = m_slots;
+		SlotState* old_states = m_states;
+		uint32_t old_capacity = m_capacity;
+
+		m_slots = new Pair<Key, Value>[capacity];
+		m_states = new SlotState[capacity];
+		m_capacity = capacity;
+		m_size = 0;
+		m_deleted = 0;
+		for(uint32_t i = 0; i < capacity; ++i)
+			m_states[i] = SlotState::EMPTY;
+
+		// Re-insert the used slots
+		uint32_t mask = m_capacity - 1;
+		for(uint32_t i = 0; i < old_capacity; ++i) {
+
+			if(old_states[i] != SlotState::USED)
+				continue;
+
+			uint32_t index = (uint32_t) Hasher<Key>::hash(old_slots[i].first) & mask;
+			while (m_states[index] == SlotState::USED)
+				index = (index + 1) & mask;
+
+			m_slots[index] = old_slots[i];
+			m_states[index] = SlotState::USED;
+			m_size++;
+		}
+
+		delete[] old_slots;
+		delete[] old_states;
+	}
+}
+
+
+#endif //MAXOS_COMMON_HASHMAP_H
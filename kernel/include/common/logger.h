@@ -37,9 +37,44 @@ namespace MaxOS {
 	constexpr LogLevel MAX_LOG_LEVEL = LogLevel::DEBUG;     ///< The maximum log level for this build (messages above this level will not be logged)
 #endif
 
+	constexpr uint32_t LOG_RING_SIZE = 16384;               ///< How many characters each core can have waiting to be written out
+	constexpr uint8_t MAX_LOG_RINGS = 16;                   ///< How many cores get a log ring, cores after this write straight to the log writers
+	constexpr uint32_t LOG_DRAIN_INTERVAL = 10;             ///< How many milliseconds the drain thread sleeps for once everything is written out
+	constexpr uint32_t LOG_DRAIN_CHUNK = 256;               ///< How many characters are taken from a ring at a time when draining
+
+	/**
+	 * @class LogRing
+	 * @brief The characters logged by one core that are waiting to be written out. Only that core appends and only the drain
+	 * reads, so neither side needs a lock.
+	 *
+	 * @details Positions only ever increase and are wrapped when indexing. Only whole lines are readable (unless the ring is
+	 * full) so the output of different cores doesn't interleave mid line. When the ring is full new characters are dropped
+	 * and counted, keeping what was logged before (e.g. leading up to a panic).
+	 */
+	class LogRing {
+
+		private:
+			char m_buffer[LOG_RING_SIZE];
+			uint64_t m_head = 0;                ///< How many characters have been appended
+			uint64_t m_line_end = 0;            ///< Where the last line that can be read ends
+			uint64_t m_tail = 0;                ///< How many characters have been read
+			uint64_t m_dropped = 0;             ///< How many characters didn't fit (only changed by the producer)
+			uint64_t m_dropped_reported = 0;    ///< How many of the dropped characters have been reported (only changed by the reader)
+
+		public:
+			bool append(char c);
+			size_t read(char* buffer, size_t size);
+			uint64_t take_dropped();
+	};
+
+
 	/**
 	 * @class Logger
 	 * @brief A class that handles logging messages to the console and files.
+	 *
+	 * @details Once buffering has started each core appends what it logs to its own LogRing and a kernel thread writes the
+	 * rings out to the log writers, so logging never waits on a slow writer (e.g. the serial port). Before then, and once
+	 * the kernel panics, characters are written straight to the log writers.
 	 */
 	class Logger : public MaxOS::common::OutputStream {
 		private:
@@ -51,12 +86,24 @@ namespace MaxOS {
 
 			// Progress bar
 			static inline uint8_t s_progress_total = 100;
-			uint8_t m_progress_current = 0;
+			static inline uint8_t s_progress_current = 0;
+			static inline uint8_t s_progress_drawn = 0xFF;
 
 			static inline Logger* s_active_logger = nullptr;
 
 			LogLevel m_log_level = LogLevel::INFO;
 
+			// Buffering
+			static inline LogRing s_rings[MAX_LOG_RINGS];
+			static inline bool s_buffering = false;
+			static inline common::Spinlock s_drain_lock;
+			LogRing* m_ring = nullptr;          ///< The ring of the core this logger was returned to (by ERROR() etc), nullptr to find it per character
+
+			static LogRing* executing_ring();
+			static Logger entry(LogLevel log_level);
+			static void drain_worker(uint64_t argc, Logger** argv);
+			void write_to_writers(char c);
+
 		public:
 			Logger();
 			~Logger();
@@ -66,6 +113,10 @@ namespace MaxOS {
 
 			void set_log_level(LogLevel log_level);
 
+			void start_buffering();
+			void stop_buffering();
+			void flush();
+
 			void write_char(char c) final;
 			void printf(const char* format, ...);
 
@@ -129,7 +129,7 @@ namespace MaxOS::common {
 		                                                                                               other.height;
 
 		// Return the intersection
-		return Rectangle<Type>(i_left, i_top, right - left, bottom - top);
+		return Rectangle<Type>(i_left, i_top, right - i_left, bottom - i_top);
 	}
 
 	/**
@@ -0,0 +1,67 @@
+/**
+ * @file region.h
+ * @brief Defines a Region class for storing an area made of many rectangles and combining areas together
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+ */
+
+#ifndef MAXOS_COMMON_REGION_H
+#define MAXOS_COMMON_REGION_H
+
+#include <cstdint>
+#include <common/rectangle.h>
+#include <common/vector.h>
+
+namespace MaxOS::common {
+
+	/**
+	 * @class Region
+	 * @brief An area of the screen stored as a list of non-overlapping rectangles, split into y-x bands
+	 *
+	 * @details Each band is a run of rectangles sharing the same top and height, sorted left to right without touching.
+	 * Bands are sorted top to bottom and never overlap, and a band is merged into the one above when their rectangles line
+	 * up. This means any area has only one representation and two regions can be combined in a single pass over both.
+	 */
+	class Region {
+
+		private:
+			/// How two regions are combined
+			enum class Operation {
+				UNION,
+				SUBTRACT,
+				INTERSECT,
+			};
+
+			Vector<Rectangle<int32_t>> m_rectangles;        ///< The bands of the region
+			Rectangle<int32_t> m_extents;                   ///< The smallest rectangle that contains the whole region
+
+			void combine(const Region& other, Operation operation);
+			void update_extents();
+
+		public:
+			Region();
+			explicit Region(const Rectangle<int32_t>& rectangle);
+			~Region();
+
+			[[nodiscard]] bool empty() const;
+			[[nodiscard]] const Vector<Rectangle<int32_t>>& rectangles() const;
+			[[nodiscard]] Rectangle<int32_t> extents() const;
+			[[nodiscard]] uint64_t area() const;
+			[[nodiscard]] bool contains(int32_t x, int32_t y) const;
+
+			void clear();
+
+			void unite(const Region& other);
+			void unite(const Rectangle<int32_t>& rectangle);
+			void subtract(const Region& other);
+			void subtract(const Rectangle<int32_t>& rectangle);
+			void intersect(const Region& other);
+			void intersect(const Rectangle<int32_t>& rectangle);
+
+			void include(const Rectangle<int32_t>& damage, uint32_t slack, uint32_t max_rectangles);
+	};
+
+}
+
+#endif //MAXOS_COMMON_REGION_H
@@ -1,6 +1,6 @@
 /**
  * @file spinlock.h
- * @brief Defines Spinlock and BlockingLock classes for thread synchronization
+ * @brief Defines Spinlock, BlockingLock and ReadWriteLock classes for thread synchronization
  *
  * @date 24th February 2025
  * @author Max Tyson
@@ -10,18 +10,52 @@
 #define MAXOS_COMMON_SPINLOCK_H
 
 #include <common/vector.h>
+#include <common/pair.h>
 
 
 namespace MaxOS::common {
 
+	/**
+	 * @class LockStatistics
+	 * @brief Contention counters for a single lock, all instances are linked so that hot locks can be listed
+	 */
+	class LockStatistics {
+
+		private:
+			inline static LockStatistics* s_first = nullptr;
+
+		public:
+			explicit LockStatistics(const char* name);
+			~LockStatistics();
+
+			const char* name;                   ///< The name to report the lock as
+			uint64_t acquisitions = 0;          ///< How many times the lock has been taken
+			uint64_t contended = 0;             ///< How many of those acquisitions had to wait
+			uint64_t spins = 0;                 ///< How many times a waiter paused while spinning
+			uint64_t wait_cycles = 0;           ///< How many TSC cycles were spent waiting for the lock
+			LockStatistics* next = nullptr;     ///< The next lock being tracked
+
+			void record(uint64_t spin_count, uint64_t cycles);
+
+			static void print_all();
+	};
+
+	/// How many pauses a waiter does per thread ahead of it in the queue before checking the ticket again
+	constexpr uint32_t SPINLOCK_BACKOFF_PAUSES = 32;
+
 	/**
 	 * @class Spinlock
 	 * @brief Enables a resource to be used by only one instance at a time through locking and unlocking
+	 *
+	 * @note Ticket based, so waiters are served in the order they arrived and only read the shared line while waiting
 	 */
 	class Spinlock {
 
 		private:
-			bool m_locked = false;
+			uint32_t m_next_ticket = 0;
+			uint32_t m_now_serving = 0;
+
+			LockStatistics* m_statistics = nullptr;
 
 		public:
 			Spinlock();
@@ -32,9 +66,42 @@ namespace MaxOS::common {
 			[[nodiscard]] bool is_locked() const;
 
 			void acquire();
+			bool try_acquire();
 			void release();
+
+			uint64_t acquire_irqsave();
+			void release_irqrestore(uint64_t flags);
+
+			void enable_statistics(const char* name);
+			[[nodiscard]] LockStatistics* statistics() const;
 	};
 
+	/**
+	 * @class WaitQueue
+	 * @brief A queue of threads sleeping until they are woken by another thread. Guarded by a Spinlock owned by the user of the queue
+	 */
+	class WaitQueue {
+
+		private:
+			Vector<Pair<uint64_t, uint64_t>> m_waiters;
+
+			void drop_exited();
+			bool remove(uint64_t tid);
+
+		public:
+			WaitQueue();
+			~WaitQueue();
+
+			void wait(Spinlock& guard, uint64_t tag = 0);
+			bool wait_for(Spinlock& guard, size_t milliseconds, uint64_t tag = 0);
+			void enqueue_current(uint64_t tag = 0);
+
+			[[nodiscard]] bool empty();
+			[[nodiscard]] uint64_t peek_tag();
+			[[nodiscard]] size_t count(uint64_t tag);
+			uint64_t wake_one();
+			size_t wake(size_t count);
+	};
 
 	/// How many attempts to acquire the lock should fail before queueing
 	constexpr uint8_t BLOCKING_FAST_TRY_LIMIT = UINT8_MAX;
@@ -50,7 +117,10 @@ namespace MaxOS::common {
 
 		private:
 			bool m_locked = false;
-			Vector<uint64_t> m_queue;
+			Spinlock m_queue_lock;
+			WaitQueue m_queue;
+
+			LockStatistics* m_statistics = nullptr;
 
 			static bool must_spin();
 
@@ -65,8 +135,45 @@ namespace MaxOS::common {
 			void acquire();
 			void release();
 
+			void enable_statistics(const char* name);
+			[[nodiscard]] LockStatistics* statistics() const;
 	};
 
+	/**
+	 * @class ReadWriteLock
+	 * @brief Allows many readers or a single writer to hold the lock at once, waiters sleep on the same queue as a BlockingLock
+	 *
+	 * @note Writers are preferred: once a writer is waiting new readers queue behind it so that writers can't be starved
+	 */
+	class ReadWriteLock {
+
+		private:
+			Spinlock m_state_lock;
+			WaitQueue m_queue;
+
+			uint32_t m_readers = 0;
+			bool m_writer = false;
+
+			LockStatistics* m_statistics = nullptr;
+
+			void wake_waiters();
+
+		public:
+			ReadWriteLock();
+			~ReadWriteLock();
+
+			void read_lock();
+			void read_unlock();
+
+			void write_lock();
+			void write_unlock();
+
+			[[nodiscard]] bool is_locked() const;
+			[[nodiscard]] bool is_write_locked() const;
+
+			void enable_statistics(const char* name);
+			[[nodiscard]] LockStatistics* statistics() const;
+	};
 
 }
 
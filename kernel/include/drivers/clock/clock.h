@@ -156,6 +156,7 @@ namespace MaxOS::drivers::clock {
 
 			void activate() override;
 			void delay(uint32_t milliseconds) const;
+			[[nodiscard]] uint64_t uptime() const;
 
 			void calibrate(uint64_t ms_per_tick = 1);
 			void setup_apic_clock(hardwarecommunication::LocalAPIC* local_apic) const;
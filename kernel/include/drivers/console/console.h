@@ -50,6 +50,8 @@ namespace MaxOS::drivers::console {
 
 			virtual void invert_colors(uint16_t x, uint16_t y);
 
+			virtual void flush();
+
 	};
 
 	/**
@@ -82,6 +84,8 @@ namespace MaxOS::drivers::console {
 			char get_character(uint16_t x, uint16_t y) override;
 			common::ConsoleColour get_foreground_color(uint16_t x, uint16_t y) override;
 			common::ConsoleColour get_background_color(uint16_t x, uint16_t y) override;
+
+			void flush() override;
 	};
 
 	/**
@@ -10,16 +10,44 @@
 #define MAXOS_SERIAL_H
 
 #include <hardwarecommunication/port.h>
+#include <hardwarecommunication/interrupts.h>
 #include <drivers/driver.h>
 #include <common/logger.h>
+#include <common/spinlock.h>
 
 
 namespace MaxOS::drivers {
 
+	constexpr uint32_t SERIAL_TRANSMIT_BUFFER_SIZE = 8192;     ///< How many characters can be waiting to be sent (must be a power of 2)
+	constexpr uint32_t SERIAL_RECEIVE_BUFFER_SIZE = 256;       ///< How many received characters can be waiting to be read (must be a power of 2)
+	constexpr uint8_t SERIAL_FIFO_SIZE = 16;                   ///< How many characters the 16550 can hold to send
+
+	class SerialConsole;
+
+	/**
+	 * @class SerialInterruptHandler
+	 * @brief Passes the COM1 interrupt to the serial console, which is set up before there are interrupts to handle
+	 */
+	class SerialInterruptHandler : public hardwarecommunication::InterruptHandler {
+
+		private:
+			SerialConsole* m_console;
+
+		public:
+			explicit SerialInterruptHandler(SerialConsole* console);
+			~SerialInterruptHandler();
+
+			void handle_interrupt() final;
+	};
 
 	/**
 	 * @class SerialConsole
 	 * @brief A driver for the serial output
+	 *
+	 * @details Once activated, written characters are queued and the port's interrupt refills the transmit FIFO whenever it
+	 * empties, so writers don't wait on the port. When the queue is full new characters are dropped and counted. Received
+	 * characters are queued until they are read. Before activation and once the kernel panics each character is written by
+	 * waiting for the port.
 	 */
 	class SerialConsole : public Driver, public common::OutputStream {
 
@@ -30,13 +58,45 @@ namespace MaxOS::drivers {
 			hardwarecommunication::Port8Bit m_line_control_port;
 			hardwarecommunication::Port8Bit m_modem_control_port;
 			hardwarecommunication::Port8Bit m_line_status_port;
+			hardwarecommunication::Port8Bit m_modem_status_port;
+
+			bool m_present = false;
+			SerialInterruptHandler* m_interrupt_handler = nullptr;
+			inline static SerialConsole* s_active_console = nullptr;
+
+			// There is only one port so the buffers don't take space on the boot stack
+			common::Spinlock m_lock;
+			inline static char s_transmit_buffer[SERIAL_TRANSMIT_BUFFER_SIZE] = { };
+			uint32_t m_transmit_head = 0;
+			uint32_t m_transmit_tail = 0;
+			bool m_transmitting = false;
+			uint64_t m_dropped = 0;
+
+			inline static char s_receive_buffer[SERIAL_RECEIVE_BUFFER_SIZE] = { };
+			uint32_t m_receive_head = 0;
+			uint32_t m_receive_tail = 0;
+
+			void fill_fifo();
+			void receive();
+			void write_queued();
 
 		public:
 			explicit SerialConsole(Logger* logger);
 			~SerialConsole();
 
+			void activate() final;
+			void handle_interrupt();
+
 			void put_character(char c);
 			void write_char(char c) final;
+			[[nodiscard]] uint64_t dropped() const;
+			size_t read(char* buffer, size_t size);
+			[[nodiscard]] uint32_t queued() const;
+
+			static SerialConsole* active_console();
+
+			string vendor_name() final;
+			string device_name() final;
 
 	};
 
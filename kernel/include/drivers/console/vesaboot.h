@@ -11,6 +11,7 @@
 
 #include <cstdint>
 #include <gui/font.h>
+#include <gui/surface.h>
 #include <drivers/driver.h>
 #include <drivers/console/console.h>
 #include <common/logo.h>
@@ -26,12 +27,22 @@ namespace MaxOS::drivers::console {
 	/**
 	 * @class VESABootConsole
 	 * @brief Driver for the VESA Console during boot, handles the printing of characters and strings to the screen using VESA protocol
+	 *
+	 * @details The text is kept in a grid in memory. The log area on the left is drawn into a back buffer whose lines are used as
+	 * a ring, so scrolling moves where the top line is instead of moving pixels, and the changed lines are copied to the screen
+	 * in one go when the console is flushed (at the end of every line written to the stream).
 	 */
 	class VESABootConsole : public Driver, public Console {
 
 		private:
 			uint16_t* m_video_memory_meta;
 			inline static common::GraphicsContext* s_graphics_context = nullptr;
+			inline static gui::Surface* s_back_buffer = nullptr;
+
+			uint16_t m_buffered_width = 0;      ///< How many columns from the left are drawn to the back buffer
+			uint16_t m_ring_top = 0;            ///< The line of the back buffer that is at the top of the screen
+			uint16_t m_dirty_top = 0;           ///< The first line that has changed since the last flush
+			uint16_t m_dirty_bottom = 0;        ///< The line after the last line that has changed since the last flush
 			ConsoleArea* m_console_area;
 			gui::Font m_font;
 
@@ -41,6 +52,10 @@ namespace MaxOS::drivers::console {
 			common::ConsoleColour m_foreground_color = common::ConsoleColour::Uninitialised;
 			common::ConsoleColour m_background_color = common::ConsoleColour::Uninitialised;
 
+			void render_character(uint16_t x, uint16_t y, char c, uint32_t foreground, uint32_t background);
+			void render_fill(uint16_t left, uint16_t top, uint16_t width, uint16_t height, uint32_t background);
+			void invalidate_lines(uint16_t top, uint16_t bottom);
+
 		public:
 			explicit VESABootConsole(common::GraphicsContext*);
 			~VESABootConsole();
@@ -56,6 +71,9 @@ namespace MaxOS::drivers::console {
 			void set_background_color(uint16_t x, uint16_t y, common::ConsoleColour) final;
 
 			void scroll_up(uint16_t left, uint16_t top, uint16_t width, uint16_t height, common::ConsoleColour foreground, common::ConsoleColour background, char fill) final;
+			void clear() final;
+			void clear(uint16_t left, uint16_t top, uint16_t width, uint16_t height, common::ConsoleColour foreground, common::ConsoleColour background, char fill) final;
+			void flush() final;
 
 			char get_character(uint16_t x, uint16_t y) final;
 			common::ConsoleColour get_foreground_color(uint16_t x, uint16_t y) final;
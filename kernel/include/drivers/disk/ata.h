@@ -11,6 +11,7 @@
 
 #include <common/buffer.h>
 #include <common/outputStream.h>
+#include <common/spinlock.h>
 #include <hardwarecommunication/port.h>
 #include <drivers/disk/disk.h>
 #include <cstdint>
@@ -18,9 +19,13 @@
 
 namespace MaxOS::drivers::disk {
 
+	constexpr uint16_t ATA_MAX_SECTORS_PER_COMMAND = 256;     ///< How many sectors a single read command can transfer
+
 	/**
 	 * @class AdvancedTechnologyAttachment
 	 * @brief Driver for the ATA controller, handles the reading and writing of data to the hard drive
+	 *
+	 * @note The master and slave on a channel share its ports so every command holds the channel's lock until it is done
 	 */
 	class AdvancedTechnologyAttachment : public Disk {
 
@@ -37,12 +42,17 @@ namespace MaxOS::drivers::disk {
 			bool m_is_master;
 			uint16_t m_bytes_per_sector { 512 };
 
+			common::BlockingLock* m_channel_lock;
+
+			void send_flush();
+
 		public:
-			AdvancedTechnologyAttachment(uint16_t port_base, bool master);
+			AdvancedTechnologyAttachment(uint16_t port_base, bool master, common::BlockingLock* channel_lock);
 			virtual ~AdvancedTechnologyAttachment();
 
 			bool identify();
 			void read(uint32_t sector, common::buffer_t* data_buffer, size_t amount) final;
+			void read_sectors(uint32_t sector, uint32_t count, common::buffer_t* data_buffer) final;
 			void write(uint32_t sector, common::buffer_t* data, size_t count) final;
 			void flush() final;
 
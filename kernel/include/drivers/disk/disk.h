@@ -29,6 +29,7 @@ namespace MaxOS::drivers::disk {
 
 			void read(uint32_t sector, common::buffer_t* data_buffer);
 			virtual void read(uint32_t sector, common::buffer_t* data_buffer, size_t amount);
+			virtual void read_sectors(uint32_t sector, uint32_t count, common::buffer_t* data_buffer);
 
 			void write(uint32_t sector, common::buffer_t* data);
 			virtual void write(uint32_t sector, common::buffer_t* data, size_t count);
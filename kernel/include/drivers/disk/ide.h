@@ -26,6 +26,9 @@ namespace MaxOS::drivers::disk {
 		private:
 			common::Map<AdvancedTechnologyAttachment*, bool> devices;
 
+			common::BlockingLock m_primary_lock;
+			common::BlockingLock m_secondary_lock;
+
 		public:
 			explicit IntegratedDriveElectronicsController(hardwarecommunication::PCIDeviceDescriptor* device_descriptor);
 			~IntegratedDriveElectronicsController();
@@ -18,6 +18,9 @@
 
 namespace MaxOS::drivers::ethernet {
 
+	/// The largest ring the device supports (the length is stored as a 4 bit power of two)
+	constexpr uint32_t AMD_AM79C973_MAX_RING_SIZE = 512;
+
 	/**
 	 * @struct InitializationBlock
 	 * @brief The initialization block for the AMD AM79C973 Ethernet Controller
@@ -29,9 +32,9 @@ namespace MaxOS::drivers::ethernet {
 
 		uint16_t mode;                      ///< The operation mode
 		unsigned reserved1 : 4;                ///< Unused, must be zero
-		unsigned num_send_buffers : 4;            ///< How many buffers are used for sending
+		unsigned num_recv_buffers : 4;            ///< How many buffers are used for receiving (log2)
 		unsigned reserved2 : 4;                ///< Unused, must be zero
-		unsigned num_recv_buffers : 4;            ///< How many buffers are used for receiving
+		unsigned num_send_buffers : 4;            ///< How many buffers are used for sending (log2)
 		uint64_t physical_address : 48;        ///< The physical (MAC) address of the device (Not 64 bits but will be treated like it is)
 		uint16_t reserved3;                 ///< Unused, must be zero
 		uint64_t logical_address;            ///< The logical address filter for the device to use when deciding whether to accept a packet (0 = no filtering)
@@ -50,10 +53,10 @@ namespace MaxOS::drivers::ethernet {
 	 */
 	typedef struct PACKED BufferDescriptor {
 
-		uint64_t address;   ///< Physical address of the buffer
+		uint32_t address;   ///< Physical address of the buffer
 		uint32_t flags;     ///< Flags for the buffer
 		uint32_t flags2;    ///< Additional flags for the buffer (@todo enum this)
-		uint32_t avail;     ///< Indicates whether the buffer is available to be used
+		uint32_t avail;     ///< Reserved for the driver, unused
 
 	}
 			buffer_descriptor_t;
@@ -79,27 +82,33 @@ namespace MaxOS::drivers::ethernet {
 			hardwarecommunication::Port16Bit reset_port;
 
 			//The main purpose of the initialization block it to hold a pointer to the array of BufferDescriptors, which hold the pointers to the buffers
-			initialisation_block_t init_block { };
-
+			initialisation_block_t* init_block;                   //Read by the device by physical address so lives with the rings
 
+			uint32_t send_ring_size;                              //How many send descriptors there are
 			buffer_descriptor_t* send_buffer_descr;               //Descriptor entry
-			uint8_t send_buffers[2 * 1024 + 15][8] { };       //8 Send Buffers, 2KB + 15 bytes
-			uint8_t current_send_buffer;               //Which buffers are active
+			net::PacketBuffer** send_packets;                     //The packet each send descriptor points at, released once it has been sent
+			uint32_t current_send_buffer;                         //Which buffers are active
+			uint32_t reclaim_send_buffer;                         //The oldest send descriptor that hasn't been reclaimed
+			uint32_t sends_in_flight;                             //How many send descriptors are waiting to be reclaimed
+			common::Spinlock send_lock;                           //Guards the send ring
 
+			uint32_t recv_ring_size;                              //How many receive descriptors there are
 			buffer_descriptor_t* recv_buffer_descr;               //Descriptor entry
-			uint8_t recv_buffers[2 * 1024 + 15][8] { };       //8 Send Buffers, 2KB + 15 bytes
-			uint8_t current_recv_buffer;               //Which buffers are active
+			uint8_t* recv_buffers;                                //The buffers the device receives into (one per descriptor)
+			uint32_t current_recv_buffer;                         //Which buffers are active
+
+			void reclaim_sent();                                  //Release the packets the device has finished sending
 
 			//Ethernet Driver functions
 			MediaAccessControlAddress own_mac;                //MAC address of the device
 			volatile bool active;                            //Is the device active
 			volatile bool init_done;                          //Is the device initialised
 
-			void fetch_data_received();                        //Fetches the data from the buffer
+			uint32_t fetch_data_received(uint32_t budget);     //Fetches the data from the buffer
 			void fetch_data_sent();                            //Fetches the data from the buffer
 
 		public:
-			explicit AMD_AM79C973(hardwarecommunication::PCIDeviceDescriptor* dev);
+			explicit AMD_AM79C973(hardwarecommunication::PCIDeviceDescriptor* dev, uint32_t receive_ring_size = ETHERNET_DEFAULT_RING_SIZE, uint32_t send_ring_size = ETHERNET_DEFAULT_RING_SIZE);
 			~AMD_AM79C973();
 
 			// Override driver default methods
@@ -114,8 +123,12 @@ namespace MaxOS::drivers::ethernet {
 			//Override Interrupt default methods
 			void handle_interrupt() final;
 
+			//Polling
+			uint32_t poll(uint32_t budget) final;
+			void set_receive_interrupts(bool enabled) final;
+
 			//Ethernet Driver functions
-			void do_send(uint8_t* buffer, uint32_t size) final;
+			void do_send(net::PacketBuffer* packet) final;
 			uint64_t get_media_access_control_address() final;
 	};
 
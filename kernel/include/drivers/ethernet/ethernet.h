@@ -13,6 +13,8 @@
 #include <drivers/driver.h>
 #include <common/vector.h>
 #include <common/eventHandler.h>
+#include <common/spinlock.h>
+#include <net/packetbuffer.h>
 
 
 namespace MaxOS::drivers::ethernet {
@@ -56,13 +58,12 @@ namespace MaxOS::drivers::ethernet {
 
 	/**
 	 * @class DataReceivedEvent
-	 * @brief Event that is triggered when data is received, holds the buffer and size of the data
+	 * @brief Event that is triggered when data is received, holds the packet that was received
 	 */
 	class DataReceivedEvent : public common::Event<EthernetDriverEvents> {
 		public:
-			uint8_t* buffer;     ///< @deprecated WRS
-			uint32_t size;       ///< @deprecated WRS
-			DataReceivedEvent(uint8_t* buffer, uint32_t size);
+			net::PacketBuffer* packet;     ///< The received packet, owned by the driver until the handler returns
+			explicit DataReceivedEvent(net::PacketBuffer* packet);
 			~DataReceivedEvent();
 	};
 
@@ -79,26 +80,86 @@ namespace MaxOS::drivers::ethernet {
 
 			virtual void before_send(uint8_t* buffer, uint32_t size);
 			virtual void data_sent(uint8_t* buffer, uint32_t size);
-			virtual bool data_received(uint8_t* buffer, uint32_t size);
+			virtual bool data_received(net::PacketBuffer* packet);
 	};
 
+	/// How many frames the poll worker handles in one pass before checking for more
+	constexpr uint32_t ETHERNET_POLL_BUDGET = 64;
+
+	constexpr uint32_t ETHERNET_DEFAULT_RING_SIZE = 256;        ///< How many descriptors a ring has unless the driver is told otherwise
+	constexpr uint32_t ETHERNET_MIN_RING_SIZE = 8;              ///< The smallest ring a driver will create
+	constexpr uint32_t ETHERNET_MAX_RING_SIZE = 4096;           ///< The largest ring a driver will create
+	constexpr uint32_t ETHERNET_RING_BUFFER_SIZE = 2048;        ///< The size of each receive buffer in a ring (fits a full frame)
+	constexpr uint32_t ETHERNET_SEND_RECLAIM_BATCH = 32;        ///< How many sent descriptors build up before they are reclaimed together
+	constexpr uint32_t ETHERNET_MAX_FRAME_SIZE = 1518;          ///< The largest frame a device will put on the wire
+
+	/**
+	 * @struct EthernetStatistics
+	 * @brief Counters for the frames passing through a driver's rings, used to size the rings for the traffic they see
+	 *
+	 * @typedef ethernet_statistics_t
+	 * @brief Alias for EthernetStatistics struct
+	 */
+	typedef struct EthernetStatistics {
+
+		uint64_t received;                  ///< Frames passed up to the handlers
+		uint64_t receive_dropped;           ///< Frames the device received that were thrown away (errors or no packet buffer free)
+		uint64_t receive_overruns;          ///< Frames the device missed because the receive ring was full
+
+		uint64_t sent;                      ///< Frames handed to the device
+		uint64_t send_dropped;              ///< Frames thrown away because the send ring was full or the device isn't active
+		uint64_t send_reclaimed;            ///< Send descriptors given back once the device finished with them
+		uint64_t send_oversized;            ///< Frames thrown away because they were larger than ETHERNET_MAX_FRAME_SIZE
+
+	} ethernet_statistics_t;
+
 	/**
 	 * @class EthernetDriver
 	 * @brief Driver for the Ethernet Controller, manages the sending and receiving of data, the mac address, and the events
+	 *
+	 * @note Received frames are handled in the interrupt by default. Once polling is enabled the interrupt only masks
+	 * further receive interrupts and wakes a worker thread, which drains the ring in batches until it is empty
 	 */
 	class EthernetDriver : public Driver, public common::EventManager<EthernetDriverEvents> {
+
+		private:
+			bool m_polling = false;
+			bool m_poll_pending = false;
+			uint32_t m_poll_budget = ETHERNET_POLL_BUDGET;
+
+			common::Spinlock m_poll_lock;
+			common::WaitQueue m_poll_queue;
+
+			static void poll_worker(uint64_t argc, EthernetDriver** argv);
+
 		protected:
-			virtual void do_send(uint8_t* buffer, uint32_t size);
-			void fire_data_received(uint8_t* buffer, uint32_t size);
+			ethernet_statistics_t m_statistics = {};   ///< The ring counters for this device
+			bool m_checksum_offload = false;           ///< Does the device fill in TCP/UDP checksums left by the stack
+
+			static uint32_t ring_size(uint32_t requested);
+
+			virtual void do_send(net::PacketBuffer* packet);
+			void fire_data_received(net::PacketBuffer* packet);
 			void fire_data_sent(uint8_t* buffer, uint32_t size);
 
+			void schedule_poll();
+			virtual uint32_t poll(uint32_t budget);
+			virtual void set_receive_interrupts(bool enabled);
+
 		public:
 			EthernetDriver();
 			~EthernetDriver();
 
+			void enable_polling(uint32_t budget = ETHERNET_POLL_BUDGET);
+			[[nodiscard]] bool polling() const;
+
+			[[nodiscard]] const ethernet_statistics_t& statistics() const;
+			[[nodiscard]] bool checksum_offload() const;
+
 			static MediaAccessControlAddress create_media_access_control_address(uint8_t digit1, uint8_t digit2, uint8_t digit3, uint8_t digit4, uint8_t digit5, uint8_t digit6);
 			virtual MediaAccessControlAddress get_media_access_control_address();
 
+			void send(net::PacketBuffer* packet);
 			void send(uint8_t* buffer, uint32_t size);
 	};
 
@@ -75,6 +75,8 @@ namespace MaxOS::drivers::ethernet {
 			uint16_t eprom_register;                  // The address of the eeprom register
 			uint16_t control_ext_register;             // The control extension register
 			uint16_t interrupt_mask_register;          // The interrupt mask register
+			uint16_t interrupt_mask_clear_register;    // The interrupt mask clear register
+			uint16_t missed_packets_register;          // The missed packets count register (clears when read)
 
 			//Registers Addresses (Receive Registers)
 			uint16_t receive_control_register;         // The receive control register
@@ -96,11 +98,20 @@ namespace MaxOS::drivers::ethernet {
 
 
 			//Buffers
-			receive_descriptor_t* receive_dsrctrs[32];    // The receive descriptors
-			uint16_t current_receive_buffer;           // The current receive buffer
+			uint32_t receive_ring_size;                // How many receive descriptors there are
+			receive_descriptor_t* receive_dsrctrs;     // The receive descriptors
+			uint8_t* receive_buffers;                  // The buffers the device receives into (one per descriptor)
+			uint32_t current_receive_buffer;           // The current receive buffer
 
-			send_descriptor_t* send_dsrctrs[8];           // The send descriptors
-			uint16_t current_send_buffer;              // The current send buffer
+			uint32_t send_ring_size;                   // How many send descriptors there are
+			send_descriptor_t* send_dsrctrs;           // The send descriptors
+			net::PacketBuffer** send_packets;          // The packet each send descriptor points at, released once it has been sent
+			uint32_t current_send_buffer;              // The current send buffer
+			uint32_t reclaim_send_buffer;              // The oldest send descriptor that hasn't been reclaimed
+			uint32_t sends_in_flight;                  // How many send descriptors are waiting to be reclaimed
+			common::Spinlock send_lock;                // Guards the send ring
+
+			void reclaim_sent();                       // Release the packets the device has finished sending
 
 
 			// write Commands and read results From NICs either using MemIO or IO Ports
@@ -123,11 +134,11 @@ namespace MaxOS::drivers::ethernet {
 			volatile bool active;                            //Is the device active
 			volatile bool init_done;                          //Is the device initialised
 
-			void fetch_data_received();                        //Fetches the data from the buffer
+			uint32_t fetch_data_received(uint32_t budget);     //Fetches the data from the buffer
 
 		public:
 
-			explicit IntelI217(hardwarecommunication::PCIDeviceDescriptor* device_descriptor);
+			explicit IntelI217(hardwarecommunication::PCIDeviceDescriptor* device_descriptor, uint32_t receive_ring_size = ETHERNET_DEFAULT_RING_SIZE, uint32_t send_ring_size = ETHERNET_DEFAULT_RING_SIZE);
 			~IntelI217();
 
 
@@ -139,12 +150,16 @@ namespace MaxOS::drivers::ethernet {
 			//Override Interrupt default methods
 			void handle_interrupt() final;
 
+			//Polling
+			uint32_t poll(uint32_t budget) final;
+			void set_receive_interrupts(bool enabled) final;
+
 
 			//Ethernet Driver functions
 			string vendor_name() final;
 			string device_name() final;
 
-			void do_send(uint8_t* buffer, uint32_t size) final;
+			void do_send(net::PacketBuffer* packet) final;
 			uint64_t get_media_access_control_address() final;
 	};
 
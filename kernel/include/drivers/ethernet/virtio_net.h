@@ -0,0 +1,234 @@
+/**
+ * @file virtio_net.h
+ * @brief Driver for virtio network devices (legacy PCI transport) with split virtqueues and multiple queue pairs
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+ */
+
+#ifndef MAXOS_DRIVERS_ETHERNET_VIRTIO_NET_H
+#define MAXOS_DRIVERS_ETHERNET_VIRTIO_NET_H
+
+#include <cstdint>
+#include <common/macros.h>
+#include <common/spinlock.h>
+#include <drivers/ethernet/ethernet.h>
+#include <hardwarecommunication/pci.h>
+#include <hardwarecommunication/interrupts.h>
+#include <hardwarecommunication/port.h>
+
+
+namespace MaxOS::drivers::ethernet {
+
+	constexpr uint16_t VIRTIO_NET_MAX_QUEUE_PAIRS = 8;     ///< The most receive/send queue pairs the driver will use (one per core)
+	constexpr uint32_t VIRTIO_QUEUE_ALIGNMENT = 4096;      ///< The legacy interface expects the used ring to start on a page boundary
+
+	/**
+	 * @enum VirtioStatus
+	 * @brief The bits of the device status register, set in order as the driver initialises the device
+	 */
+	enum class VirtioStatus : uint8_t {
+		ACKNOWLEDGE = 1,
+		DRIVER = 2,
+		DRIVER_OK = 4,
+		FEATURES_OK = 8,
+		FAILED = 128,
+	};
+
+	/**
+	 * @enum VirtioNetFeature
+	 * @brief The feature bits (low 32) that the driver knows how to use
+	 */
+	enum class VirtioNetFeature : uint32_t {
+		CHECKSUM = 1 << 0,
+		MAC = 1 << 5,
+		STATUS = 1 << 16,
+		CONTROL_QUEUE = 1 << 17,
+		MULTIQUEUE = 1 << 22,
+		EVENT_INDEX = 1 << 29,
+	};
+
+	/**
+	 * @enum VirtQueueDescriptorFlags
+	 * @brief Flags for a descriptor in a virtqueue
+	 */
+	enum class VirtQueueDescriptorFlags : uint16_t {
+		NEXT = 1,
+		WRITE = 2,
+	};
+
+	/**
+	 * @struct VirtQueueDescriptor
+	 * @brief One buffer (or part of a chain of buffers) given to the device
+	 *
+	 * @typedef virtq_descriptor_t
+	 * @brief Alias for VirtQueueDescriptor struct
+	 */
+	typedef struct PACKED VirtQueueDescriptor {
+		uint64_t address;       ///< Physical address of the buffer
+		uint32_t length;        ///< Length of the buffer
+		uint16_t flags;         ///< VirtQueueDescriptorFlags
+		uint16_t next;          ///< The next descriptor in the chain (if NEXT is set)
+	} virtq_descriptor_t;
+
+	/**
+	 * @struct VirtQueueUsedElement
+	 * @brief An entry in the used ring, a chain the device has finished with
+	 *
+	 * @typedef virtq_used_element_t
+	 * @brief Alias for VirtQueueUsedElement struct
+	 */
+	typedef struct PACKED VirtQueueUsedElement {
+		uint32_t id;            ///< The first descriptor of the chain
+		uint32_t length;        ///< How many bytes the device wrote into the chain
+	} virtq_used_element_t;
+
+	/**
+	 * @struct VirtQueueBuffer
+	 * @brief A buffer to add to a virtqueue
+	 *
+	 * @typedef virtq_buffer_t
+	 * @brief Alias for VirtQueueBuffer struct
+	 */
+	typedef struct VirtQueueBuffer {
+		uintptr_t address;      ///< Physical address of the buffer
+		uint32_t length;        ///< Length of the buffer
+		bool device_writes;     ///< Whether the device writes to (rather than reads from) the buffer
+	} virtq_buffer_t;
+
+	/**
+	 * @struct VirtioNetHeader
+	 * @brief The header in front of every frame sent or received (legacy layout, without merged receive buffers)
+	 *
+	 * @typedef virtio_net_header_t
+	 * @brief Alias for VirtioNetHeader struct
+	 */
+	typedef struct PACKED VirtioNetHeader {
+		uint8_t flags;                  ///< Checksum flags
+		uint8_t gso_type;               ///< Segmentation offload type
+		uint16_t header_length;         ///< Length of the headers to copy into each segment
+		uint16_t gso_size;              ///< Size of each segment
+		uint16_t checksum_start;        ///< Where to start checksumming from
+		uint16_t checksum_offset;       ///< Where to store the checksum (from checksum_start)
+	} virtio_net_header_t;
+
+	/**
+	 * @class VirtQueue
+	 * @brief A split virtqueue: the descriptor table, the ring of buffers given to the device and the ring of buffers it has finished with
+	 *
+	 * @note Not locked, the driver guards each queue
+	 */
+	class VirtQueue {
+
+		private:
+			uint16_t m_index;
+			uint16_t m_size;
+			bool m_event_index;
+
+			uintptr_t m_physical_address = 0;
+			virtq_descriptor_t* m_descriptors = nullptr;
+			volatile uint16_t* m_available = nullptr;               // flags, index, ring[size], used_event
+			volatile uint16_t* m_used_header = nullptr;             // flags, index
+			volatile virtq_used_element_t* m_used = nullptr;        // ring[size], avail_event
+			void** m_tokens = nullptr;
+
+			uint16_t m_free_head = 0;
+			uint16_t m_free_count = 0;
+			uint16_t m_last_used = 0;
+			uint16_t m_last_notified = 0;
+
+		public:
+			VirtQueue(uint16_t index, uint16_t size, bool event_index);
+			~VirtQueue();
+
+			static size_t bytes_needed(uint16_t size);
+
+			[[nodiscard]] uint16_t index() const;
+			[[nodiscard]] uint16_t size() const;
+			[[nodiscard]] uintptr_t physical_address() const;
+			[[nodiscard]] uint16_t free_descriptors() const;
+
+			bool add(const virtq_buffer_t* buffers, uint16_t count, void* token);
+			bool notify_needed();
+
+			[[nodiscard]] bool has_used() const;
+			bool next_used(void*& token, uint32_t& length);
+
+			void set_interrupts(bool enabled);
+	};
+
+	/**
+	 * @class VirtioNet
+	 * @brief Driver for a virtio network device, uses one receive and one send queue per core when the device supports multiqueue
+	 *
+	 * @note Only the legacy (transitional device) interface is supported, modern only devices (disable-legacy=on) are not
+	 */
+	class VirtioNet : public EthernetDriver, public hardwarecommunication::InterruptHandler {
+
+		private:
+			hardwarecommunication::Port32Bit device_features_port;
+			hardwarecommunication::Port32Bit driver_features_port;
+			hardwarecommunication::Port32Bit queue_address_port;
+			hardwarecommunication::Port16Bit queue_size_port;
+			hardwarecommunication::Port16Bit queue_select_port;
+			hardwarecommunication::Port16Bit queue_notify_port;
+			hardwarecommunication::Port8Bit device_status_port;
+			hardwarecommunication::Port8Bit isr_status_port;
+
+			uint16_t port_base;                     // Where the device's registers start
+			uint32_t features = 0;                  // The features both the driver and device support
+			MediaAccessControlAddress own_mac = 0;  // MAC address of the device
+
+			uint16_t queue_pairs = 0;                       // How many receive/send queue pairs are in use
+			VirtQueue* receive_queues[VIRTIO_NET_MAX_QUEUE_PAIRS] = {};
+			uint8_t* receive_buffers[VIRTIO_NET_MAX_QUEUE_PAIRS] = {};
+			uintptr_t receive_buffers_physical[VIRTIO_NET_MAX_QUEUE_PAIRS] = {};
+			VirtQueue* send_queues[VIRTIO_NET_MAX_QUEUE_PAIRS] = {};
+			common::Spinlock send_locks[VIRTIO_NET_MAX_QUEUE_PAIRS];
+
+			VirtQueue* control_queue = nullptr;             // Used to tell the device how many queue pairs to use
+			uint8_t* control_buffer = nullptr;              // Command, data and acknowledgement for the control queue
+			uintptr_t control_buffer_physical = 0;
+
+			volatile bool active = false;                   // Is the device active
+			bool receive_interrupts = true;                 // Should the receive queues raise interrupts
+
+			VirtQueue* setup_queue(uint16_t index);
+			void notify(VirtQueue* queue);
+
+			void fill_receive_queue(uint16_t pair);
+			void free_queue_pair(uint16_t pair);
+			uint32_t fetch_data_received(uint32_t budget);
+			void reclaim_sent(uint16_t pair);
+
+			bool send_control(uint8_t command_class, uint8_t command, const void* data, uint32_t size);
+
+		public:
+			explicit VirtioNet(hardwarecommunication::PCIDeviceDescriptor* device_descriptor);
+			~VirtioNet();
+
+			// Override driver default methods
+			uint32_t reset() final;
+			void activate() final;
+			void deactivate() final;
+
+			// Naming
+			string vendor_name() final;
+			string device_name() final;
+
+			//Override Interrupt default methods
+			void handle_interrupt() final;
+
+			//Polling
+			uint32_t poll(uint32_t budget) final;
+			void set_receive_interrupts(bool enabled) final;
+
+			//Ethernet Driver functions
+			void do_send(net::PacketBuffer* packet) final;
+			uint64_t get_media_access_control_address() final;
+	};
+
+}
+
+
+#endif //MAXOS_DRIVERS_ETHERNET_VIRTIO_NET_H
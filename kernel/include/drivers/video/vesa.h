@@ -37,13 +37,17 @@ namespace MaxOS::drivers::video {
 			// Info
 			multiboot_tag_framebuffer* m_framebuffer_info;
 			uint8_t m_bpp;
-			uint16_t m_pitch;
+
+			inline static VideoElectronicsStandardsAssociation* s_active_driver = nullptr;
 
 		public:
 			explicit VideoElectronicsStandardsAssociation(multiboot_tag_framebuffer* framebuffer_info);
 			~VideoElectronicsStandardsAssociation();
 
 			bool supports_mode(uint32_t width, uint32_t height, uint32_t) final;
+			void set_framebuffer_caching(size_t caching);
+
+			static VideoElectronicsStandardsAssociation* active_driver();
 
 			string vendor_name() final;
 			string device_name() final;
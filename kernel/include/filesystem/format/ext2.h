@@ -317,17 +317,24 @@ namespace MaxOS::filesystem::format::ext2 {
 	 * @class Ext2Volume
 	 * @brief Common operations for an ext2 volume that are used by both files & directories (like block & inode allocation)
 	 *
+	 * @note Each block group has its own lock for its bitmaps, counters and inode table so allocations in different groups
+	 * don't wait on each other. The superblock and descriptor table write back have a separate lock that is always taken last.
+	 * Both are held while blocks are read and written so waiters sleep rather than spin.
+	 *
 	 * @todo Free blocks
 	 */
 	class Ext2Volume {
 
 		private:
+			common::BlockingLock* m_group_locks = nullptr;
+			common::BlockingLock m_metadata_lock;
+
 			common::Vector<uint32_t> allocate_group_blocks(uint32_t block_group, uint32_t amount);
 			void free_group_blocks(uint32_t block_group, uint32_t amount, uint32_t start);
 
-
 			void write_back_block_groups() const;
 			void write_back_superblock();
+			void write_back_metadata(int32_t inode_change, int32_t block_change);
 
 		public:
 			Ext2Volume(drivers::disk::Disk* disk, lba_t partition_offset);
@@ -347,15 +354,14 @@ namespace MaxOS::filesystem::format::ext2 {
 			uint32_t inodes_per_block;                          ///< How many inodes fit in a block
 			uint32_t sectors_per_block;                         ///< How many sectors does a block take
 
-			common::Spinlock ext2_lock;                         ///< Lock for synchronised access to the volume (@todo: remove public?)
-
 			void write_block(uint32_t block_num, common::buffer_t* buffer) const;
-			void write_inode(uint32_t inode_num, inode_t* inode) const;
+			void write_inode(uint32_t inode_num, inode_t* inode);
 
 			[[nodiscard]] uint32_t create_inode(bool is_directory);
 			void free_inode(uint32_t inode);
 
 			void read_block(uint32_t block_num, common::buffer_t* buffer) const;
+			void read_blocks(uint32_t block_num, uint32_t count, common::buffer_t* buffer) const;
 			[[nodiscard]] inode_t read_inode(uint32_t inode_num) const;
 
 			[[nodiscard]] uint32_t allocate_block();
@@ -365,17 +371,48 @@ namespace MaxOS::filesystem::format::ext2 {
 			void free_blocks(const common::Vector<uint32_t>& blocks);
 	};
 
+	/**
+	 * @struct BlockExtent
+	 * @brief A run of blocks in an inode that are also next to each other on disk
+	 *
+	 * @typedef block_extent_t
+	 * @brief Alias for BlockExtent struct
+	 */
+	typedef struct BlockExtent {
+		uint32_t logical;       ///< The first block of the inode's data that the run covers
+		uint32_t physical;      ///< The block on disk that holds the first logical block
+		uint32_t length;        ///< How many blocks are in the run
+	} block_extent_t;
+
+	/// The most blocks that will be read from an extent in one transfer
+	constexpr uint32_t EXT2_MAX_TRANSFER_BLOCKS = 16;
+
 	/**
 	 * @class InodeHandler
 	 * @brief Simplfies the management of an inode & its blocks
+	 *
+	 * @note Users of the handler take the lock for reading while they only read the inode's data and for writing while they
+	 * change its data, size or blocks
+	 * @note The block map is cached as extents and only the pointer blocks that are used get read
+	 * @note A zero pointer is a hole, anywhere up to the last allocated block, and reads as zeros
 	 */
 	class InodeHandler {
 
 		private:
 			Ext2Volume* m_volume = nullptr;
 
-			void parse_indirect(uint32_t level, uint32_t block, common::buffer_t* buffer);
-			void write_indirect(uint32_t level, uint32_t& block, size_t& index);
+			common::Vector<block_extent_t> m_extents;
+			common::Spinlock m_extent_lock;
+			uint32_t m_block_count = 0;
+
+			uint32_t count_indirect(uint32_t level, uint32_t block);
+			uint32_t pointer_block(uint32_t logical, size_t& slot, bool allocate);
+			void load_pointers(uint32_t logical);
+
+			bool find_extent(uint32_t logical, size_t& index) const;
+			void cache_extent(uint32_t logical, uint32_t physical, uint32_t length);
+			void cache_pointers(uint32_t logical, const uint32_t* pointers, size_t count);
+
 			void store_blocks(const common::Vector<uint32_t>& blocks);
 
 		public:
@@ -384,7 +421,12 @@ namespace MaxOS::filesystem::format::ext2 {
 
 			uint32_t inode_number;                      ///< The index of the inode
 			inode_t inode;                              ///< The inode metadata for this file/directory
-			common::Vector<uint32_t> block_cache;       ///< All the blocks used by this inode
+			common::ReadWriteLock lock;                 ///< Guards the inode's data and metadata
+
+			[[nodiscard]] uint32_t block_count() const;
+			uint32_t block(uint32_t logical);
+			uint32_t extent(uint32_t logical, uint32_t& length);
+			uint32_t fill_hole(uint32_t logical);
 
 			[[nodiscard]] size_t size() const;
 			void set_size(size_t size);
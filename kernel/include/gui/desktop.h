@@ -11,6 +11,8 @@
 
 #include <cstdint>
 #include <common/graphicsContext.h>
+#include <common/region.h>
+#include <common/spinlock.h>
 #include <drivers/peripherals/mouse.h>
 #include <gui/widget.h>
 #include <drivers/clock/clock.h>
@@ -18,10 +20,40 @@
 
 namespace MaxOS::gui {
 
+	constexpr uint32_t DESKTOP_INPUT_QUEUE_SIZE = 64;     ///< How many input events can wait for the desktop to be unlocked before new ones are dropped
+
+	/**
+	 * @enum DesktopInputType
+	 * @brief The kinds of input the desktop receives
+	 */
+	enum class DesktopInputType {
+		MOUSE_MOVE,
+		MOUSE_DOWN,
+		MOUSE_UP,
+		KEY_DOWN,
+		KEY_UP,
+	};
+
+	/**
+	 * @struct DesktopInput
+	 * @brief An input event waiting to be applied to the desktop
+	 */
+	struct DesktopInput {
+		DesktopInputType type;                              ///< What happened
+		int8_t x;                                           ///< How far the mouse moved horizontally
+		int8_t y;                                           ///< How far the mouse moved vertically
+		uint8_t button;                                     ///< The mouse button pressed or released
+		drivers::peripherals::KeyCode key;                  ///< The key pressed or released
+		drivers::peripherals::KeyboardState state;          ///< The state of the keyboard when the key changed
+	};
+
 	/**
 	 * @class Desktop
 	 * @brief The desktop that contains all the windows, handles the drawing of the screen and the mouse on every tick
 	 *
+	 * @details The widget tree is guarded by lock(), held for as long as it is changed or drawn. Input arrives in interrupts
+	 * (on any core) so it is only queued there, the thread that locks the desktop applies it. Interrupts never touch the tree.
+	 *
 	 * @todo It is not a good idea to hardcode the mouse into the desktop as a tablet or touch screen device won't have a mouse cursor
 	 */
 	class Desktop : public CompositeWidget, public drivers::peripherals::MouseEventHandler {
@@ -31,6 +63,7 @@ namespace MaxOS::gui {
 			uint32_t m_mouse_y;                                                              ///< The vertical position of the mouse cursor
 
 			common::GraphicsContext* m_graphics_context;                                    ///< Where to draw the desktop to
+			bool m_back_buffered { false };                                                 ///< Is the desktop drawn off screen then presented, with the cursor drawn on top as it is
 
 			Widget* m_focussed_widget { nullptr };                                          ///< The widget that currently is receiving keyboard input and is at the front
 			drivers::peripherals::MouseEventHandler* m_dragged_widget { nullptr };          ///< The widget that the mouse is currently dragging
@@ -38,18 +71,36 @@ namespace MaxOS::gui {
 			void set_focus(Widget*) final;
 			void bring_to_front(Widget*) final;
 			void invert_mouse_cursor();
+			void invalidate_mouse_cursor();
 
-			common::Vector<common::Rectangle<int32_t>> m_invalid_areas;                    ///< The areas of the desktop that need to be redrawn
-			void internal_invalidate(common::Rectangle<int32_t>& area, common::Vector<common::Rectangle<int32_t>>::iterator start, common::Vector<common::Rectangle<int32_t>>::iterator stop);
+			common::Region m_invalid_areas;                                                 ///< The areas of the desktop that need to be redrawn
 			void draw_self(common::GraphicsContext* gc, common::Rectangle<int32_t>& area) final;
 
+		private:
+			common::Spinlock m_lock;
+			common::Spinlock m_input_lock;
+			DesktopInput m_input[DESKTOP_INPUT_QUEUE_SIZE];
+			uint32_t m_input_head { 0 };
+			uint32_t m_input_count { 0 };
+
+			void queue_input(const DesktopInput& input);
+			void apply_input();
+
+			void move_mouse(int8_t x, int8_t y);
+			void press_mouse(uint8_t button);
+			void release_mouse(uint8_t button);
+
 		public:
 			common::Colour colour;                                                          ///< The background colour of the desktop (@todo: replace with image, make priv)
 
 			explicit Desktop(common::GraphicsContext* gc);
 			~Desktop();
 
+			void lock();
+			void unlock();
+
 			void add_child(Widget*) final;
+			void remove_child(Widget*) final;
 			void on_time(const common::Time& time);
 			void invalidate(common::Rectangle<int32_t>& area) final;
 
@@ -19,6 +19,27 @@ namespace MaxOS::gui {
 	constexpr uint8_t FONT_PADDING = 3;                         ///< How many vertical pixels to add to the top and bottom of the font to prevent squishing
 	constexpr uint8_t FONT_HEIGHT = 8 + (2 * FONT_PADDING);     ///< How many pixels tall the font is
 	constexpr uint8_t FONT_WIDTH = 8;                           ///< How many pixels wide the font is
+	constexpr uint8_t GLYPH_PIXELS = 8 * 8;                     ///< How many pixels are in the tile of an expanded glyph
+	constexpr uint8_t GLYPH_CACHE_SLOTS = 4;                    ///< How many combinations of colours a font keeps expanded glyphs for
+
+	/**
+	 * @struct GlyphTileSet
+	 * @brief The glyphs of a font expanded into tiles ready to blit, for one foreground, background and color depth
+	 *
+	 * @typedef glyph_tile_set_t
+	 * @brief Alias for GlyphTileSet struct
+	 */
+	typedef struct GlyphTileSet {
+
+		uint32_t foreground;            ///< The foreground colour, in the format of the color depth
+		uint32_t background;            ///< The background colour, in the format of the color depth
+		uint32_t color_depth;           ///< The color depth the colours were converted for
+		uint64_t last_used;             ///< When the set was last drawn with, the least recently used set is replaced first
+
+		uint64_t expanded[4];           ///< Bit n is set if the tile for character n holds this set's colours
+		uint32_t* tiles[256];           ///< The tile for each character (8 rows of 8 pixels, one per uint32_t), allocated when first drawn
+
+	} glyph_tile_set_t;
 
 	/**
 	 * @class Font
@@ -29,6 +50,12 @@ namespace MaxOS::gui {
 			bool m_is_8_by_8 = { true };                ///< Is the font 8 pixels by 8 pixels per character
 			uint8_t m_font8x8[2048] = { 0 };              ///< The 8x8 font data
 
+			glyph_tile_set_t* m_glyph_cache[GLYPH_CACHE_SLOTS] = { nullptr };    ///< The expanded glyphs for the colours most recently drawn with
+			uint64_t m_glyph_cache_clock = 0;                                   ///< Counts draws to find the least recently used tile set
+
+			glyph_tile_set_t* tile_set(uint32_t foreground, uint32_t background, uint32_t color_depth);
+			const uint32_t* glyph(glyph_tile_set_t* tile_set, uint8_t character);
+
 		public:
 
 			explicit Font(const uint8_t* font_data);
@@ -42,6 +69,8 @@ namespace MaxOS::gui {
 			virtual void draw_text(int32_t x, int32_t y, common::Colour foreground_colour, common::Colour background_colour, common::GraphicsContext* context, string text);
 			virtual void draw_text(int32_t x, int32_t y, common::Colour foreground_colour, common::Colour background_colour, common::GraphicsContext* context, string text, common::Rectangle<int32_t> limit_area);
 
+			void draw_character(int32_t x, int32_t y, uint32_t foreground, uint32_t background, common::GraphicsContext* context, char character);
+
 			virtual size_t get_text_height(string);
 			virtual size_t get_text_width(string);
 	};
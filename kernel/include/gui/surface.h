@@ -0,0 +1,45 @@
+/**
+ * @file surface.h
+ * @brief Defines a Surface class for drawing off screen so the result can be copied to the screen later
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+ */
+
+#ifndef MAXOS_GUI_SURFACE_H
+#define MAXOS_GUI_SURFACE_H
+
+#include <cstdint>
+#include <common/graphicsContext.h>
+#include <common/rectangle.h>
+
+namespace MaxOS::gui {
+
+	/**
+	 * @class Surface
+	 * @brief A graphics context that draws into memory, one uint32_t per pixel in the format of the screen it will be copied to
+	 *
+	 * @details At 32 bits per pixel the memory is laid out like a framebuffer so it gets the fast span drawing, other depths
+	 * are drawn a pixel at a time.
+	 */
+	class Surface final : public common::GraphicsContext {
+
+		private:
+			uint32_t* m_pixels;
+
+		protected:
+			void render_pixel(uint32_t x, uint32_t y, uint32_t colour) final;
+			uint32_t get_rendered_pixel(uint32_t x, uint32_t y) final;
+
+		public:
+			Surface(uint32_t width, uint32_t height, uint32_t color_depth);
+			~Surface();
+
+			[[nodiscard]] uint32_t* pixels() const;
+
+			void composite(common::GraphicsContext* gc, int32_t x, int32_t y, const common::Rectangle<int32_t>& area) const;
+	};
+
+}
+
+#endif //MAXOS_GUI_SURFACE_H
@@ -22,6 +22,9 @@ namespace MaxOS {
 
 	namespace gui {
 
+		constexpr uint32_t DAMAGE_MERGE_SLACK = 4096;      ///< How many undamaged pixels can be redrawn to merge two invalid areas into one
+		constexpr uint32_t DAMAGE_MAX_RECTANGLES = 32;     ///< How many invalid areas are tracked before the whole span between them is redrawn
+
 		/**
 		 * @class Widget
 		 * @brief A graphical object that can be drawn on the screen
@@ -45,6 +48,7 @@ namespace MaxOS {
 
 				virtual void set_focus(Widget*);
 				virtual void bring_to_front(Widget*);
+				void invalidate_in_parent(const common::Rectangle<int32_t>& area);
 
 			public:
 
@@ -104,6 +108,7 @@ namespace MaxOS {
 				// Drawing functions
 				void draw(common::GraphicsContext* gc, common::Rectangle<int32_t>& area) override;
 				void add_child(Widget* child) override;
+				virtual void remove_child(Widget* child);
 
 				// Mouse functions
 				void on_mouse_enter_widget(uint32_t to_x, uint32_t to_y) override;
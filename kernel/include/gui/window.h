@@ -10,6 +10,8 @@
 #define MaxOS_GUI_WINDOW_H
 
 #include <stdint.h>
+#include <common/region.h>
+#include <gui/surface.h>
 #include <gui/widget.h>
 #include <gui/widgets/text.h>
 
@@ -20,6 +22,9 @@ namespace MaxOS{
         /**
          * @class Window
          * @brief A window that can be moved and resized and contains a widget.
+         *
+         * @details The window and its children are drawn into a surface of their own, which is only redrawn where its
+         * content changes. Moving the window or changing what is in front of it just copies the surface back to the screen.
          */
         class Window : public CompositeWidget{
 
@@ -37,6 +42,12 @@ namespace MaxOS{
                 WidgetMoverResizerBottomLeft  m_resizer_bottom_left;
                 WidgetMoverResizerBottomRight m_resizer_bottom_right;
 
+                Surface* m_surface { nullptr };
+                common::Region m_surface_damage;
+                bool m_drawing_to_surface { false };
+
+                void update_surface(common::GraphicsContext* gc);
+
 
             public:
 
@@ -51,9 +62,13 @@ namespace MaxOS{
                 Window(Widget* contained_widget, const string& title_text);
                 ~Window();
 
+                void draw(common::GraphicsContext* gc, common::Rectangle<int32_t>& area) override;
                 void draw_self(common::GraphicsContext* gc, common::Rectangle<int32_t>& area) override;
+                void invalidate(common::Rectangle<int32_t>& area) override;
                 void add_child(Widget* child) override;
 
+                common::Coordinates absolute_coordinates(common::Coordinates coordinates) override;
+
                 drivers::peripherals::MouseEventHandler* on_mouse_button_pressed(uint32_t x, uint32_t y, uint8_t button) override;
         };
     }
@@ -0,0 +1,105 @@
+/**
+ * @file windowserver.h
+ * @brief Defines the WindowServer that shows windows drawn by userspace processes on the desktop
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+ */
+
+#ifndef MAXOS_GUI_WINDOWSERVER_H
+#define MAXOS_GUI_WINDOWSERVER_H
+
+#include <cstdint>
+#include <common/string.h>
+#include <common/vector.h>
+#include <gui/desktop.h>
+#include <gui/widget.h>
+#include <processes/ipc.h>
+#include <syscore/include/gui/window.h>
+
+
+namespace MaxOS::gui {
+
+	typedef ::syscore::gui::WindowRequestType window_request_type_t;    ///< Alias to make the libsyscore WindowRequestType accessible here
+	typedef ::syscore::gui::WindowRequest window_request_t;             ///< Alias to make the libsyscore WindowRequest accessible here
+	typedef ::syscore::gui::WindowEventType window_event_type_t;        ///< Alias to make the libsyscore WindowEventType accessible here
+	typedef ::syscore::gui::WindowModifiers window_modifiers_t;         ///< Alias to make the libsyscore WindowModifiers accessible here
+	typedef ::syscore::gui::WindowEvent window_event_t;                 ///< Alias to make the libsyscore WindowEvent accessible here
+
+	constexpr uint32_t WINDOW_SERVER_FRAME_INTERVAL = 16;                ///< How many milliseconds the window server waits between frames
+	constexpr uint32_t WINDOW_SERVER_MAX_REQUESTS = 64;                  ///< How many requests are handled each frame before drawing
+
+	/**
+	 * @class ClientWindow
+	 * @brief A window drawn by a userspace process. Its surface is shared memory the process draws into, so it is copied
+	 * straight to the screen. Input is sent back as messages on the window's event endpoint.
+	 */
+	class ClientWindow final : public Widget {
+
+		private:
+			string m_name;
+			uint64_t m_owner;
+
+			processes::SharedMemory* m_surface;
+			processes::SharedMessageEndpoint* m_events;
+			uint32_t* m_pixels;
+
+			void send(window_event_type_t type, int32_t x, int32_t y, uint32_t value, uint32_t modifiers = 0);
+			static uint32_t modifiers(const drivers::peripherals::KeyboardState& state);
+
+		public:
+			ClientWindow(const string& name, uint64_t owner, processes::SharedMemory* surface, processes::SharedMessageEndpoint* events, int32_t left, int32_t top, uint32_t width, uint32_t height);
+			~ClientWindow();
+
+			string name();
+			uint64_t owner();
+			processes::SharedMemory* surface();
+			processes::SharedMessageEndpoint* events();
+
+			void draw(common::GraphicsContext* gc, common::Rectangle<int32_t>& area) final;
+			void damage(int32_t x, int32_t y, uint32_t width, uint32_t height);
+
+			void on_focus() final;
+			void on_focus_lost() final;
+
+			void on_mouse_move_widget(uint32_t from_x, uint32_t from_y, uint32_t to_x, uint32_t to_y) final;
+			drivers::peripherals::MouseEventHandler* on_mouse_button_pressed(uint32_t x, uint32_t y, uint8_t button) final;
+			void on_mouse_button_released(uint32_t x, uint32_t y, uint8_t button) final;
+
+			void on_key_down(drivers::peripherals::KeyCode key_down_code, const drivers::peripherals::KeyboardState& key_down_state) final;
+			void on_key_up(drivers::peripherals::KeyCode key_up_code, const drivers::peripherals::KeyboardState& key_up_state) final;
+	};
+
+	/**
+	 * @class WindowServer
+	 * @brief Reads window requests from userspace on the "gui:server" endpoint and draws the desktop, once per frame on a
+	 * kernel thread of its own
+	 *
+	 * @details A client creates its surface ("gui:NAME:surface") and event endpoint ("gui:NAME:events") then sends a
+	 * CREATE request. The server keeps both open until the window is destroyed so they outlive the client closing them.
+	 * Only the process that created a window can change it.
+	 */
+	class WindowServer {
+
+		private:
+			Desktop* m_desktop;
+			processes::SharedMessageEndpoint* m_requests = nullptr;
+			common::Vector<ClientWindow*> m_windows;
+
+			ClientWindow* find_window(const string& name);
+			void create_window(const window_request_t& request, const string& name, uint64_t sender);
+			void destroy_window(ClientWindow* window);
+
+			static void worker(uint64_t argc, WindowServer** argv);
+
+		public:
+			explicit WindowServer(Desktop* desktop);
+			~WindowServer();
+
+			void handle_request(const window_request_t& request, uint64_t sender);
+			void frame();
+	};
+
+}
+
+#endif //MAXOS_GUI_WINDOWSERVER_H
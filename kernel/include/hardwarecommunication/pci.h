@@ -99,6 +99,7 @@ namespace MaxOS::hardwarecommunication {
 			PCIDeviceDescriptor get_device_descriptor(uint16_t bus, uint16_t device, uint16_t function);
 			BaseAddressRegister get_base_address_register(uint16_t bus, uint16_t device, uint16_t function, uint16_t bar);
 			bool device_has_functions(uint16_t bus, uint16_t device);
+			void enable_bus_mastering(uint16_t bus, uint16_t device, uint16_t function);
 
 		public:
 			PCIController();
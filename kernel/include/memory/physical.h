@@ -49,6 +49,7 @@ namespace MaxOS::memory {
 		DIRTY = (1 << 6),         ///< This page has been written to
 		HUGE_PAGE = (1 << 7),         ///< This page is not 4Kib (2MB or 1GB)
 		GLOBAL = (1 << 8),         ///< The page can be shared  between processes
+		WRITE_COMBINING = (1 << 9),         ///< Writes are buffered and combined into bursts, not cached (for framebuffers, see Core::init_pat)
 		NO_EXECUTE = (1ULL << 63)      ///< Dont let the CPU execute code on this page
 	} page_flags_t;
 
@@ -90,6 +91,7 @@ namespace MaxOS::memory {
 
 	constexpr uint64_t PAGE_SIZE = 0x1000;      ///< The size of a page (4KB)
 	constexpr uint8_t ROW_BITS = 64;           ///< The number of bits in the bitmap row
+	constexpr uint64_t DMA_32_BIT_LIMIT = 0x100000000;     ///< The end of the memory a device that only takes 32 bit addresses can reach (4GB)
 
 	constexpr uint64_t HIGHER_HALF_KERNEL_OFFSET = 0xFFFFFFFF80000000;                                  ///< Where the kernel is mapped in higher half memory
 	constexpr uint64_t HIGHER_HALF_MEM_OFFSET = 0xFFFF800000000000;                                     ///< Where higher half memory starts
@@ -159,7 +161,7 @@ namespace MaxOS::memory {
 			void* allocate_frame();
 			void free_frame(void* address);
 
-			void* allocate_area(uint64_t start_address, size_t size);
+			void* allocate_area(uint64_t start_address, size_t size, uint64_t limit = UINT64_MAX);
 			void free_area(uint64_t start_address, size_t size);
 
 			// Map
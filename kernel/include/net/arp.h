@@ -12,10 +12,19 @@
 #include <cstdint>
 
 #include <net/ipv4.h>
+#include <common/hashmap.h>
+#include <common/spinlock.h>
 
 
 namespace MaxOS::net {
 
+	constexpr uint32_t ARP_ENTRY_LIFETIME = 60000;      ///< How long (ms) a resolved address is used before it is asked for again
+	constexpr uint32_t ARP_RETRY_INTERVAL = 1000;       ///< How long (ms) to wait for a reply before asking again
+	constexpr uint8_t ARP_MAX_RETRIES = 3;              ///< How many times to ask before giving up on an address
+	constexpr uint8_t ARP_MAX_PENDING = (IPV4_MAX_DATAGRAM - 20 + ((IPV4_MTU - 20) & ~7) - 1) / ((IPV4_MTU - 20) & ~7);   ///< How many packets can wait for an address to be resolved, enough for every fragment of the largest datagram (the oldest are dropped)
+	constexpr uint32_t ARP_MAX_ENTRIES = 256;           ///< The most addresses the cache holds
+	constexpr uint32_t ARP_TIMER_INTERVAL = 100;        ///< How often (ms) the timer worker checks the cache
+
 	/**
 	 * @struct ARPMessage
 	 * @brief An ARP message
@@ -40,25 +49,62 @@ namespace MaxOS::net {
 
 	} arp_message_t;
 
+	/**
+	 * @enum ARPEntryState
+	 * @brief The state of an address in the cache
+	 */
+	enum class ARPEntryState : uint8_t {
+		INCOMPLETE,     ///< A request has been sent, packets are held until the reply arrives
+		REACHABLE,      ///< The MAC address is known
+	};
+
+	/**
+	 * @struct ARPEntry
+	 * @brief An address in the cache
+	 *
+	 * @typedef arp_entry_t
+	 * @brief Alias for ARPEntry struct
+	 */
+	typedef struct ARPEntry {
+		drivers::ethernet::MediaAccessControlAddress media_access_control_address = 0;    ///< The MAC address (once resolved)
+		ARPEntryState state = ARPEntryState::INCOMPLETE;                                   ///< Has the address been resolved
+		uint64_t deadline = 0;                                      ///< When the entry expires (reachable) or the request is sent again (incomplete)
+		uint8_t retries = 0;                                        ///< How many requests have been sent
+		uint8_t pending_count = 0;                                  ///< How many packets are held
+		PacketBuffer* pending[ARP_MAX_PENDING] = {};                ///< The packets waiting for the address (oldest first)
+	} arp_entry_t;
+
 	/**
 	 * @class AddressResolutionProtocol
 	 * @brief Handles ARP requests and replies
+	 *
+	 * @details Resolved addresses are cached until they age out. Packets sent to an address that isn't resolved yet are held in
+	 * its entry and sent once the reply arrives, so sending never waits on the network. A timer worker sends the requests
+	 * again and gives up (dropping the held packets) after ARP_MAX_RETRIES.
 	 */
 	class AddressResolutionProtocol : public EthernetFramePayloadHandler, public IPV4AddressResolver {
 
 		private:
-			common::Map<InternetProtocolAddress, drivers::ethernet::MediaAccessControlAddress> address_cache;
+			common::HashMap<InternetProtocolAddress, arp_entry_t> address_cache;
+			common::Spinlock m_lock;
 			InternetProtocolHandler* internet_protocol_handler;
 			common::OutputStream* error_messages;
 
+			void learn(InternetProtocolAddress internet_protocol_address, drivers::ethernet::MediaAccessControlAddress media_access_control_address, bool create);
+			void handle_timers(uint64_t now);
+
+			static uint64_t now();
+			static void timer_worker(uint64_t argc, AddressResolutionProtocol** argv);
+
 		public:
 			AddressResolutionProtocol(EthernetFrameHandler* ethernet_frame_handler, InternetProtocolHandler* internet_protocol_handler, common::OutputStream* error_messages);
 			~AddressResolutionProtocol();
 
-			bool handle_ethernetframe_payload(uint8_t* etherframe_payload, uint32_t size) final;
+			bool handle_ethernetframe_payload(PacketBuffer* packet) final;
 
 			void request_mac_address(InternetProtocolAddress address);
 			drivers::ethernet::MediaAccessControlAddress resolve(InternetProtocolAddress address) final;
+			bool resolve(InternetProtocolAddress address, PacketBuffer* packet, drivers::ethernet::MediaAccessControlAddress& media_access_control_address) final;
 			void store(InternetProtocolAddress internet_protocol_address, drivers::ethernet::MediaAccessControlAddress media_access_control_address) final;
 	};
 
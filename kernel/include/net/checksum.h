@@ -0,0 +1,44 @@
+/**
+ * @file checksum.h
+ * @brief Defines the Internet checksum (RFC 1071) used by IPv4, ICMP, TCP and UDP, with incremental updates (RFC 1624)
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+ */
+
+#ifndef MAXOS_NET_CHECKSUM_H
+#define MAXOS_NET_CHECKSUM_H
+
+#include <cstdint>
+#include <cstddef>
+
+
+namespace MaxOS::net {
+
+	class PacketBuffer;
+
+	/**
+	 * @class InternetChecksum
+	 * @brief The one's complement sum of 16-bit words. The sum is byte order independent so words are added as they are in
+	 * memory and the result can be stored straight into a header.
+	 *
+	 * @details A partial sum is the 32-bit unfolded sum of some data, partial sums of consecutive (even length) blocks can be
+	 * added together and folded once at the end.
+	 */
+	class InternetChecksum {
+
+		public:
+			static uint32_t partial(const void* data, size_t length, uint32_t sum = 0);
+			static uint32_t pseudo_header(uint32_t source_ip, uint32_t destination_ip, uint8_t protocol, uint16_t length);
+			static uint16_t fold(uint32_t sum);
+			static uint16_t compute(const void* data, size_t length, uint32_t sum = 0);
+
+			static uint16_t update(uint16_t checksum, uint16_t old_value, uint16_t new_value);
+			static uint16_t update(uint16_t checksum, uint32_t old_value, uint32_t new_value);
+
+			static void complete(PacketBuffer* packet);
+	};
+
+}
+
+#endif //MAXOS_NET_CHECKSUM_H
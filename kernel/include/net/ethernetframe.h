@@ -15,8 +15,16 @@
 #include <common/map.h>
 #include <drivers/ethernet/ethernet.h>
 #include <memory/memorymanagement.h>
+#include <net/packetbuffer.h>
 
 
+/// Per frame trace output, writing it for every frame is too slow under load so it is only built in when MAXOS_NET_TRACE is defined
+#ifdef MAXOS_NET_TRACE
+	#define NET_TRACE(stream, message) (stream)->write(message)
+#else
+	#define NET_TRACE(stream, message)
+#endif
+
 namespace MaxOS::net {
 
 	/**
@@ -65,7 +73,8 @@ namespace MaxOS::net {
 			EthernetFramePayloadHandler(EthernetFrameHandler* frame_handler, uint16_t handled_type);
 			~EthernetFramePayloadHandler();
 
-			virtual bool handle_ethernetframe_payload(uint8_t* ethernetframe_payload, uint32_t size);
+			virtual bool handle_ethernetframe_payload(PacketBuffer* packet);
+			void send(uint64_t destination, PacketBuffer* packet);
 			void send(uint64_t destination, uint8_t* data, uint32_t size);
 	};
 
@@ -86,9 +95,9 @@ namespace MaxOS::net {
 			~EthernetFrameHandler();
 
 			drivers::ethernet::MediaAccessControlAddress get_mac();
-			bool data_received(uint8_t* data, uint32_t size) override;
+			bool data_received(PacketBuffer* packet) override;
 			void connect_handler(EthernetFramePayloadHandler* handler);
-			void send_ethernet_frame(uint64_t destination_mac, uint16_t frame_type, uint8_t* data, uint32_t size);
+			void send_ethernet_frame(uint64_t destination_mac, uint16_t frame_type, PacketBuffer* packet);
 
 	};
 }
@@ -46,7 +46,7 @@ namespace MaxOS::net {
 			InternetControlMessageProtocol(InternetProtocolHandler* internet_protocol_handler, common::OutputStream* error_messages);
 			~InternetControlMessageProtocol();
 
-			bool handle_internet_protocol_payload(net::InternetProtocolAddress src_ip_be, net::InternetProtocolAddress dst_ip_be, uint8_t* payload_data, uint32_t size) final;
+			bool handle_internet_protocol_payload(net::InternetProtocolAddress src_ip_be, net::InternetProtocolAddress dst_ip_be, PacketBuffer* packet) final;
 			void request_echo_reply(uint32_t ip_be);
 	};
 
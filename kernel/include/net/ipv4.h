@@ -11,6 +11,7 @@
 
 #include <cstdint>
 #include <net/ethernetframe.h>
+#include <common/spinlock.h>
 
 
 namespace MaxOS::net {
@@ -18,6 +19,15 @@ namespace MaxOS::net {
 	typedef uint32_t InternetProtocolAddress;   ///< An IPv4 address @todo: Make IPv4Address class and do ip_t
 	typedef uint32_t SubnetMask;                ///< A subnet mask @todo: Make SubnetMask class and do subnetmask_t
 
+	constexpr uint32_t IPV4_MTU = 1500;                         ///< The largest packet (header included) sent in one frame
+	constexpr uint32_t IPV4_MAX_DATAGRAM = 65535;               ///< The largest datagram (header included)
+	constexpr uint8_t IPV4_MAX_REASSEMBLIES = 8;                ///< How many datagrams can be reassembled at once (the oldest is dropped for a new one)
+	constexpr uint32_t IPV4_REASSEMBLY_TIMEOUT = 30000;         ///< How long (ms) to wait for the rest of a datagram's fragments
+	constexpr uint32_t IPV4_IDENTIFIER_BUCKETS = 1024;          ///< How many identifier counters destinations are hashed across
+	constexpr uint16_t IPV4_FLAG_MORE_FRAGMENTS = 0x2000;       ///< Set on every fragment but the last (host order)
+	constexpr uint16_t IPV4_FLAG_DONT_FRAGMENT = 0x4000;        ///< The datagram can't be fragmented (host order)
+	constexpr uint16_t IPV4_FRAGMENT_OFFSET = 0x1FFF;           ///< Where the fragment goes in the datagram, in 8 byte blocks (host order)
+
 	/**
 	 * @struct IPV4Header
 	 * @brief The header of an IPv4 packet
@@ -44,6 +54,50 @@ namespace MaxOS::net {
 
 	} ipv4_header_t;
 
+	/**
+	 * @struct IPV4Statistics
+	 * @brief Counters for the packets sent and received, including fragmentation and reassembly
+	 *
+	 * @typedef ipv4_statistics_t
+	 * @brief Alias for IPV4Statistics struct
+	 */
+	typedef struct IPV4Statistics {
+
+		uint64_t sent;                      ///< Datagrams sent
+		uint64_t fragmented;                ///< Datagrams that had to be sent in fragments
+		uint64_t fragments_sent;            ///< Fragments sent
+		uint64_t fragmentation_failed;      ///< Datagrams that couldn't be fragmented (no packet buffers free)
+
+		uint64_t received;                  ///< Datagrams passed to the protocol handlers
+		uint64_t fragments_received;        ///< Fragments received
+		uint64_t reassembled;               ///< Datagrams put back together from their fragments
+		uint64_t reassembly_failed;         ///< Datagrams given up on (timed out, pushed out of the table or malformed)
+
+	} ipv4_statistics_t;
+
+	/**
+	 * @struct IPV4Reassembly
+	 * @brief A datagram being put back together from its fragments
+	 *
+	 * @typedef ipv4_reassembly_t
+	 * @brief Alias for IPV4Reassembly struct
+	 */
+	typedef struct IPV4Reassembly {
+
+		bool active;                        ///< Is the slot in use
+		uint32_t source_ip;                 ///< The IP of the sender
+		uint32_t destination_ip;            ///< The IP of the receiver
+		uint16_t identifier;                ///< The identifier the fragments share
+		uint8_t protocol;                   ///< The protocol of the payload
+
+		PacketBuffer* packet;               ///< Where the payload is put together
+		uint32_t length;                    ///< The length of the payload, 0 until the last fragment has arrived
+		uint32_t received_blocks;           ///< How many 8 byte blocks of the payload have arrived
+		uint64_t blocks[IPV4_MAX_DATAGRAM / 8 / 64 + 1];     ///< Which 8 byte blocks have arrived
+		uint64_t deadline;                  ///< When to give up on the datagram
+
+	} ipv4_reassembly_t;
+
 	class InternetProtocolHandler;
 
 	/**
@@ -55,6 +109,7 @@ namespace MaxOS::net {
 			explicit IPV4AddressResolver(InternetProtocolHandler* internet_protocol_handler);
 			~IPV4AddressResolver();
 			virtual drivers::ethernet::MediaAccessControlAddress resolve(InternetProtocolAddress address);
+			virtual bool resolve(InternetProtocolAddress address, PacketBuffer* packet, drivers::ethernet::MediaAccessControlAddress& media_access_control_address);
 			virtual void store(InternetProtocolAddress internet_protocol_address, drivers::ethernet::MediaAccessControlAddress media_access_control_address);
 	};
 
@@ -74,7 +129,8 @@ namespace MaxOS::net {
 			IPV4PayloadHandler(InternetProtocolHandler* internet_protocol_handler, uint8_t protocol);
 			~IPV4PayloadHandler();
 
-			virtual bool handle_internet_protocol_payload(net::InternetProtocolAddress src_ip_be, net::InternetProtocolAddress dst_ip_be, uint8_t* internetprotocol_payload, uint32_t size);
+			virtual bool handle_internet_protocol_payload(net::InternetProtocolAddress src_ip_be, net::InternetProtocolAddress dst_ip_be, PacketBuffer* packet);
+			void send(InternetProtocolAddress destination_ip, PacketBuffer* packet);
 			void send(InternetProtocolAddress destination_ip, uint8_t* payload_data, uint32_t size);
 	};
 
@@ -97,8 +153,22 @@ namespace MaxOS::net {
 			InternetProtocolAddress default_gateway_internet_protocol_address;                          ///< The IP address of the default gateway
 			SubnetMask subnet_mask;                                                                  ///< The subnet mask
 
+			ipv4_statistics_t m_statistics = {};                                                     ///< The packet counters
+			common::Spinlock m_reassembly_lock;                                                      ///< Guards the reassembly table
+			ipv4_reassembly_t m_reassemblies[IPV4_MAX_REASSEMBLIES];                                 ///< The datagrams being reassembled
+			inline static uint32_t s_identifiers[IPV4_IDENTIFIER_BUCKETS] = {};                     ///< The identifier counters, shared by every destination that hashes to them
+
 			void register_ipv_4_address_resolver(IPV4AddressResolver* ipv4_resolver);
 
+			bool write_header(PacketBuffer* packet, InternetProtocolAddress destination_ip, uint8_t protocol, uint16_t identifier, uint16_t flags_and_offset);
+			void transmit(InternetProtocolAddress destination_ip, PacketBuffer* packet);
+			void fragment(InternetProtocolAddress destination_ip, uint8_t protocol, uint16_t identifier, PacketBuffer* packet);
+			PacketBuffer* reassemble(const ipv4_header_t* header, PacketBuffer* packet);
+			void release_reassembly(ipv4_reassembly_t& reassembly);
+
+			static uint16_t next_identifier(InternetProtocolAddress destination_ip, uint8_t protocol);
+			static uint64_t now();
+
 		public:
 			InternetProtocolHandler(EthernetFrameHandler* backend,
 			                        InternetProtocolAddress own_internet_protocol_address,
@@ -107,8 +177,8 @@ namespace MaxOS::net {
 			                        common::OutputStream* error_messages);
 			~InternetProtocolHandler();
 
-			bool handle_ethernetframe_payload(uint8_t* ethernetframe_payload, uint32_t size) override;
-			void send_internet_protocol_packet(uint32_t dst_ip_be, uint8_t protocol, const uint8_t* data, uint32_t size);
+			bool handle_ethernetframe_payload(PacketBuffer* packet) override;
+			void send_internet_protocol_packet(uint32_t dst_ip_be, uint8_t protocol, PacketBuffer* packet);
 
 			static uint16_t checksum(const uint16_t* data, uint32_t length_in_bytes);
 
@@ -116,6 +186,7 @@ namespace MaxOS::net {
 			static InternetProtocolAddress parse(string address);
 			static SubnetMask create_subnet_mask(uint8_t digit1, uint8_t digit2, uint8_t digit3, uint8_t digit4);
 			[[nodiscard]] InternetProtocolAddress get_internet_protocol_address() const;
+			[[nodiscard]] const ipv4_statistics_t& statistics() const;
 			drivers::ethernet::MediaAccessControlAddress get_media_access_control_address();
 
 			void connect_ipv_4_payload_handler(IPV4PayloadHandler* ipv_4_payload_handler);
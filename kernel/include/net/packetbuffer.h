@@ -0,0 +1,104 @@
+/**
+ * @file packetbuffer.h
+ * @brief Defines a PacketBuffer that holds a frame with room in front for each layer to add its header in place, and the
+ * pool they are allocated from
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+ */
+
+#ifndef MAXOS_NET_PACKETBUFFER_H
+#define MAXOS_NET_PACKETBUFFER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <common/spinlock.h>
+
+
+namespace MaxOS::net {
+
+	constexpr size_t PACKET_BUFFER_SIZE = 2048;         ///< How many bytes each buffer can hold (a full ethernet frame plus headroom)
+	constexpr size_t PACKET_BUFFER_HEADROOM = 128;      ///< How much space is left in front of the data for headers to be prepended
+	constexpr size_t PACKET_BUFFER_POOL_SIZE = 1024;    ///< How many buffers are in the pool
+	constexpr size_t PACKET_BUFFER_MAX_LARGE = 65536;   ///< The most data a large (heap) buffer can hold, enough for any IP datagram
+
+	/**
+	 * @class PacketBuffer
+	 * @brief A frame being sent or received. Each layer prepends (sending) or pulls (receiving) its header so the data is never copied between layers
+	 *
+	 * @note Buffers from the pool are physically contiguous so their data can be given straight to a NIC. Large buffers are
+	 * allocated from the heap for datagrams bigger than a frame (being fragmented or reassembled) and can't be.
+	 */
+	class PacketBuffer {
+			friend class PacketBufferPool;
+
+		private:
+			uint8_t* m_memory = nullptr;
+			uintptr_t m_physical_address = 0;
+			size_t m_capacity = PACKET_BUFFER_SIZE;
+			bool m_pooled = true;
+
+			size_t m_head = 0;
+			size_t m_tail = 0;
+
+			PacketBuffer* m_next_free = nullptr;
+
+			bool m_checksum_pending = false;
+			size_t m_checksum_start = 0;
+			uint16_t m_checksum_offset = 0;
+
+		public:
+			PacketBuffer();
+			~PacketBuffer();
+
+			[[nodiscard]] uint8_t* data() const;
+			[[nodiscard]] uintptr_t physical_address() const;
+			[[nodiscard]] size_t length() const;
+			[[nodiscard]] bool pooled() const;
+
+			[[nodiscard]] size_t headroom() const;
+			[[nodiscard]] size_t tailroom() const;
+
+			uint8_t* prepend(size_t size);
+			uint8_t* append(size_t size);
+			uint8_t* pull(size_t size);
+			void trim(size_t length);
+
+			void reset(size_t headroom = PACKET_BUFFER_HEADROOM);
+			void release();
+
+			void request_checksum(size_t start, uint16_t offset);
+			void clear_checksum();
+			[[nodiscard]] bool checksum_pending() const;
+			[[nodiscard]] size_t checksum_start() const;
+			[[nodiscard]] uint16_t checksum_offset() const;
+	};
+
+	/**
+	 * @class PacketBufferPool
+	 * @brief A fixed set of packet buffers allocated from one physically contiguous area when the first one is needed
+	 */
+	class PacketBufferPool {
+
+		private:
+			inline static common::Spinlock s_lock;
+			inline static PacketBuffer* s_buffers = nullptr;
+			inline static PacketBuffer* s_free = nullptr;
+			inline static size_t s_available = 0;
+
+			static void initialise();
+
+		public:
+			static PacketBuffer* allocate(size_t headroom = PACKET_BUFFER_HEADROOM);
+			static PacketBuffer* allocate(const uint8_t* data, size_t size, size_t headroom = PACKET_BUFFER_HEADROOM);
+			static PacketBuffer* allocate_large(size_t size, size_t headroom = PACKET_BUFFER_HEADROOM);
+			static PacketBuffer* allocate_large(const uint8_t* data, size_t size, size_t headroom = PACKET_BUFFER_HEADROOM);
+			static void free(PacketBuffer* buffer);
+
+			static size_t available();
+	};
+
+}
+
+
+#endif //MAXOS_NET_PACKETBUFFER_H
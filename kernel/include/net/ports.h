@@ -0,0 +1,88 @@
+/**
+ * @file ports.h
+ * @brief Defines the key TCP and UDP connections are looked up by and the bitmap that hands out their local ports
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+ */
+
+#ifndef MAXOS_NET_PORTS_H
+#define MAXOS_NET_PORTS_H
+
+#include <cstdint>
+#include <common/hashmap.h>
+
+
+namespace MaxOS::net {
+
+	constexpr uint16_t EPHEMERAL_PORT_FIRST = 0x8000;      ///< The first port handed out to connections that don't ask for one
+	constexpr uint16_t EPHEMERAL_PORT_LAST = 0xFFFF;       ///< The last port handed out to connections that don't ask for one
+
+	/**
+	 * @struct ConnectionKey
+	 * @brief The addresses and ports (host order) that identify a connection
+	 *
+	 * @typedef connection_key_t
+	 * @brief Alias for ConnectionKey struct
+	 */
+	typedef struct ConnectionKey {
+		uint32_t local_ip;          ///< The IP address of this device
+		uint32_t remote_ip;         ///< The IP address of the external device
+		uint16_t local_port;        ///< The port on this device
+		uint16_t remote_port;       ///< The port on the external device
+
+		/**
+		 * @brief Compare two keys
+		 *
+		 * @param other The key to compare to
+		 * @return True if the addresses and ports are the same
+		 */
+		bool operator ==(const ConnectionKey& other) const {
+			return local_ip == other.local_ip && remote_ip == other.remote_ip && local_port == other.local_port && remote_port == other.remote_port;
+		}
+	} connection_key_t;
+
+	/**
+	 * @class PortAllocator
+	 * @brief Tracks which of the 65536 ports are in use with a bitmap so that ephemeral ports never collide with a port already in use
+	 */
+	class PortAllocator {
+
+		private:
+			uint64_t m_used[65536 / 64] = { };
+			uint16_t m_next = EPHEMERAL_PORT_FIRST;
+
+		public:
+			PortAllocator();
+			~PortAllocator();
+
+			[[nodiscard]] bool in_use(uint16_t port) const;
+			bool reserve(uint16_t port);
+			void release(uint16_t port);
+
+			uint16_t allocate();
+	};
+}
+
+namespace MaxOS::common {
+
+	/**
+	 * @class Hasher<ConnectionKey>
+	 * @brief Hashes the addresses and ports of a connection
+	 */
+	template<> struct Hasher<net::ConnectionKey> {
+
+		/**
+		 * @brief Hash a connection key
+		 *
+		 * @param key The key to hash
+		 * @return The hash of the key
+		 */
+		static uint64_t hash(net::ConnectionKey const& key) {
+			return hash_mix(((uint64_t) key.local_ip << 32 | key.remote_ip) ^ hash_mix((uint64_t) key.local_port << 16 | key.remote_port));
+		}
+	};
+}
+
+
+#endif // MAXOS_NET_PORTS_H
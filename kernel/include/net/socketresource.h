@@ -0,0 +1,119 @@
+/**
+ * @file socketresource.h
+ * @brief Defines SocketResource classes for exposing TCP and UDP sockets to userspace through the Resource interface
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+ */
+
+#ifndef MAXOS_NET_SOCKETRESOURCE_H
+#define MAXOS_NET_SOCKETRESOURCE_H
+
+#include <cstdint>
+#include <processes/resource.h>
+#include <common/buffer.h>
+#include <common/spinlock.h>
+#include <net/tcp.h>
+#include <net/udp.h>
+#include <syscore/include/net/socket.h>
+
+
+namespace MaxOS::net {
+
+	typedef ::syscore::net::SocketFlags socket_flags_t;     ///< Alias to make the libsyscore SocketFlags accessible here
+	typedef ::syscore::net::SocketError socket_error_t;     ///< Alias to make the libsyscore SocketError accessible here
+
+	constexpr uint32_t SOCKET_RECEIVE_BUFFER_SIZE = 65536;  ///< How many bytes of a stream can be waiting to be read
+	constexpr uint16_t SOCKET_MAX_DATAGRAMS = 64;           ///< How many datagrams can be waiting to be read
+	constexpr uint8_t SOCKET_MAX_BACKLOG = 16;              ///< How many connections can be waiting to be accepted
+
+	class SocketResourceRegistry;
+
+	/**
+	 * @class SocketResource
+	 * @brief A TCP or UDP socket opened by a process. Data arriving on the socket is queued until it is read and reads and
+	 * writes can either wait or return WOULD_BLOCK
+	 *
+	 * @details Connections accepted by a listener are registered under their own name and queued on the listener, reading
+	 * with the ACCEPT flag returns the name so the process can open it.
+	 */
+	class SocketResource final : public processes::Resource, public TCPPayloadHandler, public UDPPayloadHandler {
+
+		private:
+			SocketResourceRegistry* m_registry;
+			uint64_t m_owner;
+			TCPSocket* m_tcp_socket = nullptr;
+			UDPSocket* m_udp_socket = nullptr;
+
+			bool m_listening = false;
+			bool m_connected = false;
+			bool m_closed = false;
+
+			common::Spinlock m_lock;
+			uint8_t* m_receive_buffer = nullptr;
+			uint32_t m_receive_start = 0;
+			uint32_t m_received = 0;
+
+			common::Vector<common::buffer_t*> m_datagrams;
+			common::Vector<SocketResource*> m_backlog;
+
+			int read_stream(uint8_t* buffer, size_t size);
+			int read_datagram(uint8_t* buffer, size_t size);
+			int accept(uint8_t* buffer, size_t size);
+
+		public:
+			SocketResource(const string& name, size_t flags, processes::resource_type_t type, uint64_t owner);
+			~SocketResource() final;
+
+			[[nodiscard]] uint64_t owner() const;
+
+			void attach(SocketResourceRegistry* registry, TCPSocket* socket, bool listening);
+			void attach(SocketResourceRegistry* registry, UDPSocket* socket, bool listening);
+
+			void close(size_t flags) final;
+			int read(void* buffer, size_t size, size_t flags) final;
+			int write(const void* buffer, size_t size, size_t flags) final;
+			size_t poll(size_t events) final;
+
+			void handle_transmission_control_protocol_payload(TCPSocket* socket, uint8_t* data, uint16_t size) final;
+			void connected(TCPSocket* socket) final;
+			void disconnected(TCPSocket* socket) final;
+			void space_available(TCPSocket* socket) final;
+
+			void handle_user_datagram_protocol_message(UDPSocket* socket, uint8_t* data, uint16_t size) final;
+	};
+
+	/**
+	 * @class SocketResourceRegistry
+	 * @brief A resource registry that opens a new socket for each name of the form "tcp:IP:PORT" or "udp:IP:PORT" (an IP of
+	 * 0.0.0.0 listens on the port). Each socket is registered under a unique name that only the process that opened it can
+	 * open again, connections accepted by a listener belong to the process that owns the listener
+	 *
+	 * @note Sockets are created from the network thread as well as syscalls so the registry is guarded by a lock
+	 */
+	class SocketResourceRegistry : processes::BaseResourceRegistry {
+
+		private:
+			TransmissionControlProtocolHandler* m_tcp;
+			UserDatagramProtocolHandler* m_udp;
+
+			common::Spinlock m_lock;
+			uint32_t m_next_id = 1;
+
+			processes::Resource* open_socket(const string& name);
+
+		public:
+			SocketResourceRegistry(TransmissionControlProtocolHandler* tcp, UserDatagramProtocolHandler* udp);
+			~SocketResourceRegistry();
+
+			processes::Resource* get_resource(const string& name) final;
+			bool register_resource(processes::Resource* resource) final;
+			void close_resource(processes::Resource* resource, size_t flags) final;
+
+			SocketResource* accept(TCPSocket* socket, uint64_t owner);
+			void discard(SocketResource* resource);
+	};
+
+}
+
+#endif //MAXOS_NET_SOCKETRESOURCE_H
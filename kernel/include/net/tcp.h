@@ -11,6 +11,8 @@
 
 #include <cstdint>
 #include <net/ipv4.h>
+#include <net/ports.h>
+#include <common/spinlock.h>
 #include <memory/memorymanagement.h>
 
 
@@ -18,6 +20,21 @@ namespace MaxOS::net {
 
 	typedef uint16_t TransmissionControlProtocolPort;   ///< TCP port @todo: Make TCPPort class and do tcp_port_t
 
+	constexpr uint32_t TCP_SEND_BUFFER_SIZE = 65536;            ///< How many bytes can be waiting to be sent or acknowledged per socket
+	constexpr uint32_t TCP_RECEIVE_BUFFER_SIZE = 65536;         ///< How many bytes can be received ahead of a missing segment per socket
+	constexpr uint8_t TCP_WINDOW_SCALE = 2;                     ///< The shift applied to the receive window advertised to the remote end
+	constexpr uint16_t TCP_DEFAULT_MSS = 536;                   ///< The segment size to use if the remote end doesn't say
+	constexpr uint16_t TCP_MAX_MSS = 1460;                      ///< The largest segment this end sends or accepts (an ethernet frame)
+	constexpr uint32_t TCP_INITIAL_WINDOW = 10;                 ///< How many segments can be sent before the first acknowledgement
+	constexpr uint8_t TCP_DUPLICATE_ACK_THRESHOLD = 3;          ///< How many duplicate acknowledgements mean a segment was lost
+	constexpr uint8_t TCP_MAX_OUT_OF_ORDER = 8;                 ///< How many separate ranges of data can be held ahead of a missing segment
+	constexpr uint8_t TCP_MAX_RETRANSMITS = 12;                 ///< How many times a segment is retransmitted before the connection is dropped
+	constexpr uint32_t TCP_INITIAL_RTO = 1000;                  ///< The retransmission timeout (ms) before a round trip time has been measured
+	constexpr uint32_t TCP_MIN_RTO = 200;                       ///< The shortest retransmission timeout (ms)
+	constexpr uint32_t TCP_MAX_RTO = 60000;                     ///< The longest retransmission timeout (ms)
+	constexpr uint32_t TCP_TIME_WAIT = 2000;                    ///< How long (ms) a closed connection waits for stray segments
+	constexpr uint32_t TCP_TIMER_INTERVAL = 50;                 ///< How often (ms) the timer worker checks the connections
+
 	/**
 	 * @enum TCPSocketState
 	 * @brief The state of a TCP socket
@@ -77,10 +94,19 @@ namespace MaxOS::net {
 		uint16_t checksum;                  ///< The checksum of the header
 		uint16_t urgent_ptr;                 ///< Where in the data the urgent data *ends* (if the URG flag is set)
 
-		uint32_t options;                   ///< The options for the TCP packet (MSS, Window Scale, SACK Permitted) @todo: make this a struct
-
 	} tcp_header_t;
 
+	/**
+	 * @enum TCPOption
+	 * @brief The kinds of option that can follow the TCP header
+	 */
+	enum class TCPOption : uint8_t {
+		END = 0,
+		NOP = 1,
+		MAXIMUM_SEGMENT_SIZE = 2,
+		WINDOW_SCALE = 3,
+	};
+
 	/**
 	 * @struct TCPPseudoHeader
 	 * @brief The pseudo header used for TCP checksum calculation
@@ -101,6 +127,18 @@ namespace MaxOS::net {
 	} tcp_pseudo_header_t;
 
 
+	/**
+	 * @struct TCPSequenceRange
+	 * @brief A range of sequence numbers [start, end)
+	 *
+	 * @typedef tcp_sequence_range_t
+	 * @brief Alias for TCPSequenceRange struct
+	 */
+	typedef struct TCPSequenceRange {
+		uint32_t start;         ///< The first sequence number in the range
+		uint32_t end;           ///< The sequence number after the last one in the range
+	} tcp_sequence_range_t;
+
 	// Forward declarations
 	class TCPSocket;
 
@@ -113,7 +151,8 @@ namespace MaxOS::net {
 	enum class TCPPayloadHandlerEvents {
 		CONNECTED,
 		DISCONNECTED,
-		DATA_RECEIVED
+		DATA_RECEIVED,
+		SPACE_AVAILABLE
 	};
 
 	/**
@@ -151,6 +190,17 @@ namespace MaxOS::net {
 			~DisconnectedEvent();
 	};
 
+	/**
+	 * @class SpaceAvailableEvent
+	 * @brief Event for when the remote end has acknowledged data, making room in the send ring of a TCP socket
+	 */
+	class SpaceAvailableEvent : public common::Event<TCPPayloadHandlerEvents> {
+		public:
+			TCPSocket* socket;                      ///< The socket that has room to send
+			explicit SpaceAvailableEvent(TCPSocket* socket);
+			~SpaceAvailableEvent();
+	};
+
 	/**
 	 * @class TCPPayloadHandler
 	 * @brief Handler for TCP payloads
@@ -165,11 +215,20 @@ namespace MaxOS::net {
 			virtual void handle_transmission_control_protocol_payload(TCPSocket* socket, uint8_t* data, uint16_t size);
 			virtual void connected(TCPSocket* socket);
 			virtual void disconnected(TCPSocket* socket);
+			virtual void space_available(TCPSocket* socket);
 	};
 
 	/**
 	 * @class TCPSocket
 	 * @brief A TCP socket. Allows for sending and receiving data over TCP at a port
+	 *
+	 * @details Data written to the socket is kept in a send ring until it is acknowledged so it can be retransmitted, data
+	 * received ahead of a missing segment is kept in a receive ring until the gap is filled. All the state is guarded by the
+	 * lock of the handler.
+	 *
+	 * The receive window is the free space in the receive ring, or less if the handlers limit it with set_receive_space()
+	 * (data they don't have room for isn't acknowledged). Connections accepted by a listener start with its space. The
+	 * socket is freed once it has closed and its user has called disconnect().
 	 */
 	class TCPSocket : public common::EventManager<TCPPayloadHandlerEvents> {
 			friend class TransmissionControlProtocolHandler;
@@ -177,15 +236,71 @@ namespace MaxOS::net {
 			friend class TransmissionControlProtocolPortListener;
 
 		protected:
-			uint16_t remotePort = 0;                    ///< The port on the external device
+			uint16_t remotePort = 0;                    ///< The port on the external device (host order)
 			uint32_t remote_ip = 0;                      ///< The IP address of the external device
-			uint16_t local_port = 0;                     ///< The port on this device
+			uint16_t local_port = 0;                     ///< The port on this device (host order)
 			uint32_t local_ip = 0;                       ///< The IP address of this device
-			uint32_t sequence_number = 0;                ///< The current order number of the data being sent
-			uint32_t acknowledgement_number = 0;         ///< The number used to keep track of what has been received, incremented by 1 each time
+
+			// Send sequence space
+			uint32_t initial_sequence_number = 0;        ///< The sequence number of the SYN sent by this end
+			uint32_t unacknowledged = 0;                 ///< The oldest sequence number not yet acknowledged
+			uint32_t sequence_number = 0;                ///< The next sequence number to send
+			uint32_t highest_sent = 0;                   ///< The sequence number after the last one sent (sequence_number goes back on a timeout)
+			uint32_t send_window = 0;                    ///< How many bytes the remote end will accept (after scaling)
+			uint32_t window_update_sequence = 0;         ///< The sequence number of the segment that last updated the send window
+			uint32_t window_update_acknowledgement = 0;  ///< The acknowledgement number of the segment that last updated the send window
+			uint16_t maximum_segment_size = TCP_DEFAULT_MSS;  ///< The largest segment the remote end accepts
+			uint8_t send_window_scale = 0;               ///< The shift applied to windows advertised by the remote end
+			uint8_t receive_window_scale = 0;            ///< The shift applied to windows advertised by this end
+			bool fin_queued = false;                     ///< Should a FIN be sent once the buffered data is
+			bool fin_sent = false;                       ///< Has the FIN been sent (it takes the sequence number after the buffered data)
+			bool accepted = false;                       ///< Was the socket accepted by a listener (the listener owns the local port)
+
+			// Receive sequence space
+			uint32_t acknowledgement_number = 0;         ///< The next sequence number expected from the remote end
+			tcp_sequence_range_t out_of_order[TCP_MAX_OUT_OF_ORDER] = {};   ///< Data held in the receive ring ahead of acknowledgement_number (sorted)
+			uint8_t out_of_order_count = 0;              ///< How many ranges are held
+
+			// Buffers
+			uint8_t* send_buffer = nullptr;              ///< Ring of data from unacknowledged onwards
+			uint32_t send_buffer_start = 0;              ///< Where in the ring unacknowledged is
+			uint32_t send_buffered = 0;                  ///< How many bytes are in the send ring
+			uint8_t* receive_buffer = nullptr;           ///< Ring of data from acknowledgement_number onwards
+			uint32_t receive_buffer_start = 0;           ///< Where in the ring acknowledgement_number is
+			uint32_t receive_space = UINT32_MAX;         ///< How many more bytes the handlers can take (UINT32_MAX if they don't limit it)
+			uint32_t advertised_edge = 0;                ///< The sequence number after the last one the remote end has been told it can send
+
+			// Congestion control (NewReno)
+			uint32_t congestion_window = 0;              ///< How many bytes can be in flight
+			uint32_t slow_start_threshold = UINT32_MAX;  ///< The window at which slow start gives way to congestion avoidance
+			uint32_t recover = 0;                        ///< highest_sent when fast recovery was entered
+			uint8_t duplicate_acks = 0;                  ///< How many duplicate acknowledgements have been received in a row
+			bool fast_recovery = false;                  ///< Is a lost segment being recovered from
+
+			// Round trip time and retransmission
+			uint32_t smoothed_rtt = 0;                   ///< The smoothed round trip time (ms), 0 until measured
+			uint32_t rtt_variance = 0;                   ///< The round trip time variation (ms)
+			uint32_t retransmission_timeout = TCP_INITIAL_RTO;  ///< How long (ms) to wait for an acknowledgement
+			bool rtt_timing = false;                     ///< Is a segment being timed
+			uint32_t rtt_sequence = 0;                   ///< The acknowledgement that ends the timing
+			uint64_t rtt_start = 0;                      ///< When the timed segment was sent
+			uint64_t retransmit_deadline = 0;            ///< When to retransmit (0 if nothing is outstanding)
+			uint8_t retransmits = 0;                     ///< How many times in a row the retransmission timer has expired without the remote end answering
+			uint64_t time_wait_deadline = 0;             ///< When to close the connection after TIME_WAIT
 
 			TransmissionControlProtocolHandler* transmission_control_protocol_handler;  ///< The TCP handler this socket is using
 			TCPSocketState state;                                                    ///< The state of the socket
+			uint32_t references = 1;                     ///< Who is using the socket: its user, the tables of the handler and events being raised
+			bool released = false;                       ///< Whether its user has given it up with disconnect()
+			common::WaitQueue send_waiters;              ///< Threads waiting to connect or for space in the send ring
+
+			void allocate_buffers();
+			void free_buffers();
+
+			[[nodiscard]] uint32_t flight_size() const;
+			[[nodiscard]] uint32_t receive_window() const;
+			[[nodiscard]] uint16_t advertised_window() const;
+
 		public:
 			explicit TCPSocket(TransmissionControlProtocolHandler* transmission_control_protocol_handler);
 			~TCPSocket();
@@ -195,29 +310,79 @@ namespace MaxOS::net {
 
 			void disconnected();
 			void connected();
+			void space_available();
 
 			bool handle_transmission_control_protocol_payload(uint8_t* data, uint16_t size);
+
+			[[nodiscard]] ConnectionKey connection_key() const;
+			[[nodiscard]] TCPSocketState current_state() const;
+			[[nodiscard]] uint32_t send_space() const;
+
+			void set_receive_space(uint32_t space);
+			void open_receive_window(uint32_t size);
 	};
 
+	/**
+	 * @struct TCPDelivery
+	 * @brief The events a segment caused, raised once the handler lock has been released so handlers can send on the socket
+	 *
+	 * @typedef tcp_delivery_t
+	 * @brief Alias for TCPDelivery struct
+	 */
+	typedef struct TCPDelivery {
+		TCPSocket* socket = nullptr;        ///< The socket the segment was for
+		TCPSocket* listener = nullptr;      ///< The listener that accepted the socket, told instead of the socket when it connects
+		bool connected = false;             ///< Did the connection become established
+		bool disconnected = false;          ///< Did the connection close
+		bool space_available = false;       ///< Was data acknowledged, making room in the send ring
+		uint8_t* data[3] = {};              ///< Data that is now in order (the segment and up to two parts of the receive ring)
+		uint32_t size[3] = {};              ///< The size of each part of the data
+	} tcp_delivery_t;
+
 	/**
 	 * @class TransmissionControlProtocolHandler
 	 * @brief Handles TCP packets and manages TCP sockets
+	 *
+	 * @note Segments should be received in thread context (the poll worker of the NIC) as the handler lock doesn't disable interrupts
 	 */
 	class TransmissionControlProtocolHandler : IPV4PayloadHandler {
 			friend class TCPSocket;
 
 		protected:
 			common::OutputStream* error_messages;                                ///< Where to write error messages
-			common::Vector<TCPSocket*> sockets;         ///< The list of connected sockets
-
-			static TransmissionControlProtocolPort free_ports;                   ///< The next free port to use for new sockets
-			void send_transmission_control_protocol_packet(TCPSocket* socket, const uint8_t* data, uint16_t size, uint16_t flags = 0);
+			common::HashMap<ConnectionKey, TCPSocket*> connections;                 ///< Sockets with a remote end, looked up by their addresses and ports
+			common::HashMap<TransmissionControlProtocolPort, TCPSocket*> listeners; ///< Sockets waiting for a connection, looked up by their local port
+			common::Spinlock m_lock;                                             ///< Guards the tables and the state of every socket
+			common::Vector<common::Pair<InternetProtocolAddress, PacketBuffer*>> m_transmit_queue;  ///< Segments built while the lock was held, sent once it is released
+
+			static PortAllocator ports;                                          ///< The local ports in use
+			void remove_socket(TCPSocket* socket);
+			void release_socket(TCPSocket* socket);
+			void unlock_and_transmit();
+			static void start(TCPSocket* socket);
+
+			void send_segment(TCPSocket* socket, uint32_t sequence, uint32_t size, uint8_t flags);
+			void send_reset(InternetProtocolAddress source_ip, InternetProtocolAddress destination_ip, const tcp_header_t* header, uint32_t size);
+			void output(TCPSocket* socket);
+			void retransmit(TCPSocket* socket);
+
+			void handle_acknowledgement(TCPSocket* socket, const tcp_header_t* header, uint32_t sequence, uint32_t size);
+			void handle_data(TCPSocket* socket, uint32_t sequence, uint8_t* data, uint32_t size, tcp_delivery_t& delivery);
+			void handle_timers(uint64_t now);
+			void enter_time_wait(TCPSocket* socket);
+
+			static void parse_options(TCPSocket* socket, const tcp_header_t* header);
+			static void sample_rtt(TCPSocket* socket, uint32_t rtt);
+			static uint32_t initial_sequence_number(const ConnectionKey& key);
+			static uint64_t now();
+			void deliver(tcp_delivery_t& delivery);
+			static void timer_worker(uint64_t argc, TransmissionControlProtocolHandler** argv);
 
 		public:
 			TransmissionControlProtocolHandler(InternetProtocolHandler* internet_protocol_handler, common::OutputStream* error_messages);
 			~TransmissionControlProtocolHandler();
 
-			bool handle_internet_protocol_payload(net::InternetProtocolAddress source_ip, net::InternetProtocolAddress destination_ip, uint8_t* payload_data, uint32_t size) override;
+			bool handle_internet_protocol_payload(net::InternetProtocolAddress source_ip, net::InternetProtocolAddress destination_ip, PacketBuffer* packet) override;
 
 			TCPSocket* connect(InternetProtocolAddress ip, TransmissionControlProtocolPort port);
 			static TCPSocket* connect(const string& address);
@@ -228,7 +393,6 @@ namespace MaxOS::net {
 			virtual void bind(TCPSocket* socket, TCPPayloadHandler* handler);
 	};
 
-
 }
 
 
@@ -13,6 +13,7 @@
 #include <cstdint>
 #include <common/eventHandler.h>
 #include <net/ipv4.h>
+#include <net/ports.h>
 #include <memory/memorymanagement.h>
 
 
@@ -88,8 +89,8 @@ namespace MaxOS::net {
 		protected:
 			bool listening;                ///< Wether the port is waiting for incoming connections
 
-			uint16_t local_port = 0;         ///< The port on this device
-			uint16_t remote_port = 0;        ///< The port on the remote device
+			uint16_t local_port = 0;         ///< The port on this device (host order)
+			uint16_t remote_port = 0;        ///< The port on the remote device (host order)
 
 			uint32_t local_ip = 0;           ///< The IP of this device
 			uint32_t remote_ip = 0;          ///< The IP of the remote device
@@ -104,6 +105,7 @@ namespace MaxOS::net {
 			virtual void send(uint8_t* data, uint16_t size);
 			virtual void disconnect();
 
+			[[nodiscard]] ConnectionKey connection_key() const;
 	};
 
 	/**
@@ -112,15 +114,16 @@ namespace MaxOS::net {
 	 */
 	class UserDatagramProtocolHandler : IPV4PayloadHandler {
 		protected:
-			common::Vector<UDPSocket*> sockets;    ///< The list of UDP sockets
-			static UserDatagramProtocolPort free_ports;              ///< The next free port number
-			common::OutputStream* errorMessages;                    ///< Where to write error messages
+			common::HashMap<ConnectionKey, UDPSocket*> connections;             ///< Sockets with a remote end, looked up by their addresses and ports
+			common::HashMap<UserDatagramProtocolPort, UDPSocket*> listeners;    ///< Sockets waiting for their first datagram, looked up by their local port
+			static PortAllocator ports;                                         ///< The local ports in use
+			common::OutputStream* errorMessages;                                ///< Where to write error messages
 
 		public:
 			UserDatagramProtocolHandler(InternetProtocolHandler* internet_protocol_handler, common::OutputStream* error_messages);
 			~UserDatagramProtocolHandler();
 
-			bool handle_internet_protocol_payload(net::InternetProtocolAddress source_ip, net::InternetProtocolAddress destination_ip, uint8_t* payload_data, uint32_t size) override;
+			bool handle_internet_protocol_payload(net::InternetProtocolAddress source_ip, net::InternetProtocolAddress destination_ip, PacketBuffer* packet) override;
 
 			UDPSocket* connect(uint32_t ip, uint16_t port);
 			static UDPSocket* connect(const string& address);
@@ -12,6 +12,7 @@
 #include <cstdint>
 #include <cstddef>
 #include <common/vector.h>
+#include <common/hashmap.h>
 #include <common/string.h>
 #include <common/buffer.h>
 #include <common/spinlock.h>
@@ -50,11 +51,13 @@ namespace MaxOS::processes {
 	/**
 	 * @class SharedMessageEndpoint
 	 * @brief A endpoint that allows processes to queue messages on
+	 *
+	 * @details Each message remembers the process that wrote it so the kernel can check who a request came from
 	 */
 	class SharedMessageEndpoint final : public Resource {
 
 		private:
-			common::Vector<common::buffer_t*> m_queue { };
+			common::Vector<common::Pair<uint64_t, common::buffer_t*>> m_queue { };
 			common::Spinlock m_message_lock;
 
 		public:
@@ -62,7 +65,29 @@ namespace MaxOS::processes {
 			~SharedMessageEndpoint() final;
 
 			int read(void* buffer, size_t size, size_t flags) final;
+			int read_message(void* buffer, size_t size, uint64_t& sender);
 			int write(const void* buffer, size_t size, size_t flags) final;
+
+			size_t poll(size_t events) final;
+	};
+
+	/**
+	 * @class FutexManager
+	 * @brief Sleeps threads on a 32 bit word of user memory until another thread wakes them
+	 *
+	 * @note Waiters are keyed by the physical address of the word so that processes sharing memory can wait on each other
+	 */
+	class FutexManager {
+
+		private:
+			inline static common::Spinlock s_lock;
+			inline static common::HashMap<uintptr_t, common::WaitQueue*> s_waiters;
+
+			static uintptr_t physical_key(uintptr_t address);
+
+		public:
+			static bool wait(uintptr_t address, uint32_t expected);
+			static size_t wake(uintptr_t address, size_t count);
 	};
 }
 
@@ -63,6 +63,7 @@ namespace MaxOS::processes {
 
 			uint64_t tid;                             ///< The thread ID
 			uint64_t parent_pid;                      ///< The parent process ID
+			Process* parent = nullptr;                ///< The parent process (owns this thread so outlives it)
 
 			system::cpu_status_t execution_state;     ///< The CPU state of the thread
 			thread_state_t thread_state;              ///< The current state of the thread
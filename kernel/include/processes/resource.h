@@ -11,9 +11,11 @@
 
 #include <cstddef>
 #include <common/map.h>
+#include <common/hashmap.h>
 #include <common/vector.h>
 #include <common/string.h>
 #include <common/logger.h>
+#include <common/spinlock.h>
 #include <syscalls.h>
 
 
@@ -21,10 +23,14 @@ namespace MaxOS::processes {
 
 	typedef ::syscore::ResourceType resource_type_t;                    ///< Alias to make the libsyscore ResourceType accessible here
 	typedef ::syscore::ResourceErrorBase resource_error_base_t;         ///< Alias to make the libsyscore ResourceErrorBase accessible here
+	typedef ::syscore::ResourceReadiness resource_readiness_t;          ///< Alias to make the libsyscore ResourceReadiness accessible here
+	typedef ::syscore::ResourcePollEntry resource_poll_entry_t;         ///< Alias to make the libsyscore ResourcePollEntry accessible here
 
 	/**
 	 * @class Resource
 	 * @brief Represents a generic resource that can be opened, closed, read from and written to
+	 *
+	 * @details Threads polling resources sleep until one of them calls readiness_changed() (or their time runs out)
 	 */
 	class Resource {
 
@@ -32,6 +38,10 @@ namespace MaxOS::processes {
 			string m_name;
 			resource_type_t m_type;
 
+			inline static common::Spinlock s_poll_lock;
+			inline static common::WaitQueue s_poll_waiters;
+			inline static uint64_t s_poll_generation = 0;
+
 		public:
 
 			Resource(const string& name, size_t flags, resource_type_t type);
@@ -45,6 +55,12 @@ namespace MaxOS::processes {
 
 			virtual int read(void* buffer, size_t size, size_t flags);
 			virtual int write(const void* buffer, size_t size, size_t flags);
+
+			virtual size_t poll(size_t events);
+
+			static uint64_t poll_generation();
+			static bool wait_for_change(uint64_t generation, uint64_t milliseconds);
+			static void readiness_changed();
 	};
 
 	/**
@@ -134,16 +150,57 @@ namespace MaxOS::processes {
 			static void remove_registry(BaseResourceRegistry* registry);
 	};
 
+	/// How many of the low bits of a handle hold the index into the handle table, the rest hold the generation
+	constexpr uint8_t RESOURCE_HANDLE_INDEX_BITS = 32;
+
+	/**
+	 * @struct ResourceHandleSlot
+	 * @brief An entry in a process's handle table
+	 *
+	 * @typedef resource_handle_slot_t
+	 * @brief Alias for ResourceHandleSlot struct
+	 */
+	typedef struct ResourceHandleSlot {
+
+		Resource* resource = nullptr;           ///< The resource open in this slot or nullptr if the slot is free
+		uint32_t generation = 1;                ///< Bumped each time the slot is freed so that stale handles no longer match
+		uint32_t next_free = 0;                 ///< The index of the next free slot when this slot is on the free list (0 = end)
+
+	} resource_handle_slot_t;
+
+	/**
+	 * @struct ResourceNameEntry
+	 * @brief An entry in the name index of a process's handle table
+	 *
+	 * @typedef resource_name_entry_t
+	 * @brief Alias for ResourceNameEntry struct
+	 */
+	typedef struct ResourceNameEntry {
+
+		uint64_t handle = 0;                    ///< A handle that has the resource with this name open
+		uint32_t count = 0;                     ///< How many handles have a resource with this name open
+
+	} resource_name_entry_t;
+
 	/**
 	 * @class ResourceManager
 	 * @brief Manages the open resources for a process
+	 *
+	 * @note Handles are (generation << 32) | index into a dense table, slot 0 is reserved so that 0 stays the invalid handle
 	 */
 	class ResourceManager {
 
 		private:
-			common::Map<uint64_t, Resource*> m_resources;
+			common::Vector<resource_handle_slot_t> m_handles;
+			uint32_t m_free_head = 0;
+
+			common::HashMap<string, resource_name_entry_t> m_name_index;
+
+			static uint64_t make_handle(uint32_t index, uint32_t generation);
+			resource_handle_slot_t* lookup(uint64_t handle) const;
 
-			uint64_t m_next_handle = 1;
+			void index_name(const string& name, uint64_t handle);
+			void unindex_name(const string& name, uint64_t handle);
 
 		public:
 			ResourceManager();
@@ -154,8 +211,8 @@ namespace MaxOS::processes {
 			uint64_t open_resource(resource_type_t type, const string& name, size_t flags);
 			void close_resource(uint64_t handle, size_t flags);
 
-			Resource* get_resource(uint64_t handle);
-			Resource* get_resource(const string& name);
+			Resource* get_resource(uint64_t handle) const;
+			Resource* get_resource(const string& name) const;
 	};
 }
 
@@ -50,6 +50,7 @@ namespace MaxOS::processes {
 
 			system::cpu_status_t* handle_interrupt(system::cpu_status_t* status) final;
 			static system::cpu_status_t* yield(system::cpu_status_t* current);
+			static void sleep(size_t milliseconds);
 
 			static void activate();
 			static void deactivate();
@@ -58,7 +59,7 @@ namespace MaxOS::processes {
 			void balance();
 
 			static void load_multiboot_elfs(system::Multiboot* multiboot);
-			static void print_running_header();
+			static void print_running_header(common::OutputStream& stream);
 
 			uint64_t add_process(Process* process);
 			uint64_t add_thread(Thread* thread);
@@ -204,6 +204,11 @@ namespace MaxOS::system {
 	/// The size of the stack allocated for booting a core (should align with the startup assembly code for the kernel)
 	constexpr size_t BOOT_STACK_SIZE = 16384;
 
+	constexpr uint32_t PAT_MSR = 0x277;     ///< The MSR holding the Page Attribute Table
+
+	/// The memory type of each PAT entry (a page selects one with its PAT, cache disabled and write through bits): WB, WC, UC-, UC, WB, WP, UC-, WT
+	constexpr uint64_t PAT_LAYOUT = 0x0407050600070106;
+
 	class CPU;
 
 	/**
@@ -226,6 +231,7 @@ namespace MaxOS::system {
 
 			void init_tss();
 			void init_sse();
+			void init_pat();
 
 		public:
 			explicit Core(hardwarecommunication::madt_processor_apic_t* madt_item);
@@ -280,6 +286,7 @@ namespace MaxOS::system {
 
 			static uint64_t read_msr(uint32_t msr);
 			static void write_msr(uint32_t msr, uint64_t value);
+			static uint64_t read_timestamp();
 
 			static void cpuid(uint32_t leaf, uint32_t* eax, uint32_t* ebx, uint32_t* ecx, uint32_t* edx);
 			static bool check_cpu_feature(CPU_FEATURE_ECX feature);
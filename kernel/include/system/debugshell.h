@@ -0,0 +1,50 @@
+/**
+ * @file debugshell.h
+ * @brief Defines a DebugShell class for inspecting the kernel over the serial port
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+ */
+
+#ifndef MAXOS_SYSTEM_DEBUGSHELL_H
+#define MAXOS_SYSTEM_DEBUGSHELL_H
+
+#include <cstdint>
+#include <drivers/console/serial.h>
+
+namespace MaxOS::system {
+
+	constexpr uint32_t DEBUG_SHELL_POLL_INTERVAL = 50;     ///< How many milliseconds the shell sleeps between checking for input
+	constexpr uint8_t DEBUG_SHELL_LINE_MAX = 128;          ///< How many characters a command can be
+
+	/**
+	 * @class DebugShell
+	 * @brief A line based shell on the serial port for looking at the state of the running kernel
+	 *
+	 * @details Input is queued by the serial interrupt and read by a kernel thread, so commands never run in interrupt
+	 * context and can take locks like any other thread.
+	 */
+	class DebugShell {
+
+		private:
+			drivers::SerialConsole* m_serial;
+
+			char m_line[DEBUG_SHELL_LINE_MAX] = { };
+			uint8_t m_length = 0;
+
+			void prompt();
+			void receive(char c);
+			void run(const char* command);
+
+			static void worker(uint64_t argc, DebugShell** argv);
+
+		public:
+			explicit DebugShell(drivers::SerialConsole* serial);
+			~DebugShell();
+
+			void poll();
+	};
+
+}
+
+#endif //MAXOS_SYSTEM_DEBUGSHELL_H
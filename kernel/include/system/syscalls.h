@@ -80,9 +80,12 @@ namespace MaxOS::system {
 			static syscall_args_t* syscall_resource_close(syscall_args_t* args);
 			static syscall_args_t* syscall_resource_write(syscall_args_t* args);
 			static syscall_args_t* syscall_resource_read(syscall_args_t* args);
+			static syscall_args_t* syscall_resource_poll(syscall_args_t* args);
 			static syscall_args_t* syscall_thread_yield(syscall_args_t* args);
 			static syscall_args_t* syscall_thread_sleep(syscall_args_t* args);
 			static syscall_args_t* syscall_thread_close(syscall_args_t* args);
+			static syscall_args_t* syscall_futex_wait(syscall_args_t* args);
+			static syscall_args_t* syscall_futex_wake(syscall_args_t* args);
 	};
 }
 
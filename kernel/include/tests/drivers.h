@@ -0,0 +1,18 @@
+/**
+ * @file drivers.h
+ * @brief Defines the tests for the device drivers of MaxOS
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+*/
+
+#ifndef MAXOS_TESTS_DRIVERS_H
+#define MAXOS_TESTS_DRIVERS_H
+
+#include <tests/test.h>
+
+namespace MaxOS::tests {
+	void register_tests_drivers();
+}
+
+#endif //MAXOS_TESTS_DRIVERS_H
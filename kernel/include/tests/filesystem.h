@@ -0,0 +1,18 @@
+/**
+ * @file filesystem.h
+ * @brief Defines the tests for the filesystems of MaxOS
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+*/
+
+#ifndef MAXOS_TESTS_FILESYSTEM_H
+#define MAXOS_TESTS_FILESYSTEM_H
+
+#include <tests/test.h>
+
+namespace MaxOS::tests {
+	void register_tests_filesystem();
+}
+
+#endif //MAXOS_TESTS_FILESYSTEM_H
@@ -0,0 +1,18 @@
+/**
+ * @file gui.h
+ * @brief Defines the tests for the graphics and GUI components of MaxOS
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+*/
+
+#ifndef MAXOS_TESTS_GUI_H
+#define MAXOS_TESTS_GUI_H
+
+#include <tests/test.h>
+
+namespace MaxOS::tests {
+	void register_tests_gui();
+}
+
+#endif //MAXOS_TESTS_GUI_H
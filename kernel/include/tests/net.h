@@ -0,0 +1,18 @@
+/**
+ * @file net.h
+ * @brief Defines the tests for the network stack of MaxOS
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+*/
+
+#ifndef MAXOS_TESTS_NET_H
+#define MAXOS_TESTS_NET_H
+
+#include <tests/test.h>
+
+namespace MaxOS::tests {
+	void register_tests_net();
+}
+
+#endif //MAXOS_TESTS_NET_H
@@ -0,0 +1,18 @@
+/**
+ * @file processes.h
+ * @brief Defines the tests for the process management of MaxOS
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+*/
+
+#ifndef MAXOS_TESTS_PROCESSES_H
+#define MAXOS_TESTS_PROCESSES_H
+
+#include <tests/test.h>
+
+namespace MaxOS::tests {
+	void register_tests_processes();
+}
+
+#endif //MAXOS_TESTS_PROCESSES_H
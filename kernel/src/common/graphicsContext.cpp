@@ -7,9 +7,103 @@
  */
 
 #include <common/graphicsContext.h>
+#include <memory/memoryIO.h>
 
 using namespace MaxOS::common;
 
+/// Rows of the plus sign drawn as the mouse cursor, bit n set if the pixel n across is part of the cursor
+static const uint8_t CURSOR_SHAPE[CURSOR_SIZE] = { 0x08, 0x08, 0x08, 0x7F, 0x08, 0x08, 0x08 };
+
+/// Rows in the back buffer aren't always 8 byte aligned
+typedef uint64_t __attribute__((may_alias, aligned(1))) unaligned_uint64_t;
+
+/**
+ * @brief Copies memory to the framebuffer with non-temporal stores, so the copy doesn't evict the cache and combines into
+ * full bus writes
+ *
+ * @param destination Where to copy to (in the framebuffer)
+ * @param source Where to copy from
+ * @param bytes The number of bytes to copy
+ *
+ * @note An sfence is needed before the stores are guaranteed to be visible
+ */
+static void stream_copy(uint8_t* destination, const uint8_t* source, size_t bytes) {
+
+	// Align the destination so each store is a whole quadword
+	for(; bytes && ((uintptr_t) destination & 7); --bytes)
+		*destination++ = *source++;
+
+	for(; bytes >= 8; bytes -= 8, destination += 8, source += 8)
+		asm volatile("movnti %1, (%0)" : : "r"(destination), "r"(*(const unaligned_uint64_t*) source) : "memory");
+
+	for(; bytes; --bytes)
+		*destination++ = *source++;
+}
+
+/**
+ * @brief Fills a run of pixels in a row of the framebuffer with one colour
+ *
+ * @tparam Depth The color depth in bits per pixel
+ * @param destination The address of the first pixel
+ * @param count The number of pixels to fill
+ * @param colour The colour, already in the format of the color depth
+ *
+ * @note The kernel is built without SSE so string stores are the widest stores available
+ */
+template<uint32_t Depth> static void fill_span_depth(uint8_t* destination, uint32_t count, uint32_t colour) {
+
+	if constexpr (Depth == 32)
+		asm volatile("rep stosl" : "+D"(destination), "+c"(count) : "a"(colour) : "memory");
+
+	else if constexpr (Depth == 16)
+		asm volatile("rep stosw" : "+D"(destination), "+c"(count) : "a"((uint16_t) colour) : "memory");
+
+	else if constexpr (Depth == 8)
+		asm volatile("rep stosb" : "+D"(destination), "+c"(count) : "a"((uint8_t) colour) : "memory");
+
+	// No store is 3 bytes wide
+	else {
+		for(uint32_t i = 0; i < count; ++i, destination += 3) {
+			destination[0] = colour;
+			destination[1] = colour >> 8;
+			destination[2] = colour >> 16;
+		}
+	}
+}
+
+/**
+ * @brief Copies a run of pixels into a row of the framebuffer
+ *
+ * @tparam Depth The color depth in bits per pixel
+ * @param destination The address of the first pixel
+ * @param source The pixels, one per uint32_t already in the format of the color depth
+ * @param count The number of pixels to copy
+ */
+template<uint32_t Depth> static void blit_span_depth(uint8_t* destination, const uint32_t* source, uint32_t count) {
+
+	if constexpr (Depth == 32)
+		asm volatile("rep movsl" : "+D"(destination), "+S"(source), "+c"(count) : : "memory");
+
+	else if constexpr (Depth == 16) {
+		auto* pixels = (uint16_t*) destination;
+		for(uint32_t i = 0; i < count; ++i)
+			pixels[i] = source[i];
+	}
+
+	else if constexpr (Depth == 8) {
+		for(uint32_t i = 0; i < count; ++i)
+			destination[i] = source[i];
+	}
+
+	else {
+		for(uint32_t i = 0; i < count; ++i, destination += 3) {
+			destination[0] = source[i];
+			destination[1] = source[i] >> 8;
+			destination[2] = source[i] >> 16;
+		}
+	}
+}
+
 
 /**
  * @brief Constructs a GraphicsContext object and initializes the color palette
@@ -95,7 +189,14 @@ GraphicsContext::GraphicsContext() {
 
 }
 
-GraphicsContext::~GraphicsContext() = default;
+/**
+ * @brief Destroys the GraphicsContext, freeing the back buffer if there is one
+ */
+GraphicsContext::~GraphicsContext() {
+
+	if(m_front_buffer)
+		delete[] (uint8_t*) m_framebuffer_address;
+}
 
 /**
  * @brief Renders a pixel to the screen based on the current color depth
@@ -474,47 +575,14 @@ void GraphicsContext::draw_line(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t
 
 	// Vertical line
 	if(x1 == x0) {
-		// Force the line to be within the screen
-		if(y_min < 0) y_min = 0;
-		if(y_max >= m_height)
-			y_max = m_height - 1;
-
-		// Mirror the Y axis as directly calling put_pixel will not do this
-		if(mirror_y_axis) {
-			int32_t temp = y_max;
-			y_max = m_height - y_min - 1;
-			y_min = m_height - temp - 1;
-		}
-
-		// Check that the line is within the screen
-		if(0 > x0 || x0 >= m_width) {
-			return;
-		}
-
-		// Draw the line
-		for(int32_t y = y_min; y <= y_max; ++y)
-			put_pixel(x0, y, colour);
-
+		fill_rect((int32_t) x0, y_min, 1, y_max - y_min + 1, colour);
 		return;
 	}
 
 	// Horizontal line
 	if(y1 == y0) {
-		// Ensure the line is within the screen
-		if(x0 < 0) x0 = 0;
-		if(x1 >= m_width) x1 = m_width - 1;
-
-		// Mirror the Y axis as directly calling put_pixel will not do this
-		if(mirror_y_axis)
-			y0 = m_height - y0 - 1;
-
-		// Check that the line is within the screen
-		if(0 > y0 || y0 >= m_height)
-			return;
-
-		// Draw the line
-		for(int32_t x = x0; x <= x1; ++x)
-			put_pixel(x, y0, colour);
+		fill_span((int32_t) x0, (int32_t) y0, (int32_t) x1 - (int32_t) x0 + 1, colour);
+		return;
 	}
 
 	// If the line is not horizontal or vertical then it must be a diagonal line
@@ -601,39 +669,13 @@ void GraphicsContext::fill_rectangle(uint32_t x0, uint32_t y0, uint32_t x1, uint
  */
 void GraphicsContext::fill_rectangle(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, uint32_t colour) {
 
-	// Draw from left to right
-	if(y1 < y0) {
-		fill_rectangle(x1, y1, x0, y0, colour);
-		return;
-	}
-
-	// Make sure the rectangle is within the height of the screen
-	if(y0 < 0) y0 = 0;
-	if(y1 > m_height) y1 = m_height;
-
-	// Make sure the rectangle is within the width of the screen
-	bool x_0_is_smaller = x0 < x1;
-	int32_t x_min = x_0_is_smaller ? x0 : x1;
-	int32_t x_max = x_0_is_smaller ? x1 : x0;
-
-	if(x_min < 0) x_min = 0;
-	if(x_max > m_width)
-		x_max = m_width;
-
-	// Mirror the Y axis as directly calling put_pixel will not do this
-	if(mirror_y_axis) {
-		int32_t temp = y1;
-		y1 = m_height - y0 - 1;
-		y0 = m_height - temp - 1;
-	}
-
-	// Draw the rectangle
-	for(int32_t y = y0; y < y1; ++y) {
-		for(int32_t x = x_min; x < x_max; ++x) {
-			put_pixel(x, y, colour);
-		}
-	}
+	// The corners can be given in any order
+	int32_t left = (int32_t) x0 < (int32_t) x1 ? x0 : x1;
+	int32_t right = (int32_t) x0 < (int32_t) x1 ? x1 : x0;
+	int32_t top = (int32_t) y0 < (int32_t) y1 ? y0 : y1;
+	int32_t bottom = (int32_t) y0 < (int32_t) y1 ? y1 : y0;
 
+	fill_rect(left, top, right - left, bottom - top, colour);
 }
 
 /**
@@ -740,3 +782,359 @@ void GraphicsContext::fill_circle(uint32_t x0, uint32_t y0, uint32_t radius, uin
 uint64_t* GraphicsContext::framebuffer_address() {
 	return m_framebuffer_address;
 }
+
+/**
+ * @brief Picks the row functions for the current color depth, called whenever the mode or framebuffer changes
+ */
+void GraphicsContext::select_span_functions() {
+
+	m_fill_span = nullptr;
+	m_blit_span = nullptr;
+
+	// Rows can only be written directly to a linear framebuffer
+	if(!m_framebuffer_address || !m_pitch)
+		return;
+
+	switch(m_color_depth) {
+		case 8:
+			m_fill_span = fill_span_depth<8>;
+			m_blit_span = blit_span_depth<8>;
+			break;
+		case 16:
+			m_fill_span = fill_span_depth<16>;
+			m_blit_span = blit_span_depth<16>;
+			break;
+		case 24:
+			m_fill_span = fill_span_depth<24>;
+			m_blit_span = blit_span_depth<24>;
+			break;
+		case 32:
+			m_fill_span = fill_span_depth<32>;
+			m_blit_span = blit_span_depth<32>;
+			break;
+	}
+}
+
+/**
+ * @brief Gets the address of a row in the framebuffer, resolving the mirroring of the y axis
+ *
+ * @param y The y coordinate of the row
+ * @param row_step Set to the number of bytes to add to move to the next row down the screen
+ * @return The address of the first pixel in the row
+ */
+uint8_t* GraphicsContext::row_address(int32_t y, int32_t& row_step) {
+
+	auto* framebuffer = (uint8_t*) m_framebuffer_address;
+
+	if(mirror_y_axis) {
+		row_step = -(int32_t) m_pitch;
+		return framebuffer + (uint64_t) m_pitch * (m_height - y - 1);
+	}
+
+	row_step = (int32_t) m_pitch;
+	return framebuffer + (uint64_t) m_pitch * y;
+}
+
+/**
+ * @brief Clips a rectangle to the screen
+ *
+ * @param x The x coordinate of the rectangle, moved onto the screen
+ * @param y The y coordinate of the rectangle, moved onto the screen
+ * @param width The width of the rectangle, shrunk to fit on the screen
+ * @param height The height of the rectangle, shrunk to fit on the screen
+ * @return True if any of the rectangle is on the screen
+ */
+bool GraphicsContext::clip(int32_t& x, int32_t& y, int32_t& width, int32_t& height) const {
+
+	if(x < 0) {
+		width += x;
+		x = 0;
+	}
+
+	if(y < 0) {
+		height += y;
+		y = 0;
+	}
+
+	if(x + width > (int32_t) m_width)
+		width = (int32_t) m_width - x;
+
+	if(y + height > (int32_t) m_height)
+		height = (int32_t) m_height - y;
+
+	return width > 0 && height > 0;
+}
+
+/**
+ * @brief Draws a horizontal run of pixels
+ *
+ * @param x The x coordinate of the first pixel
+ * @param y The y coordinate of the run
+ * @param length The number of pixels
+ * @param colour The colour of the run
+ */
+void GraphicsContext::fill_span(int32_t x, int32_t y, int32_t length, const Colour& colour) {
+	fill_rect(x, y, length, 1, colour_to_int(colour));
+}
+
+/**
+ * @brief Draws a horizontal run of pixels
+ *
+ * @param x The x coordinate of the first pixel
+ * @param y The y coordinate of the run
+ * @param length The number of pixels
+ * @param colour The colour of the run
+ */
+void GraphicsContext::fill_span(int32_t x, int32_t y, int32_t length, uint32_t colour) {
+	fill_rect(x, y, length, 1, colour);
+}
+
+/**
+ * @brief Fills a rectangle a row at a time
+ *
+ * @param x The x coordinate of the top left corner
+ * @param y The y coordinate of the top left corner
+ * @param width The width of the rectangle
+ * @param height The height of the rectangle
+ * @param colour The colour of the rectangle
+ */
+void GraphicsContext::fill_rect(int32_t x, int32_t y, int32_t width, int32_t height, const Colour& colour) {
+	fill_rect(x, y, width, height, colour_to_int(colour));
+}
+
+/**
+ * @brief Fills a rectangle a row at a time
+ *
+ * @param x The x coordinate of the top left corner
+ * @param y The y coordinate of the top left corner
+ * @param width The width of the rectangle
+ * @param height The height of the rectangle
+ * @param colour The colour of the rectangle
+ */
+void GraphicsContext::fill_rect(int32_t x, int32_t y, int32_t width, int32_t height, uint32_t colour) {
+
+	if(!clip(x, y, width, height))
+		return;
+
+	// Without a linear framebuffer (e.g. VGA) each pixel has to go through the driver
+	if(!m_fill_span) {
+		for(int32_t row = y; row < y + height; ++row)
+			for(int32_t column = x; column < x + width; ++column)
+				render_pixel(column, mirror_y_axis ? m_height - row - 1 : row, colour);
+		return;
+	}
+
+	int32_t row_step;
+	uint8_t* row = row_address(y, row_step) + x * (m_color_depth / 8);
+	for(int32_t i = 0; i < height; ++i, row += row_step)
+		m_fill_span(row, width, colour);
+}
+
+/**
+ * @brief Copies a rectangle of pixels onto the screen
+ *
+ * @param x The x coordinate to draw the top left pixel at
+ * @param y The y coordinate to draw the top left pixel at
+ * @param pixels The pixels, one per uint32_t already converted with colour_to_int()
+ * @param width The width of the rectangle
+ * @param height The height of the rectangle
+ * @param stride The number of pixels between the start of each row of the source
+ */
+void GraphicsContext::blit(int32_t x, int32_t y, const uint32_t* pixels, int32_t width, int32_t height, int32_t stride) {
+
+	// Skip the part of the source that is off the screen
+	int32_t left = x;
+	int32_t top = y;
+	if(!clip(x, y, width, height))
+		return;
+	pixels += (y - top) * stride + (x - left);
+
+	if(!m_blit_span) {
+		for(int32_t row = 0; row < height; ++row, pixels += stride)
+			for(int32_t column = 0; column < width; ++column)
+				render_pixel(x + column, mirror_y_axis ? m_height - (y + row) - 1 : y + row, pixels[column]);
+		return;
+	}
+
+	int32_t row_step;
+	uint8_t* row = row_address(y, row_step) + x * (m_color_depth / 8);
+	for(int32_t i = 0; i < height; ++i, row += row_step, pixels += stride)
+		m_blit_span(row, pixels, width);
+}
+
+/**
+ * @brief Moves a rectangle of pixels already on the screen, the source and destination can overlap (e.g. when scrolling)
+ *
+ * @param source_x The x coordinate of the top left corner to copy from
+ * @param source_y The y coordinate of the top left corner to copy from
+ * @param width The width of the rectangle
+ * @param height The height of the rectangle
+ * @param destination_x The x coordinate of the top left corner to copy to
+ * @param destination_y The y coordinate of the top left corner to copy to
+ */
+void GraphicsContext::copy_rect(int32_t source_x, int32_t source_y, int32_t width, int32_t height, int32_t destination_x, int32_t destination_y) {
+
+	// Clip the source then the destination, moving the other by the same amount
+	int32_t x = source_x;
+	int32_t y = source_y;
+	if(!clip(source_x, source_y, width, height))
+		return;
+	destination_x += source_x - x;
+	destination_y += source_y - y;
+
+	x = destination_x;
+	y = destination_y;
+	if(!clip(destination_x, destination_y, width, height))
+		return;
+	source_x += destination_x - x;
+	source_y += destination_y - y;
+
+	// Copy from the bottom up when moving down so rows aren't overwritten before they are read
+	bool upwards = destination_y > source_y;
+	int32_t first = upwards ? height - 1 : 0;
+	int32_t step = upwards ? -1 : 1;
+
+	if(!m_fill_span) {
+		bool backwards = destination_x > source_x;
+		for(int32_t i = 0, row = first; i < height; ++i, row += step) {
+			uint32_t from = mirror_y_axis ? m_height - (source_y + row) - 1 : source_y + row;
+			uint32_t to = mirror_y_axis ? m_height - (destination_y + row) - 1 : destination_y + row;
+			for(int32_t j = 0, column = backwards ? width - 1 : 0; j < width; ++j, column += backwards ? -1 : 1)
+				render_pixel(destination_x + column, to, get_rendered_pixel(source_x + column, from));
+		}
+		return;
+	}
+
+	uint32_t bytes_per_pixel = m_color_depth / 8;
+	int32_t row_step;
+	uint8_t* source = row_address(source_y + first, row_step) + source_x * bytes_per_pixel;
+	uint8_t* destination = row_address(destination_y + first, row_step) + destination_x * bytes_per_pixel;
+	row_step *= step;
+
+	for(int32_t i = 0; i < height; ++i, source += row_step, destination += row_step)
+		memmove(destination, source, (uint64_t) width * bytes_per_pixel);
+}
+
+/**
+ * @brief Draws into a copy of the framebuffer in system memory from now on, which is cached and fast to read back. Changes
+ * only reach the screen when they are presented.
+ *
+ * @return True if the back buffer is in use, false if the framebuffer can't be written to directly
+ */
+bool GraphicsContext::enable_back_buffer() {
+
+	if(m_front_buffer)
+		return true;
+
+	if(!m_framebuffer_address || !m_pitch)
+		return false;
+
+	size_t size = (size_t) m_pitch * m_height;
+	auto* back_buffer = new uint8_t[size];
+	if(!back_buffer)
+		return false;
+
+	// Start from what is already on the screen
+	memcpy(back_buffer, m_framebuffer_address, size);
+	m_front_buffer = m_framebuffer_address;
+	m_framebuffer_address = (uint64_t*) back_buffer;
+	return true;
+}
+
+/**
+ * @brief Checks if drawing goes to a back buffer that has to be presented
+ *
+ * @return True if there is a back buffer
+ */
+bool GraphicsContext::has_back_buffer() const {
+	return m_front_buffer != nullptr;
+}
+
+/**
+ * @brief Copies an area of the back buffer to the screen, drawing the cursor on top as it goes
+ *
+ * @param x The x coordinate of the top left corner
+ * @param y The y coordinate of the top left corner
+ * @param width The width of the area
+ * @param height The height of the area
+ */
+void GraphicsContext::present(int32_t x, int32_t y, int32_t width, int32_t height) {
+
+	if(!m_front_buffer || !clip(x, y, width, height))
+		return;
+
+	// The front buffer has the same layout so the rows are at the same offsets
+	int32_t row_step;
+	uint8_t* source = row_address(y, row_step) + x * (m_color_depth / 8);
+	uint8_t* destination = (uint8_t*) m_front_buffer + (source - (uint8_t*) m_framebuffer_address);
+
+	for(int32_t row = y; row < y + height; ++row, source += row_step, destination += row_step)
+		present_row(destination, source, x, row, width);
+
+	asm volatile("sfence" : : : "memory");
+}
+
+/**
+ * @brief Copies part of a row of the back buffer to the screen, inverting the pixels under the cursor
+ *
+ * @param destination The address of the first pixel on the screen
+ * @param source The address of the first pixel in the back buffer
+ * @param x The x coordinate of the first pixel
+ * @param y The y coordinate of the row
+ * @param width The number of pixels to copy
+ */
+void GraphicsContext::present_row(uint8_t* destination, const uint8_t* source, int32_t x, int32_t y, int32_t width) {
+
+	uint32_t bytes_per_pixel = m_color_depth / 8;
+	int32_t cursor_left = m_cursor_x - CURSOR_SIZE / 2;
+	int32_t cursor_row = y - (m_cursor_y - CURSOR_SIZE / 2);
+
+	// Find the part of the row the cursor covers
+	int32_t start = x > cursor_left ? x : cursor_left;
+	int32_t end = x + width < cursor_left + CURSOR_SIZE ? x + width : cursor_left + CURSOR_SIZE;
+	if(!m_cursor_visible || cursor_row < 0 || cursor_row >= CURSOR_SIZE || start >= end) {
+		stream_copy(destination, source, width * bytes_per_pixel);
+		return;
+	}
+
+	// Invert the pixels of the cursor in a copy of the covered part
+	uint8_t composed[CURSOR_SIZE * sizeof(uint32_t)];
+	uint32_t before = (start - x) * bytes_per_pixel;
+	uint32_t covered = (end - start) * bytes_per_pixel;
+	memcpy(composed, source + before, covered);
+
+	for(int32_t column = start; column < end; ++column) {
+		if(!(CURSOR_SHAPE[cursor_row] & (1 << (column - cursor_left))))
+			continue;
+
+		uint8_t* pixel = composed + (column - start) * bytes_per_pixel;
+		uint32_t value = 0;
+		memcpy(&value, pixel, bytes_per_pixel);
+
+		Colour colour = int_to_colour(value);
+		colour.red = 255 - colour.red;
+		colour.green = 255 - colour.green;
+		colour.blue = 255 - colour.blue;
+
+		value = colour_to_int(colour);
+		memcpy(pixel, &value, bytes_per_pixel);
+	}
+
+	// Copy the row around it
+	stream_copy(destination, source, before);
+	stream_copy(destination + before, composed, covered);
+	stream_copy(destination + before + covered, source + before + covered, width * bytes_per_pixel - before - covered);
+}
+
+/**
+ * @brief Moves the cursor drawn when the back buffer is presented, the areas it covered before and after need presenting
+ *
+ * @param x The x coordinate of the centre of the cursor
+ * @param y The y coordinate of the centre of the cursor
+ */
+void GraphicsContext::move_cursor(int32_t x, int32_t y) {
+
+	m_cursor_x = x;
+	m_cursor_y = y;
+	m_cursor_visible = true;
+}
@@ -12,12 +12,15 @@
 #include <common/version.h>
 #include <system/cpu.h>
 #include <processes/scheduler.h>
+#include <hardwarecommunication/interrupts.h>
+#include <memory/memoryIO.h>
 
 using namespace MaxOS;
 using namespace MaxOS::common;
 using namespace MaxOS::drivers::console;
 using namespace MaxOS::processes;
 using namespace MaxOS::system;
+using namespace MaxOS::hardwarecommunication;
 
 /**
  * @brief Constructs a Logger object and sets it as the active logger
@@ -85,10 +88,16 @@ void Logger::set_log_level(LogLevel log_level) {
 	// Set the log level
 	m_log_level = log_level;
 
-	// Update the progress bar
+	// Update the progress bar, only drawing it when it has moved
 	if (log_level == LogLevel::INFO) {
-		VESABootConsole::update_progress_bar((m_progress_current * 100) / s_progress_total);
-		m_progress_current++;
+		uint8_t percentage = s_progress_current >= s_progress_total ? 100 : (s_progress_current * 100) / s_progress_total;
+		if (percentage != s_progress_drawn) {
+			VESABootConsole::update_progress_bar(percentage);
+			s_progress_drawn = percentage;
+		}
+
+		if (s_progress_current < s_progress_total)
+			s_progress_current++;
 	}
 
 	// Print the header
@@ -119,7 +128,117 @@ void Logger::set_log_level(LogLevel log_level) {
 			break;
 	}
 
-	GlobalScheduler::print_running_header();
+	GlobalScheduler::print_running_header(*this);
+}
+
+/**
+ * @brief Starts the thread that writes out the log rings, from then on logging only appends to the executing core's ring
+ *
+ * @note Needs the scheduler, until then everything is written straight to the log writers
+ */
+void Logger::start_buffering() {
+
+	if (s_buffering || !GlobalScheduler::system_scheduler())
+		return;
+
+	s_buffering = true;
+
+	Logger* args[] = { this };
+	auto* drain = new Process("Log Drain", (void (*)(void*)) (uintptr_t) drain_worker, args, 1, true);
+	GlobalScheduler::system_scheduler()->add_process(drain);
+}
+
+/**
+ * @brief Writes out everything waiting in the rings then goes back to writing straight to the log writers
+ *
+ * @note Used when panicking, the rings are left in memory if another core is in the middle of draining them
+ */
+void Logger::stop_buffering() {
+
+	s_buffering = false;
+	flush();
+}
+
+/**
+ * @brief Writes out the lines waiting in every core's ring
+ */
+void Logger::flush() {
+
+	// If another core is already draining it will write these out
+	if (!s_drain_lock.try_acquire())
+		return;
+
+	char chunk[LOG_DRAIN_CHUNK];
+	for (auto& ring : s_rings) {
+
+		size_t read;
+		while ((read = ring.read(chunk, sizeof(chunk))) > 0)
+			for (size_t i = 0; i < read; i++)
+				s_active_logger->write_to_writers(chunk[i]);
+
+		// Let the reader know there is a gap
+		uint64_t dropped = ring.take_dropped();
+		if (!dropped)
+			continue;
+
+		const char* parts[] = { "\n[ ", itoa(10, (int64_t) dropped), " log characters dropped ]\n" };
+		for (auto part : parts)
+			for (; *part; part++)
+				s_active_logger->write_to_writers(*part);
+	}
+
+	s_drain_lock.release();
+}
+
+/**
+ * @brief (Drain Side) Write out the rings then sleep, forever
+ *
+ * @param argc Unused
+ * @param argv The logger
+ */
+void Logger::drain_worker(uint64_t argc, Logger** argv) {
+
+	Logger* logger = argv[0];
+	while (true) {
+
+		logger->flush();
+
+		GlobalScheduler::sleep(LOG_DRAIN_INTERVAL);
+	}
+}
+
+/**
+ * @brief Gets the ring of the core that is running
+ *
+ * @return The ring or nullptr if the core doesn't have one
+ */
+LogRing* Logger::executing_ring() {
+
+	// Before the cores are found only the bootstrap core is running
+	Core* core = CPU::executing_core();
+	uint8_t id = core ? core->id : 0;
+
+	return id < MAX_LOG_RINGS ? &s_rings[id] : nullptr;
+}
+
+/**
+ * @brief Starts a new log entry at a level
+ *
+ * @param log_level The level of the entry
+ * @return A copy of the active logger that writes to the executing core's ring
+ */
+Logger Logger::entry(LogLevel log_level) {
+
+	// Continuing the line through Out() uses the active logger's level
+	s_active_logger->m_log_level = log_level;
+
+	// Look the ring up once for the whole entry
+	Logger logger = *s_active_logger;
+	if (s_buffering)
+		logger.m_ring = executing_ring();
+
+	logger.set_log_level(log_level);
+	return logger;
 }
 
 
@@ -134,11 +253,31 @@ void Logger::write_char(char c) {
 	if (m_log_level > MAX_LOG_LEVEL)
 		return;
 
-	// Write the character to all output streams
+	// Before the drain thread has started (and once panicking) write straight out
+	LogRing* ring = s_buffering ? (m_ring ? m_ring : executing_ring()) : nullptr;
+	if (!ring) {
+		write_to_writers(c);
+		return;
+	}
+
+	// Only this core appends to the ring, so it just needs to stop an interrupt logging in the middle
+	uint64_t flags;
+	asm volatile("pushfq\n pop %0\n cli" : "=r" (flags) : : "memory");
+	ring->append(c);
+	if (flags & (1 << 9))
+		asm volatile("sti");
+}
+
+/**
+ * @brief Writes a character to all the enabled log writers
+ *
+ * @param c The character to write
+ */
+void Logger::write_to_writers(char c) {
+
 	for (int i = 0; i < m_log_writer_count; i++)
 		if (m_log_writers_enabled[i])
 			m_log_writers[i]->write_char(c);
-
 }
 
 /**
@@ -158,9 +297,7 @@ Logger &Logger::Out() {
  */
 Logger Logger::HEADER() {
 
-	s_active_logger->set_log_level(LogLevel::HEADER);
-	return Out();
-
+	return entry(LogLevel::HEADER);
 }
 
 /**
@@ -170,8 +307,7 @@ Logger Logger::HEADER() {
  */
 Logger Logger::INFO() {
 
-	s_active_logger->set_log_level(LogLevel::INFO);
-	return Out();
+	return entry(LogLevel::INFO);
 }
 
 /**
@@ -181,8 +317,7 @@ Logger Logger::INFO() {
  */
 Logger Logger::TEST() {
 
-	s_active_logger->set_log_level(LogLevel::TEST);
-	return Out();
+	return entry(LogLevel::TEST);
 }
 
 /**
@@ -192,9 +327,7 @@ Logger Logger::TEST() {
  */
 Logger Logger::DEBUG() {
 
-	s_active_logger->set_log_level(LogLevel::DEBUG);
-	return Out();
-
+	return entry(LogLevel::DEBUG);
 }
 
 /**
@@ -204,8 +337,7 @@ Logger Logger::DEBUG() {
  */
 Logger Logger::WARNING() {
 
-	s_active_logger->set_log_level(LogLevel::WARNING);
-	return Out();
+	return entry(LogLevel::WARNING);
 }
 
 /**
@@ -215,9 +347,7 @@ Logger Logger::WARNING() {
  */
 Logger Logger::ERROR() {
 
-	s_active_logger->set_log_level(LogLevel::ERROR);
-	return Out();
-
+	return entry(LogLevel::ERROR);
 }
 
 /**
@@ -274,4 +404,66 @@ Logger &Logger::operator<<(LogLevel log_level) {
 	set_log_level(log_level);
 	return *this;
 
-}
\ No newline at end of file
+}
+/**
+ * @brief Appends a character to the ring
+ *
+ * @param c The character
+ * @return False if the ring is full and the character was dropped
+ */
+bool LogRing::append(char c) {
+
+	// Full, keep what is already there
+	uint64_t tail = __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE);
+	if (m_head - tail >= LOG_RING_SIZE) {
+		m_dropped++;
+		return false;
+	}
+
+	m_buffer[m_head % LOG_RING_SIZE] = c;
+	uint64_t head = m_head + 1;
+	__atomic_store_n(&m_head, head, __ATOMIC_RELEASE);
+
+	// A line is finished, or there is no more room for the rest of it
+	if (c == '\n' || head - tail == LOG_RING_SIZE)
+		__atomic_store_n(&m_line_end, head, __ATOMIC_RELEASE);
+
+	return true;
+}
+
+/**
+ * @brief Takes the finished lines out of the ring
+ *
+ * @param buffer Where to copy the characters to
+ * @param size The maximum number of characters to copy
+ * @return The number of characters copied
+ */
+size_t LogRing::read(char* buffer, size_t size) {
+
+	uint64_t end = __atomic_load_n(&m_line_end, __ATOMIC_ACQUIRE);
+	size_t available = end - m_tail;
+	size_t count = available < size ? available : size;
+
+	// Copy the part up to the end of the buffer then the part that wrapped around
+	size_t start = m_tail % LOG_RING_SIZE;
+	size_t first = count < LOG_RING_SIZE - start ? count : LOG_RING_SIZE - start;
+	memcpy(buffer, m_buffer + start, first);
+	memcpy(buffer + first, m_buffer, count - first);
+
+	__atomic_store_n(&m_tail, m_tail + count, __ATOMIC_RELEASE);
+	return count;
+}
+
+/**
+ * @brief Gets how many characters have been dropped since this was last called
+ *
+ * @return The number of characters dropped
+ */
+uint64_t LogRing::take_dropped() {
+
+	uint64_t dropped = __atomic_load_n(&m_dropped, __ATOMIC_RELAXED);
+	uint64_t count = dropped - m_dropped_reported;
+	m_dropped_reported = dropped;
+
+	return count;
+}
@@ -0,0 +1,471 @@
+/**
+ * @file region.cpp
+ * @brief Implementation of the Region class defined in region.h
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+ */
+
+#include <common/region.h>
+
+using namespace MaxOS::common;
+
+typedef Vector<Rectangle<int32_t>> rectangles_t;   ///< Shorthand for the list of rectangles in a region
+
+/**
+ * @brief Find where the band starting at a rectangle ends
+ *
+ * @param rectangles The bands
+ * @param start The index of the first rectangle in the band
+ * @return The index after the last rectangle in the band
+ */
+static uint32_t band_end(const rectangles_t& rectangles, uint32_t start) {
+
+	uint32_t end = start + 1;
+	while(end < rectangles.size() && rectangles[end].top == rectangles[start].top)
+		end++;
+
+	return end;
+}
+
+/**
+ * @brief Add a span to the band being built
+ *
+ * @param result The bands being built
+ * @param left The left of the span
+ * @param right The right of the span (exclusive)
+ * @param top The top of the band
+ * @param bottom The bottom of the band (exclusive)
+ */
+static void add_span(rectangles_t& result, int32_t left, int32_t right, int32_t top, int32_t bottom) {
+
+	// Spans that touch the previous one in the same band join it
+	if(!result.empty()) {
+		Rectangle<int32_t>& last = result[result.size() - 1];
+		if(last.top == top && last.left + last.width >= left) {
+			if(right > last.left + last.width)
+				last.width = right - last.left;
+			return;
+		}
+	}
+
+	result.push_back(Rectangle<int32_t>(left, top, right - left, bottom - top));
+}
+
+/**
+ * @brief Finish the band that was just built, merging it into the band above if their spans are the same
+ *
+ * @param result The bands being built
+ * @param previous_band The index of the first rectangle in the band above
+ * @param current_band The index of the first rectangle in the band that was just built
+ * @return The index of the first rectangle of the last band
+ */
+static uint32_t coalesce_band(rectangles_t& result, uint32_t previous_band, uint32_t current_band) {
+
+	uint32_t end = result.size();
+	uint32_t current_count = end - current_band;
+
+	// Nothing was added
+	if(!current_count)
+		return previous_band;
+
+	// The bands must touch and have the same number of spans
+	if(previous_band == current_band || current_band - previous_band != current_count)
+		return current_band;
+
+	Rectangle<int32_t>& above = result[previous_band];
+	if(above.top + above.height != result[current_band].top)
+		return current_band;
+
+	for(uint32_t i = 0; i < current_count; i++) {
+		Rectangle<int32_t>& upper = result[previous_band + i];
+		Rectangle<int32_t>& lower = result[current_band + i];
+		if(upper.left != lower.left || upper.width != lower.width)
+			return current_band;
+	}
+
+	// Grow the band above and drop the new one
+	int32_t height = result[current_band].height;
+	for(uint32_t i = 0; i < current_count; i++) {
+		result[previous_band + i].height += height;
+		result.pop_back();
+	}
+
+	return previous_band;
+}
+
+Region::Region() = default;
+
+/**
+ * @brief Create a region covering a single rectangle
+ *
+ * @param rectangle The rectangle to cover
+ */
+Region::Region(const Rectangle<int32_t>& rectangle) {
+
+	if(rectangle.width <= 0 || rectangle.height <= 0)
+		return;
+
+	m_rectangles.push_back(rectangle);
+	m_extents = rectangle;
+}
+
+Region::~Region() = default;
+
+/**
+ * @brief Check if the region covers nothing
+ *
+ * @return True if the region is empty
+ */
+bool Region::empty() const {
+	return m_rectangles.empty();
+}
+
+/**
+ * @brief Get the rectangles that make up the region, sorted top to bottom then left to right
+ *
+ * @return The rectangles in the region
+ */
+const Vector<Rectangle<int32_t>>& Region::rectangles() const {
+	return m_rectangles;
+}
+
+/**
+ * @brief Get the smallest rectangle that contains the whole region
+ *
+ * @return The bounds of the region
+ */
+Rectangle<int32_t> Region::extents() const {
+	return m_extents;
+}
+
+/**
+ * @brief Get the number of pixels covered by the region
+ *
+ * @return The area of the region
+ */
+uint64_t Region::area() const {
+
+	uint64_t total = 0;
+	for(auto& rectangle : m_rectangles)
+		total += (uint64_t) rectangle.width * rectangle.height;
+
+	return total;
+}
+
+/**
+ * @brief Check if a point is inside the region
+ *
+ * @param x The x coordinate
+ * @param y The y coordinate
+ * @return True if the point is covered by the region
+ */
+bool Region::contains(int32_t x, int32_t y) const {
+
+	for(auto& rectangle : m_rectangles) {
+
+		// Bands are sorted so once past the point nothing else can contain it
+		if(rectangle.top > y)
+			break;
+
+		if(y < rectangle.top + rectangle.height && x >= rectangle.left && x < rectangle.left + rectangle.width)
+			return true;
+	}
+
+	return false;
+}
+
+/**
+ * @brief Remove everything from the region
+ */
+void Region::clear() {
+
+	m_rectangles.clear();
+	m_extents = Rectangle<int32_t>();
+}
+
+/**
+ * @brief Recalculate the bounds of the region after its rectangles change
+ */
+void Region::update_extents() {
+
+	if(m_rectangles.empty()) {
+		m_extents = Rectangle<int32_t>();
+		return;
+	}
+
+	// The first band is the top and the last band is the bottom
+	Rectangle<int32_t>& first = m_rectangles[0];
+	Rectangle<int32_t>& last = m_rectangles[m_rectangles.size() - 1];
+	int32_t left = first.left;
+	int32_t right = first.left + first.width;
+	for(auto& rectangle : m_rectangles) {
+		if(rectangle.left < left)
+			left = rectangle.left;
+		if(rectangle.left + rectangle.width > right)
+			right = rectangle.left + rectangle.width;
+	}
+
+	m_extents = Rectangle<int32_t>(left, first.top, right - left, last.top + last.height - first.top);
+}
+
+/**
+ * @brief Combine another region with this one by sweeping down both sets of bands at once
+ *
+ * @param other The region to combine with
+ * @param operation How to combine the spans of rows covered by both regions
+ */
+void Region::combine(const Region& other, Operation operation) {
+
+	const rectangles_t& a = m_rectangles;
+	const rectangles_t& b = other.m_rectangles;
+
+	rectangles_t result;
+	uint32_t previous_band = 0;
+
+	uint32_t a_index = 0;
+	uint32_t b_index = 0;
+	int32_t y = INT32_MIN;
+
+	// Copies the spans of a band that only one region covers
+	auto copy_band = [&](const rectangles_t& source, uint32_t start, uint32_t end, int32_t top, int32_t bottom) {
+		uint32_t current_band = result.size();
+		for(uint32_t i = start; i < end; i++)
+			add_span(result, source[i].left, source[i].left + source[i].width, top, bottom);
+		previous_band = coalesce_band(result, previous_band, current_band);
+	};
+
+	while(a_index < a.size() && b_index < b.size()) {
+
+		uint32_t a_end = band_end(a, a_index);
+		uint32_t b_end = band_end(b, b_index);
+
+		// Parts of a band above y have already been handled
+		int32_t a_top = a[a_index].top > y ? a[a_index].top : y;
+		int32_t b_top = b[b_index].top > y ? b[b_index].top : y;
+		int32_t a_bottom = a[a_index].top + a[a_index].height;
+		int32_t b_bottom = b[b_index].top + b[b_index].height;
+
+		if(a_top < b_top) {
+
+			// Rows only this region covers
+			y = a_bottom < b_top ? a_bottom : b_top;
+			if(operation != Operation::INTERSECT)
+				copy_band(a, a_index, a_end, a_top, y);
+
+		} else if(b_top < a_top) {
+
+			// Rows only the other region covers
+			y = b_bottom < a_top ? b_bottom : a_top;
+			if(operation == Operation::UNION)
+				copy_band(b, b_index, b_end, b_top, y);
+
+		} else {
+
+			// Rows both regions cover, walk the two lists of spans together
+			int32_t top = a_top;
+			y = a_bottom < b_bottom ? a_bottom : b_bottom;
+			uint32_t current_band = result.size();
+			uint32_t i = a_index;
+			uint32_t j = b_index;
+
+			switch(operation) {
+
+				case Operation::UNION:
+					while(i < a_end || j < b_end) {
+						const Rectangle<int32_t>& next = (j >= b_end || (i < a_end && a[i].left < b[j].left)) ? a[i++] : b[j++];
+						add_span(result, next.left, next.left + next.width, top, y);
+					}
+					break;
+
+				case Operation::INTERSECT:
+					while(i < a_end && j < b_end) {
+						int32_t left = a[i].left > b[j].left ? a[i].left : b[j].left;
+						int32_t a_right = a[i].left + a[i].width;
+						int32_t b_right = b[j].left + b[j].width;
+						int32_t right = a_right < b_right ? a_right : b_right;
+						if(left < right)
+							add_span(result, left, right, top, y);
+
+						// Move past whichever span ends first
+						if(a_right < b_right)
+							i++;
+						else
+							j++;
+					}
+					break;
+
+				case Operation::SUBTRACT:
+					for(; i < a_end; i++) {
+						int32_t left = a[i].left;
+						int32_t right = a[i].left + a[i].width;
+
+						// Skip the spans that end before this one, the rest may still cut into the next span
+						while(j < b_end && b[j].left + b[j].width <= left)
+							j++;
+
+						for(uint32_t k = j; k < b_end && b[k].left < right; k++) {
+							if(b[k].left > left)
+								add_span(result, left, b[k].left, top, y);
+							if(b[k].left + b[k].width > left)
+								left = b[k].left + b[k].width;
+						}
+
+						if(left < right)
+							add_span(result, left, right, top, y);
+					}
+					break;
+			}
+
+			previous_band = coalesce_band(result, previous_band, current_band);
+		}
+
+		// Move on to the next band once all its rows are done
+		if(a_bottom <= y)
+			a_index = a_end;
+		if(b_bottom <= y)
+			b_index = b_end;
+	}
+
+	// The rest of this region is only kept if it wasn't needed to overlap the other
+	if(operation != Operation::INTERSECT) {
+		while(a_index < a.size()) {
+			uint32_t a_end = band_end(a, a_index);
+			int32_t a_top = a[a_index].top > y ? a[a_index].top : y;
+			copy_band(a, a_index, a_end, a_top, a[a_index].top + a[a_index].height);
+			a_index = a_end;
+		}
+	}
+
+	// The rest of the other region
+	if(operation == Operation::UNION) {
+		while(b_index < b.size()) {
+			uint32_t b_end = band_end(b, b_index);
+			int32_t b_top = b[b_index].top > y ? b[b_index].top : y;
+			copy_band(b, b_index, b_end, b_top, b[b_index].top + b[b_index].height);
+			b_index = b_end;
+		}
+	}
+
+	m_rectangles = result;
+	update_extents();
+}
+
+/**
+ * @brief Add another region to this one
+ *
+ * @param other The region to add
+ */
+void Region::unite(const Region& other) {
+
+	if(other.empty())
+		return;
+
+	// Adding a region that covers all of this one is just a copy
+	if(empty()) {
+		m_rectangles = other.m_rectangles;
+		m_extents = other.m_extents;
+		return;
+	}
+
+	combine(other, Operation::UNION);
+}
+
+/**
+ * @brief Add a rectangle to the region
+ *
+ * @param rectangle The rectangle to add
+ */
+void Region::unite(const Rectangle<int32_t>& rectangle) {
+	unite(Region(rectangle));
+}
+
+/**
+ * @brief Remove another region from this one
+ *
+ * @param other The region to remove
+ */
+void Region::subtract(const Region& other) {
+
+	// Nothing to remove if the two don't overlap
+	if(empty() || other.empty() || !m_extents.intersects(other.m_extents))
+		return;
+
+	combine(other, Operation::SUBTRACT);
+}
+
+/**
+ * @brief Remove a rectangle from the region
+ *
+ * @param rectangle The rectangle to remove
+ */
+void Region::subtract(const Rectangle<int32_t>& rectangle) {
+	subtract(Region(rectangle));
+}
+
+/**
+ * @brief Keep only the parts of the region that are also in another region
+ *
+ * @param other The region to intersect with
+ */
+void Region::intersect(const Region& other) {
+
+	// Nothing is left if the two don't overlap
+	if(empty() || other.empty() || !m_extents.intersects(other.m_extents)) {
+		clear();
+		return;
+	}
+
+	combine(other, Operation::INTERSECT);
+}
+
+/**
+ * @brief Keep only the parts of the region that are inside a rectangle
+ *
+ * @param rectangle The rectangle to intersect with
+ */
+void Region::intersect(const Rectangle<int32_t>& rectangle) {
+	intersect(Region(rectangle));
+}
+
+/**
+ * @brief Add damage to the region, merging it with nearby damage so that fewer (but slightly larger) rectangles are redrawn
+ *
+ * @param damage The area that needs to be redrawn
+ * @param slack How many pixels that aren't damaged can be redrawn to draw two areas as one rectangle
+ * @param max_rectangles How many rectangles the region can hold before it is replaced by its bounds
+ */
+void Region::include(const Rectangle<int32_t>& damage, uint32_t slack, uint32_t max_rectangles) {
+
+	if(damage.width <= 0 || damage.height <= 0)
+		return;
+
+	// Grow the damage over any rectangle close enough that drawing both as one costs little extra
+	Rectangle<int32_t> grown = damage;
+	for(auto& rectangle : m_rectangles) {
+
+		int32_t left = grown.left < rectangle.left ? grown.left : rectangle.left;
+		int32_t top = grown.top < rectangle.top ? grown.top : rectangle.top;
+		int32_t right = grown.left + grown.width > rectangle.left + rectangle.width ? grown.left + grown.width : rectangle.left + rectangle.width;
+		int32_t bottom = grown.top + grown.height > rectangle.top + rectangle.height ? grown.top + grown.height : rectangle.top + rectangle.height;
+
+		// The overlap is drawn once either way
+		int64_t overlap_width = (grown.left + grown.width < rectangle.left + rectangle.width ? grown.left + grown.width : rectangle.left + rectangle.width) - (grown.left > rectangle.left ? grown.left : rectangle.left);
+		int64_t overlap_height = (grown.top + grown.height < rectangle.top + rectangle.height ? grown.top + grown.height : rectangle.top + rectangle.height) - (grown.top > rectangle.top ? grown.top : rectangle.top);
+		int64_t overlap = overlap_width > 0 && overlap_height > 0 ? overlap_width * overlap_height : 0;
+
+		int64_t covered = (int64_t) grown.width * grown.height + (int64_t) rectangle.width * rectangle.height - overlap;
+		int64_t bounds = (int64_t) (right - left) * (bottom - top);
+		if(bounds - covered <= (int64_t) slack)
+			grown = Rectangle<int32_t>(left, top, right - left, bottom - top);
+	}
+
+	unite(grown);
+
+	// Too scattered to be worth tracking, redraw everything in between
+	if(m_rectangles.size() > max_rectangles) {
+		Rectangle<int32_t> bounds = m_extents;
+		m_rectangles.clear();
+		m_rectangles.push_back(bounds);
+	}
+}
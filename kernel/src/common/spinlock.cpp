@@ -15,6 +15,59 @@ using namespace MaxOS::processes;
 using namespace MaxOS::system;
 using namespace MaxOS::hardwarecommunication;
 
+/// Wait queue tag for a thread waiting to read
+constexpr uint64_t RW_WAIT_READ = 0;
+
+/// Wait queue tag for a thread waiting to write
+constexpr uint64_t RW_WAIT_WRITE = 1;
+
+/**
+ * @brief Creates a new set of lock statistics and adds it to the list of tracked locks
+ *
+ * @param name The name to report the lock as
+ */
+LockStatistics::LockStatistics(const char* name)
+: name(name)
+{
+
+	// Link into the list (only ever prepended to so a CAS is enough to be safe across cores)
+	next = __atomic_load_n(&s_first, __ATOMIC_ACQUIRE);
+	while (!__atomic_compare_exchange_n(&s_first, &next, this, false, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE));
+}
+
+LockStatistics::~LockStatistics() = default;
+
+/**
+ * @brief Records an acquisition of the lock
+ *
+ * @param spin_count How many times the acquirer paused waiting for the lock
+ * @param cycles How many TSC cycles the acquirer waited for
+ */
+void LockStatistics::record(uint64_t spin_count, uint64_t cycles) {
+
+	__atomic_fetch_add(&acquisitions, 1, __ATOMIC_RELAXED);
+
+	// Didn't have to wait
+	if(!spin_count && !cycles)
+		return;
+
+	__atomic_fetch_add(&contended, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&spins, spin_count, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&wait_cycles, cycles, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Logs the counters of every tracked lock
+ */
+void LockStatistics::print_all() {
+
+	for (LockStatistics* statistics = __atomic_load_n(&s_first, __ATOMIC_ACQUIRE); statistics; statistics = statistics->next) {
+		Logger::DEBUG() << "Lock " << statistics->name << ": " << itoa(10, (int64_t)statistics->acquisitions) << " acquisitions, ";
+		Logger::Out() << itoa(10, (int64_t)statistics->contended) << " contended, " << itoa(10, (int64_t)statistics->spins) << " spins, ";
+		Logger::Out() << itoa(10, (int64_t)statistics->wait_cycles) << " cycles waiting\n";
+	}
+}
+
 Spinlock::Spinlock() = default;
 Spinlock::~Spinlock() = default;
 
@@ -23,15 +76,12 @@ Spinlock::~Spinlock() = default;
  */
 void Spinlock::lock() {
 	acquire();
-	m_locked = true;
 }
 
 /**
  * @brief Unlock the spinlock
  */
 void Spinlock::unlock() {
-
-	m_locked = false;
 	release();
 }
 
@@ -41,30 +91,318 @@ void Spinlock::unlock() {
  * @return True if the spinlock is locked, false otherwise
  */
 bool Spinlock::is_locked() const {
-	return m_locked;
+	return __atomic_load_n(&m_next_ticket, __ATOMIC_RELAXED) != __atomic_load_n(&m_now_serving, __ATOMIC_RELAXED);
 }
 
 
 /**
- * @brief Acquire the spinlock: wait until the lock is available, spinning until that happens.
+ * @brief Acquire the spinlock: take a ticket and wait until it is being served, backing off for longer the further back in the queue it is
  */
 void Spinlock::acquire() {
-	while (__atomic_test_and_set(&m_locked, __ATOMIC_ACQUIRE))
-		asm("nop");
+
+	// Take a ticket
+	uint32_t ticket = __atomic_fetch_add(&m_next_ticket, 1, __ATOMIC_RELAXED);
+	if(__atomic_load_n(&m_now_serving, __ATOMIC_ACQUIRE) == ticket) {
+		if(m_statistics)
+			m_statistics->record(0, 0);
+		return;
+	}
+
+	// Wait for the turn
+	uint64_t start = m_statistics ? CPU::read_timestamp() : 0;
+	uint64_t spins = 0;
+	while (true) {
+
+		uint32_t serving = __atomic_load_n(&m_now_serving, __ATOMIC_ACQUIRE);
+		if(serving == ticket)
+			break;
+
+		// Each holder ahead will take at least a while, don't touch the line until then
+		uint32_t ahead = ticket - serving;
+		for (uint32_t i = 0; i < ahead * SPINLOCK_BACKOFF_PAUSES; ++i)
+			asm volatile("pause");
+		spins += ahead * SPINLOCK_BACKOFF_PAUSES;
+	}
+
+	if(m_statistics)
+		m_statistics->record(spins, CPU::read_timestamp() - start);
+}
+
+/**
+ * @brief Try to acquire the spinlock without waiting
+ *
+ * @return True if the lock was acquired, false if it is held by someone else
+ */
+bool Spinlock::try_acquire() {
+
+	// Only take a ticket if it would be served straight away
+	uint32_t serving = __atomic_load_n(&m_now_serving, __ATOMIC_ACQUIRE);
+	uint32_t expected = serving;
+	if(!__atomic_compare_exchange_n(&m_next_ticket, &expected, serving + 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+		return false;
+
+	if(m_statistics)
+		m_statistics->record(0, 0);
+	return true;
 }
 
 /**
- * @brief Release the spinlock
+ * @brief Release the spinlock, serving the next ticket
  */
 void Spinlock::release() {
-	__atomic_clear(&m_locked, __ATOMIC_RELEASE);
+
+	// Only the holder writes this so a plain increment is safe
+	__atomic_store_n(&m_now_serving, m_now_serving + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Disable interrupts on this core then acquire the spinlock, for locks that are also taken by an interrupt handler
+ *
+ * @return The flags from before interrupts were disabled, to be passed to release_irqrestore()
+ */
+uint64_t Spinlock::acquire_irqsave() {
+
+	uint64_t flags;
+	asm volatile("pushfq\n pop %0\n cli" : "=r" (flags) : : "memory");
+	acquire();
+	return flags;
+}
+
+/**
+ * @brief Release the spinlock then re-enable interrupts if they were enabled when it was acquired
+ *
+ * @param flags The flags returned by acquire_irqsave()
+ */
+void Spinlock::release_irqrestore(uint64_t flags) {
+
+	release();
+	if (flags & (1 << 9))
+		asm volatile("sti");
+}
+
+/**
+ * @brief Start counting how contended this lock is
+ *
+ * @param name The name to report the lock as
+ */
+void Spinlock::enable_statistics(const char* name) {
+
+	if(!m_statistics)
+		m_statistics = new LockStatistics(name);
+}
+
+/**
+ * @brief Gets the contention counters for this lock
+ *
+ * @return The statistics or nullptr if they are not enabled
+ */
+LockStatistics* Spinlock::statistics() const {
+	return m_statistics;
+}
+
+WaitQueue::WaitQueue() = default;
+WaitQueue::~WaitQueue() = default;
+
+/**
+ * @brief Puts the current thread to sleep on this queue. The guard must be held, it is released once the thread is queued
+ *
+ * @param guard The lock protecting this queue (and whatever condition is being waited on)
+ * @param tag A value stored with the waiter that the waker can inspect
+ *
+ * @note The guard is not held when this returns
+ */
+void WaitQueue::wait(Spinlock& guard, uint64_t tag) {
+
+	// Add to the queue
+	auto thread = GlobalScheduler::current_thread();
+	enqueue_current(tag);
+	guard.release();
+
+	thread->save_cpu_state();
+
+	// Guard against being resumed here
+	if(thread->thread_state == ThreadState::WAITING){
+
+		// Yield to the next thread
+		cpu_status_t* next = GlobalScheduler::core_scheduler()->schedule_next(&thread->execution_state);
+		InterruptManager::ForceInterruptReturn(next);
+	}
+}
+
+/**
+ * @brief Puts the current thread to sleep on this queue until it is woken or the time runs out. The guard must be held,
+ * it is released once the thread is queued
+ *
+ * @param guard The lock protecting this queue (and whatever condition is being waited on)
+ * @param milliseconds How long to wait at most
+ * @param tag A value stored with the waiter that the waker can inspect
+ * @return True if the thread was woken, false if the time ran out
+ *
+ * @note The guard is not held when this returns
+ */
+bool WaitQueue::wait_for(Spinlock& guard, size_t milliseconds, uint64_t tag) {
+
+	// Add to the queue, the scheduler wakes the thread itself once the time is up
+	auto thread = GlobalScheduler::current_thread();
+	enqueue_current(tag);
+	thread->sleep(milliseconds);
+	guard.release();
+
+	thread->save_cpu_state();
+
+	// Guard against being resumed here
+	if(thread->thread_state == ThreadState::SLEEPING){
+
+		// Yield to the next thread
+		cpu_status_t* next = GlobalScheduler::core_scheduler()->schedule_next(&thread->execution_state);
+		InterruptManager::ForceInterruptReturn(next);
+	}
+
+	// A thread that ran out of time is still queued, take it off so it isn't woken later while doing something else
+	guard.acquire();
+	bool woken = !remove(thread->tid);
+	guard.release();
+
+	return woken;
+}
+
+/**
+ * @brief Marks the current thread as waiting and adds it to the queue without yielding. The guard must be held
+ *
+ * @param tag A value stored with the waiter that the waker can inspect
+ *
+ * @note For callers that switch threads themselves (e.g. syscalls returning a new cpu state)
+ */
+void WaitQueue::enqueue_current(uint64_t tag) {
+
+	auto thread = GlobalScheduler::current_thread();
+	thread->thread_state = ThreadState::WAITING;
+	m_waiters.push_back({ thread->tid, tag });
+}
+
+/**
+ * @brief Removes the waiters at the front of the queue whose thread has exited, so that nothing is handed to them
+ */
+void WaitQueue::drop_exited() {
+
+	while (!m_waiters.empty()) {
+
+		Thread* thread = GlobalScheduler::get_thread(m_waiters[0].first);
+		if(thread && thread->thread_state != ThreadState::STOPPED)
+			return;
+
+		m_waiters.pop_front();
+	}
+}
+
+/**
+ * @brief Takes a thread off the queue without waking it. The guard must be held
+ *
+ * @param tid The thread to take off
+ * @return True if the thread was queued
+ */
+bool WaitQueue::remove(uint64_t tid) {
+
+	for(auto waiter = m_waiters.begin(); waiter != m_waiters.end(); ++waiter) {
+		if(waiter->first != tid)
+			continue;
+
+		m_waiters.erase(waiter);
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * @brief Check if there are no threads waiting. The guard should be held
+ *
+ * @return True if no threads are waiting
+ */
+bool WaitQueue::empty() {
+
+	drop_exited();
+	return m_waiters.empty();
+}
+
+/**
+ * @brief Gets the tag of the thread that would be woken next. The guard should be held
+ *
+ * @return The tag or 0 if no threads are waiting
+ */
+uint64_t WaitQueue::peek_tag() {
+
+	drop_exited();
+	if(m_waiters.empty())
+		return 0;
+
+	return m_waiters[0].second;
+}
+
+/**
+ * @brief Counts the threads waiting with a tag, skipping those that have exited. The guard should be held
+ *
+ * @param tag The tag to look for
+ * @return How many threads are waiting with the tag
+ */
+size_t WaitQueue::count(uint64_t tag) {
+
+	size_t waiting = 0;
+	for(auto& waiter : m_waiters) {
+		if(waiter.second != tag)
+			continue;
+
+		Thread* thread = GlobalScheduler::get_thread(waiter.first);
+		if(thread && thread->thread_state != ThreadState::STOPPED)
+			waiting++;
+	}
+
+	return waiting;
+}
+
+/**
+ * @brief Wakes the longest waiting thread that hasn't exited. The guard should be held
+ *
+ * @return The tid of the thread woken or 0 if none were waiting
+ */
+uint64_t WaitQueue::wake_one() {
+
+	drop_exited();
+	if(m_waiters.empty())
+		return 0;
+
+	// Next thread can be run
+	uint64_t tid = m_waiters.pop_front().first;
+	GlobalScheduler::get_thread(tid)->thread_state = ThreadState::READY;
+
+	return tid;
+}
+
+/**
+ * @brief Wakes up to a number of the longest waiting threads. The guard should be held
+ *
+ * @param count The maximum amount of threads to wake
+ * @return How many threads were woken
+ */
+size_t WaitQueue::wake(size_t count) {
+
+	size_t woken = 0;
+	while (woken < count && wake_one())
+		woken++;
+
+	return woken;
 }
 
 BlockingLock::BlockingLock() = default;
 BlockingLock::~BlockingLock() = default;
 
+/**
+ * @brief Check if there is a scheduler to sleep on, if not waiters have to spin
+ *
+ * @return True if waiters must spin
+ */
 bool BlockingLock::must_spin() {
-	return GlobalScheduler::is_active();
+	return !GlobalScheduler::is_active();
 }
 
 /**
@@ -72,15 +410,12 @@ bool BlockingLock::must_spin() {
  */
 void BlockingLock::lock() {
 	acquire();
-	m_locked = true;
 }
 
 /**
  * @brief Unlock the spinlock
  */
 void BlockingLock::unlock() {
-
-	m_locked = false;
 	release();
 }
 
@@ -90,49 +425,239 @@ void BlockingLock::unlock() {
  * @return True if the spinlock is locked, false otherwise
  */
 bool BlockingLock::is_locked() const {
-	return m_locked;
+	return __atomic_load_n(&m_locked, __ATOMIC_RELAXED);
 }
 
 /**
  * @brief Acquire the spinlock, spin until the lock is available and sleeping the thread until marked as available
- *
- * @todo Move the yielding logic into process/thread code so that it can be reused
  */
 void BlockingLock::acquire() {
 
 	// Try to get the lock
-	for (int i = 0; (i < BLOCKING_FAST_TRY_LIMIT || must_spin()); ++i)
-		if(!__atomic_test_and_set(&m_locked, __ATOMIC_ACQUIRE))
-			return;
+	uint64_t start = m_statistics ? CPU::read_timestamp() : 0;
+	uint64_t spins = 0;
+	for (int i = 0; (i < BLOCKING_FAST_TRY_LIMIT || must_spin()); ++i) {
 
-	// Add to the queue
-	auto thread = GlobalScheduler::current_thread();
-	thread->thread_state = ThreadState::WAITING;
-	m_queue.push_back(thread->tid);
+		if(!__atomic_test_and_set(&m_locked, __ATOMIC_ACQUIRE)) {
+			if(m_statistics)
+				m_statistics->record(spins, spins ? CPU::read_timestamp() - start : 0);
+			return;
+		}
 
-	thread->save_cpu_state();
+		asm volatile("pause");
+		spins++;
+	}
 
-	// Guard against being resumed here
-	if(thread->thread_state == ThreadState::WAITING){
+	// May have been released while taking the queue lock
+	m_queue_lock.acquire();
+	if(!__atomic_test_and_set(&m_locked, __ATOMIC_ACQUIRE)) {
+		m_queue_lock.release();
+	} else {
 
-		// Yield to the next thread
-		cpu_status_t* next = GlobalScheduler::core_scheduler()->schedule_next(&thread->execution_state);
-		InterruptManager::ForceInterruptReturn(next);
+		// Sleep, release() hands the lock over without unlocking it
+		m_queue.wait(m_queue_lock);
 	}
 
-
+	if(m_statistics)
+		m_statistics->record(spins, CPU::read_timestamp() - start);
 }
 
 /**
- * @brief Mark as unlocked, wake the next enqueued thread
+ * @brief Hand the lock to the next enqueued thread, or mark as unlocked if none are waiting
  */
 void BlockingLock::release() {
 
-	// Next thread can be run
-	if(!m_queue.empty()){
-		auto tid = m_queue.pop_front();
-		GlobalScheduler::get_thread(tid)->thread_state = ThreadState::READY;
+	m_queue_lock.acquire();
+
+	// Next thread now owns the lock (waiters that have exited are skipped so the lock isn't handed to nobody)
+	if(m_queue.wake_one()) {
+		m_queue_lock.release();
+		return;
 	}
 
 	__atomic_clear(&m_locked, __ATOMIC_RELEASE);
-}
\ No newline at end of file
+	m_queue_lock.release();
+}
+
+/**
+ * @brief Start counting how contended this lock is
+ *
+ * @param name The name to report the lock as
+ */
+void BlockingLock::enable_statistics(const char* name) {
+
+	if(!m_statistics)
+		m_statistics = new LockStatistics(name);
+}
+
+/**
+ * @brief Gets the contention counters for this lock
+ *
+ * @return The statistics or nullptr if they are not enabled
+ */
+LockStatistics* BlockingLock::statistics() const {
+	return m_statistics;
+}
+
+ReadWriteLock::ReadWriteLock() = default;
+ReadWriteLock::~ReadWriteLock() = default;
+
+/**
+ * @brief Hands the lock to whoever is at the front of the queue: either a single writer or every reader before the next writer. The state lock must be held
+ */
+void ReadWriteLock::wake_waiters() {
+
+	// A writer is next, it can only have the lock once everyone is done
+	if(!m_queue.empty() && m_queue.peek_tag() == RW_WAIT_WRITE) {
+
+		if(m_readers || m_writer)
+			return;
+
+		m_writer = true;
+		m_queue.wake_one();
+		return;
+	}
+
+	// Let the readers in together
+	while (!m_writer && !m_queue.empty() && m_queue.peek_tag() == RW_WAIT_READ) {
+		m_readers++;
+		m_queue.wake_one();
+	}
+}
+
+/**
+ * @brief Take the lock for reading, waiting while there is a writer holding it or queued for it
+ */
+void ReadWriteLock::read_lock() {
+
+	uint64_t start = m_statistics ? CPU::read_timestamp() : 0;
+	uint64_t spins = 0;
+	while (true) {
+
+		m_state_lock.acquire();
+
+		// No writers, can share (counted from the queue so a writer that exited while waiting doesn't hold readers off)
+		if(!m_writer && !m_queue.count(RW_WAIT_WRITE)) {
+			m_readers++;
+			m_state_lock.release();
+			break;
+		}
+
+		// Can't sleep yet, spin
+		if(!GlobalScheduler::is_active()) {
+			m_state_lock.release();
+			asm volatile("pause");
+			spins++;
+			continue;
+		}
+
+		// Sleep, the writer counts this thread as a reader before waking it
+		m_queue.wait(m_state_lock, RW_WAIT_READ);
+		spins++;
+		break;
+	}
+
+	if(m_statistics)
+		m_statistics->record(spins, spins ? CPU::read_timestamp() - start : 0);
+}
+
+/**
+ * @brief Release the lock held for reading, handing it to a writer if this was the last reader
+ */
+void ReadWriteLock::read_unlock() {
+
+	m_state_lock.acquire();
+
+	m_readers--;
+	if(!m_readers)
+		wake_waiters();
+
+	m_state_lock.release();
+}
+
+/**
+ * @brief Take the lock for writing, waiting until there are no readers or writers holding it
+ */
+void ReadWriteLock::write_lock() {
+
+	uint64_t start = m_statistics ? CPU::read_timestamp() : 0;
+	uint64_t spins = 0;
+	while (true) {
+
+		m_state_lock.acquire();
+
+		// Free
+		if(!m_writer && !m_readers) {
+			m_writer = true;
+			m_state_lock.release();
+			break;
+		}
+
+		// Can't sleep yet, spin
+		if(!GlobalScheduler::is_active()) {
+			m_state_lock.release();
+			asm volatile("pause");
+			spins++;
+			continue;
+		}
+
+		// Sleep, the lock is handed over before being woken
+		m_queue.wait(m_state_lock, RW_WAIT_WRITE);
+		spins++;
+		break;
+	}
+
+	if(m_statistics)
+		m_statistics->record(spins, spins ? CPU::read_timestamp() - start : 0);
+}
+
+/**
+ * @brief Release the lock held for writing, handing it to the next writer or group of readers
+ */
+void ReadWriteLock::write_unlock() {
+
+	m_state_lock.acquire();
+
+	m_writer = false;
+	wake_waiters();
+
+	m_state_lock.release();
+}
+
+/**
+ * @brief Check if the lock is held by anyone
+ *
+ * @return True if there is a writer or any readers
+ */
+bool ReadWriteLock::is_locked() const {
+	return __atomic_load_n(&m_writer, __ATOMIC_RELAXED) || __atomic_load_n(&m_readers, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Check if the lock is held by a writer
+ *
+ * @return True if there is a writer
+ */
+bool ReadWriteLock::is_write_locked() const {
+	return __atomic_load_n(&m_writer, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Start counting how contended this lock is
+ *
+ * @param name The name to report the lock as
+ */
+void ReadWriteLock::enable_statistics(const char* name) {
+
+	if(!m_statistics)
+		m_statistics = new LockStatistics(name);
+}
+
+/**
+ * @brief Gets the contention counters for this lock
+ *
+ * @return The statistics or nullptr if they are not enabled
+ */
+LockStatistics* ReadWriteLock::statistics() const {
+	return m_statistics;
+}
@@ -118,6 +118,15 @@ void Clock::delay(uint32_t milliseconds) const {
 		asm volatile("nop");
 }
 
+/**
+ * @brief Get how long the clock has been running for
+ *
+ * @return The number of milliseconds since the clock was activated
+ */
+uint64_t Clock::uptime() const {
+	return m_ticks * clock_accuracy;
+}
+
 /**
  * @brief Gets the vendor who created the device
  *
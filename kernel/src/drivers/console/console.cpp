@@ -219,6 +219,13 @@ void Console::invert_colors(uint16_t x, uint16_t y) {
 	set_background_color(x, y, foreground);
 }
 
+/**
+ * @brief Make sure everything written to the console is on the screen, consoles that draw straight away don't need to
+ */
+void Console::flush() {
+
+}
+
 /**
  * @brief Construct a new Console Area object
  *
@@ -417,6 +424,14 @@ void ConsoleArea::scroll_up(uint16_t left, uint16_t top, uint16_t width,
 
 }
 
+/**
+ * @brief Flush the console the area is on
+ */
+void ConsoleArea::flush() {
+
+	m_console->flush();
+}
+
 /**
  * @brief Construct a new Console Stream object
  * @param console The console to create the stream on
@@ -458,6 +473,9 @@ void ConsoleStream::write_char(char c) {
 				m_cursor_y = m_console->height() - 1;
 			}
 
+			// Show the whole line at once
+			m_console->flush();
+
 			// don't break here, we want to go to the next case because of the \r
 			[[fallthrough]];
 
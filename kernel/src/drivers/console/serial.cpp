@@ -7,9 +7,33 @@
  */
 
 #include <drivers/console/serial.h>
+#include <system/cpu.h>
 
 using namespace MaxOS;
 using namespace MaxOS::drivers;
+using namespace MaxOS::hardwarecommunication;
+using namespace MaxOS::system;
+
+/**
+ * @brief Registers for the COM1 interrupt
+ *
+ * @param console The console to pass the interrupt to
+ */
+SerialInterruptHandler::SerialInterruptHandler(SerialConsole* console)
+: InterruptHandler(0x24, 0x4, 0x18),
+  m_console(console)
+{
+
+}
+
+SerialInterruptHandler::~SerialInterruptHandler() = default;
+
+/**
+ * @brief Passes the interrupt to the console
+ */
+void SerialInterruptHandler::handle_interrupt() {
+	m_console->handle_interrupt();
+}
 
 /**
  * @brief Constructs a new Serial Console object and initialises the serial port
@@ -21,7 +45,8 @@ SerialConsole::SerialConsole(Logger* logger)
   m_fifo_control_port(0x3FA),
   m_line_control_port(0x3FB),
   m_modem_control_port(0x3FC),
-  m_line_status_port(0x3FD)
+  m_line_status_port(0x3FD),
+  m_modem_status_port(0x3FE)
 {
 
 	// Disable all interrupts
@@ -53,11 +78,111 @@ SerialConsole::SerialConsole(Logger* logger)
 	m_modem_control_port.write(0x0F);
 
 	// Set the active serial console
+	m_present = true;
+	s_active_console = this;
 	logger->add_log_writer(this);
 }
 
 SerialConsole::~SerialConsole() = default;
 
+/**
+ * @brief Starts sending and receiving with interrupts instead of waiting on the port
+ */
+void SerialConsole::activate() {
+
+	if (!m_present || m_interrupt_handler)
+		return;
+
+	m_interrupt_handler = new SerialInterruptHandler(this);
+
+	// Interrupt when data arrives and when the transmitter is empty
+	m_interrupt_enable_port.write(0x03);
+}
+
+/**
+ * @brief Refill the transmit FIFO and store the received characters
+ */
+void SerialConsole::handle_interrupt() {
+
+	m_lock.acquire();
+
+	// Reading the identification clears it, keep going until nothing else is pending
+	uint8_t identification;
+	while (!((identification = m_fifo_control_port.read()) & 0x01)) {
+		switch ((identification >> 1) & 0x07) {
+
+			// Transmitter empty
+			case 0b001:
+				m_transmitting = false;
+				fill_fifo();
+				break;
+
+			// Data available or timed out waiting for more
+			case 0b010:
+			case 0b110:
+				receive();
+				break;
+
+			// Line status
+			case 0b011:
+				m_line_status_port.read();
+				break;
+
+			// Modem status
+			default:
+				m_modem_status_port.read();
+				break;
+		}
+	}
+
+	m_lock.release();
+}
+
+/**
+ * @brief Moves queued characters into the transmit FIFO if it is empty
+ *
+ * @note The lock must be held
+ */
+void SerialConsole::fill_fifo() {
+
+	// The FIFO can only be known to have room once it is empty
+	if (!(m_line_status_port.read() & 0x20))
+		return;
+
+	uint8_t written = 0;
+	for (; written < SERIAL_FIFO_SIZE && m_transmit_tail != m_transmit_head; written++)
+		m_data_port.write(s_transmit_buffer[m_transmit_tail++ & (SERIAL_TRANSMIT_BUFFER_SIZE - 1)]);
+
+	// The interrupt will fire again once these have been sent, if nothing was written it won't so the next write has to start it
+	if (written)
+		m_transmitting = true;
+}
+
+/**
+ * @brief Stores the characters waiting in the receive FIFO, dropping them if the buffer is full
+ *
+ * @note The lock must be held
+ */
+void SerialConsole::receive() {
+
+	while (m_line_status_port.read() & 0x01) {
+		char c = (char) m_data_port.read();
+		if (m_receive_head - m_receive_tail < SERIAL_RECEIVE_BUFFER_SIZE)
+			s_receive_buffer[m_receive_head++ & (SERIAL_RECEIVE_BUFFER_SIZE - 1)] = c;
+	}
+}
+
+/**
+ * @brief Writes out the queued characters by waiting on the port
+ *
+ * @note The lock must be held
+ */
+void SerialConsole::write_queued() {
+
+	while (m_transmit_tail != m_transmit_head)
+		put_character(s_transmit_buffer[m_transmit_tail++ & (SERIAL_TRANSMIT_BUFFER_SIZE - 1)]);
+}
+
 /**
  * @brief Waits for the serial port to be ready, then writes a character to it
  *
@@ -73,6 +198,115 @@ void SerialConsole::put_character(char c) {
 
 }
 
+/**
+ * @brief Queues a character to be sent, dropping it if the queue is full
+ *
+ * @param c The character to write
+ */
 void SerialConsole::write_char(char c) {
-	put_character(c);
+
+	// Nothing will empty the queue until activated
+	if (!m_interrupt_handler) {
+		put_character(c);
+		return;
+	}
+
+	// The interrupt may never come when panicking, send what is queued then the character straight away
+	if (CPU::panic_lock.is_locked()) {
+		if (m_lock.try_acquire()) {
+			write_queued();
+			m_lock.release();
+		}
+
+		put_character(c);
+		return;
+	}
+
+	// Interrupts are off so the handler can't wait on the lock from this core
+	uint64_t flags;
+	asm volatile("pushfq\n pop %0\n cli" : "=r" (flags) : : "memory");
+	m_lock.acquire();
+
+	// Full, keep what is already queued rather than waiting for the port with interrupts off
+	if (m_transmit_head - m_transmit_tail >= SERIAL_TRANSMIT_BUFFER_SIZE)
+		m_dropped++;
+	else
+		s_transmit_buffer[m_transmit_head++ & (SERIAL_TRANSMIT_BUFFER_SIZE - 1)] = c;
+
+	// Start sending if nothing is
+	if (!m_transmitting)
+		fill_fifo();
+
+	m_lock.release();
+	if (flags & (1 << 9))
+		asm volatile("sti");
+}
+
+/**
+ * @brief Gets how many characters didn't fit in the transmit queue
+ *
+ * @return The number of characters dropped
+ */
+uint64_t SerialConsole::dropped() const {
+	return m_dropped;
+}
+
+/**
+ * @brief Takes the received characters waiting to be read
+ *
+ * @param buffer Where to copy the characters to
+ * @param size The maximum number of characters to copy
+ * @return The number of characters copied
+ */
+size_t SerialConsole::read(char* buffer, size_t size) {
+
+	uint64_t flags;
+	asm volatile("pushfq\n pop %0\n cli" : "=r" (flags) : : "memory");
+	m_lock.acquire();
+
+	size_t count = 0;
+	for (; count < size && m_receive_tail != m_receive_head; count++)
+		buffer[count] = s_receive_buffer[m_receive_tail++ & (SERIAL_RECEIVE_BUFFER_SIZE - 1)];
+
+	m_lock.release();
+	if (flags & (1 << 9))
+		asm volatile("sti");
+
+	return count;
+}
+
+/**
+ * @brief Get how many characters are waiting to be sent
+ *
+ * @return The number of queued characters
+ */
+uint32_t SerialConsole::queued() const {
+	return __atomic_load_n(&m_transmit_head, __ATOMIC_RELAXED) - __atomic_load_n(&m_transmit_tail, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Get the serial console that is writing to COM1
+ *
+ * @return The console, or nullptr if there is no serial port
+ */
+SerialConsole* SerialConsole::active_console() {
+	return s_active_console;
+}
+
+/**
+ * @brief Get the vendor name
+ *
+ * @return The vendor name of the driver
+ */
+string SerialConsole::vendor_name() {
+	return "Generic";
+}
+
+/**
+ * @brief Get the device name
+ *
+ * @return The name of the device
+ */
+string SerialConsole::device_name() {
+	return "16550 UART";
 }
\ No newline at end of file
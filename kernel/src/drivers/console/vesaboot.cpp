@@ -34,6 +34,11 @@ VESABootConsole::VESABootConsole(GraphicsContext* graphics_context)
 	VESABootConsole::clear();
 	print_logo();
 	m_console_area = new ConsoleArea(this, 0, 0, width() / 2 - 25, height(), ConsoleColour::DarkGrey, ConsoleColour::Black);
+
+	// Draw the log area off screen so scrolling never reads the framebuffer
+	m_buffered_width = m_console_area->width();
+	s_back_buffer = new Surface(m_buffered_width * FONT_WIDTH, height() * FONT_HEIGHT, s_graphics_context->color_depth());
+	s_back_buffer->fill_rect(0, 0, (int32_t) s_back_buffer->width(), (int32_t) s_back_buffer->height(), Colour(ConsoleColour::Black));
 	cout = new ConsoleStream(m_console_area);
 
 	// Only log to the screen when debugging
@@ -125,15 +130,83 @@ void VESABootConsole::put_character(uint16_t x, uint16_t y, char c) {
 	// Set the character at the offset, by masking the character with the current character (last 8 bits)
 	m_video_memory_meta[offset] = (m_video_memory_meta[offset] & 0xFF00) | (uint16_t) c;
 
-	// Convert the char into a string
-	char s[] = " ";
-	s[0] = c;
-
 	Colour foreground = m_foreground_color == ConsoleColour::Uninitialised ? Colour(get_foreground_color(x, y)) : Colour(m_foreground_color);
 	Colour background = m_background_color == ConsoleColour::Uninitialised ? Colour(get_background_color(x, y)) : Colour(m_background_color);
 
-	// Use the m_font to draw the character
-	m_font.draw_text(x * 8, y * FONT_HEIGHT, foreground, background, s_graphics_context, s);
+	render_character(x, y, c, s_graphics_context->colour_to_int(foreground), s_graphics_context->colour_to_int(background));
+}
+
+/**
+ * @brief Draws a character into the back buffer if it is in the log area, otherwise straight to the screen
+ *
+ * @param x The x coordinate
+ * @param y The y coordinate
+ * @param c The character to draw
+ * @param foreground The colour of the character (in the format of the screen)
+ * @param background The colour behind the character (in the format of the screen)
+ */
+void VESABootConsole::render_character(uint16_t x, uint16_t y, char c, uint32_t foreground, uint32_t background) {
+
+	if(x >= m_buffered_width) {
+		m_font.draw_character(x * FONT_WIDTH, y * FONT_HEIGHT, foreground, background, s_graphics_context, c);
+		return;
+	}
+
+	// The back buffer lines start at the top of the ring
+	uint16_t line = (y + m_ring_top) % height();
+	m_font.draw_character(x * FONT_WIDTH, line * FONT_HEIGHT, foreground, background, s_back_buffer, c);
+	invalidate_lines(y, y + 1);
+}
+
+/**
+ * @brief Fills an area of cells with a colour, in the back buffer for the part in the log area and on the screen for the rest
+ *
+ * @param left The left coordinate of the area
+ * @param top The top coordinate of the area
+ * @param width The width of the area
+ * @param height The height of the area
+ * @param background The colour to fill with (in the format of the screen)
+ */
+void VESABootConsole::render_fill(uint16_t left, uint16_t top, uint16_t width, uint16_t height, uint32_t background) {
+
+	uint16_t right = left + width;
+	uint16_t buffered_right = right < m_buffered_width ? right : m_buffered_width;
+
+	// Fill a line at a time as the lines wrap around the ring
+	if(left < buffered_right) {
+		for(uint16_t y = top; y < top + height; y++) {
+			uint16_t line = (y + m_ring_top) % this->height();
+			s_back_buffer->fill_rect(left * FONT_WIDTH, line * FONT_HEIGHT, (buffered_right - left) * FONT_WIDTH, FONT_HEIGHT, background);
+		}
+
+		invalidate_lines(top, top + height);
+		left = buffered_right;
+	}
+
+	if(left < right)
+		s_graphics_context->fill_rect(left * FONT_WIDTH, top * FONT_HEIGHT, (right - left) * FONT_WIDTH, height * FONT_HEIGHT, background);
+}
+
+/**
+ * @brief Marks lines of the log area as needing to be copied to the screen on the next flush
+ *
+ * @param top The first line that changed
+ * @param bottom The line after the last line that changed
+ */
+void VESABootConsole::invalidate_lines(uint16_t top, uint16_t bottom) {
+
+	// Nothing is waiting to be flushed
+	if(m_dirty_top >= m_dirty_bottom) {
+		m_dirty_top = top;
+		m_dirty_bottom = bottom;
+		return;
+	}
+
+	if(top < m_dirty_top)
+		m_dirty_top = top;
+
+	if(bottom > m_dirty_bottom)
+		m_dirty_bottom = bottom;
 }
 
 /**
@@ -261,6 +334,8 @@ void VESABootConsole::print_logo(bool is_panic) {
 	// Fill the screen with the logo colour
 	auto col = Colour(is_panic ? ConsoleColour::Red : ConsoleColour::Black);
 	memset(s_graphics_context->framebuffer_address(), s_graphics_context->colour_to_int(col), screen_width * screen_height * (s_graphics_context->color_depth() / 8));
+	if(s_back_buffer)
+		s_back_buffer->fill_rect(0, 0, (int32_t) s_back_buffer->width(), (int32_t) s_back_buffer->height(), col);
 
 	// Draw the logo
 	for(uint32_t logo_y = 0; logo_y < LOGO_HEIGHT; ++logo_y) {
@@ -284,6 +359,9 @@ void VESABootConsole::print_logo(bool is_panic) {
 /**
  * @brief Scrolls the console up by 1 line
  *
+ * @details Scrolling the whole log area only moves the top of the ring, the new positions are copied to the screen on the
+ * next flush. Other areas outside the log area are moved on the screen.
+ *
  * @param left The left coordinate of the area to scroll
  * @param top The top coordinate of the area to scroll
  * @param width The width of the area to scroll
@@ -297,50 +375,113 @@ void VESABootConsole::scroll_up(uint16_t left, uint16_t top, uint16_t width,
                                 common::ConsoleColour foreground,
                                 common::ConsoleColour background, char fill) {
 
+	if(!width || !height)
+		return;
 
-	// Get the framebuffer info
-	auto* framebuffer_address = (uint8_t*) s_graphics_context->framebuffer_address();
-	uint64_t framebuffer_width = s_graphics_context->width();
-	uint64_t framebuffer_bpp = s_graphics_context->color_depth(); // in bits per pixel
-	uint64_t bytes_per_pixel = framebuffer_bpp / 8;
-	uint64_t framebuffer_pitch = framebuffer_width * bytes_per_pixel;
-
-	uint16_t line_height = FONT_HEIGHT;
-
-	// Region conversions
-	uint16_t region_pixel_y = top * line_height;
-	uint16_t region_pixel_height = height * line_height;
-	uint16_t region_pixel_left = left * FONT_WIDTH;
-	uint16_t region_pixel_width = width * FONT_WIDTH;
-	size_t row_bytes = region_pixel_width * bytes_per_pixel;
-
-	// Decide the colour of the pixel
+	// The new line keeps the colours of the old bottom line
 	ConsoleColour to_set_foreground = get_foreground_color(left, top + height - 1);
 	ConsoleColour to_set_background = get_background_color(left, top + height - 1);
-	uint32_t fill_value = s_graphics_context->colour_to_int(Colour(to_set_background));
 
-	// Scroll the region upward by one text line
-	for(uint16_t row = 0; row < region_pixel_height - line_height; row++) {
-		uint8_t* src = framebuffer_address + (region_pixel_y + row + line_height) * framebuffer_pitch + region_pixel_left * bytes_per_pixel;
-		uint8_t* dest = framebuffer_address + (region_pixel_y + row) * framebuffer_pitch + region_pixel_left * bytes_per_pixel;
-		memmove(dest, src, row_bytes);
+	bool whole_log = left == 0 && top == 0 && width == m_buffered_width && height == this->height();
+	if(!whole_log && left < m_buffered_width) {
+
+		// Part of the log area, move it a character at a time
+		Console::scroll_up(left, top, width, height, to_set_foreground, to_set_background, fill);
+		return;
 	}
 
-	// Clear the last line of the region
-	uint16_t clear_start_y = region_pixel_y + region_pixel_height - line_height;
-	for(uint16_t row = 0; row < line_height; row++) {
-		auto row_add = (uint32_t*) (framebuffer_address + (clear_start_y + row) * framebuffer_pitch + region_pixel_left * 4);
-		for(uint16_t col = 0; col < region_pixel_width; col++) {
-			row_add[col] = fill_value;
-		}
+	// Move the text up in the grid
+	uint16_t grid_width = this->width();
+	for(uint16_t y = top; y < top + height - 1; y++)
+		memmove(&m_video_memory_meta[y * grid_width + left], &m_video_memory_meta[(y + 1) * grid_width + left], width * sizeof(uint16_t));
+
+	// Move the pixels
+	if(whole_log) {
+		m_ring_top = (m_ring_top + 1) % height;
+		invalidate_lines(0, height);
+	} else {
+		s_graphics_context->copy_rect(left * FONT_WIDTH, (top + 1) * FONT_HEIGHT, width * FONT_WIDTH, (height - 1) * FONT_HEIGHT, left * FONT_WIDTH, top * FONT_HEIGHT);
 	}
 
-	//Update any per-pixel colour metadata
+	// Clear the new line
 	uint16_t text_row = top + height - 1;
-	for(uint16_t x = left; x < left + width; x++) {
-		set_foreground_color(x, text_row, to_set_foreground);
-		set_background_color(x, text_row, to_set_background);
-	}
+	uint16_t cell = (uint8_t) fill | ((uint16_t) to_set_foreground << 8) | ((uint16_t) to_set_background << 12);
+	for(uint16_t x = left; x < left + width; x++)
+		m_video_memory_meta[text_row * grid_width + x] = cell;
+
+	uint32_t fill_value = s_graphics_context->colour_to_int(Colour(to_set_background));
+	render_fill(left, text_row, width, 1, fill_value);
+
+	if(fill != ' ')
+		for(uint16_t x = left; x < left + width; x++)
+			render_character(x, text_row, fill, s_graphics_context->colour_to_int(Colour(to_set_foreground)), fill_value);
+}
+
+/**
+ * @brief Clears the entire console
+ */
+void VESABootConsole::clear() {
+
+	Console::clear();
+}
+
+/**
+ * @brief Clears an area of the console, filling the pixels a rectangle at a time instead of drawing each cell
+ *
+ * @param left The left coordinate of the area to clear
+ * @param top The top coordinate of the area to clear
+ * @param width The width of the area to clear
+ * @param height The height of the area to clear
+ * @param foreground The foreground color of the area
+ * @param background The background color of the area
+ * @param fill The character to fill the area with
+ */
+void VESABootConsole::clear(uint16_t left, uint16_t top, uint16_t width, uint16_t height, ConsoleColour foreground, ConsoleColour background, char fill) {
+
+	// Check bounds
+	if(left + width > this->width() || top + height > this->height() || !width || !height)
+		return;
+
+	// Store the cells
+	uint16_t grid_width = this->width();
+	uint16_t cell = (uint8_t) fill | ((uint16_t) foreground << 8) | ((uint16_t) background << 12);
+	for(uint16_t y = top; y < top + height; y++)
+		for(uint16_t x = left; x < left + width; x++)
+			m_video_memory_meta[y * grid_width + x] = cell;
+
+	// Draw them
+	Colour foreground_colour = m_foreground_color == ConsoleColour::Uninitialised ? Colour(get_foreground_color(left, top)) : Colour(m_foreground_color);
+	Colour background_colour = m_background_color == ConsoleColour::Uninitialised ? Colour(get_background_color(left, top)) : Colour(m_background_color);
+	render_fill(left, top, width, height, s_graphics_context->colour_to_int(background_colour));
+
+	if(fill != ' ')
+		for(uint16_t y = top; y < top + height; y++)
+			for(uint16_t x = left; x < left + width; x++)
+				render_character(x, y, fill, s_graphics_context->colour_to_int(foreground_colour), s_graphics_context->colour_to_int(background_colour));
+}
+
+/**
+ * @brief Copies the lines of the log area that changed since the last flush to the screen
+ */
+void VESABootConsole::flush() {
+
+	// Nothing to copy
+	if(!s_back_buffer || m_dirty_top >= m_dirty_bottom)
+		return;
+
+	// The lines may wrap around the end of the back buffer, making two copies
+	uint16_t lines = height();
+	uint16_t first = (m_dirty_top + m_ring_top) % lines;
+	uint16_t count = m_dirty_bottom - m_dirty_top;
+	uint16_t before_wrap = count < lines - first ? count : lines - first;
+	int32_t pixel_width = m_buffered_width * FONT_WIDTH;
+
+	s_back_buffer->composite(s_graphics_context, 0, (m_dirty_top - first) * FONT_HEIGHT, Rectangle<int32_t>(0, first * FONT_HEIGHT, pixel_width, before_wrap * FONT_HEIGHT));
+	if(before_wrap < count)
+		s_back_buffer->composite(s_graphics_context, 0, (m_dirty_top + before_wrap) * FONT_HEIGHT, Rectangle<int32_t>(0, 0, pixel_width, (count - before_wrap) * FONT_HEIGHT));
+
+	m_dirty_top = 0;
+	m_dirty_bottom = 0;
 }
 
 /**
@@ -350,6 +491,7 @@ void VESABootConsole::finish() const {
 
 	// Done
 	Logger::HEADER() << "MaxOS Kernel Successfully Booted\n" << ANSI_COLOURS[ANSIColour::Reset];
+	Logger::active_logger()->flush();
 	cout->set_cursor(0, 0);
 	Logger::active_logger()->disable_log_writer(cout);
 }
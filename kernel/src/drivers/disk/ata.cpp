@@ -19,8 +19,9 @@ using namespace MaxOS::drivers::disk;
  *
  * @param port_base The base port for the ATA device
  * @param master True if the device is master, false if slave
+ * @param channel_lock The lock shared by the devices on this channel
  */
-AdvancedTechnologyAttachment::AdvancedTechnologyAttachment(uint16_t port_base, bool master)
+AdvancedTechnologyAttachment::AdvancedTechnologyAttachment(uint16_t port_base, bool master, BlockingLock* channel_lock)
 		: m_data_port(port_base),
 		m_error_port(port_base + 1),
 		m_sector_count_port(port_base + 2),
@@ -30,7 +31,8 @@ AdvancedTechnologyAttachment::AdvancedTechnologyAttachment(uint16_t port_base, b
 		m_device_port(port_base + 6),
 		m_command_port(port_base + 7),
 		m_control_port(port_base + 0x206),
-		m_is_master(master) {
+		m_is_master(master),
+		m_channel_lock(channel_lock) {
 
 }
 
@@ -43,6 +45,8 @@ AdvancedTechnologyAttachment::~AdvancedTechnologyAttachment() = default;
  */
 bool AdvancedTechnologyAttachment::identify() {
 
+	m_channel_lock->lock();
+
 	// Select the device (master or slave)
 	m_device_port.write(m_is_master ? 0xA0 : 0xB0);
 
@@ -53,6 +57,7 @@ bool AdvancedTechnologyAttachment::identify() {
 	m_device_port.write(0xA0);
 	uint8_t status = m_command_port.read();
 	if (status == 0xFF) {
+		m_channel_lock->unlock();
 		Logger::WARNING() << "ATA Device: Invalid status";
 		return false;
 	}
@@ -69,8 +74,10 @@ bool AdvancedTechnologyAttachment::identify() {
 	// Check if the device is present
 	m_command_port.write(0x0EC);
 	status = m_command_port.read();
-	if (status == 0x00)
+	if (status == 0x00) {
+		m_channel_lock->unlock();
 		return false;
+	}
 
 	// Wait for the device to be ready or for an error to occur
 	while (((status & 0x80) == 0x80) && ((status & 0x01) != 0x01))
@@ -78,6 +85,7 @@ bool AdvancedTechnologyAttachment::identify() {
 
 	//Check for any errors
 	if (status & 0x01) {
+		m_channel_lock->unlock();
 		Logger::WARNING() << "ATA Device: Error reading status\n";
 		return false;
 	}
@@ -88,6 +96,7 @@ bool AdvancedTechnologyAttachment::identify() {
 		(void) data;
 	}
 
+	m_channel_lock->unlock();
 
 	// Device is present and ready
 	return true;
@@ -106,6 +115,8 @@ void AdvancedTechnologyAttachment::read(uint32_t sector, buffer_t* data_buffer,
 	if (sector & 0xF0000000 || amount > m_bytes_per_sector)
 		return;
 
+	m_channel_lock->lock();
+
 	// Select the device (master or slave)
 	m_device_port.write((m_is_master ? 0xE0 : 0xF0) | ((sector & 0x0F000000) >> 24));
 
@@ -126,16 +137,20 @@ void AdvancedTechnologyAttachment::read(uint32_t sector, buffer_t* data_buffer,
 
 	// Make sure the device is there
 	uint8_t status = m_command_port.read();
-	if (status == 0x00)
+	if (status == 0x00) {
+		m_channel_lock->unlock();
 		return;
+	}
 
 	// Wait for the device to be ready or for an error to occur @todo Userspace block here
 	while (((status & 0x80) == 0x80) && ((status & 0x01) != 0x01))
 		status = m_command_port.read();
 
 	//Check for any errors
-	if (status & 0x01)
+	if (status & 0x01) {
+		m_channel_lock->unlock();
 		return;
+	}
 
 	for (size_t i = 0; i < amount; i += 2) {
 
@@ -151,6 +166,83 @@ void AdvancedTechnologyAttachment::read(uint32_t sector, buffer_t* data_buffer,
 	// Read the remaining bytes as a full sector has to be read
 	for (uint16_t i = amount + (amount % 2); i < m_bytes_per_sector; i += 2)
 		m_data_port.read();
+
+	m_channel_lock->unlock();
+}
+
+/**
+ * @brief read a run of whole sectors from the ATA device, using as few commands as possible
+ *
+ * @param sector The first sector to read
+ * @param count How many sectors to read
+ * @param data_buffer The buffer to read the data into (must hold count sectors)
+ */
+void AdvancedTechnologyAttachment::read_sectors(uint32_t sector, uint32_t count, buffer_t* data_buffer) {
+
+	// Don't allow reading past what 28 bit addressing can reach
+	if ((uint64_t) sector + count > 0x10000000)
+		return;
+
+	m_channel_lock->lock();
+	while (count) {
+
+		// A count of 0 tells the device to read the most it can
+		uint32_t batch = count < ATA_MAX_SECTORS_PER_COMMAND ? count : ATA_MAX_SECTORS_PER_COMMAND;
+
+		// Select the device (master or slave)
+		m_device_port.write((m_is_master ? 0xE0 : 0xF0) | ((sector & 0x0F000000) >> 24));
+
+		// Device is busy @todo yield
+		while ((m_command_port.read() & 0x80) != 0);
+
+		// Reset the device
+		m_error_port.write(0);
+		m_sector_count_port.write((uint8_t) batch);
+
+		// Split the sector into the ports
+		m_LBA_low_port.write(sector & 0x000000FF);
+		m_LBA_mid_port.write((sector & 0x0000FF00) >> 8);
+		m_LBA_high_Port.write((sector & 0x00FF0000) >> 16);
+
+		// Tell the device to prepare for reading
+		m_command_port.write(0x20);
+
+		for (uint32_t i = 0; i < batch; ++i) {
+
+			// Make sure the device is there
+			uint8_t status = m_command_port.read();
+			if (status == 0x00) {
+				m_channel_lock->unlock();
+				return;
+			}
+
+			// Wait for the sector to be ready or for an error to occur @todo Userspace block here
+			while (((status & 0x80) == 0x80 || (status & 0x08) != 0x08) && (status & 0x01) != 0x01)
+				status = m_command_port.read();
+
+			// Check for any errors
+			if (status & 0x01) {
+				m_channel_lock->unlock();
+				return;
+			}
+
+			// Read the whole sector
+			for (uint16_t j = 0; j < m_bytes_per_sector; j += 2) {
+				uint16_t read_data = m_data_port.read();
+				data_buffer->write(read_data & 0x00FF);
+				data_buffer->write((read_data >> 8) & 0x00FF);
+			}
+
+			// Give the device time to update its status before the next sector (reading the alternate status takes ~100ns)
+			for (int delay = 0; delay < 4; ++delay)
+				m_control_port.read();
+		}
+
+		sector += batch;
+		count -= batch;
+	}
+
+	m_channel_lock->unlock();
 }
 
 /**
@@ -166,6 +258,8 @@ void AdvancedTechnologyAttachment::write(uint32_t sector, buffer_t* data, size_t
 	if (sector > 0x0FFFFFFF || count > m_bytes_per_sector)
 		return;
 
+	m_channel_lock->lock();
+
 	// Select the device (master or slave)
 	m_device_port.write(m_is_master ? 0xE0 : 0xF0 | ((sector & 0x0F000000) >> 24));
 
@@ -210,7 +304,8 @@ void AdvancedTechnologyAttachment::write(uint32_t sector, buffer_t* data, size_t
 	while ((status & 0x80) != 0 || (status & 0x08) != 0)
 		status = m_command_port.read();
 
-	flush();
+	send_flush();
+	m_channel_lock->unlock();
 }
 
 /**
@@ -218,6 +313,18 @@ void AdvancedTechnologyAttachment::write(uint32_t sector, buffer_t* data, size_t
  */
 void AdvancedTechnologyAttachment::flush() {
 
+	m_channel_lock->lock();
+	send_flush();
+	m_channel_lock->unlock();
+}
+
+/**
+ * @brief Sends the flush cache command
+ *
+ * @note The channel lock must be held
+ */
+void AdvancedTechnologyAttachment::send_flush() {
+
 	// Select the device (master or slave)
 	m_device_port.write(m_is_master ? 0xE0 : 0xF0);
 
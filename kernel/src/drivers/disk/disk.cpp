@@ -41,6 +41,19 @@ void Disk::read(uint32_t sector, buffer_t* data_buffer, size_t amount) {
 
 }
 
+/**
+ * @brief read a run of whole sectors from the disk, drivers that can transfer many sectors at once should override this
+ *
+ * @param sector The first sector to read
+ * @param count How many sectors to read
+ * @param data_buffer The buffer to read the data into (must hold count sectors)
+ */
+void Disk::read_sectors(uint32_t sector, uint32_t count, buffer_t* data_buffer) {
+
+	for (uint32_t i = 0; i < count; ++i)
+		read(sector + i, data_buffer, 512);
+}
+
 /**
  * @brief write data to the disk from a buffer (max capacity 512 bytes)
  *
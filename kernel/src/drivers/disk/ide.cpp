@@ -25,14 +25,14 @@ using namespace MaxOS::filesystem::partition;
 IntegratedDriveElectronicsController::IntegratedDriveElectronicsController(PCIDeviceDescriptor* device_descriptor)
 {
 	// Primary
-	auto primary_maser = new AdvancedTechnologyAttachment(0x1F0, true);
-	auto primary_slave = new AdvancedTechnologyAttachment(0x1F0, false);
+	auto primary_maser = new AdvancedTechnologyAttachment(0x1F0, true, &m_primary_lock);
+	auto primary_slave = new AdvancedTechnologyAttachment(0x1F0, false, &m_primary_lock);
 	devices.insert(primary_maser, true);
 	devices.insert(primary_slave, false);
 
 	// Secondary
-	auto secondary_maser = new AdvancedTechnologyAttachment(0x170, true);
-	auto secondary_slave = new AdvancedTechnologyAttachment(0x170, false);
+	auto secondary_maser = new AdvancedTechnologyAttachment(0x170, true, &m_secondary_lock);
+	auto secondary_slave = new AdvancedTechnologyAttachment(0x170, false, &m_secondary_lock);
 	devices.insert(secondary_maser, true);
 	devices.insert(secondary_slave, false);
 
@@ -7,6 +7,8 @@
  */
 
 #include <drivers/ethernet/amd_am79c973.h>
+#include <memory/physical.h>
+#include <memory/memoryIO.h>
 
 using namespace MaxOS;
 using namespace MaxOS::common;
@@ -14,6 +16,7 @@ using namespace MaxOS::memory;
 using namespace MaxOS::drivers;
 using namespace MaxOS::drivers::ethernet;
 using namespace MaxOS::hardwarecommunication;
+using namespace MaxOS::net;
 
 /// MAX OS NET CODE:
 ///     All the old (this) networking code poorly written and not used, this will be moved to userspace in the future
@@ -22,8 +25,10 @@ using namespace MaxOS::hardwarecommunication;
 /**
  * @brief Constructs a new AMD_AM79C973 Ethernet driver, reads the MAC address and sets up the initialisation block and buffer descriptors
  * @param dev The PCI device descriptor for this device
+ * @param receive_ring_size How many receive descriptors to use (rounded to a power of two, at most 512)
+ * @param send_ring_size How many send descriptors to use (rounded to a power of two, at most 512)
  */
-AMD_AM79C973::AMD_AM79C973(PCIDeviceDescriptor* dev)
+AMD_AM79C973::AMD_AM79C973(PCIDeviceDescriptor* dev, uint32_t receive_ring_size, uint32_t send_ring_size)
 : InterruptHandler(0x20 + dev->interrupt),
 mac_address_0_port(dev->port_base),
 mac_address_2_port(dev->port_base + 0x02),
@@ -32,12 +37,23 @@ register_data_port(dev->port_base + 0x10),
 register_address_port(dev->port_base + 0x12),
 bus_control_register_data_port(dev->port_base + 0x16),
 reset_port(dev->port_base + 0x14),
-init_block(),
-send_buffers(),
-recv_buffers() {
-	// No active buffer at the start
-	current_send_buffer = 0;
-	current_recv_buffer = 0;
+init_block(nullptr),
+send_ring_size(ring_size(send_ring_size)),
+send_buffer_descr(nullptr),
+send_packets(nullptr),
+current_send_buffer(0),
+reclaim_send_buffer(0),
+sends_in_flight(0),
+recv_ring_size(ring_size(receive_ring_size)),
+recv_buffer_descr(nullptr),
+recv_buffers(nullptr),
+current_recv_buffer(0) {
+
+	// The ring length is stored as a power of two in 4 bits
+	if(this->send_ring_size > AMD_AM79C973_MAX_RING_SIZE)
+		this->send_ring_size = AMD_AM79C973_MAX_RING_SIZE;
+	if(this->recv_ring_size > AMD_AM79C973_MAX_RING_SIZE)
+		this->recv_ring_size = AMD_AM79C973_MAX_RING_SIZE;
 
 	//Not active or initialised
 	active = false;
@@ -69,48 +85,59 @@ recv_buffers() {
 	register_address_port.write(0);               // Tell device to write to register 0
 	register_data_port.write(0x04);               // write desired data
 
+	// The device reads everything by (32 bit) physical address so the init block, descriptors and receive buffers share one area
+	size_t init_size = (sizeof(InitializationBlock) + 15) & ~(size_t) 0xF;
+	size_t recv_descriptors_size = recv_ring_size * sizeof(BufferDescriptor);
+	size_t send_descriptors_size = send_ring_size * sizeof(BufferDescriptor);
+	size_t rings_size = init_size + recv_descriptors_size + send_descriptors_size;
+	auto physical = (uintptr_t) PhysicalMemoryManager::s_current_manager->allocate_area(0, rings_size + recv_ring_size * ETHERNET_RING_BUFFER_SIZE, DMA_32_BIT_LIMIT);
+	auto* memory = (uint8_t*) PhysicalMemoryManager::to_dm_region(physical);
+	memset(memory, 0, rings_size);
+
+	init_block = (InitializationBlock*) memory;
+	recv_buffer_descr = (BufferDescriptor*) (memory + init_size);
+	send_buffer_descr = (BufferDescriptor*) (memory + init_size + recv_descriptors_size);
+	recv_buffers = memory + rings_size;
+	send_packets = new PacketBuffer*[send_ring_size];
+
+	// Ring lengths are given as powers of two
+	uint8_t send_ring_bits = 0;
+	uint8_t recv_ring_bits = 0;
+	while((1u << send_ring_bits) < send_ring_size) send_ring_bits++;
+	while((1u << recv_ring_bits) < recv_ring_size) recv_ring_bits++;
+
 	// Set the initialization block
-	init_block.mode = 0x0000;                         // Promiscuous mode = false   ( promiscuous mode tells it to receive all packets, not just broadcasts and those for its own MAC address)
-	init_block.reserved1 = 0;                         // Reserved
-	init_block.num_send_buffers = 3;                    // Means 8 because 2^8 (number of bits used)
-	init_block.reserved2 = 0;                         // Reserved
-	init_block.num_recv_buffers = 3;                    // Means 8 because 2^8 (number of bits used)
-	init_block.physical_address = own_mac;              // Set the physical address to the MAC address
-	init_block.reserved3 = 0;                         // Reserved
-	init_block.logical_address = 0;                    // None for now
-
-	// Set Buffer descriptors memory
-	send_buffer_descr = (BufferDescriptor*) (MemoryManager::kmalloc((sizeof(BufferDescriptor) * 8) + 15));  // Allocate memory for 8 buffer descriptors
-	init_block.send_buffer_descr_address = (uint64_t) send_buffer_descr;
-
-	recv_buffer_descr = (BufferDescriptor*) (MemoryManager::kmalloc((sizeof(BufferDescriptor) * 8) + 15));  // Allocate memory for 8 buffer descriptors
-	init_block.recv_buffer_descr_address = (uint64_t) recv_buffer_descr;
-
-	for(uint8_t i = 0; i < 8; i++) {
-
-		// Send buffer descriptors
-		send_buffer_descr[i].address = (((uint64_t) &send_buffers[i]) + 15) & ~(uint32_t) 0xF;       // Same as above
-		send_buffer_descr[i].flags =
-		0x7FF                                                         // Length of descriptor
-		| 0xF000;                                                     // Set it to send buffer
-		send_buffer_descr[i].flags2 = 0;                                                           // "Flags2" shows whether an error occurred while sending and should therefore be set to 0 by the drive
-		send_buffer_descr[i].avail = 0;                                                            // IF it is in use
-
-		// Receive
-		recv_buffer_descr[i].address = (((uint64_t) &recv_buffers[i]) + 15) & ~(uint32_t) 0xF;   // Same as above
+	init_block->mode = 0x0000;                         // Promiscuous mode = false   ( promiscuous mode tells it to receive all packets, not just broadcasts and those for its own MAC address)
+	init_block->reserved1 = 0;                         // Reserved
+	init_block->num_send_buffers = send_ring_bits;       // 2^n descriptors
+	init_block->reserved2 = 0;                         // Reserved
+	init_block->num_recv_buffers = recv_ring_bits;       // 2^n descriptors
+	init_block->physical_address = own_mac;              // Set the physical address to the MAC address
+	init_block->reserved3 = 0;                         // Reserved
+	init_block->logical_address = 0;                    // None for now
+	init_block->recv_buffer_descr_address = physical + init_size;
+	init_block->send_buffer_descr_address = physical + init_size + recv_descriptors_size;
+
+	// Send buffer descriptors point at the packet being sent so start empty
+	for(uint32_t i = 0; i < send_ring_size; i++) {
+		send_packets[i] = nullptr;
+		send_buffer_descr[i].flags = 0xF000;                                                       // Set it to send buffer
+	}
+
+	// Receive
+	for(uint32_t i = 0; i < recv_ring_size; i++) {
+		recv_buffer_descr[i].address = physical + rings_size + i * ETHERNET_RING_BUFFER_SIZE;
 		recv_buffer_descr[i].flags =
-		0xF7FF                                                        // Length of descriptor        (This 0xF7FF is what was causing the problem, it used to be 0x7FF)
-		| 0x80000000;                                                 // Set it to receive buffer
-		recv_buffer_descr[i].flags2 = 0;                                                           // "Flags2" shows whether an error occurred while sending and should therefore be set to 0 by the drive
-		recv_buffer_descr[i].avail = 0;                                                            // IF it is in use
+		0xF000 | ((-ETHERNET_RING_BUFFER_SIZE) & 0xFFF)               // Length of the buffer (two's complement)
+		| 0x80000000;                                                 // Give it to the device
 	}
 
 	// Move initialization block into device
 	register_address_port.write(1);                                     // Tell device to write to register 1
-	register_data_port.write((uint64_t) (&init_block) &
+	register_data_port.write((physical) &
 	                         0xFFFF);             // write address data
 	register_address_port.write(2);                                     // Tell device to write to register 2
-	register_data_port.write(((uint64_t) (&init_block) >> 16) &
+	register_data_port.write(((physical) >> 16) &
 	                         0xFFFF);     // write shifted address data
 
 
@@ -178,14 +205,21 @@ void AMD_AM79C973::handle_interrupt() {
 		Logger::WARNING() << "AMD am79c973 ERROR: ";
 	if((temp & 0x2000) == 0x2000)
 		Logger::WARNING() << "COLLISION ERROR\n";
-	if((temp & 0x1000) == 0x1000)
+	if((temp & 0x1000) == 0x1000) {
 		Logger::WARNING() << "MISSED FRAME\n";
+		m_statistics.receive_overruns++;
+	}
 	if((temp & 0x0800) == 0x0800)
 		Logger::WARNING() << "MEMORY ERROR\n";
 
 
 	// Responses
-	if((temp & 0x0400) == 0x0400) fetch_data_received();
+	if((temp & 0x0400) == 0x0400) {
+		if(polling())
+			schedule_poll();
+		else
+			fetch_data_received(UINT32_MAX);
+	}
 	if((temp & 0x0200) == 0x0200) fetch_data_sent();
 	if((temp & 0x0100) == 0x0100) init_done = true;//
 
@@ -202,54 +236,110 @@ void AMD_AM79C973::handle_interrupt() {
 //  Furthermore, STP (Start of Packet, 0x02000000) and ENP (End of Packet, 0x01000000) should be set - this indicates that the data is not split up, but that it is a single Ethernet packet.
 //  Furthermore, bits 12-15 must be set (0x0000F000, are probably reserved) and bits 0-11 are negative Size of the package.
 /**
- * @brief This function sends a package
+ * @brief This function sends a package, the card reads it straight out of the packet buffer
  *
- * @param buffer The buffer to send
- * @param size The size of the buffer
+ * @param packet The packet to send, released once the card has sent it and the descriptor is reclaimed
  */
-void AMD_AM79C973::do_send(uint8_t* buffer, uint32_t size) {
+void AMD_AM79C973::do_send(PacketBuffer* packet) {
 
-	while(!active);
+	// Not set up yet, there is nowhere to put the packet
+	if(!active) {
+		__atomic_add_fetch(&m_statistics.send_dropped, 1, __ATOMIC_RELAXED);
+		packet->release();
+		return;
+	}
 
-	int send_descriptor = current_send_buffer;              // Get where data has been written to
-	current_send_buffer = (current_send_buffer + 1) %
-	                      8;    // Move send buffer to next send buffer (div by 8 so that it is cycled) (this allows for data to be sent from different m_tasks in parallel)
+	// Oversized frames were already rejected by EthernetDriver::send()
+	uint32_t size = packet->length();
 
-	if(size >
-	   1518) {                                    // If attempt to send more than 1518 bytes at once it will be too large
-		size = 1518;                                    // Discard all data after that  (Generally if data is bigger than that at driver level then a higher up network layer must have made a mistake)
+	// The interrupt reclaims and replies on this core, so it must not come in while the lock is held
+	uint64_t flags = send_lock.acquire_irqsave();
 
-	}
+	// Reclaim in batches rather than waiting for each packet to go out
+	if(sends_in_flight >= ETHERNET_SEND_RECLAIM_BATCH || sends_in_flight == send_ring_size)
+		reclaim_sent();
 
-	// What this loop does is copy the information passed as the parameter buffer (src) to the send buffer in the ram (dst) which the card will then use to send the data
-	for(uint8_t* src = buffer + size -
-	                   1,                                                   // Set src pointer to the end of the data that is being sent
-	    * dst = (uint8_t*) (send_buffer_descr[send_descriptor].address + size -
-	                        1);       // Take the buffer that has been selected
-	    src >=
-	    buffer;                                                             // While there is still information in the buffer that hasn't been written to src
-	    src--, dst--                                                                // Move 2 pointers to the end of the buffers
-	) {
-		*dst = *src;                                                                        // Copy data from source buffer to destination buffer
+	// Ring is full
+	if(sends_in_flight == send_ring_size) {
+		m_statistics.send_dropped++;
+		send_lock.release_irqrestore(flags);
+		packet->release();
+		return;
 	}
 
+	buffer_descriptor_t& descriptor = send_buffer_descr[current_send_buffer];
+	send_packets[current_send_buffer] = packet;
+	current_send_buffer = (current_send_buffer + 1) % send_ring_size;    // Move send buffer to next send buffer (this allows for data to be sent from different m_tasks in parallel)
+	sends_in_flight++;
+	m_statistics.sent++;
 
-	send_buffer_descr[send_descriptor].avail = 0;                               // Set that this buffer is in use
-	send_buffer_descr[send_descriptor].flags2 = 0;                              // Clear any previous error messages
-	send_buffer_descr[send_descriptor].flags = 0x8300F000                       // Encode the size of what is being sent
-	                                           | ((uint16_t) ((-size) & 0xFFF));
+	descriptor.address = packet->physical_address();
+	descriptor.flags2 = 0;                              // Clear any previous error messages
+	descriptor.flags = 0x8300F000                       // Encode the size of what is being sent
+	                   | ((uint16_t) ((-size) & 0xFFF));
 
 	register_address_port.write(0);                           // Tell device to write to register 0
 	register_data_port.write(
 	0x48);                           // Tell device to send the data currently in the buffer
+
+	send_lock.release_irqrestore(flags);
 }
 
-void AMD_AM79C973::fetch_data_received() {
+/**
+ * @brief Release the packets the device has finished sending, the send lock must be held
+ */
+void AMD_AM79C973::reclaim_sent() {
+
+	while(sends_in_flight && !(send_buffer_descr[reclaim_send_buffer].flags & 0x80000000)) {
 
-	for(; (recv_buffer_descr[current_recv_buffer].flags & 0x80000000) == 0; current_recv_buffer =
+		send_packets[reclaim_send_buffer]->release();
+		send_packets[reclaim_send_buffer] = nullptr;
+
+		reclaim_send_buffer = (reclaim_send_buffer + 1) % send_ring_size;
+		sends_in_flight--;
+		m_statistics.send_reclaimed++;
+	}
+}
+
+/**
+ * @brief Handle the frames waiting in the receive ring (called by the poll worker)
+ *
+ * @param budget The most frames to handle
+ * @return How many frames were handled
+ */
+uint32_t AMD_AM79C973::poll(uint32_t budget) {
+	return fetch_data_received(budget);
+}
+
+/**
+ * @brief Enable or mask the receive interrupt (RINTM in CSR3)
+ *
+ * @param enabled Whether the interrupt should be raised
+ */
+void AMD_AM79C973::set_receive_interrupts(bool enabled) {
+
+	register_address_port.write(3);                           // Tell device to read from register 3
+	uint32_t temp = register_data_port.read();                     // Get current masks
+
+	register_address_port.write(3);                           // Tell device to write to register 3
+	register_data_port.write(enabled ? temp & ~0x0400 : temp | 0x0400);
+}
+
+/**
+ * @brief Pass the received frames in the ring to the handlers
+ *
+ * @param budget The most frames to handle
+ * @return How many frames were handled
+ */
+uint32_t AMD_AM79C973::fetch_data_received(uint32_t budget) {
+
+	uint32_t handled = 0;
+	for(; handled < budget && (recv_buffer_descr[current_recv_buffer].flags & 0x80000000) == 0; current_recv_buffer =
 	                                                                        (current_recv_buffer + 1) %
-	                                                                        8)         //Loop through all the buffers
+	                                                                        recv_ring_size)         //Loop through all the buffers
 	{
+		handled++;
+		PacketBuffer* packet = nullptr;
 		if(!(recv_buffer_descr[current_recv_buffer].flags & 0x40000000)                   //Check if there is an error
 		   && (recv_buffer_descr[current_recv_buffer].flags & 0x03000000) ==
 		      0x03000000)    //Check start and end bits of the packet
@@ -259,36 +349,36 @@ void AMD_AM79C973::fetch_data_received() {
 			   64)                                                              //If the size is the size of ethernet 2 frame
 				size -= 4;                                                              //remove the checksum
 
-			auto* buffer = (uint8_t*) (recv_buffer_descr[current_recv_buffer].address);   //Get the buffer
-			fire_data_received(buffer, size);                                             //Pass data to handler
+			uint8_t* buffer = recv_buffers + current_recv_buffer * ETHERNET_RING_BUFFER_SIZE;  //Get the buffer
+			packet = PacketBufferPool::allocate(buffer, size);                               //Move it out of the ring so the descriptor can be reused straight away
 		}
 
 		recv_buffer_descr[current_recv_buffer].flags2 = 0;                                  //write that the data has been read and can now be used again
-		recv_buffer_descr[current_recv_buffer].flags = 0x8000F7FF;                          //Clear the buffer
+		recv_buffer_descr[current_recv_buffer].flags = 0x8000F000 | ((-ETHERNET_RING_BUFFER_SIZE) & 0xFFF);  //Give the buffer back to the device
+
+		// Handled after the descriptor is given back as the handlers may take a while
+		if(packet) {
+			m_statistics.received++;
+			fire_data_received(packet);                                                     //Pass data to handler
+		} else {
+			m_statistics.receive_dropped++;
+		}
 	}
+
+	return handled;
 }
 
+/**
+ * @brief Reclaim the send descriptors the device has finished with (send interrupt)
+ */
 void AMD_AM79C973::fetch_data_sent() {
 
-	/*
-	for(;(recvBufferDescr[currentRecvBuffer].flags & 0x80000000) == 0; currentRecvBuffer = (currentRecvBuffer+1)%8)
-	{
-		if(!(recvBufferDescr[currentRecvBuffer].flags    & 0x40000000)
-		   && (recvBufferDescr[currentRecvBuffer].flags & 0x03000000) == 0x03000000)
-		{
-			uint32_t size = recvBufferDescr[currentRecvBuffer].flags2 & 0xFFF;
-			if (size > 64)
-				size -= 4;
-
-			uint8_t* buffer = (uint8_t*)(recvBufferDescr[currentRecvBuffer].address);
-			FireDataSent(buffer, size);
-		}
-
-		recvBufferDescr[currentRecvBuffer].flags2 = 0;
-		recvBufferDescr[currentRecvBuffer].flags = 0x8000F7FF;
-	}
-	*/
+	// A send in progress on another thread will reclaim them itself
+	if(!send_lock.try_acquire())
+		return;
 
+	reclaim_sent();
+	send_lock.release();
 }
 
 
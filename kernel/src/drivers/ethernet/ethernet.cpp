@@ -7,11 +7,15 @@
  */
 
 #include <drivers/ethernet/ethernet.h>
+#include <processes/scheduler.h>
+#include <net/checksum.h>
 
 using namespace MaxOS;
 using namespace MaxOS::common;
 using namespace MaxOS::drivers;
 using namespace MaxOS::drivers::ethernet;
+using namespace MaxOS::net;
+using namespace MaxOS::processes;
 
 ///__EVENT HANDLER___
 
@@ -22,11 +26,10 @@ EthernetDriverEventHandler::~EthernetDriverEventHandler() = default;
 /**
  * @brief Handle data received event
  *
- * @param buffer The buffer to handle
- * @param size The size of the buffer
- * @return True if the data should be sent back, false otherwise
+ * @param packet The packet that was received, positioned at the start of the frame
+ * @return True if the packet should be sent back, false otherwise
  */
-bool EthernetDriverEventHandler::data_received(uint8_t* buffer, uint32_t size) {
+bool EthernetDriverEventHandler::data_received(PacketBuffer* packet) {
 	return false;
 }
 
@@ -67,8 +70,7 @@ Event<EthernetDriverEvents>* EthernetDriverEventHandler::on_event(Event<Ethernet
 			break;
 
 		case EthernetDriverEvents::DATA_RECEIVED:
-			event->return_value.bool_value = data_received(((DataReceivedEvent*) event)->buffer,
-			                                               ((DataReceivedEvent*) event)->size);
+			event->return_value.bool_value = data_received(((DataReceivedEvent*) event)->packet);
 			break;
 
 		default:
@@ -91,52 +93,78 @@ MediaAccessControlAddress EthernetDriver::get_media_access_control_address() {
 }
 
 /**
- * @brief send data to the network via the driver backend
+ * @brief send a packet to the network via the driver backend
+ *
+ * @param packet The packet to send, the driver takes ownership of it
+ */
+void EthernetDriver::send(PacketBuffer* packet) {
+
+	// A higher up layer made a mistake, sending part of the frame would only put garbage on the wire
+	if (packet->length() > ETHERNET_MAX_FRAME_SIZE) {
+		__atomic_add_fetch(&m_statistics.send_oversized, 1, __ATOMIC_RELAXED);
+		packet->release();
+		return;
+	}
+
+	// The device can't fill in the checksum so do it here
+	if (!m_checksum_offload)
+		InternetChecksum::complete(packet);
+
+	// Raised directly rather than through raise_event() so that every frame doesn't cost a heap allocation
+	BeforeSendEvent event(packet->data(), packet->length());
+	for (auto& handler : m_handlers)
+		handler->on_event(&event);
+
+	do_send(packet);
+}
+
+/**
+ * @brief send data to the network via the driver backend, copying it into a packet buffer first
  *
  * @param buffer  The buffer to send
  * @param size The size of the buffer
  */
 void EthernetDriver::send(uint8_t* buffer, uint32_t size) {
 
-	// Raise the event
-	raise_event(new BeforeSendEvent(buffer, size));
+	// No buffers left, drop it
+	PacketBuffer* packet = PacketBufferPool::allocate(buffer, size, 0);
+	if (!packet)
+		return;
 
-	do_send(buffer, size);
+	send(packet);
 }
 
 /**
- * @brief (Device Side) send the data
+ * @brief (Device Side) send the packet
  *
- * @param buffer The buffer to handle
- * @param size The size of the buffer
+ * @param packet The packet to send, must be released once the device is done with it
  */
-void EthernetDriver::do_send(uint8_t* buffer, uint32_t size) {
+void EthernetDriver::do_send(PacketBuffer* packet) {
+	packet->release();
 }
 
 /**
- * @brief Handle the recieved data
+ * @brief Handle a received packet, the packet is either sent back or released
  *
- * @param buffer The buffer to handle
- * @param size The size of the buffer
+ * @param packet The packet that was received
  */
-void EthernetDriver::fire_data_received(uint8_t* buffer, uint32_t size) {
+void EthernetDriver::fire_data_received(PacketBuffer* packet) {
 
-	// Raise the event
-	Vector<Event<EthernetDriverEvents>*> values =
-			raise_event(new DataReceivedEvent(buffer, size));
+	// Raised directly rather than through raise_event() so that every frame doesn't cost a heap allocation
+	DataReceivedEvent event(packet);
 
-	// Loop through the events
-	for (auto &value : values) {
-		switch (value->type) {
-			case EthernetDriverEvents::DATA_RECEIVED:
-				if (value->return_value.bool_value)
-					send(buffer, size);
-				break;
-
-			default:
-				break;
-		}
+	// Only one handler can reply with the packet as the reply is written over it
+	bool send_back = false;
+	for (auto& handler : m_handlers) {
+		event.return_value.bool_value = false;
+		if (handler->on_event(&event)->return_value.bool_value)
+			send_back = true;
 	}
+
+	if (send_back)
+		send(packet);
+	else
+		packet->release();
 }
 
 /**
@@ -149,6 +177,137 @@ void EthernetDriver::fire_data_sent(uint8_t* buffer, uint32_t size) {
 	raise_event(new DataSentEvent(buffer, size));
 }
 
+/**
+ * @brief Get the counters for this device's rings
+ *
+ * @return The statistics
+ */
+const ethernet_statistics_t& EthernetDriver::statistics() const {
+	return m_statistics;
+}
+
+/**
+ * @brief Check if the device fills in the TCP/UDP checksums of the packets it sends
+ *
+ * @return True if the checksums are offloaded
+ */
+bool EthernetDriver::checksum_offload() const {
+	return m_checksum_offload;
+}
+
+/**
+ * @brief Work out how many descriptors a ring should have
+ *
+ * @param requested The size asked for
+ * @return The size clamped between the minimum and maximum and rounded up to a power of two
+ */
+uint32_t EthernetDriver::ring_size(uint32_t requested) {
+
+	if (requested > ETHERNET_MAX_RING_SIZE)
+		return ETHERNET_MAX_RING_SIZE;
+
+	uint32_t size = ETHERNET_MIN_RING_SIZE;
+	while (size < requested)
+		size <<= 1;
+
+	return size;
+}
+
+/**
+ * @brief Move received frame handling out of the interrupt and into a worker thread for this device
+ *
+ * @param budget The most frames to handle in one pass of the worker
+ *
+ * @note Does nothing until the scheduler has been created, received frames are handled in the interrupt until then
+ */
+void EthernetDriver::enable_polling(uint32_t budget) {
+
+	if (m_polling || !GlobalScheduler::system_scheduler())
+		return;
+
+	m_poll_budget = budget ? budget : ETHERNET_POLL_BUDGET;
+
+	// Start the worker, it sleeps until the first receive interrupt
+	EthernetDriver* args[] = { this };
+	auto* worker = new Process("Ethernet Poll", (void (*)(void*)) (uintptr_t) poll_worker, args, 1, true);
+	GlobalScheduler::system_scheduler()->add_process(worker);
+
+	m_polling = true;
+}
+
+/**
+ * @brief Check if received frames are handled by the poll worker
+ *
+ * @return True if polling is enabled
+ */
+bool EthernetDriver::polling() const {
+	return m_polling;
+}
+
+/**
+ * @brief (Interrupt Side) Stop receive interrupts and wake the poll worker to drain the ring
+ */
+void EthernetDriver::schedule_poll() {
+
+	set_receive_interrupts(false);
+
+	m_poll_lock.lock();
+	m_poll_pending = true;
+	m_poll_queue.wake_one();
+	m_poll_lock.unlock();
+}
+
+/**
+ * @brief (Device Side) Handle the frames waiting in the receive ring
+ *
+ * @param budget The most frames to handle
+ * @return How many frames were handled
+ */
+uint32_t EthernetDriver::poll(uint32_t budget) {
+	return 0;
+}
+
+/**
+ * @brief (Device Side) Enable or mask the interrupt raised when a frame is received
+ *
+ * @param enabled Whether the interrupt should be raised
+ */
+void EthernetDriver::set_receive_interrupts(bool enabled) {
+}
+
+/**
+ * @brief The poll worker thread, waits for a receive interrupt then drains the ring with interrupts masked
+ *
+ * @param argc Amount of arguments (1)
+ * @param argv The driver to poll
+ */
+void EthernetDriver::poll_worker(uint64_t argc, EthernetDriver** argv) {
+
+	EthernetDriver* driver = argv[0];
+	while (true) {
+
+		// Interrupts are off so the device can't schedule a poll between checking and going to sleep
+		asm volatile("cli");
+		driver->m_poll_lock.lock();
+		if (!driver->m_poll_pending) {
+			driver->m_poll_queue.wait(driver->m_poll_lock);
+			asm volatile("sti");
+			continue;
+		}
+
+		driver->m_poll_pending = false;
+		driver->m_poll_lock.unlock();
+		asm volatile("sti");
+
+		// Keep going while there are more frames than the budget
+		while (driver->poll(driver->m_poll_budget) == driver->m_poll_budget);
+
+		// Caught up so go back to interrupts, then pick up anything that arrived before they were unmasked
+		driver->set_receive_interrupts(true);
+		while (driver->poll(driver->m_poll_budget) == driver->m_poll_budget);
+	}
+}
+
 // if your mac address is e.g. 1c:6f:65:07:ad:1a (see output of ifconfig)
 // then you would call CreateMediaAccessControlAddress(0x1c, 0x6f, 0x65, 0x07, 0xad, 0x1a)
 /**
@@ -190,13 +349,11 @@ DataSentEvent::~DataSentEvent() = default;
 /**
  * @brief Construct a new Data Received Event object
  *
- * @param buffer The buffer that was received
- * @param size The size of the buffer
+ * @param packet The packet that was received
  */
-DataReceivedEvent::DataReceivedEvent(uint8_t* buffer, uint32_t size)
+DataReceivedEvent::DataReceivedEvent(PacketBuffer* packet)
 		: Event(EthernetDriverEvents::DATA_RECEIVED) {
-	this->buffer = buffer;
-	this->size = size;
+	this->packet = packet;
 }
 
 DataReceivedEvent::~DataReceivedEvent()
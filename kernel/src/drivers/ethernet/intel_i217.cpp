@@ -7,6 +7,7 @@
  */
 
 #include <drivers/ethernet/intel_i217.h>
+#include <memory/physical.h>
 
 using namespace MaxOS;
 using namespace MaxOS::common;
@@ -14,6 +15,7 @@ using namespace MaxOS::drivers;
 using namespace MaxOS::drivers::ethernet;
 using namespace MaxOS::hardwarecommunication;
 using namespace memory;
+using namespace MaxOS::net;
 
 /// MAX OS NET CODE:
 ///     All the old (this) networking code poorly written and not used, this will be moved to userspace in the future
@@ -22,16 +24,28 @@ using namespace memory;
 ///     See OSDEV wiki for the credit for this driver
 
 // Buffer Sizes
-#define buffer8192                 ((2 << 16) | (1 << 25))
+#define buffer2048                 (0 << 16)
 
 
 /**
  * @brief Constructs a new Intel I217 Ethernet driver. Gets the MAC address and clears the receive descriptor array
  *
  * @param device_descriptor The PCI device descriptor for this device
+ * @param receive_ring_size How many receive descriptors to use (rounded to a power of two)
+ * @param send_ring_size How many send descriptors to use (rounded to a power of two)
  */
-IntelI217::IntelI217(PCIDeviceDescriptor* device_descriptor)
-		: InterruptHandler(0x20 + device_descriptor->interrupt) {
+IntelI217::IntelI217(PCIDeviceDescriptor* device_descriptor, uint32_t receive_ring_size, uint32_t send_ring_size)
+		: InterruptHandler(0x20 + device_descriptor->interrupt),
+		  receive_ring_size(ring_size(receive_ring_size)),
+		  receive_dsrctrs(nullptr),
+		  receive_buffers(nullptr),
+		  current_receive_buffer(0),
+		  send_ring_size(ring_size(send_ring_size)),
+		  send_dsrctrs(nullptr),
+		  send_packets(nullptr),
+		  current_send_buffer(0),
+		  reclaim_send_buffer(0),
+		  sends_in_flight(0) {
 
 	//Set the registers
 	control_register = 0x0000;
@@ -39,6 +53,8 @@ IntelI217::IntelI217(PCIDeviceDescriptor* device_descriptor)
 	eprom_register = 0x0014;
 	control_ext_register = 0x0018;
 	interrupt_mask_register = 0x00D0;
+	interrupt_mask_clear_register = 0x00D8;
+	missed_packets_register = 0x4010;
 
 	receive_control_register = 0x0100;
 	receive_descriptor_low_register = 0x2800;
@@ -202,34 +218,28 @@ bool IntelI217::read_mac_address() {
 
 void IntelI217::receive_init() {
 
-	uint8_t* ptr;                                                                                                          //A pointer to the memory
-	receive_descriptor_t* descs;                                                                                        //A pointer to the receive descriptors
-	ptr = (uint8_t*) (MemoryManager::kmalloc(
-			sizeof(receive_descriptor_t) * 32 + 16));           //Allocate memory for the receive descriptors
-	descs = (receive_descriptor_t*) ptr;                                                                                //Set the pointer to the receive descriptors
+	// The device reads the descriptors and writes the buffers by physical address so they come from one contiguous area
+	size_t descriptors_size = receive_ring_size * sizeof(receive_descriptor_t);
+	auto physical = (uintptr_t) PhysicalMemoryManager::s_current_manager->allocate_area(0, descriptors_size + receive_ring_size * ETHERNET_RING_BUFFER_SIZE);
+	receive_dsrctrs = (receive_descriptor_t*) PhysicalMemoryManager::to_dm_region(physical);
+	receive_buffers = (uint8_t*) receive_dsrctrs + descriptors_size;
+	memset(receive_dsrctrs, 0, descriptors_size);
 
-	for (int i = 0; i < 32; i++) {
-		receive_dsrctrs[i] = (receive_descriptor_t*) ((uint8_t*) descs + i * 16);
-		receive_dsrctrs[i]->buffer_address = (uint64_t) (uint8_t*) (MemoryManager::kmalloc(8192 + 16));
-		receive_dsrctrs[i]->status = 0;
-	}
-
-	//write the send descriptor list address to the register
-	write(send_descriptor_low_register, (uint32_t) ((uint64_t) ptr >> 32));
-	write(send_descriptor_high_register, (uint32_t) ((uint64_t) ptr & 0xFFFFFFFF));
+	for (uint32_t i = 0; i < receive_ring_size; i++)
+		receive_dsrctrs[i].buffer_address = physical + descriptors_size + i * ETHERNET_RING_BUFFER_SIZE;
 
 	//write the receive descriptor list address to the register
-	write(receive_descriptor_low_register, (uint64_t) ptr);
-	write(receive_descriptor_high_register, 0);
+	write(receive_descriptor_low_register, (uint32_t) (physical & 0xFFFFFFFF));
+	write(receive_descriptor_high_register, (uint32_t) (physical >> 32));
 
 	//Set the receive descriptor list length
-	write(receive_descriptor_length_register, 32 * 16);
+	write(receive_descriptor_length_register, descriptors_size);
 
 
 	write(receive_descriptor_head_register,
 	      0);                                                                       //Set the head to 0
 	write(receive_descriptor_tail_register,
-	      32 - 1);                                                                    //Set the tail to 32-1
+	      receive_ring_size - 1);                                                   //Give the device every descriptor but the last
 
 	current_receive_buffer = 0;                                                                                                   //Set the current receive buffer to 0
 
@@ -241,36 +251,32 @@ void IntelI217::receive_init() {
 	                              | (0 << 8)        // Free Buffer Threshold is 1/2 of RDLEN
 	                              | (1 << 15)       // Broadcast Accept Mode
 	                              | (1 << 26)       // Strip Ethernet CRC
-	                              | buffer8192
+	                              | buffer2048
 	);
 
-	delete ptr;
-
 }
 
 void IntelI217::send_init() {
 
-	uint8_t* ptr;                                                                                                          //A pointer to the memory
-	send_descriptor_t* descs;                                                                                           //A pointer to the send descriptors
-	ptr = (uint8_t*) (MemoryManager::kmalloc(
-			sizeof(send_descriptor_t) * 8 + 16));                //Allocate memory for the send descriptors
-	descs = (send_descriptor_t*) ptr;                                                                                   //Set the pointer to the send descriptors
-
+	// The packets are sent straight out of their packet buffers so only the descriptors need to be allocated
+	size_t descriptors_size = send_ring_size * sizeof(send_descriptor_t);
+	auto physical = (uintptr_t) PhysicalMemoryManager::s_current_manager->allocate_area(0, descriptors_size);
+	send_dsrctrs = (send_descriptor_t*) PhysicalMemoryManager::to_dm_region(physical);
+	memset(send_dsrctrs, 0, descriptors_size);
 
-	for (int i = 0; i < 8; i++) {
-		send_dsrctrs[i] = (send_descriptor_t*) ((uint8_t*) descs + i * 16);
-		send_dsrctrs[i]->buffer_address = 0;
-		send_dsrctrs[i]->cmd = 0;
-		send_dsrctrs[i]->status = (1 << 0);    // Descriptor Done
+	send_packets = new PacketBuffer*[send_ring_size];
+	for (uint32_t i = 0; i < send_ring_size; i++) {
+		send_packets[i] = nullptr;
+		send_dsrctrs[i].status = (1 << 0);    // Descriptor Done
 	}
 
 	//write the send descriptor list address to the register
-	write(send_descriptor_high_register, (uint32_t) ((uint64_t) ptr >> 32));
-	write(send_descriptor_low_register, (uint32_t) ((uint64_t) ptr & 0xFFFFFFFF));
+	write(send_descriptor_high_register, (uint32_t) (physical >> 32));
+	write(send_descriptor_low_register, (uint32_t) (physical & 0xFFFFFFFF));
 
 
 	//now setup total length of descriptors
-	write(send_descriptor_length_register, 8 * 16);
+	write(send_descriptor_length_register, descriptors_size);
 
 
 	//setup numbers
@@ -278,6 +284,8 @@ void IntelI217::send_init() {
 	write(send_descriptor_tail_register, 0);
 
 	current_send_buffer = 0;
+	reclaim_send_buffer = 0;
+	sends_in_flight = 0;
 
 	write(send_control_register, (1 << 1)    // Transmit Enable
 	                           | (1 << 3)                 // Pad Short Packets
@@ -291,8 +299,6 @@ void IntelI217::send_init() {
 	// write(sendControlRegister,  0b0110000000000111111000011111010);
 	//write(0x0410,  0x0060200A);
 
-	delete ptr;
-
 }
 
 void IntelI217::activate() {
@@ -324,58 +330,152 @@ void IntelI217::handle_interrupt() {
 	// if(temp & 0x10)
 	//   m_driver_message_stream-> write("INTEL i217 GOOD THRESHOLD");
 
-	if (temp & 0x80) fetch_data_received();
+	if (temp & 0x80) {
+		if (polling())
+			schedule_poll();
+		else
+			fetch_data_received(UINT32_MAX);
+	}
 }
 
-void IntelI217::fetch_data_received() {
+/**
+ * @brief Handle the frames waiting in the receive ring (called by the poll worker)
+ *
+ * @param budget The most frames to handle
+ * @return How many frames were handled
+ */
+uint32_t IntelI217::poll(uint32_t budget) {
 
+	uint32_t handled = fetch_data_received(budget);
 
-	uint16_t old_cur;
+	// Give back sent packets while the device is quiet rather than waiting for the next send to fill a batch
+	if (sends_in_flight && send_lock.try_acquire()) {
+		reclaim_sent();
+		send_lock.release();
+	}
 
-	while ((receive_dsrctrs[current_receive_buffer]->status & 0x1)) {
-		auto* buffer = (uint8_t*) receive_dsrctrs[current_receive_buffer]->buffer_address;
-		uint16_t size = receive_dsrctrs[current_receive_buffer]->length;
+	return handled;
+}
+
+/**
+ * @brief Enable or mask the receive timer interrupt
+ *
+ * @param enabled Whether the interrupt should be raised
+ */
+void IntelI217::set_receive_interrupts(bool enabled) {
+	write(enabled ? interrupt_mask_register : interrupt_mask_clear_register, 0x80);
+}
+
+/**
+ * @brief Pass the received frames in the ring to the handlers
+ *
+ * @param budget The most frames to handle
+ * @return How many frames were handled
+ */
+uint32_t IntelI217::fetch_data_received(uint32_t budget) {
+
+
+	uint32_t old_cur;
+	uint32_t handled = 0;
+
+	while (handled < budget && (receive_dsrctrs[current_receive_buffer].status & 0x1)) {
+		handled++;
+		receive_descriptor_t& descriptor = receive_dsrctrs[current_receive_buffer];
+		uint8_t* buffer = receive_buffers + current_receive_buffer * ETHERNET_RING_BUFFER_SIZE;
+		uint16_t size = descriptor.length;
 
 		if (size > 64) {          // If the size is the size of ethernet 2 frame
 			size -= 4;          // remove the checksum
 		}
 
-		fire_data_received(buffer, size);  //Pass data to handler
+		PacketBuffer* packet = descriptor.errors ? nullptr : PacketBufferPool::allocate(buffer, size);  //Move it out of the ring so the descriptor can be reused straight away
+		if (packet) {
+			m_statistics.received++;
+			fire_data_received(packet);  //Pass data to handler
+		} else {
+			m_statistics.receive_dropped++;
+		}
 
 
-		receive_dsrctrs[current_receive_buffer]->status = 0;
+		descriptor.status = 0;
 
 		old_cur = current_receive_buffer;                         //Save the current receive buffer
-		current_receive_buffer = (current_receive_buffer + 1) % 32; //Increment the current receive buffer
+		current_receive_buffer = (current_receive_buffer + 1) % receive_ring_size; //Increment the current receive buffer
 
 		write(receive_descriptor_tail_register, old_cur); //write the old current receive buffer to the tail register
 	}
 
+	// Frames the device couldn't store because the ring was full
+	m_statistics.receive_overruns += read(missed_packets_register);
+
+	return handled;
 }
 
-void IntelI217::do_send(uint8_t* buffer, uint32_t size) {
+/**
+ * @brief Send a packet, the card reads it straight out of the packet buffer
+ *
+ * @param packet The packet to send, released once the card has sent it and the descriptor is reclaimed
+ */
+void IntelI217::do_send(PacketBuffer* packet) {
+
+	// Not set up yet, there is nowhere to put the packet
+	if (!active) {
+		__atomic_add_fetch(&m_statistics.send_dropped, 1, __ATOMIC_RELAXED);
+		packet->release();
+		return;
+	}
+
+	// The interrupt reclaims and replies on this core, so it must not come in while the lock is held
+	uint64_t flags = send_lock.acquire_irqsave();
+
+	// Reclaim in batches rather than waiting for each packet to go out
+	if (sends_in_flight >= ETHERNET_SEND_RECLAIM_BATCH || sends_in_flight == send_ring_size - 1)
+		reclaim_sent();
 
-	while (!active);
+	// Ring is full (one descriptor is always left empty so a full ring doesn't look empty to the device)
+	if (sends_in_flight == send_ring_size - 1) {
+		m_statistics.send_dropped++;
+		send_lock.release_irqrestore(flags);
+		packet->release();
+		return;
+	}
 
 	//Put params into send buffer
-	send_dsrctrs[current_send_buffer]->buffer_address = (uint64_t) buffer;
-	send_dsrctrs[current_send_buffer]->length = size;
+	send_descriptor_t& descriptor = send_dsrctrs[current_send_buffer];
+	descriptor.buffer_address = packet->physical_address();
+	descriptor.length = packet->length();
 
 	//Set the commands
-	send_dsrctrs[current_send_buffer]->cmd = (1 << 0)    // End of Packet
-	                                      | (1 << 1)    // Insert FCS
-	                                      | (1 << 3)    // Report Status
+	descriptor.cmd = (1 << 0)    // End of Packet
+	               | (1 << 1)    // Insert FCS
+	               | (1 << 3)    // Report Status
 			;
 
-	send_dsrctrs[current_send_buffer]->status = 0;
+	descriptor.status = 0;
+	send_packets[current_send_buffer] = packet;
+	sends_in_flight++;
+	m_statistics.sent++;
 
-	uint8_t old_cur = current_send_buffer;                                    //Save the current send buffer
-	current_send_buffer = (current_send_buffer + 1) % 8;                        //Increment the current send buffer
+	current_send_buffer = (current_send_buffer + 1) % send_ring_size;     //Increment the current send buffer
 	write(send_descriptor_tail_register, current_send_buffer);       //write the current send buffer to the tail register
 
-	//Wait for the packet to be sent
-	while (!(send_dsrctrs[old_cur]->status & 0xff));
+	send_lock.release_irqrestore(flags);
+}
+
+/**
+ * @brief Release the packets the device has finished sending, the send lock must be held
+ */
+void IntelI217::reclaim_sent() {
+
+	while (sends_in_flight && (send_dsrctrs[reclaim_send_buffer].status & 0x1)) {
 
+		send_packets[reclaim_send_buffer]->release();
+		send_packets[reclaim_send_buffer] = nullptr;
+
+		reclaim_send_buffer = (reclaim_send_buffer + 1) % send_ring_size;
+		sends_in_flight--;
+		m_statistics.send_reclaimed++;
+	}
 }
 
 uint64_t IntelI217::get_media_access_control_address() {
@@ -0,0 +1,687 @@
+/**
+ * @file virtio_net.cpp
+ * @brief Implementation of the virtio network device driver
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+ */
+
+#include <drivers/ethernet/virtio_net.h>
+#include <memory/physical.h>
+#include <memory/memoryIO.h>
+#include <system/cpu.h>
+
+using namespace MaxOS;
+using namespace MaxOS::common;
+using namespace MaxOS::drivers;
+using namespace MaxOS::drivers::ethernet;
+using namespace MaxOS::hardwarecommunication;
+using namespace MaxOS::memory;
+using namespace MaxOS::system;
+using namespace MaxOS::net;
+
+// Legacy register layout (offsets from BAR0)
+#define VIRTIO_DEVICE_FEATURES      0x00
+#define VIRTIO_DRIVER_FEATURES      0x04
+#define VIRTIO_QUEUE_ADDRESS        0x08
+#define VIRTIO_QUEUE_SIZE           0x0C
+#define VIRTIO_QUEUE_SELECT         0x0E
+#define VIRTIO_QUEUE_NOTIFY         0x10
+#define VIRTIO_DEVICE_STATUS        0x12
+#define VIRTIO_ISR_STATUS           0x13
+#define VIRTIO_NET_MAC              0x14
+#define VIRTIO_NET_MAX_PAIRS        0x1C
+
+// Ring flags
+#define VIRTQ_AVAIL_NO_INTERRUPT    1
+#define VIRTQ_USED_NO_NOTIFY        1
+
+// Control queue
+#define VIRTIO_NET_CTRL_MQ          4
+#define VIRTIO_NET_CTRL_MQ_PAIRS    0
+#define VIRTIO_NET_OK               0
+
+// Header flags
+#define VIRTIO_NET_HDR_NEEDS_CSUM   1
+
+/**
+ * @brief Round up to the alignment the legacy interface expects
+ */
+static inline size_t queue_align(size_t size) {
+	return (size + VIRTIO_QUEUE_ALIGNMENT - 1) & ~((size_t) VIRTIO_QUEUE_ALIGNMENT - 1);
+}
+
+/**
+ * @brief Make sure the ring writes are seen by the device in order
+ */
+static inline void memory_barrier() {
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Allocates a split virtqueue and links all of its descriptors into the free list
+ *
+ * @param index The index of the queue on the device
+ * @param size How many descriptors the device says the queue has
+ * @param event_index Whether the used/avail event fields are used to suppress interrupts and notifications
+ */
+VirtQueue::VirtQueue(uint16_t index, uint16_t size, bool event_index)
+: m_index(index),
+  m_size(size),
+  m_event_index(event_index),
+  m_free_count(size)
+{
+
+	// The device finds the whole queue from a single page number so it has to be contiguous
+	size_t bytes = bytes_needed(size);
+	m_physical_address = (uintptr_t) PhysicalMemoryManager::s_current_manager->allocate_area(0, bytes);
+	auto* base = (uint8_t*) PhysicalMemoryManager::to_dm_region(m_physical_address);
+	memset(base, 0, bytes);
+
+	m_descriptors = (virtq_descriptor_t*) base;
+	m_available = (volatile uint16_t*) (base + size * sizeof(virtq_descriptor_t));
+	m_used_header = (volatile uint16_t*) (base + queue_align(size * sizeof(virtq_descriptor_t) + (3 + size) * sizeof(uint16_t)));
+	m_used = (volatile virtq_used_element_t*) (m_used_header + 2);
+
+	m_tokens = new void*[size];
+	for (uint16_t i = 0; i < size; i++) {
+		m_descriptors[i].next = i + 1;
+		m_tokens[i] = nullptr;
+	}
+}
+
+VirtQueue::~VirtQueue() {
+
+	PhysicalMemoryManager::s_current_manager->free_area(m_physical_address, bytes_needed(m_size));
+	delete[] m_tokens;
+}
+
+/**
+ * @brief How many bytes a queue of a given size takes up in memory
+ *
+ * @param size The number of descriptors
+ * @return The bytes needed for the descriptors, available ring and (page aligned) used ring
+ */
+size_t VirtQueue::bytes_needed(uint16_t size) {
+
+	return queue_align(size * sizeof(virtq_descriptor_t) + (3 + size) * sizeof(uint16_t))
+	       + queue_align(3 * sizeof(uint16_t) + size * sizeof(virtq_used_element_t));
+}
+
+/**
+ * @brief Get the index of the queue on the device
+ *
+ * @return The queue index
+ */
+uint16_t VirtQueue::index() const {
+	return m_index;
+}
+
+/**
+ * @brief Get the number of descriptors in the queue
+ *
+ * @return The queue size
+ */
+uint16_t VirtQueue::size() const {
+	return m_size;
+}
+
+/**
+ * @brief Get the physical address of the start of the queue
+ *
+ * @return The physical address
+ */
+uintptr_t VirtQueue::physical_address() const {
+	return m_physical_address;
+}
+
+/**
+ * @brief Get how many descriptors are not owned by the device
+ *
+ * @return The number of free descriptors
+ */
+uint16_t VirtQueue::free_descriptors() const {
+	return m_free_count;
+}
+
+/**
+ * @brief Chain some buffers together and make them available to the device
+ *
+ * @param buffers The buffers to chain
+ * @param count How many buffers there are
+ * @param token Returned by next_used() once the device is done with the chain
+ * @return True if the chain was added, false if there aren't enough free descriptors
+ */
+bool VirtQueue::add(const virtq_buffer_t* buffers, uint16_t count, void* token) {
+
+	if (!count || count > m_free_count)
+		return false;
+
+	// Take the descriptors off the free list, the links already point at the next free one so they double as the chain
+	uint16_t head = m_free_head;
+	for (uint16_t i = 0; i < count; i++) {
+		virtq_descriptor_t& descriptor = m_descriptors[m_free_head];
+		descriptor.address = buffers[i].address;
+		descriptor.length = buffers[i].length;
+		descriptor.flags = (buffers[i].device_writes ? (uint16_t) VirtQueueDescriptorFlags::WRITE : 0)
+		                   | (i + 1 < count ? (uint16_t) VirtQueueDescriptorFlags::NEXT : 0);
+		m_free_head = descriptor.next;
+	}
+
+	m_free_count -= count;
+	m_tokens[head] = token;
+
+	// Publish the chain, the index must be written after the ring entry
+	uint16_t available_index = m_available[1];
+	m_available[2 + available_index % m_size] = head;
+	memory_barrier();
+	m_available[1] = available_index + 1;
+
+	return true;
+}
+
+/**
+ * @brief Check whether the device wants to be told about the buffers added since the last notification
+ *
+ * @return True if the queue should be notified
+ */
+bool VirtQueue::notify_needed() {
+
+	memory_barrier();
+
+	uint16_t new_index = m_available[1];
+	uint16_t old_index = m_last_notified;
+	m_last_notified = new_index;
+
+	if (new_index == old_index)
+		return false;
+
+	// The device asks to be notified once the available index passes its event
+	if (m_event_index) {
+		uint16_t event = *(volatile uint16_t*) (m_used + m_size);
+		return (uint16_t) (new_index - event - 1) < (uint16_t) (new_index - old_index);
+	}
+
+	return !(m_used_header[0] & VIRTQ_USED_NO_NOTIFY);
+}
+
+/**
+ * @brief Check whether the device has finished with any chains that haven't been collected
+ *
+ * @return True if next_used() will return a chain
+ */
+bool VirtQueue::has_used() const {
+	return m_used_header[1] != m_last_used;
+}
+
+/**
+ * @brief Collect the next chain the device has finished with and free its descriptors
+ *
+ * @param token Set to the token the chain was added with
+ * @param length Set to the number of bytes the device wrote into the chain
+ * @return True if a chain was collected, false if the device hasn't finished with any
+ */
+bool VirtQueue::next_used(void*& token, uint32_t& length) {
+
+	if (!has_used())
+		return false;
+
+	// Don't read the entry before the index that says it is there
+	memory_barrier();
+	virtq_used_element_t element = { m_used[m_last_used % m_size].id, m_used[m_last_used % m_size].length };
+	m_last_used++;
+
+	auto head = (uint16_t) element.id;
+	token = m_tokens[head];
+	length = element.length;
+	m_tokens[head] = nullptr;
+
+	// Put the chain back on the free list
+	uint16_t tail = head;
+	uint16_t count = 1;
+	while (m_descriptors[tail].flags & (uint16_t) VirtQueueDescriptorFlags::NEXT) {
+		tail = m_descriptors[tail].next;
+		count++;
+	}
+
+	m_descriptors[tail].next = m_free_head;
+	m_free_head = head;
+	m_free_count += count;
+
+	return true;
+}
+
+/**
+ * @brief Ask the device to (not) interrupt when it finishes with a chain
+ *
+ * @param enabled Whether the device should interrupt
+ *
+ * @note With the event index the device interrupts once it passes the next entry to be collected so this must be called again
+ * after collecting to re-arm it
+ */
+void VirtQueue::set_interrupts(bool enabled) {
+
+	if (m_event_index)
+		m_available[2 + m_size] = enabled ? m_last_used : (uint16_t) (m_last_used - 1);
+	else
+		m_available[0] = enabled ? 0 : VIRTQ_AVAIL_NO_INTERRUPT;
+
+	memory_barrier();
+}
+
+/**
+ * @brief Constructs a new virtio network driver. Negotiates features with the device and reads the MAC address
+ *
+ * @param device_descriptor The PCI device descriptor for this device
+ */
+VirtioNet::VirtioNet(PCIDeviceDescriptor* device_descriptor)
+: InterruptHandler(0x20 + device_descriptor->interrupt),
+  device_features_port(device_descriptor->port_base + VIRTIO_DEVICE_FEATURES),
+  driver_features_port(device_descriptor->port_base + VIRTIO_DRIVER_FEATURES),
+  queue_address_port(device_descriptor->port_base + VIRTIO_QUEUE_ADDRESS),
+  queue_size_port(device_descriptor->port_base + VIRTIO_QUEUE_SIZE),
+  queue_select_port(device_descriptor->port_base + VIRTIO_QUEUE_SELECT),
+  queue_notify_port(device_descriptor->port_base + VIRTIO_QUEUE_NOTIFY),
+  device_status_port(device_descriptor->port_base + VIRTIO_DEVICE_STATUS),
+  isr_status_port(device_descriptor->port_base + VIRTIO_ISR_STATUS),
+  port_base(device_descriptor->port_base)
+{
+
+	// Reset the device and say a driver has found it
+	device_status_port.write(0);
+	device_status_port.write((uint8_t) VirtioStatus::ACKNOWLEDGE);
+	device_status_port.write((uint8_t) VirtioStatus::ACKNOWLEDGE | (uint8_t) VirtioStatus::DRIVER);
+
+	// Only use what both sides understand (multiqueue is configured through the control queue so needs both)
+	uint32_t wanted = (uint32_t) VirtioNetFeature::CHECKSUM | (uint32_t) VirtioNetFeature::MAC | (uint32_t) VirtioNetFeature::STATUS
+	                  | (uint32_t) VirtioNetFeature::CONTROL_QUEUE | (uint32_t) VirtioNetFeature::MULTIQUEUE
+	                  | (uint32_t) VirtioNetFeature::EVENT_INDEX;
+	features = device_features_port.read() & wanted;
+	if (!(features & (uint32_t) VirtioNetFeature::CONTROL_QUEUE))
+		features &= ~(uint32_t) VirtioNetFeature::MULTIQUEUE;
+	driver_features_port.write(features);
+	m_checksum_offload = features & (uint32_t) VirtioNetFeature::CHECKSUM;
+
+	// Read the MAC address
+	uint8_t mac[6];
+	for (int i = 0; i < 6; i++) {
+		Port8Bit mac_port(port_base + VIRTIO_NET_MAC + i);
+		mac[i] = mac_port.read();
+	}
+	own_mac = create_media_access_control_address(mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+
+	// One queue pair per core (when the device has enough)
+	queue_pairs = 1;
+	if (features & (uint32_t) VirtioNetFeature::MULTIQUEUE) {
+		Port16Bit max_pairs_port(port_base + VIRTIO_NET_MAX_PAIRS);
+		uint16_t max_pairs = max_pairs_port.read();
+		queue_pairs = max_pairs < CPU::cores.size() ? max_pairs : CPU::cores.size();
+		if (queue_pairs > VIRTIO_NET_MAX_QUEUE_PAIRS)
+			queue_pairs = VIRTIO_NET_MAX_QUEUE_PAIRS;
+		if (!queue_pairs)
+			queue_pairs = 1;
+	}
+}
+
+VirtioNet::~VirtioNet() {
+
+	for (uint16_t pair = 0; pair < VIRTIO_NET_MAX_QUEUE_PAIRS; pair++)
+		free_queue_pair(pair);
+	delete control_queue;
+}
+
+/**
+ * @brief Free the queues and receive buffers of a queue pair
+ *
+ * @param pair The queue pair to free
+ */
+void VirtioNet::free_queue_pair(uint16_t pair) {
+
+	if (receive_buffers_physical[pair])
+		PhysicalMemoryManager::s_current_manager->free_area(receive_buffers_physical[pair], receive_queues[pair]->size() * ETHERNET_RING_BUFFER_SIZE);
+
+	delete receive_queues[pair];
+	delete send_queues[pair];
+
+	receive_queues[pair] = nullptr;
+	send_queues[pair] = nullptr;
+	receive_buffers[pair] = nullptr;
+	receive_buffers_physical[pair] = 0;
+}
+
+/**
+ * @brief Tell the device where a queue is
+ *
+ * @param index The index of the queue on the device
+ * @return The queue, or nullptr if the device doesn't have it
+ */
+VirtQueue* VirtioNet::setup_queue(uint16_t index) {
+
+	queue_select_port.write(index);
+	uint16_t size = queue_size_port.read();
+	if (!size)
+		return nullptr;
+
+	auto* queue = new VirtQueue(index, size, features & (uint32_t) VirtioNetFeature::EVENT_INDEX);
+	queue_address_port.write(queue->physical_address() / VIRTIO_QUEUE_ALIGNMENT);
+	return queue;
+}
+
+/**
+ * @brief Tell the device there are new buffers in a queue
+ *
+ * @param queue The queue to notify
+ */
+void VirtioNet::notify(VirtQueue* queue) {
+	queue_notify_port.write(queue->index());
+}
+
+/**
+ * @brief Give every descriptor in a receive queue a buffer for the device to write frames into
+ *
+ * @param pair The queue pair to fill
+ */
+void VirtioNet::fill_receive_queue(uint16_t pair) {
+
+	VirtQueue* queue = receive_queues[pair];
+	size_t size = queue->size() * ETHERNET_RING_BUFFER_SIZE;
+	receive_buffers_physical[pair] = (uintptr_t) PhysicalMemoryManager::s_current_manager->allocate_area(0, size);
+	receive_buffers[pair] = (uint8_t*) PhysicalMemoryManager::to_dm_region(receive_buffers_physical[pair]);
+
+	// The token is the index of the buffer so it can be posted again once the frame is copied out
+	for (uintptr_t i = 0; i < queue->size(); i++) {
+		virtq_buffer_t buffer = { receive_buffers_physical[pair] + i * ETHERNET_RING_BUFFER_SIZE, ETHERNET_RING_BUFFER_SIZE, true };
+		queue->add(&buffer, 1, (void*) i);
+	}
+}
+
+/**
+ * @brief Set up the queues, then tell the device the driver is ready
+ */
+void VirtioNet::activate() {
+
+	uint16_t max_pairs = 1;
+	if (features & (uint32_t) VirtioNetFeature::MULTIQUEUE) {
+		Port16Bit max_pairs_port(port_base + VIRTIO_NET_MAX_PAIRS);
+		max_pairs = max_pairs_port.read();
+	}
+
+	// Receive queues are even, send queues are odd and the control queue comes after all the pairs the device has
+	for (uint16_t pair = 0; pair < queue_pairs; pair++) {
+		receive_queues[pair] = setup_queue(pair * 2);
+		send_queues[pair] = setup_queue(pair * 2 + 1);
+
+		if (!receive_queues[pair] || !send_queues[pair]) {
+			device_status_port.write((uint8_t) VirtioStatus::FAILED);
+			return;
+		}
+
+		// Sent packets are reclaimed in batches so the send queues never need to interrupt
+		send_queues[pair]->set_interrupts(false);
+		fill_receive_queue(pair);
+	}
+
+	if (features & (uint32_t) VirtioNetFeature::CONTROL_QUEUE) {
+		control_queue = setup_queue(max_pairs * 2);
+		if (control_queue) {
+			control_queue->set_interrupts(false);
+			auto physical = (uintptr_t) PhysicalMemoryManager::s_current_manager->allocate_area(0, ETHERNET_RING_BUFFER_SIZE);
+			control_buffer_physical = physical;
+			control_buffer = (uint8_t*) PhysicalMemoryManager::to_dm_region(physical);
+		}
+	}
+
+	device_status_port.write((uint8_t) VirtioStatus::ACKNOWLEDGE | (uint8_t) VirtioStatus::DRIVER | (uint8_t) VirtioStatus::DRIVER_OK);
+
+	// The device only uses the first pair until told otherwise, so if it refuses the others are never touched and can go
+	if (queue_pairs > 1 && !(control_queue && send_control(VIRTIO_NET_CTRL_MQ, VIRTIO_NET_CTRL_MQ_PAIRS, &queue_pairs, sizeof(queue_pairs)))) {
+		for (uint16_t pair = 1; pair < queue_pairs; pair++)
+			free_queue_pair(pair);
+		queue_pairs = 1;
+	}
+
+	for (uint16_t pair = 0; pair < queue_pairs; pair++)
+		notify(receive_queues[pair]);
+
+	active = true;
+}
+
+/**
+ * @brief Send a command on the control queue and wait for the device to handle it
+ *
+ * @param command_class The class of the command
+ * @param command The command
+ * @param data The data for the command
+ * @param size The size of the data
+ * @return True if the device accepted the command
+ */
+bool VirtioNet::send_control(uint8_t command_class, uint8_t command, const void* data, uint32_t size) {
+
+	// Header and data are read by the device, the acknowledgement is written by it
+	control_buffer[0] = command_class;
+	control_buffer[1] = command;
+	memcpy(control_buffer + 2, data, size);
+	control_buffer[2 + size] = 0xFF;
+
+	virtq_buffer_t buffers[3] = {
+		{ control_buffer_physical, 2, false },
+		{ control_buffer_physical + 2, size, false },
+		{ control_buffer_physical + 2 + size, 1, true },
+	};
+
+	if (!control_queue->add(buffers, 3, control_buffer))
+		return false;
+	notify(control_queue);
+
+	// Only done during activation so just spin until it is done
+	void* token;
+	uint32_t length;
+	while (!control_queue->next_used(token, length))
+		asm volatile("pause");
+
+	return control_buffer[2 + size] == VIRTIO_NET_OK;
+}
+
+void VirtioNet::handle_interrupt() {
+
+	// Reading the status acknowledges the interrupt, if it is clear the interrupt was for another device on the line
+	uint8_t status = isr_status_port.read();
+	if (!(status & 0x1) || !active)
+		return;
+
+	if (polling())
+		schedule_poll();
+	else
+		fetch_data_received(UINT32_MAX);
+}
+
+/**
+ * @brief Handle the frames waiting in the receive queues (called by the poll worker)
+ *
+ * @param budget The most frames to handle
+ * @return How many frames were handled
+ */
+uint32_t VirtioNet::poll(uint32_t budget) {
+
+	uint32_t handled = fetch_data_received(budget);
+
+	// Give back sent packets while the device is quiet rather than waiting for the next send to fill a batch
+	for (uint16_t pair = 0; pair < queue_pairs; pair++) {
+		if (send_queues[pair]->free_descriptors() != send_queues[pair]->size() && send_locks[pair].try_acquire()) {
+			reclaim_sent(pair);
+			send_locks[pair].release();
+		}
+	}
+
+	return handled;
+}
+
+/**
+ * @brief Enable or mask the interrupts of the receive queues
+ *
+ * @param enabled Whether the interrupts should be raised
+ */
+void VirtioNet::set_receive_interrupts(bool enabled) {
+
+	receive_interrupts = enabled;
+	for (uint16_t pair = 0; pair < queue_pairs; pair++)
+		receive_queues[pair]->set_interrupts(enabled);
+}
+
+/**
+ * @brief Pass the received frames in the queues to the handlers, taking one from each queue in turn
+ *
+ * @param budget The most frames to handle
+ * @return How many frames were handled
+ */
+uint32_t VirtioNet::fetch_data_received(uint32_t budget) {
+
+	uint32_t handled = 0;
+	while (handled < budget) {
+
+		bool found = false;
+		for (uint16_t pair = 0; pair < queue_pairs && handled < budget; pair++) {
+
+			void* token;
+			uint32_t length;
+			VirtQueue* queue = receive_queues[pair];
+			if (!queue->next_used(token, length))
+				continue;
+
+			found = true;
+			handled++;
+
+			// Copy the frame out (past the virtio header) so the buffer can be given straight back
+			auto index = (uintptr_t) token;
+			uint8_t* buffer = receive_buffers[pair] + index * ETHERNET_RING_BUFFER_SIZE;
+			PacketBuffer* packet = length > sizeof(virtio_net_header_t) ? PacketBufferPool::allocate(buffer + sizeof(virtio_net_header_t), length - sizeof(virtio_net_header_t)) : nullptr;
+			if (packet) {
+				m_statistics.received++;
+				fire_data_received(packet);
+			} else {
+				m_statistics.receive_dropped++;
+			}
+
+			virtq_buffer_t ring_buffer = { receive_buffers_physical[pair] + index * ETHERNET_RING_BUFFER_SIZE, ETHERNET_RING_BUFFER_SIZE, true };
+			queue->add(&ring_buffer, 1, token);
+		}
+
+		if (found)
+			continue;
+
+		// Re-arm the interrupts then check again as a frame could have arrived before they were armed
+		if (!receive_interrupts)
+			break;
+
+		bool pending = false;
+		for (uint16_t pair = 0; pair < queue_pairs; pair++) {
+			receive_queues[pair]->set_interrupts(true);
+			pending |= receive_queues[pair]->has_used();
+		}
+
+		if (!pending)
+			break;
+	}
+
+	for (uint16_t pair = 0; pair < queue_pairs; pair++)
+		if (receive_queues[pair]->notify_needed())
+			notify(receive_queues[pair]);
+
+	return handled;
+}
+
+/**
+ * @brief Send a packet on the queue pair of the current core, the device reads it straight out of the packet buffer
+ *
+ * @param packet The packet to send, released once the device has sent it and the descriptor is reclaimed
+ */
+void VirtioNet::do_send(PacketBuffer* packet) {
+
+	// Not set up (or activate() failed), there is nowhere to put the packet
+	if (!active) {
+		__atomic_add_fetch(&m_statistics.send_dropped, 1, __ATOMIC_RELAXED);
+		packet->release();
+		return;
+	}
+
+	// The device expects its header in front of the frame, there is always headroom for it
+	bool checksum = packet->checksum_pending();
+	size_t checksum_start = packet->checksum_start();
+	auto* header = (virtio_net_header_t*) packet->prepend(sizeof(virtio_net_header_t));
+	if (!header) {
+		m_statistics.send_dropped++;
+		packet->release();
+		return;
+	}
+	memset(header, 0, sizeof(virtio_net_header_t));
+
+	// Let the device fill in the checksum
+	if (checksum) {
+		header->flags = VIRTIO_NET_HDR_NEEDS_CSUM;
+		header->checksum_start = checksum_start;
+		header->checksum_offset = packet->checksum_offset();
+		packet->clear_checksum();
+	}
+
+	// Each core sends on its own queue so the cores don't contend for a lock
+	Core* core = CPU::executing_core();
+	uint16_t pair = (core ? core->id : 0) % queue_pairs;
+	VirtQueue* queue = send_queues[pair];
+
+	// The interrupt reclaims and replies on this core, so it must not come in while the lock is held
+	uint64_t flags = send_locks[pair].acquire_irqsave();
+
+	// Reclaim in batches rather than waiting for each packet to go out
+	uint16_t in_flight = queue->size() - queue->free_descriptors();
+	if (in_flight >= ETHERNET_SEND_RECLAIM_BATCH || !queue->free_descriptors())
+		reclaim_sent(pair);
+
+	virtq_buffer_t buffer = { packet->physical_address(), (uint32_t) packet->length(), false };
+	if (!queue->add(&buffer, 1, packet)) {
+		m_statistics.send_dropped++;
+		send_locks[pair].release_irqrestore(flags);
+		packet->release();
+		return;
+	}
+
+	m_statistics.sent++;
+	if (queue->notify_needed())
+		notify(queue);
+
+	send_locks[pair].release_irqrestore(flags);
+}
+
+/**
+ * @brief Release the packets the device has finished sending, the send lock of the pair must be held
+ *
+ * @param pair The queue pair to reclaim from
+ */
+void VirtioNet::reclaim_sent(uint16_t pair) {
+
+	void* token;
+	uint32_t length;
+	while (send_queues[pair]->next_used(token, length)) {
+		((PacketBuffer*) token)->release();
+		m_statistics.send_reclaimed++;
+	}
+}
+
+uint64_t VirtioNet::get_media_access_control_address() {
+	return own_mac;
+}
+
+uint32_t VirtioNet::reset() {
+	return Driver::reset();
+}
+
+void VirtioNet::deactivate() {
+	Driver::deactivate();
+}
+
+string VirtioNet::vendor_name() {
+	return "Red Hat";
+}
+
+string VirtioNet::device_name() {
+	return "virtio-net";
+}
@@ -31,18 +31,21 @@ VideoElectronicsStandardsAssociation::VideoElectronicsStandardsAssociation(multi
 	m_bpp = m_framebuffer_info->common.framebuffer_bpp;
 	m_pitch = m_framebuffer_info->common.framebuffer_pitch;
 	m_framebuffer_size = m_framebuffer_info->common.framebuffer_height * m_pitch;
-	this->set_mode(framebuffer_info->common.framebuffer_width, framebuffer_info->common.framebuffer_height, framebuffer_info->common.framebuffer_bpp);
-	Logger::DEBUG() << "Framebuffer: bpp=" << m_bpp << ", pitch=" << m_pitch << ", size=" << m_framebuffer_size << "\n";
+	Logger::DEBUG() << "Framebuffer: bpp=" << m_bpp << ", pitch=" << (int) m_pitch << ", size=" << m_framebuffer_size << "\n";
 
 	// Map the frame buffer into the higher half
 	auto physical_address = (uint64_t) m_framebuffer_info->common.framebuffer_addr;
 	m_framebuffer_address = (uint64_t *) PhysicalMemoryManager::to_dm_region(physical_address);
-	PhysicalMemoryManager::s_current_manager->map_area((physical_address_t *) physical_address, m_framebuffer_address, m_framebuffer_size, WRITE | PRESENT);
+	PhysicalMemoryManager::s_current_manager->map_area((physical_address_t *) physical_address, m_framebuffer_address, m_framebuffer_size, WRITE | PRESENT | WRITE_COMBINING);
 
 	// Reserve the physical memory
 	size_t pages = PhysicalMemoryManager::size_to_frames(m_framebuffer_size);
 	PhysicalMemoryManager::s_current_manager->reserve(m_framebuffer_info->common.framebuffer_addr, pages, "Framebuffer");
 
+	// Set the mode once the framebuffer is mapped so the rows can be written directly
+	this->set_mode(framebuffer_info->common.framebuffer_width, framebuffer_info->common.framebuffer_height, framebuffer_info->common.framebuffer_bpp);
+	s_active_driver = this;
+
 	// Log info
 	Logger::DEBUG() << "Framebuffer address: physical=0x" << (uint64_t) physical_address << ", virtual=0x" << (uint64_t) m_framebuffer_address << "\n";
 	Logger::DEBUG() << "Framebuffer mapped: 0x" << (uint64_t) m_framebuffer_address << " - 0x" << (uint64_t) (m_framebuffer_address + m_framebuffer_size) << " (pages: " << pages << ")\n";
@@ -51,6 +54,24 @@ VideoElectronicsStandardsAssociation::VideoElectronicsStandardsAssociation(multi
 
 VideoElectronicsStandardsAssociation::~VideoElectronicsStandardsAssociation() = default;
 
+/**
+ * @brief Changes how the CPU caches writes to the framebuffer
+ *
+ * @param caching The caching flags to map the framebuffer with (e.g. WRITE_COMBINING, or NONE to leave the type to the MTRRs)
+ */
+void VideoElectronicsStandardsAssociation::set_framebuffer_caching(size_t caching) {
+
+	// Drawing may be going to a back buffer
+	auto* framebuffer = (uint8_t*) (m_front_buffer ? m_front_buffer : m_framebuffer_address);
+	uint64_t* pml4_root = PhysicalMemoryManager::s_current_manager->pml4_root_address();
+
+	for(size_t offset = 0; offset < m_framebuffer_size; offset += PAGE_SIZE)
+		PhysicalMemoryManager::s_current_manager->change_page_flags((virtual_address_t*) (framebuffer + offset), WRITE | PRESENT | caching, pml4_root);
+
+	// Write back anything cached under the old type
+	asm volatile("wbinvd" : : : "memory");
+}
+
 /**
  * @brief Sets the mode of the VESA driver
  *
@@ -111,6 +132,15 @@ uint32_t VideoElectronicsStandardsAssociation::get_rendered_pixel_32_bit(uint32_
 	return *pixel_address;
 }
 
+/**
+ * @brief Gets the VESA driver drawing to the screen
+ *
+ * @return The driver, or nullptr if there is no VESA framebuffer
+ */
+VideoElectronicsStandardsAssociation* VideoElectronicsStandardsAssociation::active_driver() {
+	return s_active_driver;
+}
+
 /**
  * @brief The name of the vendor of the VESA standard
  *
@@ -64,5 +64,6 @@ bool VideoDriver::set_mode(uint32_t width, uint32_t height, uint32_t color_depth
     m_width = width;
     m_height = height;
     m_color_depth = color_depth;
+    select_span_functions();
     return true;
 }
\ No newline at end of file
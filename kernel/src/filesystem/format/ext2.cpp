@@ -21,8 +21,6 @@ using namespace MaxOS::drivers::clock;
  *
  * @param disk The disk to read from
  * @param partition_offset The offset of the partition on the disk in sectors
- *
- * @todo Should lock per file and not expose volume lock
  */
 Ext2Volume::Ext2Volume(drivers::disk::Disk* disk, lba_t partition_offset)
 : disk(disk),
@@ -30,6 +28,9 @@ Ext2Volume::Ext2Volume(drivers::disk::Disk* disk, lba_t partition_offset)
   superblock({})
 {
 
+	// Every allocation goes through this lock, track how contended it is
+	m_metadata_lock.enable_statistics("ext2 metadata");
+
 	// Read superblock
 	buffer_t superblock_buffer(&superblock, 1024);
 	disk->read(partition_offset + 2, &superblock_buffer, 512);
@@ -67,9 +68,15 @@ Ext2Volume::Ext2Volume(drivers::disk::Disk* disk, lba_t partition_offset)
 		memcpy(block_groups[i], bg_buffer.raw() + i * sizeof(block_group_descriptor_t),
 		       sizeof(block_group_descriptor_t));
 	}
+
+	// Each group is locked separately
+	m_group_locks = new BlockingLock[total_block_groups];
 }
 
-Ext2Volume::~Ext2Volume() = default;
+Ext2Volume::~Ext2Volume() {
+
+	delete[] m_group_locks;
+}
 
 /**
  * @brief write a single block from a buffer into onto the disk
@@ -99,7 +106,7 @@ void Ext2Volume::write_block(uint32_t block_num, buffer_t* buffer) const {
  * @param inode_num The inode index
  * @param inode The inode to read from
  */
-void Ext2Volume::write_inode(uint32_t inode_num, inode_t* inode) const {
+void Ext2Volume::write_inode(uint32_t inode_num, inode_t* inode) {
 
 	// Locate the inode
 	uint32_t group = (inode_num - 1) / superblock.inodes_per_group;
@@ -111,13 +118,15 @@ void Ext2Volume::write_inode(uint32_t inode_num, inode_t* inode) const {
 	uint32_t block = offset / block_size;
 	uint32_t in_block_offset = offset % block_size;
 
-	// Read the inode
+	// Read the inode (other inodes share the block so the group is held until it is written back)
 	buffer_t buffer(block_size);
+	m_group_locks[group].lock();
 	read_block(inode_table + block, &buffer);
 	buffer.copy_from(inode, sizeof(inode_t), in_block_offset);
 
 	// Modify the block
 	write_block(inode_table + block, &buffer);
+	m_group_locks[group].unlock();
 }
 
 /**
@@ -128,16 +137,26 @@ void Ext2Volume::write_inode(uint32_t inode_num, inode_t* inode) const {
  */
 void Ext2Volume::read_block(uint32_t block_num, buffer_t* buffer) const {
 
+	read_blocks(block_num, 1, buffer);
+}
+
+/**
+ * @brief Reads a run of contiguous blocks from the disk into a buffer
+ *
+ * @param block_num The first block to read
+ * @param count How many blocks to read
+ * @param buffer The buffer to read into (must hold count blocks)
+ */
+void Ext2Volume::read_blocks(uint32_t block_num, uint32_t count, buffer_t* buffer) const {
+
 	// Ensure the buffer is in the right format
 	buffer->set_offset(0);
 
-	// Read each sector of the block
-	for(size_t i = 0; i < sectors_per_block; ++i)
-		disk->read(partition_offset + block_num * sectors_per_block + i, buffer, 512);
+	// Read the whole run in one request
+	disk->read_sectors(partition_offset + block_num * sectors_per_block, count * sectors_per_block, buffer);
 
 	// Reset buffer
 	buffer->set_offset(0);
-
 }
 
 /**
@@ -191,29 +210,38 @@ Vector<uint32_t> Ext2Volume::allocate_blocks(uint32_t amount) {
 	if(!amount)
 		return { 1, 0 };
 
-	// Find the block group with enough free blocks
-	block_group_descriptor_t* block_group = block_groups[0];
-	for(uint32_t bg_index = 0; bg_index < total_block_groups; block_group = block_groups[++bg_index])
-		if(block_group->free_blocks >= amount)
-			return allocate_group_blocks(bg_index, amount);
+	// Find the block group with enough free blocks (the counts are rechecked under the group's lock)
+	for(uint32_t bg_index = 0; bg_index < total_block_groups; ++bg_index) {
+		if(block_groups[bg_index]->free_blocks < amount)
+			continue;
+
+		auto allocated = allocate_group_blocks(bg_index, amount);
+		if(allocated[0] != 0)
+			return allocated;
+	}
 
 	// No block group can contain the block so split across multiple
 	Vector<uint32_t> result { };
 	while(amount > 0) {
 
 		// Find the block group with most free blocks
-		block_group = block_groups[0];
-		uint32_t bg_index = 0;
-		for(; bg_index < total_block_groups; ++bg_index)
-			if(block_groups[bg_index]->free_blocks > block_group->free_blocks)
-				block_group = block_groups[bg_index];
+		uint32_t best = 0;
+		for(uint32_t bg_index = 1; bg_index < total_block_groups; ++bg_index)
+			if(block_groups[bg_index]->free_blocks > block_groups[best]->free_blocks)
+				best = bg_index;
 
 		// No space
-		if(block_group->free_blocks == 0)
+		uint32_t available = block_groups[best]->free_blocks;
+		if(available == 0) {
+			free_blocks(result);
 			return { 1, 0 };
+		}
+
+		// Allocate as much of the remainder as the group can hold
+		auto allocated = allocate_group_blocks(best, available < amount ? available : amount);
+		if(allocated[0] == 0)
+			continue;
 
-		// Allocate the remaining blocks
-		auto allocated = allocate_group_blocks(bg_index, 1);
 		amount -= allocated.size();
 		for(auto block : allocated)
 			result.push_back(block);
@@ -233,13 +261,15 @@ common::Vector<uint32_t> Ext2Volume::allocate_group_blocks(uint32_t block_group,
 
 	// Ensure enough space
 	block_group_descriptor_t* descriptor = block_groups[block_group];
-	if(amount > descriptor->free_blocks)
+	m_group_locks[block_group].lock();
+	if(amount > descriptor->free_blocks) {
+		m_group_locks[block_group].unlock();
 		return { 1, 0 };
+	}
 
 	// Prepare
 	Vector<uint32_t> result { };
-	buffer_t zeros(block_size);
-	zeros.clear();
+	uint32_t allocated = 0;
 
 	// Read bitmap
 	buffer_t bitmap(block_size);
@@ -254,24 +284,25 @@ common::Vector<uint32_t> Ext2Volume::allocate_group_blocks(uint32_t block_group,
 
 		// Mark as used
 		descriptor->free_blocks--;
-		superblock.unallocated_blocks--;
 		bitmap.raw()[i / 8] |= (uint8_t) (1u << (i % 8));
-
-		// Zero out data
-		uint32_t block = block_group * superblock.blocks_per_group + superblock.starting_block + i;
-		write_block(block, &zeros);
-		result.push_back(block);
+		result.push_back(block_group * superblock.blocks_per_group + superblock.starting_block + i);
 
 		// All done
-		amount--;
-		if(!amount)
+		allocated++;
+		if(allocated == amount)
 			break;
 	}
 
 	// Save the changed metadata
 	write_block(descriptor->block_usage_bitmap, &bitmap);
-	write_back_block_groups();
-	write_back_superblock();
+	m_group_locks[block_group].unlock();
+	write_back_metadata(0, -(int32_t)allocated);
+
+	// The blocks are owned by the caller now so zeroing them doesn't need the group
+	buffer_t zeros(block_size);
+	zeros.clear();
+	for(auto block : result)
+		write_block(block, &zeros);
 
 	return result;
 }
@@ -289,12 +320,14 @@ void Ext2Volume::free_group_blocks(uint32_t block_group, uint32_t amount, uint32
 	// Read bitmap
 	block_group_descriptor_t* descriptor = block_groups[block_group];
 	buffer_t bitmap(block_size);
+	m_group_locks[block_group].lock();
 	read_block(descriptor->block_usage_bitmap, &bitmap);
 
 	// Convert start to be index based on the group instead of global
 	start -= (block_group * superblock.blocks_per_group + superblock.starting_block);
 
 	// Free the blocks
+	int32_t freed = 0;
 	for(uint32_t i = start; i < start + amount; ++i) {
 
 		// Block is already free (shouldn't happen)
@@ -303,15 +336,14 @@ void Ext2Volume::free_group_blocks(uint32_t block_group, uint32_t amount, uint32
 
 		// Mark as free
 		descriptor->free_blocks++;
-		superblock.unallocated_blocks++;
 		bitmap.raw()[i / 8] &= ~(1u << (i % 8));
+		freed++;
 	}
 
 	// Save the changed metadata
 	write_block(descriptor->block_usage_bitmap, &bitmap);
-	write_back_block_groups();
-	write_back_superblock();
-
+	m_group_locks[block_group].unlock();
+	write_back_metadata(0, freed);
 }
 
 
@@ -351,6 +383,28 @@ void Ext2Volume::write_back_superblock() {
 	disk->write(partition_offset + 3, &buffer, 512);
 }
 
+/**
+ * @brief Apply a change in the free counts to the superblock and save it along with the block group descriptors
+ *
+ * @param inode_change How many inodes were freed (negative if allocated)
+ * @param block_change How many blocks were freed (negative if allocated)
+ *
+ * @note Called after the group lock is released, the descriptors are always written as a whole so whichever group writes
+ * last stores every group's latest counts
+ */
+void Ext2Volume::write_back_metadata(int32_t inode_change, int32_t block_change) {
+
+	m_metadata_lock.lock();
+
+	superblock.unallocated_inodes += inode_change;
+	superblock.unallocated_blocks += block_change;
+
+	write_back_block_groups();
+	write_back_superblock();
+
+	m_metadata_lock.unlock();
+}
+
 /**
  * @brief How many blocks are needed to contain a set amount of bytes
  *
@@ -369,14 +423,24 @@ uint32_t Ext2Volume::bytes_to_blocks(size_t bytes) const {
  */
 uint32_t Ext2Volume::create_inode(bool is_directory) {
 
-	ext2_lock.lock();
-
-	// Find the block group with enough free inodes
-	block_group_descriptor_t* block_group = block_groups[0];
+	// Find the block group with enough free inodes (rechecked once the group is locked)
+	block_group_descriptor_t* block_group = nullptr;
 	uint32_t bg_index = 0;
-	for(; bg_index < total_block_groups; block_group = block_groups[++bg_index])
-		if(block_group->free_inodes >= 1)
+	for(; bg_index < total_block_groups; ++bg_index) {
+		if(block_groups[bg_index]->free_inodes < 1)
+			continue;
+
+		m_group_locks[bg_index].lock();
+		if(block_groups[bg_index]->free_inodes >= 1) {
+			block_group = block_groups[bg_index];
 			break;
+		}
+		m_group_locks[bg_index].unlock();
+	}
+
+	// No free inodes
+	if(!block_group)
+		return 0;
 
 	// Read bitmap
 	buffer_t bitmap(block_size);
@@ -396,7 +460,6 @@ uint32_t Ext2Volume::create_inode(bool is_directory) {
 
 		// Mark as used
 		block_group->free_inodes--;
-		superblock.unallocated_inodes--;
 		bitmap.raw()[inode_index / 8] |= (uint8_t) (1u << (inode_index % 8));
 
 		break;
@@ -407,8 +470,8 @@ uint32_t Ext2Volume::create_inode(bool is_directory) {
 
 	// Save the changed metadata
 	write_block(block_group->block_inode_bitmap, &bitmap);
-	write_back_block_groups();
-	write_back_superblock();
+	m_group_locks[bg_index].unlock();
+	write_back_metadata(-1, 0);
 
 	// Create the inode
 	inode_t inode { };
@@ -421,7 +484,6 @@ uint32_t Ext2Volume::create_inode(bool is_directory) {
 			(uint16_t) (is_directory ? InodePermissionsDefaults::DIRECTORY : InodePermissionsDefaults::FILE) & 0x0FFF;
 	write_inode(inode_index, &inode);
 
-	ext2_lock.unlock();
 	return inode_index;
 }
 
@@ -437,24 +499,24 @@ void Ext2Volume::free_inode(uint32_t inode) {
 	uint32_t bg_index = (inode - 1) / superblock.inodes_per_group;
 	block_group_descriptor_t* block_group = block_groups[bg_index];
 
-	// Read bitmap
-	buffer_t bitmap(block_size);
-	read_block(block_group->block_inode_bitmap, &bitmap);
-
 	// First group contains reserved inodes
 	uint32_t inode_index = (inode - 1) % superblock.inodes_per_group;
 	if(bg_index == 0 && (inode_index < (superblock.first_inode - 1)))
 		return;
 
-	// Mark as used
+	// Read bitmap
+	buffer_t bitmap(block_size);
+	m_group_locks[bg_index].lock();
+	read_block(block_group->block_inode_bitmap, &bitmap);
+
+	// Mark as free
 	block_group->free_inodes++;
-	superblock.unallocated_inodes++;
 	bitmap.raw()[inode_index / 8] &= (uint8_t) ~(1u << (inode_index % 8));
 
 	// Save the changed metadata
 	write_block(block_group->block_inode_bitmap, &bitmap);
-	write_back_block_groups();
-	write_back_superblock();
+	m_group_locks[bg_index].unlock();
+	write_back_metadata(1, 0);
 }
 
 /**
@@ -501,7 +563,8 @@ void Ext2Volume::free_blocks(const common::Vector<uint32_t>& blocks) {
 }
 
 /**
- * @brief Construct a new Inode Handler object. Reads the inode and caches the block pointers
+ * @brief Construct a new Inode Handler object. Reads the inode and caches the direct block pointers, the indirect ones are
+ * only read when they are needed
  *
  * @param volume The volume the inode belongs to
  * @param inode_index The inode index
@@ -511,15 +574,27 @@ InodeHandler::InodeHandler(Ext2Volume* volume, uint32_t inode_index)
 		inode_number(inode_index),
 		inode(m_volume->read_inode(inode_number)) {
 
-	// Read the block pointers
-	for(uint32_t direct_pointer = 0; direct_pointer < 12; ++direct_pointer)
-		if(inode.block_pointers[direct_pointer])
-			block_cache.push_back(inode.block_pointers[direct_pointer]);
-
-	buffer_t buffer(m_volume->block_size);
-	parse_indirect(1, inode.l1_indirect, &buffer);
-	parse_indirect(2, inode.l2_indirect, &buffer);
-	parse_indirect(3, inode.l3_indirect, &buffer);
+	// Direct pointers are in the inode so can be cached without touching the disk (holes are skipped, not the end)
+	uint32_t direct[12];
+	for(uint32_t direct_pointer = 0; direct_pointer < 12; ++direct_pointer) {
+		direct[direct_pointer] = inode.block_pointers[direct_pointer];
+		if(direct[direct_pointer])
+			m_block_count = direct_pointer + 1;
+	}
+	cache_pointers(0, direct, 12);
+
+	// The data ends after the last block in the highest indirect level that has any
+	uint32_t tops[] = { inode.l1_indirect, inode.l2_indirect, inode.l3_indirect };
+	uint32_t first = 12;
+	uint32_t span = m_volume->pointers_per_block;
+	for(uint32_t level = 1; level <= 3; ++level) {
+		uint32_t used = count_indirect(level, tops[level - 1]);
+		if(used)
+			m_block_count = first + used;
+
+		first += span;
+		span *= m_volume->pointers_per_block;
+	}
 }
 
 /**
@@ -542,127 +617,390 @@ void InodeHandler::set_size(size_t size) {
 }
 
 /**
- * @brief Caches the indirect layers block pointers
+ * @brief How many data blocks the inode has
  *
- * @param level Recursion level
- * @param block The block number to parse from
- * @param buffer Buffer to read into
+ * @return The amount of blocks
  */
-void InodeHandler::parse_indirect(uint32_t level, uint32_t block, buffer_t* buffer) {
+uint32_t InodeHandler::block_count() const {
+	return m_block_count;
+}
 
-	// Invalid
-	if(block == 0)
-		return;
+/**
+ * @brief Find where a block of the inode's data is stored on disk
+ *
+ * @param logical The index of the block in the inode's data
+ * @return The block on disk or 0 if there isn't one
+ */
+uint32_t InodeHandler::block(uint32_t logical) {
 
-	// Read the block
-	m_volume->read_block(block, buffer);
-	auto* pointers = (uint32_t*) (buffer->raw());
+	uint32_t length = 0;
+	return extent(logical, length);
+}
+
+/**
+ * @brief Find where a block of the inode's data is stored on disk and how many of the following blocks come straight after it
+ *
+ * @param logical The index of the block in the inode's data
+ * @param length Set to how many blocks from the logical one onwards are contiguous on disk (1 for a hole)
+ * @return The block on disk or 0 if the block is a hole
+ */
+uint32_t InodeHandler::extent(uint32_t logical, uint32_t& length) {
+
+	// Past the last block is a hole too
+	length = 1;
+	if(logical >= m_block_count)
+		return 0;
+
+	// Read the pointers for this part of the inode if they haven't been yet
+	block_extent_t found = {};
+	for(int attempt = 0; attempt < 2; ++attempt) {
 
-	// Parse the pointers
-	for(size_t i = 0; i < m_volume->pointers_per_block; ++i) {
-		uint32_t pointer = pointers[i];
+		size_t index = 0;
+		m_extent_lock.lock();
+		bool cached = find_extent(logical, index);
+		if(cached)
+			found = m_extents[index];
+		m_extent_lock.unlock();
 
-		// Invaild
-		if(pointer == 0)
+		if(cached || attempt)
 			break;
 
-		// Has indirect sub entries
-		if(level > 1) {
-			parse_indirect(level - 1, pointer, buffer);
-			continue;
-		}
+		load_pointers(logical);
+	}
 
-		// Parse the entry
-		block_cache.push_back(pointer);
+	// A hole in the file
+	if(found.length == 0) {
+		length = 1;
+		return 0;
+	}
+
+	length = found.length - (logical - found.logical);
+	return found.physical + (logical - found.logical);
+}
+
+/**
+ * @brief Find the cached extent that contains a logical block. The extent lock must be held
+ *
+ * @param logical The logical block to look for
+ * @param index Set to the index of the extent containing the block, or where one should be inserted if there is none
+ * @return True if an extent contains the block
+ */
+bool InodeHandler::find_extent(uint32_t logical, size_t& index) const {
+
+	// Binary search for the first extent that starts after the block
+	size_t low = 0;
+	size_t high = m_extents.size();
+	while(low < high) {
+		size_t middle = (low + high) / 2;
+		if(m_extents[middle].logical <= logical)
+			low = middle + 1;
+		else
+			high = middle;
 	}
+
+	// The one before it is the only one that could contain the block
+	index = low;
+	if(low == 0)
+		return false;
+
+	const block_extent_t& previous = m_extents[low - 1];
+	if(logical >= previous.logical + previous.length)
+		return false;
+
+	index = low - 1;
+	return true;
 }
 
 /**
- * @brief Writes the Cache to the indirect layer block pointers
+ * @brief Store a run of contiguous blocks, joining it onto its neighbours where they are contiguous too
  *
- * @param level Recursion level
- * @param block The block number to parse from
- * @param buffer Buffer to read into
- * @param index Current entry to write
+ * @param logical The first block of the inode's data in the run
+ * @param physical The block on disk that holds the first logical block
+ * @param length How many blocks are in the run
  */
-void InodeHandler::write_indirect(uint32_t level, uint32_t& block, size_t& index) {
+void InodeHandler::cache_extent(uint32_t logical, uint32_t physical, uint32_t length) {
 
-	// Nothing left to write
-	size_t remaining = block_cache.size() - index;
-	if(remaining == 0 || index >= block_cache.size())
+	m_extent_lock.lock();
+
+	// Another reader has already cached it
+	size_t index = 0;
+	if(find_extent(logical, index)) {
+		m_extent_lock.unlock();
 		return;
+	}
 
-	// Level hasn't been set yet
-	if(block == 0)
-		block = m_volume->allocate_block();
+	// Extend the previous run
+	if(index > 0) {
+		block_extent_t& previous = m_extents[index - 1];
+		if(previous.logical + previous.length == logical && previous.physical + previous.length == physical) {
+			previous.length += length;
+
+			// The gap to the next run has been closed
+			if(index < m_extents.size()) {
+				block_extent_t& next = m_extents[index];
+				if(previous.logical + previous.length == next.logical && previous.physical + previous.length == next.physical) {
+					previous.length += next.length;
+					m_extents.erase(m_extents.begin() + index);
+				}
+			}
+
+			m_extent_lock.unlock();
+			return;
+		}
+	}
 
-	// Allocate a local buffer for this recursion level
-	buffer_t buffer(m_volume->block_size);
-	buffer.clear();
-	auto* pointers = (uint32_t*) buffer.raw();
+	// Extend the next run backwards
+	if(index < m_extents.size()) {
+		block_extent_t& next = m_extents[index];
+		if(logical + length == next.logical && physical + length == next.physical) {
+			next.logical = logical;
+			next.physical = physical;
+			next.length += length;
+			m_extent_lock.unlock();
+			return;
+		}
+	}
 
-	// Write the pointers
-	for(size_t i = 0; i < m_volume->pointers_per_block; ++i) {
+	// Insert a new run, most runs are cached in order so this is normally at the end
+	m_extents.push_back({ logical, physical, length });
+	for(size_t i = m_extents.size() - 1; i > index; --i)
+		m_extents[i] = m_extents[i - 1];
+	m_extents[index] = { logical, physical, length };
 
-		// Invalid
-		if(index >= block_cache.size())
-			break;
+	m_extent_lock.unlock();
+}
+
+/**
+ * @brief Cache a list of consecutive block pointers as extents
+ *
+ * @param logical The logical block the first pointer is for
+ * @param pointers The block pointers
+ * @param count How many pointers are in the list
+ */
+void InodeHandler::cache_pointers(uint32_t logical, const uint32_t* pointers, size_t count) {
 
-		// Has indirect
-		if(level > 1) {
-			write_indirect(level - 1, pointers[i], index);
+	size_t start = 0;
+	while(start < count) {
+
+		// Holes aren't cached
+		if(pointers[start] == 0) {
+			start++;
 			continue;
 		}
 
-		// Save the pointer
-		pointers[i] = block_cache[index++];
+		// Find the end of the run
+		size_t end = start + 1;
+		while(end < count && pointers[end] == pointers[end - 1] + 1)
+			end++;
+
+		cache_extent(logical + start, pointers[start], end - start);
+		start = end;
 	}
+}
+
+/**
+ * @brief Find where the data behind an indirect pointer ends. Only the last used pointer of each level is followed, any
+ * zero pointers before it are holes
+ *
+ * @param level How many levels of pointer blocks are below this one
+ * @param block The pointer block
+ * @return How many data blocks the pointer covers up to and including the last one that is allocated (0 if none are)
+ */
+uint32_t InodeHandler::count_indirect(uint32_t level, uint32_t block) {
 
-	m_volume->write_block(block, &buffer);
+	// Invalid
+	if(block == 0)
+		return 0;
+
+	// Read the block
+	buffer_t buffer(m_volume->block_size);
+	m_volume->read_block(block, &buffer);
+	auto* pointers = (uint32_t*) (buffer.raw());
+
+	// How many data blocks each pointer covers
+	uint32_t span = 1;
+	for(uint32_t i = 1; i < level; ++i)
+		span *= m_volume->pointers_per_block;
+
+	// Work back from the last pointer, a lower level block may turn out to be all holes
+	for(uint32_t i = m_volume->pointers_per_block; i-- > 0;) {
+		if(!pointers[i])
+			continue;
+
+		uint32_t used = level == 1 ? 1 : count_indirect(level - 1, pointers[i]);
+		if(used)
+			return i * span + used;
+	}
+
+	return 0;
 }
 
 /**
- * @brief Saves the blocks to both the cached array and on disk inode
+ * @brief Walk the indirect pointers to find the pointer block that holds the pointer to a logical block
  *
- * @param blocks The blocks to save
+ * @param logical The logical block (must not be a direct block)
+ * @param slot Set to the index of the pointer in the returned block
+ * @param allocate Create any pointer blocks that are missing along the way
+ * @return The pointer block or 0 if it doesn't exist
  */
-void InodeHandler::store_blocks(Vector<uint32_t> const& blocks) {
+uint32_t InodeHandler::pointer_block(uint32_t logical, size_t& slot, bool allocate) {
+
+	// Work out which level the block is in
+	size_t pointers_per_block = m_volume->pointers_per_block;
+	size_t index = logical - 12;
+	size_t span = pointers_per_block;
+	uint32_t level = 1;
+	while(index >= span && level < 3) {
+		index -= span;
+		span *= pointers_per_block;
+		level++;
+	}
 
-	Logger::DEBUG() << "STORING BLOCKS\n";
+	// Too big
+	if(index >= span)
+		return 0;
 
-	// Store in cache
-	for(auto block : blocks)
-		block_cache.push_back(block);
+	// Get the top of the tree (have to use temp because of packed field)
+	uint32_t block = level == 1 ? inode.l1_indirect : level == 2 ? inode.l2_indirect : inode.l3_indirect;
+	if(block == 0) {
+		if(!allocate)
+			return 0;
 
-	// Direct blocks
-	for(uint32_t i = 0; i < 12; ++i)
-		inode.block_pointers[i] = i < block_cache.size() ? block_cache[i] : 0;
+		block = m_volume->allocate_block();
+		switch(level) {
+			case 1: inode.l1_indirect = block; break;
+			case 2: inode.l2_indirect = block; break;
+			default: inode.l3_indirect = block; break;
+		}
+	}
+
+	// Walk down to the last level
+	buffer_t buffer(m_volume->block_size);
+	for(; level > 1; --level) {
+		span /= pointers_per_block;
+		size_t entry = index / span;
+		index %= span;
+
+		// Read the next level
+		m_volume->read_block(block, &buffer);
+		auto* pointers = (uint32_t*) buffer.raw();
+		if(pointers[entry] == 0) {
+			if(!allocate)
+				return 0;
+
+			pointers[entry] = m_volume->allocate_block();
+			m_volume->write_block(block, &buffer);
+		}
+
+		block = pointers[entry];
+	}
+
+	slot = index;
+	return block;
+}
 
-	// No need to do any indirects
-	if(block_cache.size() < 12)
+/**
+ * @brief Read the pointer block that a logical block is in and cache all of its pointers
+ *
+ * @param logical The logical block that is needed
+ */
+void InodeHandler::load_pointers(uint32_t logical) {
+
+	// Direct blocks are cached when the inode is opened
+	if(logical < 12)
 		return;
 
-	// Setup Recursive blocks
-	size_t index = 12;
+	// Find the block
+	size_t slot = 0;
+	uint32_t block = pointer_block(logical, slot, false);
+	if(block == 0)
+		return;
 
-	// Write the blocks
-	uint32_t indirect_blocks[3] = { inode.l1_indirect, inode.l2_indirect, inode.l3_indirect };
-	for(int i = 0; i < 3; ++i) {
+	// Cache the used part of the block
+	buffer_t buffer(m_volume->block_size);
+	m_volume->read_block(block, &buffer);
+	uint32_t first = logical - slot;
+	size_t count = m_volume->pointers_per_block;
+	if(first + count > m_block_count)
+		count = m_block_count - first;
 
-		// Have to use temp because of packed field
-		uint32_t temp = indirect_blocks[i];
-		write_indirect(i + 1, temp, index);
-		indirect_blocks[i] = temp;
+	cache_pointers(first, (uint32_t*) buffer.raw(), count);
+}
+
+/**
+ * @brief Saves the blocks to both the cached extents and on disk inode
+ *
+ * @param blocks The blocks to append to the inode's data
+ */
+void InodeHandler::store_blocks(Vector<uint32_t> const& blocks) {
+
+	buffer_t buffer(m_volume->block_size);
+	uint32_t logical = m_block_count;
+	size_t index = 0;
+	while(index < blocks.size()) {
+
+		// Direct blocks
+		if(logical < 12) {
+			inode.block_pointers[logical] = blocks[index];
+			cache_extent(logical++, blocks[index++], 1);
+			continue;
+		}
+
+		// Fill as much of the pointer block as possible before writing it
+		size_t slot = 0;
+		uint32_t block = pointer_block(logical, slot, true);
+		ASSERT(block != 0, "File is too large for ext2 block pointers");
+		m_volume->read_block(block, &buffer);
+		auto* pointers = (uint32_t*) buffer.raw();
+
+		size_t first_slot = slot;
+		uint32_t first = logical;
+		for(; index < blocks.size() && slot < m_volume->pointers_per_block; ++slot, ++logical)
+			pointers[slot] = blocks[index++];
+
+		m_volume->write_block(block, &buffer);
+		cache_pointers(first, pointers + first_slot, logical - first);
 	}
 
-	// Save the new blocks
-	inode.l1_indirect = indirect_blocks[0];
-	inode.l2_indirect = indirect_blocks[1];
-	inode.l3_indirect = indirect_blocks[2];
+	m_block_count = logical;
 
 	// NOTE: Blocks get allocated when writing indirects. This is then saved later in the write() function
 }
 
+/**
+ * @brief Give a hole in the inode's data a block so that it can be written to
+ *
+ * @param logical The logical block that is a hole
+ * @return The new block on disk, it is zeroed like the hole it replaces
+ *
+ * @note The pointers are saved to disk but the inode itself needs to be saved by the caller
+ */
+uint32_t InodeHandler::fill_hole(uint32_t logical) {
+
+	uint32_t physical = m_volume->allocate_block();
+	ASSERT(physical != 0, "Failed to allocate a block for a hole in a file");
+
+	// Store the pointer
+	if(logical < 12) {
+		inode.block_pointers[logical] = physical;
+	} else {
+		size_t slot = 0;
+		uint32_t block = pointer_block(logical, slot, true);
+		ASSERT(block != 0, "File is too large for ext2 block pointers");
+
+		buffer_t buffer(m_volume->block_size);
+		m_volume->read_block(block, &buffer);
+		((uint32_t*) buffer.raw())[slot] = physical;
+		m_volume->write_block(block, &buffer);
+	}
+
+	cache_extent(logical, physical, 1);
+	if(logical >= m_block_count)
+		m_block_count = logical + 1;
+
+	return physical;
+}
+
 /**
  * @brief Increase the size of the inode's storage capacity by allocating new blocks.
  *
@@ -704,13 +1042,24 @@ void InodeHandler::save() {
  */
 void InodeHandler::free() {
 
-	m_volume->ext2_lock.lock();
+	lock.write_lock();
+
+	// Gather the data blocks, reading any pointers that haven't been needed yet
+	Vector<uint32_t> blocks;
+	for(uint32_t logical = 0; logical < m_block_count;) {
+		uint32_t length = 0;
+		uint32_t physical = extent(logical, length);
+		for(uint32_t i = 0; physical && i < length; ++i)
+			blocks.push_back(physical + i);
+
+		logical += length;
+	}
 
 	// Free the inode
-	m_volume->free_blocks(block_cache);
+	m_volume->free_blocks(blocks);
 	m_volume->free_inode(inode_number);
 
-	m_volume->ext2_lock.unlock();
+	lock.write_unlock();
 }
 
 InodeHandler::~InodeHandler() = default;
@@ -745,7 +1094,7 @@ void Ext2File::write(buffer_t* data, size_t amount) {
 		return;
 
 	// Prepare for writing
-	m_volume->ext2_lock.lock();
+	m_inode.lock.write_lock();
 	const uint32_t block_size = m_volume->block_size;
 	buffer_t buffer(block_size);
 
@@ -753,10 +1102,6 @@ void Ext2File::write(buffer_t* data, size_t amount) {
 	if(m_offset + amount > m_size)
 		m_size = m_inode.grow((m_offset + amount) - m_size, false);
 
-	// Save the updated metadata
-	m_inode.inode.last_modification_time = time_to_epoch(Clock::active_clock()->get_time());
-	m_inode.save();
-
 	// Convert bytes to blocks
 	uint32_t block_start = m_offset / block_size;
 	uint32_t block_offset = m_offset % block_size;
@@ -766,8 +1111,10 @@ void Ext2File::write(buffer_t* data, size_t amount) {
 	size_t written = 0;
 	while(written < amount) {
 
-		// Read the block
-		uint32_t block = m_inode.block_cache[current_block++];
+		// Read the block (a hole needs a block before it can hold data)
+		uint32_t block = m_inode.block(current_block++);
+		if(!block)
+			block = m_inode.fill_hole(current_block - 1);
 		m_volume->read_block(block, &buffer);
 
 		// Where in this block to start writing
@@ -781,9 +1128,13 @@ void Ext2File::write(buffer_t* data, size_t amount) {
 		written += writable;
 	}
 
+	// Save the updated metadata (including any holes that were filled)
+	m_inode.inode.last_modification_time = time_to_epoch(Clock::active_clock()->get_time());
+	m_inode.save();
+
 	// Clean up
 	m_offset += amount;
-	m_volume->ext2_lock.unlock();
+	m_inode.lock.write_unlock();
 }
 
 /**
@@ -795,44 +1146,66 @@ void Ext2File::write(buffer_t* data, size_t amount) {
 void Ext2File::read(buffer_t* data, size_t amount) {
 
 	// Nothing to read
-	if(m_size == 0 || amount == 0)
+	if(amount == 0)
 		return;
 
 	// Prepare for reading
-	m_volume->ext2_lock.lock();
+	m_inode.lock.read_lock();
 	const uint32_t block_size = m_volume->block_size;
-	buffer_t buffer(block_size);
 
-	// Force bounds
-	if(m_offset + amount > m_size)
-		amount = m_size - m_offset;
+	// Other readers may share the position, claim the range being read so that each gets its own part of the file
+	size_t requested = amount;
+	uint32_t offset = __atomic_load_n(&m_offset, __ATOMIC_RELAXED);
+	do {
 
-	// Convert bytes to blocks
-	uint32_t block_start = m_offset / block_size;
-	uint32_t block_offset = m_offset % block_size;
+		// Force bounds
+		if(offset >= m_size) {
+			m_inode.lock.read_unlock();
+			return;
+		}
 
-	// Read each block
-	size_t current_block = block_start;
+		amount = offset + requested > m_size ? m_size - offset : requested;
+	} while(!__atomic_compare_exchange_n(&m_offset, &offset, offset + amount, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+	// Size the transfer buffer for the whole read, up to the transfer limit
+	uint32_t blocks_needed = m_volume->bytes_to_blocks(offset % block_size + amount);
+	uint32_t max_transfer = blocks_needed < EXT2_MAX_TRANSFER_BLOCKS ? blocks_needed : EXT2_MAX_TRANSFER_BLOCKS;
+	buffer_t buffer(max_transfer * block_size);
+
+	// Read each run of contiguous blocks
 	size_t read = 0;
 	while(read < amount) {
 
-		// Read the block
-		uint32_t block = m_inode.block_cache[current_block++];
-		m_volume->read_block(block, &buffer);
+		// Where in the first block to start reading
+		uint32_t current_block = (offset + read) / block_size;
+		size_t buffer_start = (offset + read) % block_size;
+
+		// Find how many of the remaining blocks are next to each other on disk
+		uint32_t remaining = m_volume->bytes_to_blocks(buffer_start + amount - read);
+		uint32_t length = 0;
+		uint32_t block = m_inode.extent(current_block, length);
+		if(length > remaining)
+			length = remaining;
+		if(length > max_transfer)
+			length = max_transfer;
+
+		// Read the run (holes read as zero)
+		if(block)
+			m_volume->read_blocks(block, length, &buffer);
+		else
+			buffer.clear();
 
-		// Where in this block to start reading
-		size_t buffer_start = (current_block - 1 == block_start) ? block_offset : 0;
-		size_t readable = (amount - read < block_size - buffer_start) ? (amount - read) : (block_size - buffer_start);
+		// Copy out the requested part
+		size_t readable = length * block_size - buffer_start;
+		if(readable > amount - read)
+			readable = amount - read;
 
-		// Read the block
 		buffer.copy_to(data, readable, buffer_start, read);
 		read += readable;
-
 	}
 
 	// Clean up
-	m_offset += amount;
-	m_volume->ext2_lock.unlock();
+	m_inode.lock.read_unlock();
 }
 
 /**
@@ -909,6 +1282,7 @@ void Ext2Directory::parse_block(buffer_t* buffer) {
 void Ext2Directory::remove_entry(string const& name, bool is_directory, bool clear) {
 
 	// Find the entry
+	m_inode.lock.write_lock();
 	uint32_t index = 0;
 	directory_entry_t* entry = nullptr;
 	for(; index < m_entries.size(); ++index)
@@ -918,8 +1292,10 @@ void Ext2Directory::remove_entry(string const& name, bool is_directory, bool cle
 		}
 
 	// No entry found
-	if(!entry || entry->type != (uint8_t) (is_directory ? EntryType::DIRECTORY : EntryType::FILE))
+	if(!entry || entry->type != (uint8_t) (is_directory ? EntryType::DIRECTORY : EntryType::FILE)) {
+		m_inode.lock.write_unlock();
 		return;
+	}
 
 	// Clear the inode
 	if(clear) {
@@ -931,6 +1307,7 @@ void Ext2Directory::remove_entry(string const& name, bool is_directory, bool cle
 	m_entries.erase(entry);
 	m_entry_names.erase(m_entry_names.begin() + index);
 	write_entries();
+	m_inode.lock.write_unlock();
 }
 
 /**
@@ -943,6 +1320,7 @@ void Ext2Directory::remove_entry(string const& name, bool is_directory, bool cle
 void Ext2Directory::rename_entry(string const& old_name, string const& new_name, bool is_directory) {
 
 	// Change the name
+	m_inode.lock.write_lock();
 	for(uint32_t i = 0; i < m_entry_names.size(); ++i)
 		if(m_entry_names[i] == old_name &&
 		   m_entries[i].type == (uint8_t) (is_directory ? EntryType::DIRECTORY : EntryType::FILE))
@@ -950,7 +1328,7 @@ void Ext2Directory::rename_entry(string const& old_name, string const& new_name,
 
 	// Save the change
 	write_entries();
-
+	m_inode.lock.write_unlock();
 }
 
 /**
@@ -958,7 +1336,7 @@ void Ext2Directory::rename_entry(string const& old_name, string const& new_name,
  */
 void Ext2Directory::read_from_disk() {
 
-	m_volume->ext2_lock.lock();
+	m_inode.lock.write_lock();
 	m_entries.clear();
 	m_entry_names.clear();
 
@@ -971,11 +1349,12 @@ void Ext2Directory::read_from_disk() {
 		delete directory;
 	m_subdirectories.clear();
 
-	// Read the direct blocks (cant use for( : ))
+	// Read the blocks
 	buffer_t buffer(m_volume->block_size);
-	for(unsigned int block_pointer : m_inode.block_cache) {
+	for(uint32_t i = 0; i < m_inode.block_count(); ++i) {
 
 		// Invalid block
+		uint32_t block_pointer = m_inode.block(i);
 		if(block_pointer == 0)
 			break;
 
@@ -984,11 +1363,11 @@ void Ext2Directory::read_from_disk() {
 		parse_block(&buffer);
 	}
 
-	m_volume->ext2_lock.unlock();
+	m_inode.lock.write_unlock();
 }
 
 /**
- * @brief write all directory entries to the disk (expands the directory blocks if needed)
+ * @brief write all directory entries to the disk (expands the directory blocks if needed). The inode must be write locked
  */
 void Ext2Directory::write_entries() {
 
@@ -1002,11 +1381,10 @@ void Ext2Directory::write_entries() {
 
 	// Expand the directory
 	size_t blocks_required = m_volume->bytes_to_blocks(size_required);
-	if(blocks_required > m_inode.block_cache.size())
-		m_inode.grow((blocks_required - m_inode.block_cache.size()) * m_volume->block_size, false);
+	if(blocks_required > m_inode.block_count())
+		m_inode.grow((blocks_required - m_inode.block_count()) * m_volume->block_size, false);
 
 	// Prepare for writing
-	m_volume->ext2_lock.lock();
 	const uint32_t block_size = m_volume->block_size;
 	buffer_t buffer(block_size, false);
 	buffer.clear();
@@ -1032,7 +1410,7 @@ void Ext2Directory::write_entries() {
 
 		// Entry needs to be stored in the next block
 		if(entry.size + buffer_offset > block_size) {
-			m_volume->write_block(m_inode.block_cache[current_block], &buffer);
+			m_volume->write_block(m_inode.block(current_block), &buffer);
 			buffer.clear();
 			current_block++;
 			buffer_offset = 0;
@@ -1049,10 +1427,7 @@ void Ext2Directory::write_entries() {
 	}
 
 	// Save the last block
-	m_volume->write_block(m_inode.block_cache[current_block], &buffer);
-
-	// Clean up
-	m_volume->ext2_lock.unlock();
+	m_volume->write_block(m_inode.block(current_block), &buffer);
 }
 
 /**
@@ -1074,9 +1449,11 @@ directory_entry_t Ext2Directory::create_entry(const string& name, uint32_t inode
 	entry.size += entry.size % 4 ? 4 - entry.size % 4 : 0;
 
 	// Save the inode
+	m_inode.lock.write_lock();
 	m_entries.push_back(entry);
 	m_entry_names.push_back(name);
 	write_entries();
+	m_inode.lock.write_unlock();
 
 	return entry;
 }
@@ -32,8 +32,12 @@ Desktop::Desktop(GraphicsContext* gc)
 	m_mouse_x = gc->width() / 2;
 	m_mouse_y = gc->height() / 2;
 
-	// Draw the initial mouse cursor
-	invert_mouse_cursor();
+	// Draw off screen if possible, otherwise draw the initial mouse cursor straight onto the screen
+	m_back_buffered = gc->enable_back_buffer();
+	if(m_back_buffered)
+		gc->move_cursor(m_mouse_x, m_mouse_y);
+	else
+		invert_mouse_cursor();
 
 	// Draw the desktop
 	Widget::invalidate();
@@ -41,6 +45,86 @@ Desktop::Desktop(GraphicsContext* gc)
 
 Desktop::~Desktop() = default;
 
+/**
+ * @brief Take the widget tree so it can be changed or drawn, input that was waiting for it is applied first
+ */
+void Desktop::lock() {
+
+	m_lock.acquire();
+	apply_input();
+}
+
+/**
+ * @brief Let go of the widget tree, applying any input that arrived while it was held
+ */
+void Desktop::unlock() {
+
+	apply_input();
+	m_lock.release();
+}
+
+/**
+ * @brief Queue input to be applied by the next thread to lock the desktop, safe to call from an interrupt
+ *
+ * @param input The input event
+ */
+void Desktop::queue_input(const DesktopInput& input) {
+
+	uint64_t flags = m_input_lock.acquire_irqsave();
+	if(m_input_count < DESKTOP_INPUT_QUEUE_SIZE) {
+		m_input[(m_input_head + m_input_count) % DESKTOP_INPUT_QUEUE_SIZE] = input;
+		m_input_count++;
+	}
+	m_input_lock.release_irqrestore(flags);
+}
+
+/**
+ * @brief Apply the queued input in the order it arrived. The desktop must be locked
+ */
+void Desktop::apply_input() {
+
+	while(true) {
+
+		// Only hold the queue while taking an event, handling it can send messages to clients
+		uint64_t flags = m_input_lock.acquire_irqsave();
+		if(!m_input_count) {
+			m_input_lock.release_irqrestore(flags);
+			return;
+		}
+
+		DesktopInput input = m_input[m_input_head];
+		m_input_head = (m_input_head + 1) % DESKTOP_INPUT_QUEUE_SIZE;
+		m_input_count--;
+		m_input_lock.release_irqrestore(flags);
+
+		switch(input.type) {
+
+			case DesktopInputType::MOUSE_MOVE:
+				move_mouse(input.x, input.y);
+				break;
+
+			case DesktopInputType::MOUSE_DOWN:
+				press_mouse(input.button);
+				break;
+
+			case DesktopInputType::MOUSE_UP:
+				release_mouse(input.button);
+				break;
+
+			// Pass the key to the widget that is in focus
+			case DesktopInputType::KEY_DOWN:
+				if(m_focussed_widget != nullptr)
+					m_focussed_widget->on_key_down(input.key, input.state);
+				break;
+
+			case DesktopInputType::KEY_UP:
+				if(m_focussed_widget != nullptr)
+					m_focussed_widget->on_key_up(input.key, input.state);
+				break;
+		}
+	}
+}
+
 /**
  * @brief Updates the currently focussed widget to be the given widget
  *
@@ -64,11 +148,19 @@ void Desktop::set_focus(Widget* widget) {
  */
 void Desktop::bring_to_front(Widget* front_widget) {
 
+	// Already in front
+	if(!m_children.empty() && *m_children.begin() == front_widget)
+		return;
+
 	// Remove the widget from where ever it already is
 	m_children.erase(front_widget);
 
 	// Add it back in the front
 	m_children.push_front(front_widget);
+
+	// Show the parts that were covered, a window is copied from its surface so its content isn't drawn again
+	Rectangle<int32_t> area = front_widget->position();
+	invalidate(area);
 }
 
 /**
@@ -88,44 +180,12 @@ void Desktop::invert_mouse_cursor() {
 }
 
 /**
- * @brief Goes through the passed areas and invalidates the areas that are covered by the given area
- *
- * @param area The area that is now invalid
- * @param start The start of the invalid areas
- * @param stop The end of the invalid areas
+ * @brief Marks the area under the mouse cursor as needing to be presented again
  */
-void Desktop::internal_invalidate(common::Rectangle<int32_t>& area, Vector<Rectangle<int32_t>>::iterator start, Vector<Rectangle<int32_t>>::iterator stop) {
+void Desktop::invalidate_mouse_cursor() {
 
-	// Loop through the invalid rectangles
-	for(Vector<Rectangle<int32_t>>::iterator invaild_rect = start; invaild_rect != stop; invaild_rect++) {
-
-		// Check if the area intersects with the invalid rectangle
-		if(!area.intersects(*invaild_rect))
-			continue;
-
-		// Get the parts of the area that are covered by the invalid rectangle
-		Vector<Rectangle<int32_t>> covered_areas = area.subtract(*invaild_rect);
-
-		// Invalidate the covered areas
-		for(auto& covered_area : covered_areas)
-			internal_invalidate(covered_area, invaild_rect + 1, stop);
-
-		// The entire area will be invalidated by now
-		return;
-
-	}
-
-	// Add the area to the invalid areas, store where it was added
-	Vector<Rectangle<int32_t>>::iterator vector_position = m_invalid_areas.push_back(area);
-
-	// If the m_position is the last item then the invalidation buffer is full
-	if(vector_position == m_invalid_areas.end()) {
-
-		// Invalidate the entire desktop
-		m_invalid_areas.clear();
-		Widget::invalidate();
-
-	}
+	Rectangle<int32_t> cursor_area(m_mouse_x - CURSOR_SIZE / 2, m_mouse_y - CURSOR_SIZE / 2, CURSOR_SIZE, CURSOR_SIZE);
+	invalidate(cursor_area);
 }
 
 /**
@@ -136,14 +196,8 @@ void Desktop::internal_invalidate(common::Rectangle<int32_t>& area, Vector<Recta
  */
 void Desktop::draw_self(common::GraphicsContext* gc, common::Rectangle<int32_t>& area) {
 
-	// Calculate the rectangle
-	int32_t top_corner_x = area.left;
-	int32_t top_corner_y = area.top;
-	int32_t bottom_corner_x = area.left + area.width;
-	int32_t bottom_corner_y = area.top + area.height;
-
 	// Draw the background, a rectangle the size of the desktop of the given colour
-	gc->fill_rectangle(top_corner_x, top_corner_y, bottom_corner_x, bottom_corner_y, colour);
+	gc->fill_rect(area.left, area.top, area.width, area.height, colour);
 }
 
 /**
@@ -169,7 +223,23 @@ void Desktop::add_child(Widget* child_widget) {
 }
 
 /**
- * @brief Redraws the desktop when a time event occurs
+ * @brief Removes a child widget from the desktop, it stops receiving input
+ *
+ * @param child_widget The widget to remove
+ */
+void Desktop::remove_child(Widget* child_widget) {
+
+	if(m_focussed_widget == child_widget)
+		m_focussed_widget = nullptr;
+
+	// The drag may belong to the widget
+	m_dragged_widget = nullptr;
+
+	CompositeWidget::remove_child(child_widget);
+}
+
+/**
+ * @brief Redraws the desktop when a time event occurs. The desktop must be locked
  *
  * @param time The time when the event occurred
  */
@@ -179,21 +249,28 @@ void Desktop::on_time(common::Time const&) {
 	if(m_invalid_areas.empty())
 		return;
 
-	// Erase the mouse cursor
-	invert_mouse_cursor();
+	// Erase the mouse cursor (a back buffer never has it drawn in)
+	if(!m_back_buffered)
+		invert_mouse_cursor();
+
+	// Take the invalid areas so anything invalidated while drawing is drawn next time
+	Region invalid_areas = m_invalid_areas;
+	m_invalid_areas.clear();
 
-	// Loop through the invalid areas
-	while(!m_invalid_areas.empty()) {
+	// Redraw each area
+	for(auto& area : invalid_areas.rectangles()) {
 
-		// Redraw the m_first_memory_chunk area
-		Rectangle<int32_t> invalid_area = *(m_invalid_areas.begin());
-		m_invalid_areas.pop_front();
+		Rectangle<int32_t> invalid_area = area;
 		draw(m_graphics_context, invalid_area);
 
+		// Only the redrawn area is copied to the screen, the cursor is drawn on top as it is copied
+		if(m_back_buffered)
+			m_graphics_context->present(invalid_area.left, invalid_area.top, invalid_area.width, invalid_area.height);
 	}
 
 	// Can now draw the mouse cursor
-	invert_mouse_cursor();
+	if(!m_back_buffered)
+		invert_mouse_cursor();
 
 }
 
@@ -204,11 +281,82 @@ void Desktop::on_time(common::Time const&) {
  */
 void Desktop::invalidate(Rectangle<int32_t>& area) {
 
-	// Invalidate the area
-	internal_invalidate(area, m_invalid_areas.begin(), m_invalid_areas.end());
+	// Merge the area with the rest of the damage, nearby areas are joined so a moving window is drawn as one rectangle
+	m_invalid_areas.include(area, DAMAGE_MERGE_SLACK, DAMAGE_MAX_RECTANGLES);
+
+}
+
+
+/**
+ * @brief Queue the mouse moving to be applied to the desktop
+ *
+ * @param x How far the mouse moved horizontally
+ * @param y How far the mouse moved vertically
+ */
+void Desktop::on_mouse_move_event(int8_t x, int8_t y) {
+
+	DesktopInput input {};
+	input.type = DesktopInputType::MOUSE_MOVE;
+	input.x = x;
+	input.y = y;
+	queue_input(input);
+}
+
+/**
+ * @brief Queue a mouse button being pressed to be applied to the desktop
+ *
+ * @param button The button that was pressed
+ */
+void Desktop::on_mouse_down_event(uint8_t button) {
+
+	DesktopInput input {};
+	input.type = DesktopInputType::MOUSE_DOWN;
+	input.button = button;
+	queue_input(input);
+}
+
+/**
+ * @brief Queue a mouse button being released to be applied to the desktop
+ *
+ * @param button The button that was released
+ */
+void Desktop::on_mouse_up_event(uint8_t button) {
+
+	DesktopInput input {};
+	input.type = DesktopInputType::MOUSE_UP;
+	input.button = button;
+	queue_input(input);
+}
+
+/**
+ * @brief Queue a key being pressed to be passed to the widget that is in focus
+ *
+ * @param key_down_code The key that was pressed
+ * @param key_down_state The state of the keyboard
+ */
+void Desktop::on_key_down(KeyCode key_down_code, const KeyboardState& key_down_state) {
 
+	DesktopInput input {};
+	input.type = DesktopInputType::KEY_DOWN;
+	input.key = key_down_code;
+	input.state = key_down_state;
+	queue_input(input);
 }
 
+/**
+ * @brief Queue a key being released to be passed to the widget that is in focus
+ *
+ * @param key_up_code The key that was released
+ * @param key_up_state The state of the keyboard
+ */
+void Desktop::on_key_up(KeyCode key_up_code, const KeyboardState& key_up_state) {
+
+	DesktopInput input {};
+	input.type = DesktopInputType::KEY_UP;
+	input.key = key_up_code;
+	input.state = key_up_state;
+	queue_input(input);
+}
 
 /**
  * @brief When the mouse moves on the desktop update the m_position of the mouse and redraw the cursor. Pass the event to the widget that the mouse is over
@@ -216,7 +364,7 @@ void Desktop::invalidate(Rectangle<int32_t>& area) {
  * @param x The x m_position of the mouse
  * @param y The y m_position of the mouse
  */
-void Desktop::on_mouse_move_event(int8_t x, int8_t y) {
+void Desktop::move_mouse(int8_t x, int8_t y) {
 
 	// Calculate the m_position of the mouse on the desktop
 	Rectangle<int32_t> desktop_position = position();
@@ -228,7 +376,10 @@ void Desktop::on_mouse_move_event(int8_t x, int8_t y) {
 	if(new_mouse_y > desktop_position.height) new_mouse_y = desktop_position.height - 1;
 
 	// Remove the old cursor from the screen as it will be redrawn in the new m_position
-	invert_mouse_cursor();
+	if(m_back_buffered)
+		invalidate_mouse_cursor();
+	else
+		invert_mouse_cursor();
 
 	// If a widget is being dragged then pass the event to it
 	if(m_dragged_widget != nullptr)
@@ -243,7 +394,11 @@ void Desktop::on_mouse_move_event(int8_t x, int8_t y) {
 	m_mouse_y = new_mouse_y;
 
 	// Draw the new cursor
-	invert_mouse_cursor();
+	if(m_back_buffered) {
+		m_graphics_context->move_cursor(m_mouse_x, m_mouse_y);
+		invalidate_mouse_cursor();
+	} else
+		invert_mouse_cursor();
 }
 
 /**
@@ -251,7 +406,7 @@ void Desktop::on_mouse_move_event(int8_t x, int8_t y) {
  *
  * @param button The button that was pressed
  */
-void Desktop::on_mouse_down_event(uint8_t button) {
+void Desktop::press_mouse(uint8_t button) {
 
 	// The widget that handled the event becomes the widget being dragged
 	m_dragged_widget = CompositeWidget::on_mouse_button_pressed(m_mouse_x, m_mouse_y, button);
@@ -262,35 +417,11 @@ void Desktop::on_mouse_down_event(uint8_t button) {
  *
  * @param button The button that was released
  */
-void Desktop::on_mouse_up_event(uint8_t button) {
+void Desktop::release_mouse(uint8_t button) {
 
 	// Pass the event to the widget
 	CompositeWidget::on_mouse_button_released(m_mouse_x, m_mouse_y, button);
 
 	// Dragging has stopped
 	m_dragged_widget = nullptr;
-}
-
-/**
- * @brief When a key is pressed pass the event to the widget that is currently focussed
- * @param key_down_code The key that was pressed
- * @param key_down_state The state of the keyboard
- */
-void Desktop::on_key_down(KeyCode key_down_code, const KeyboardState& key_down_state) {
-
-	// Pass the event to the widget that is  in focus
-	if(m_focussed_widget != nullptr)
-		m_focussed_widget->on_key_down(key_down_code, key_down_state);
-}
-
-/**
- * @brief When a key is pressed pass the event to the widget that is currently focussed
- * @param key_up_code The key that was pressed
- * @param key_up_state The state of the keyboard
- */
-void Desktop::on_key_up(KeyCode key_up_code, const KeyboardState& key_up_state) {
-
-	// Pass the event to the widget that is  in focus
-	if(m_focussed_widget != nullptr)
-		m_focussed_widget->on_key_up(key_up_code, key_up_state);
 }
\ No newline at end of file
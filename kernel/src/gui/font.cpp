@@ -27,7 +27,21 @@ Font::Font(const uint8_t* font_data) {
 	}
 }
 
-Font::~Font() = default;
+/**
+ * @brief Destroy the Font object, freeing the cached glyphs
+ */
+Font::~Font() {
+
+	for(auto set : m_glyph_cache) {
+		if(!set)
+			continue;
+
+		for(auto tile : set->tiles)
+			delete[] tile;
+
+		delete set;
+	}
+}
 
 /**
  * @brief write the entire text to the screen
@@ -98,37 +112,120 @@ void Font::draw_text(int32_t x, int32_t y, common::Colour foreground_colour,
 	int32_t x_limit = limit_area.left + limit_area.width;
 	int32_t y_limit = limit_area.top + limit_area.height;
 
-	// Draw the text from top to bottom
-	for(int y_bit_map_offset = limit_area.top; y_bit_map_offset < y_limit; y_bit_map_offset++) {
-		for(int x_bit_map_offset = limit_area.left; x_bit_map_offset < x_limit; ++x_bit_map_offset) {
+	// Nothing left to draw
+	if(limit_area.width <= 0 || limit_area.height <= 0)
+		return;
+
+	// Copy the visible part of each character's tile
+	glyph_tile_set_t* tiles = tile_set(foreground, background, context->color_depth());
+	for(int32_t character_left = limit_area.left / 8 * 8; character_left < x_limit; character_left += 8) {
+
+		int32_t left = character_left > limit_area.left ? character_left : limit_area.left;
+		int32_t right = character_left + 8 < x_limit ? character_left + 8 : x_limit;
+
+		const uint32_t* tile = glyph(tiles, text[character_left / 8]);
+		context->blit(x + left, y + limit_area.top, tile + limit_area.top * 8 + (left - character_left), right - left, limit_area.height, 8);
+	}
+
+	// If the y is the middle then add a strikethrough
+	if(is_strikethrough && y_limit / 2 >= limit_area.top)
+		context->fill_span(x + limit_area.left, y + y_limit / 2, limit_area.width, foreground);
+
+	// If the y is the bottom then add an underline
+	if(is_underlined)
+		context->fill_span(x + limit_area.left, y + y_limit - 1, limit_area.width, foreground);
+}
+
+/**
+ * @brief Draw a single character, without converting the colours or building a string
+ *
+ * @param x The x coordinate of the character
+ * @param y The y coordinate of the character
+ * @param foreground The letter colour, already converted for the context
+ * @param background The background colour, already converted for the context
+ * @param context The graphics context to draw the character on
+ * @param character The character to draw
+ */
+void Font::draw_character(int32_t x, int32_t y, uint32_t foreground, uint32_t background, common::GraphicsContext* context, char character) {
 
-			// If the y is the middle then add a strikethrough
-			if(is_strikethrough && y_bit_map_offset == y_limit / 2) {
+	glyph_tile_set_t* tiles = tile_set(foreground, background, context->color_depth());
+	context->blit(x, y, glyph(tiles, character), 8, 8, 8);
 
-				// Draw the pixel
-				context->put_pixel(x + x_bit_map_offset, y + y_bit_map_offset, foreground);
-				continue;
-			}
+	if(is_strikethrough)
+		context->fill_span(x, y + 4, 8, foreground);
 
-			// If the y is the bottom then add an underline
-			if(is_underlined && y_bit_map_offset == y_limit - 1) {
+	if(is_underlined)
+		context->fill_span(x, y + 7, 8, foreground);
+}
 
-				// Draw the pixel
-				context->put_pixel(x + x_bit_map_offset, y + y_bit_map_offset, foreground);
-				continue;
-			}
+/**
+ * @brief Find the tile set for a combination of colours, replacing the least recently used set if there isn't one yet
+ *
+ * @param foreground The letter colour, in the format of the color depth
+ * @param background The background colour, in the format of the color depth
+ * @param color_depth The color depth of the context being drawn to
+ * @return The tile set
+ */
+glyph_tile_set_t* Font::tile_set(uint32_t foreground, uint32_t background, uint32_t color_depth) {
 
-			// Get the character
-			uint8_t character = text[x_bit_map_offset / 8];
+	m_glyph_cache_clock++;
 
-			// Check if this pixel  is set or not
-			bool set = m_font8x8[(uint16_t) character * 8 + y_bit_map_offset] & (128 >> (x_bit_map_offset % 8));
+	// Slots are filled in order so an empty one means there is no match
+	glyph_tile_set_t* oldest = nullptr;
+	for(auto& set : m_glyph_cache) {
 
-			// Draw the pixel
-			context->put_pixel(x + x_bit_map_offset, y + y_bit_map_offset, set ? foreground : background);
+		if(!set) {
+			set = new glyph_tile_set_t {};
+			oldest = set;
+			break;
+		}
 
+		if(set->foreground == foreground && set->background == background && set->color_depth == color_depth) {
+			set->last_used = m_glyph_cache_clock;
+			return set;
 		}
+
+		if(!oldest || set->last_used < oldest->last_used)
+			oldest = set;
+	}
+
+	// Keep the tiles allocated, they are expanded again as they are drawn
+	oldest->foreground = foreground;
+	oldest->background = background;
+	oldest->color_depth = color_depth;
+	oldest->last_used = m_glyph_cache_clock;
+	for(auto& bits : oldest->expanded)
+		bits = 0;
+
+	return oldest;
+}
+
+/**
+ * @brief Get the tile for a character, expanding the font bitmap into it the first time it is drawn with these colours
+ *
+ * @param tile_set The colours to draw with
+ * @param character The character
+ * @return The 8x8 tile, one pixel per uint32_t
+ */
+const uint32_t* Font::glyph(glyph_tile_set_t* tile_set, uint8_t character) {
+
+	uint32_t*& tile = tile_set->tiles[character];
+	if(!tile)
+		tile = new uint32_t[GLYPH_PIXELS];
+
+	// Already expanded
+	uint64_t bit = 1ULL << (character % 64);
+	if(tile_set->expanded[character / 64] & bit)
+		return tile;
+
+	for(int row = 0; row < 8; ++row) {
+		uint8_t bits = m_font8x8[(uint16_t) character * 8 + row];
+		for(int column = 0; column < 8; ++column)
+			tile[row * 8 + column] = (bits & (128 >> column)) ? tile_set->foreground : tile_set->background;
 	}
+
+	tile_set->expanded[character / 64] |= bit;
+	return tile;
 }
 
 /**
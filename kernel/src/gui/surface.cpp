@@ -0,0 +1,99 @@
+/**
+ * @file surface.cpp
+ * @brief Implementation of the Surface class defined in surface.h
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+ */
+
+#include <gui/surface.h>
+#include <memory/memoryIO.h>
+
+using namespace MaxOS;
+using namespace MaxOS::common;
+using namespace MaxOS::gui;
+
+/**
+ * @brief Creates a surface cleared to 0
+ *
+ * @param width The width in pixels
+ * @param height The height in pixels
+ * @param color_depth The color depth of the context the surface will be copied to
+ */
+Surface::Surface(uint32_t width, uint32_t height, uint32_t color_depth)
+: m_pixels(new uint32_t[width * height])
+{
+
+	m_width = width;
+	m_height = height;
+	m_color_depth = color_depth;
+	memset(m_pixels, 0, width * height * sizeof(uint32_t));
+
+	// Only 32 bit pixels can be drawn like a framebuffer
+	if(color_depth == 32) {
+		m_framebuffer_address = (uint64_t*) m_pixels;
+		m_pitch = width * sizeof(uint32_t);
+	}
+
+	select_span_functions();
+}
+
+Surface::~Surface() {
+
+	delete[] m_pixels;
+}
+
+/**
+ * @brief Stores a pixel in the surface
+ *
+ * @param x The x coordinate of the pixel
+ * @param y The y coordinate of the pixel
+ * @param colour The colour of the pixel, in the format of the color depth
+ */
+void Surface::render_pixel(uint32_t x, uint32_t y, uint32_t colour) {
+
+	m_pixels[y * m_width + x] = colour;
+}
+
+/**
+ * @brief Reads a pixel from the surface
+ *
+ * @param x The x coordinate of the pixel
+ * @param y The y coordinate of the pixel
+ * @return The colour of the pixel, in the format of the color depth
+ */
+uint32_t Surface::get_rendered_pixel(uint32_t x, uint32_t y) {
+
+	return m_pixels[y * m_width + x];
+}
+
+/**
+ * @brief Get the pixels of the surface
+ *
+ * @return The pixels, one row after another
+ */
+uint32_t* Surface::pixels() const {
+
+	return m_pixels;
+}
+
+/**
+ * @brief Copies part of the surface onto another context
+ *
+ * @param gc The context to copy to, must have the color depth the surface was created with
+ * @param x The x coordinate in the context of the surface's top left corner
+ * @param y The y coordinate in the context of the surface's top left corner
+ * @param area The part of the surface to copy
+ */
+void Surface::composite(GraphicsContext* gc, int32_t x, int32_t y, const Rectangle<int32_t>& area) const {
+
+	// Keep to the surface
+	int32_t left = area.left < 0 ? 0 : area.left;
+	int32_t top = area.top < 0 ? 0 : area.top;
+	int32_t right = area.left + area.width > (int32_t) m_width ? (int32_t) m_width : area.left + area.width;
+	int32_t bottom = area.top + area.height > (int32_t) m_height ? (int32_t) m_height : area.top + area.height;
+	if(left >= right || top >= bottom)
+		return;
+
+	gc->blit(x + left, y + top, m_pixels + top * m_width + left, right - left, bottom - top, (int32_t) m_width);
+}
@@ -7,6 +7,7 @@
  */
 
 #include <gui/widget.h>
+#include <common/region.h>
 
 using namespace MaxOS::common;
 using namespace MaxOS::gui;
@@ -77,6 +78,23 @@ void Widget::invalidate(Rectangle<int32_t>& area) {
 		m_parent->invalidate(area);
 }
 
+/**
+ * @brief Invalidates an area of the parent without marking the content of this widget as changed (e.g. when it moves)
+ *
+ * @param area The area to invalidate, relative to the parent
+ */
+void Widget::invalidate_in_parent(const Rectangle<int32_t>& area) {
+
+	if (m_parent == nullptr)
+		return;
+
+	// Convert the area to absolute coordinates
+	Coordinates coordinates = m_parent->absolute_coordinates(Coordinates(area.left, area.top));
+	Rectangle<int32_t> invalid_area(coordinates.first, coordinates.second, area.width, area.height);
+
+	m_parent->invalidate(invalid_area);
+}
+
 /**
  * @brief Set the parent of a widget to this widget, making it into a child
  *
@@ -138,14 +156,14 @@ Rectangle<int32_t> Widget::position() {
 void Widget::move(int32_t left, int32_t top) {
 
 	// Invalidate the old position
-	invalidate();
+	invalidate_in_parent(m_position);
 
 	// Set the new position
 	m_position.left = left;
 	m_position.top = top;
 
-	// Re draw the widget in the new position
-	invalidate();
+	// Re draw the widget in the new position, its content hasn't changed
+	invalidate_in_parent(m_position);
 }
 
 /**
@@ -153,8 +171,6 @@ void Widget::move(int32_t left, int32_t top) {
  *
  * @param width The new m_width of the rectangle
  * @param height The new m_height of the rectangle
- *
- * @todo Fix the invalidation so it only redraws the areas that need to be redrawn (right and bottom are always fully redrawn currently)
  */
 void Widget::resize(int32_t width, int32_t height) {
 
@@ -169,24 +185,9 @@ void Widget::resize(int32_t width, int32_t height) {
 	m_position.width = width;
 	m_position.height = height;
 
-	// Find the areas that need to be redrawn by subtracting the old position from the new position, and vice versa
-	Vector<Rectangle<int32_t>> invalid_areas_old = old_position.subtract(m_position);
-	Vector<Rectangle<int32_t>> invalid_areas_new = m_position.subtract(old_position);
-
-	// Right and Bottom require to be fully invalidated
-	if (m_position.width > old_position.width || m_position.height > old_position.height ||
-		old_position.width > m_position.width || old_position.height > m_position.height) {
-		invalidate();
-		return;
-	}
-
-	//Loop through the areas that need to be redrawn and invalidate them
-	for (auto& area: invalid_areas_old)
-		invalidate(area);
-
-	for (auto& area: invalid_areas_new)
-		invalidate(area);
-
+	// Redraw where the widget was and where it is now, the parent merges the overlap
+	invalidate_in_parent(old_position);
+	invalidate_in_parent(m_position);
 }
 
 /**
@@ -350,39 +351,41 @@ void CompositeWidget::draw(GraphicsContext* gc, Rectangle<int32_t>& area, Vector
 	// Draw the widget
 	Widget::draw(gc, area);
 
-	// Get the area of the widget
-	Rectangle<int32_t> own_area = position();
+	// Children in front cover the ones behind them and the widget itself, so each pixel is only drawn once
+	Region remaining(area);
 
 	//Note: has to use iterator as the start is not necessarily the m_first_memory_chunk child
 	for (Vector<Widget*>::iterator child_widget = start; child_widget != m_children.end(); child_widget++) {
 
-		Rectangle<int32_t> child_area = (*child_widget)->position();
+		// The entire area has been drawn
+		if (remaining.empty())
+			return;
 
 		// Check if the child is in the area that needs to be redrawn
-		if (area.intersects(child_area)) {
-
-			// Get the area that needs to be redrawn
-			Rectangle<int32_t> rectangle = area.intersection(child_area);
+		Rectangle<int32_t> child_area = (*child_widget)->position();
+		Rectangle<int32_t> remaining_bounds = remaining.extents();
+		if (!remaining_bounds.intersects(child_area))
+			continue;
 
-			// Translate the area so that it is relative to the child
-			rectangle.left -= child_area.left;
-			rectangle.top -= child_area.top;
+		// Get the parts of the child that need to be redrawn
+		Region child_draw_area = remaining;
+		child_draw_area.intersect(child_area);
 
-			// Draw the child
+		// Draw each part relative to the child
+		for (auto& part: child_draw_area.rectangles()) {
+			Rectangle<int32_t> rectangle(part.left - child_area.left, part.top - child_area.top, part.width, part.height);
 			(*child_widget)->draw(gc, rectangle);
-
-			// Draw what is left of the area that needs to be redrawn
-			Vector<Rectangle<int32_t>> rest_draw_area = area.subtract(child_area);
-			for (auto& rest_area_part: rest_draw_area)
-				draw(gc, rest_area_part, child_widget + 1);
-
-			// Return as the entire area has now been drawn
-			return;
 		}
+
+		// The child now covers that part of the area
+		remaining.subtract(child_area);
 	}
 
-	// Now draw the widget itself
-	draw_self(gc, area);
+	// Now draw what is left of the widget itself
+	for (auto& part: remaining.rectangles()) {
+		Rectangle<int32_t> rectangle = part;
+		draw_self(gc, rectangle);
+	}
 }
 
 /**
@@ -407,6 +410,20 @@ void CompositeWidget::add_child(Widget* child) {
 	Widget::add_child(child);
 }
 
+/**
+ * @brief Removes a child widget and redraws where it was. The child is not deleted
+ *
+ * @param child The widget to remove
+ */
+void CompositeWidget::remove_child(Widget* child) {
+
+	// Redraw what was under the child while it is still positioned relative to this widget
+	child->invalidate_in_parent(child->m_position);
+
+	m_children.erase(child);
+	child->m_parent = nullptr;
+}
+
 /**
  * @brief Passes the event to the child that the mouse is over. (Event handling should be done by the derived class)
  *
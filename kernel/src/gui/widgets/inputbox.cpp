@@ -107,8 +107,7 @@ void InputBox::draw(GraphicsContext* gc, Rectangle<int32_t>& area) {
 	int32_t y = input_box_coordinates.second;
 
 	// Draw the background for the input box
-	gc->fill_rectangle(x + area.left, y + area.top, x + area.left + area.width,
-					   y + area.top + area.height, background_colour);
+	gc->fill_rect(x + area.left, y + area.top, area.width, area.height, background_colour);
 
 	// Draw the border
 
@@ -116,34 +115,28 @@ void InputBox::draw(GraphicsContext* gc, Rectangle<int32_t>& area) {
 	if (area.intersects(Rectangle<int32_t>(0, 0, input_box_position.width, 1))) {
 
 		// Start in the top left corner of the button and end in the top right corner
-		gc->draw_line(x + area.left, y, x + area.left + area.width - 1, y,
-					  border_colour);
+		gc->fill_span(x + area.left, y, area.width, border_colour);
 	}
 
 	// Left Border
 	if (area.intersects(Rectangle<int32_t>(0, 0, 1, input_box_position.height))) {
 
 		// Start in the top left corner and end in the bottom left corner
-		gc->draw_line(x, y + area.top, x, y + area.top + area.height - 1,
-					  border_colour);
+		gc->fill_rect(x, y + area.top, 1, area.height, border_colour);
 	}
 
 	// Right Border
 	if (area.intersects(Rectangle<int32_t>(0, input_box_position.height - 1, input_box_position.width, 1))) {
 
 		// Start in the top right corner and end in the bottom right corner
-		gc->draw_line(x + area.left, y + input_box_position.height - 1,
-					  x + area.left + area.width - 1,
-					  y + input_box_position.height - 1, border_colour);
+		gc->fill_span(x + area.left, y + input_box_position.height - 1, area.width, border_colour);
 	}
 
 	// Bottom Border
 	if (area.intersects(Rectangle<int32_t>(input_box_position.width - 1, 0, 1, input_box_position.height))) {
 
 		// Start in the bottom left corner and end in the bottom right corner
-		gc->draw_line(x + input_box_position.width - 1, y + area.top,
-		              x + input_box_position.width - 1,
-					  y + area.top + area.height - 1, border_colour);
+		gc->fill_rect(x + input_box_position.width - 1, y + area.top, 1, area.height, border_colour);
 	}
 
 	// Draw the text
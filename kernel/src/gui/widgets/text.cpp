@@ -56,7 +56,7 @@ void Text::draw(GraphicsContext* gc, Rectangle<int32_t>& area) {
 	int32_t y = textCoordinates.second;
 
 	// Draw the background (as the text might not fill the entire area)
-	gc->fill_rectangle(x + area.left, y + area.top, x + area.left + area.width, y + area.top + area.height, background_colour);
+	gc->fill_rect(x + area.left, y + area.top, area.width, area.height, background_colour);
 
 	// Draw the text
 	this->font.draw_text(x, y, foreground_colour, background_colour, gc, m_widget_text, area);
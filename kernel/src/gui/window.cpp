@@ -90,7 +90,10 @@ Window::Window(Widget* contained_widget, const string& title_text)
 	Window::add_child(contained_widget);
 }
 
-Window::~Window() = default;
+Window::~Window() {
+
+	delete m_surface;
+}
 
 /**
  * @brief Handles the mouse button being pressed.
@@ -145,6 +148,86 @@ MouseEventHandler* Window::on_mouse_button_pressed(uint32_t mouse_x, uint32_t mo
 	return child_result;
 }
 
+/**
+ * @brief Makes sure the surface is the size of the window and redraws the parts of it that have changed
+ *
+ * @param gc The graphics context the surface will be copied to
+ */
+void Window::update_surface(GraphicsContext* gc) {
+
+	// A new size (or screen) needs a new surface, with everything on it drawn
+	Rectangle<int32_t> window_position = position();
+	if (m_surface == nullptr || (int32_t) m_surface->width() != window_position.width || (int32_t) m_surface->height() != window_position.height
+		|| m_surface->color_depth() != gc->color_depth()) {
+
+		delete m_surface;
+		m_surface = new Surface(window_position.width, window_position.height, gc->color_depth());
+		m_surface_damage = Region(Rectangle<int32_t>(0, 0, window_position.width, window_position.height));
+	}
+
+	if (m_surface_damage.empty())
+		return;
+
+	// Take the damage so anything invalidated while drawing is drawn next time
+	Region damage = m_surface_damage;
+	m_surface_damage.clear();
+
+	// Draw relative to the surface instead of the screen
+	m_drawing_to_surface = true;
+	for (auto& part: damage.rectangles()) {
+		Rectangle<int32_t> rectangle = part;
+		CompositeWidget::draw(m_surface, rectangle);
+	}
+	m_drawing_to_surface = false;
+}
+
+/**
+ * @brief Draws part of the window by copying it from the surface, redrawing the surface first if its content has changed
+ *
+ * @param gc The graphics context to draw on.
+ * @param area The area to draw
+ */
+void Window::draw(GraphicsContext* gc, Rectangle<int32_t>& area) {
+
+	update_surface(gc);
+
+	Coordinates window_absolute_position = absolute_coordinates(Coordinates(0, 0));
+	m_surface->composite(gc, window_absolute_position.first, window_absolute_position.second, area);
+}
+
+/**
+ * @brief Marks part of the window's content as changed so it is redrawn into the surface, then passes it on so the
+ * surface is copied to the screen again
+ *
+ * @param area The area that is now invalid (absolute)
+ */
+void Window::invalidate(Rectangle<int32_t>& area) {
+
+	// Store the damage relative to the surface
+	Coordinates window_absolute_position = absolute_coordinates(Coordinates(0, 0));
+	Rectangle<int32_t> surface_area(area.left - window_absolute_position.first, area.top - window_absolute_position.second, area.width, area.height);
+	Rectangle<int32_t> surface_bounds(0, 0, m_position.width, m_position.height);
+	if (surface_bounds.intersects(surface_area))
+		m_surface_damage.include(surface_bounds.intersection(surface_area), DAMAGE_MERGE_SLACK, DAMAGE_MAX_RECTANGLES);
+
+	CompositeWidget::invalidate(area);
+}
+
+/**
+ * @brief Get the absolute coordinates of a point in the window, while the window is drawing into its surface these are
+ * relative to the surface instead of the screen
+ *
+ * @param coordinates The coordinates within the window to convert
+ * @return The absolute coordinates
+ */
+Coordinates Window::absolute_coordinates(Coordinates coordinates) {
+
+	if (m_drawing_to_surface)
+		return coordinates;
+
+	return CompositeWidget::absolute_coordinates(coordinates);
+}
+
 /**
  * @brief Draws the window and its children.
  *
@@ -154,7 +237,7 @@ MouseEventHandler* Window::on_mouse_button_pressed(uint32_t mouse_x, uint32_t mo
 void Window::draw_self(common::GraphicsContext* gc, common::Rectangle<int32_t>& area) {
 
 	// Get the positioning of the window
-	Coordinates window_absolute_position = CompositeWidget::absolute_coordinates(Coordinates(0, 0));
+	Coordinates window_absolute_position = absolute_coordinates(Coordinates(0, 0));
 	Rectangle<int32_t> window_position = this->position();
 	int32_t window_x = window_absolute_position.first;
 	int32_t window_y = window_absolute_position.second;
@@ -167,9 +250,7 @@ void Window::draw_self(common::GraphicsContext* gc, common::Rectangle<int32_t>&
 	// Draw the window contents if they are in the area to draw
 	if (window_contents_area.intersects(area)) {
 		Rectangle<int32_t> contents_drawable = window_contents_area.intersection(area);
-		gc->fill_rectangle(contents_drawable.left + window_x, contents_drawable.top + window_y,
-						   contents_drawable.left + contents_drawable.width + window_x,
-						   contents_drawable.top + contents_drawable.height + window_y, area_colour);
+		gc->fill_rect(contents_drawable.left + window_x, contents_drawable.top + window_y, contents_drawable.width, contents_drawable.height, area_colour);
 	}
 
 	// Draw the frame if it is in the area to draw
@@ -177,9 +258,7 @@ void Window::draw_self(common::GraphicsContext* gc, common::Rectangle<int32_t>&
 											 frame_thickness + title_bar_height);
 	if (window_frame_top_area.intersects(area)) {
 		Rectangle<int32_t> frame_drawable = window_frame_top_area.intersection(area);
-		gc->fill_rectangle(frame_drawable.left + window_x, frame_drawable.top + window_y,
-						   frame_drawable.left + frame_drawable.width + window_x,
-						   frame_drawable.top + frame_drawable.height + window_y, frame_colour);
+		gc->fill_rect(frame_drawable.left + window_x, frame_drawable.top + window_y, frame_drawable.width, frame_drawable.height, frame_colour);
 	}
 
 	// Draw the bottom of the window frame
@@ -187,18 +266,14 @@ void Window::draw_self(common::GraphicsContext* gc, common::Rectangle<int32_t>&
 	                                            window_position.width - 2 * frame_thickness, frame_thickness);
 	if (window_frame_bottom_area.intersects(area)) {
 		Rectangle<int32_t> bottom_drawable = window_frame_bottom_area.intersection(area);
-		gc->fill_rectangle(window_x + bottom_drawable.left, window_y + bottom_drawable.top,
-						   window_x + bottom_drawable.left + bottom_drawable.width,
-						   window_y + bottom_drawable.top + bottom_drawable.height, frame_colour);
+		gc->fill_rect(window_x + bottom_drawable.left, window_y + bottom_drawable.top, bottom_drawable.width, bottom_drawable.height, frame_colour);
 	}
 
 	// Draw the left of the window frame
 	Rectangle<int32_t> window_frame_left_area(0, 0, frame_thickness, window_position.height);
 	if (window_frame_left_area.intersects(area)) {
 		Rectangle<int32_t> left_drawable = window_frame_left_area.intersection(area);
-		gc->fill_rectangle(window_x + left_drawable.left, window_y + left_drawable.top,
-						   window_x + left_drawable.left + left_drawable.width,
-						   window_y + left_drawable.top + left_drawable.height, frame_colour);
+		gc->fill_rect(window_x + left_drawable.left, window_y + left_drawable.top, left_drawable.width, left_drawable.height, frame_colour);
 	}
 
 	// Draw the right of the window frame
@@ -206,9 +281,7 @@ void Window::draw_self(common::GraphicsContext* gc, common::Rectangle<int32_t>&
 	                                           window_position.height);
 	if (window_frame_right_area.intersects(area)) {
 		Rectangle<int32_t> right_drawable = window_frame_right_area.intersection(area);
-		gc->fill_rectangle(window_x + right_drawable.left, window_y + right_drawable.top,
-						   window_x + right_drawable.left + right_drawable.width,
-						   window_y + right_drawable.top + right_drawable.height, frame_colour);
+		gc->fill_rect(window_x + right_drawable.left, window_y + right_drawable.top, right_drawable.width, right_drawable.height, frame_colour);
 	}
 }
 
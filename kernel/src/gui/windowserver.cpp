@@ -0,0 +1,439 @@
+/**
+ * @file windowserver.cpp
+ * @brief Implementation of the WindowServer and ClientWindow classes defined in windowserver.h
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+ */
+
+#include <gui/windowserver.h>
+#include <common/logger.h>
+#include <hardwarecommunication/interrupts.h>
+#include <memory/physical.h>
+#include <processes/scheduler.h>
+
+using namespace MaxOS;
+using namespace MaxOS::common;
+using namespace MaxOS::gui;
+using namespace MaxOS::memory;
+using namespace MaxOS::processes;
+using namespace MaxOS::system;
+using namespace MaxOS::hardwarecommunication;
+using namespace MaxOS::drivers::peripherals;
+
+/**
+ * @brief Create a window for a surface a client has drawn
+ *
+ * @param name The name of the window
+ * @param owner The PID of the process that created the window
+ * @param surface The shared memory the client draws into, must hold width * height pixels
+ * @param events Where to send input for the window
+ * @param left Where the window goes on the desktop
+ * @param top Where the window goes on the desktop
+ * @param width The width of the surface
+ * @param height The height of the surface
+ */
+ClientWindow::ClientWindow(const string& name, uint64_t owner, SharedMemory* surface, SharedMessageEndpoint* events, int32_t left, int32_t top, uint32_t width, uint32_t height)
+: Widget(left, top, width, height),
+  m_name(name),
+  m_owner(owner),
+  m_surface(surface),
+  m_events(events),
+  m_pixels((uint32_t*) PhysicalMemoryManager::to_dm_region(surface->physical_address()))
+{
+
+	// The surface can't be resized so neither can the window
+	m_min_width = m_max_width = width;
+	m_min_height = m_max_height = height;
+}
+
+ClientWindow::~ClientWindow() = default;
+
+/**
+ * @brief Get the name of the window
+ *
+ * @return The name the client created the window with
+ */
+string ClientWindow::name() {
+	return m_name;
+}
+
+/**
+ * @brief Get the process that created the window
+ *
+ * @return The PID of the process that sent the CREATE request
+ */
+uint64_t ClientWindow::owner() {
+	return m_owner;
+}
+
+/**
+ * @brief Get the shared memory the client draws into
+ *
+ * @return The surface
+ */
+SharedMemory* ClientWindow::surface() {
+	return m_surface;
+}
+
+/**
+ * @brief Get the endpoint input is sent to
+ *
+ * @return The event endpoint
+ */
+SharedMessageEndpoint* ClientWindow::events() {
+	return m_events;
+}
+
+/**
+ * @brief Queue an event for the client
+ *
+ * @param type The event
+ * @param x The x coordinate (relative to the window)
+ * @param y The y coordinate (relative to the window)
+ * @param value The button or key code
+ * @param modifiers The WindowModifiers held
+ */
+void ClientWindow::send(window_event_type_t type, int32_t x, int32_t y, uint32_t value, uint32_t modifiers) {
+
+	window_event_t event = { type, x, y, value, modifiers };
+	m_events->write(&event, sizeof(event), 0);
+}
+
+/**
+ * @brief Convert the state of the keyboard to the modifiers sent to clients
+ *
+ * @param state The state of the keyboard
+ * @return The WindowModifiers bits
+ */
+uint32_t ClientWindow::modifiers(const KeyboardState& state) {
+
+	uint32_t result = 0;
+	if(state.left_shift || state.right_shift)
+		result |= (uint32_t) window_modifiers_t::SHIFT;
+	if(state.left_control || state.right_control)
+		result |= (uint32_t) window_modifiers_t::CONTROL;
+	if(state.left_alt || state.right_alt)
+		result |= (uint32_t) window_modifiers_t::ALT;
+	if(state.caps_lock)
+		result |= (uint32_t) window_modifiers_t::CAPS_LOCK;
+
+	return result;
+}
+
+/**
+ * @brief Copy part of the surface to the screen
+ *
+ * @param gc The graphics context to draw to
+ * @param area The area of the window to draw
+ */
+void ClientWindow::draw(GraphicsContext* gc, Rectangle<int32_t>& area) {
+
+	// Keep to the surface
+	int32_t left = area.left < 0 ? 0 : area.left;
+	int32_t top = area.top < 0 ? 0 : area.top;
+	int32_t right = area.left + area.width > m_position.width ? m_position.width : area.left + area.width;
+	int32_t bottom = area.top + area.height > m_position.height ? m_position.height : area.top + area.height;
+	if(left >= right || top >= bottom)
+		return;
+
+	Coordinates window_coordinates = absolute_coordinates(Coordinates(0, 0));
+	const uint32_t* pixels = m_pixels + top * m_position.width + left;
+
+	// The client draws 0xRRGGBB which is already the format of a 32 bit screen
+	if(gc->color_depth() == 32) {
+		gc->blit(window_coordinates.first + left, window_coordinates.second + top, pixels, right - left, bottom - top, m_position.width);
+		return;
+	}
+
+	for(int32_t y = top; y < bottom; y++, pixels += m_position.width)
+		for(int32_t x = 0; x < right - left; x++)
+			gc->put_pixel(window_coordinates.first + left + x, window_coordinates.second + y, Colour(pixels[x] >> 16, pixels[x] >> 8, pixels[x]));
+}
+
+/**
+ * @brief Mark part of the surface as drawn to by the client so it is copied to the screen
+ *
+ * @param x The left of the area (relative to the window)
+ * @param y The top of the area (relative to the window)
+ * @param width The width of the area
+ * @param height The height of the area
+ */
+void ClientWindow::damage(int32_t x, int32_t y, uint32_t width, uint32_t height) {
+
+	Coordinates window_coordinates = absolute_coordinates(Coordinates(0, 0));
+	Rectangle<int32_t> area(window_coordinates.first + x, window_coordinates.second + y, (int32_t) width, (int32_t) height);
+	invalidate(area);
+}
+
+/**
+ * @brief Tell the client it is now receiving keyboard input
+ */
+void ClientWindow::on_focus() {
+	send(window_event_type_t::FOCUS, 0, 0, 0);
+}
+
+/**
+ * @brief Tell the client it is no longer receiving keyboard input
+ */
+void ClientWindow::on_focus_lost() {
+	send(window_event_type_t::FOCUS_LOST, 0, 0, 0);
+}
+
+/**
+ * @brief Send the new position of the mouse to the client
+ *
+ * @param from_x The old x coordinate of the mouse (relative to the parent)
+ * @param from_y The old y coordinate of the mouse (relative to the parent)
+ * @param to_x The new x coordinate of the mouse (relative to the parent)
+ * @param to_y The new y coordinate of the mouse (relative to the parent)
+ */
+void ClientWindow::on_mouse_move_widget(uint32_t from_x, uint32_t from_y, uint32_t to_x, uint32_t to_y) {
+	send(window_event_type_t::MOUSE_MOVE, (int32_t) to_x - m_position.left, (int32_t) to_y - m_position.top, 0);
+}
+
+/**
+ * @brief Send a button press to the client and bring the window to the front
+ *
+ * @param x The x coordinate of the mouse (relative to the window)
+ * @param y The y coordinate of the mouse (relative to the window)
+ * @param button The button pressed
+ * @return nullptr, the window doesn't get dragged by the mouse
+ */
+MouseEventHandler* ClientWindow::on_mouse_button_pressed(uint32_t x, uint32_t y, uint8_t button) {
+
+	bring_to_front();
+	focus();
+
+	send(window_event_type_t::MOUSE_DOWN, (int32_t) x, (int32_t) y, button);
+	return nullptr;
+}
+
+/**
+ * @brief Send a button release to the client
+ *
+ * @param x The x coordinate of the mouse (relative to the window)
+ * @param y The y coordinate of the mouse (relative to the window)
+ * @param button The button released
+ */
+void ClientWindow::on_mouse_button_released(uint32_t x, uint32_t y, uint8_t button) {
+	send(window_event_type_t::MOUSE_UP, (int32_t) x, (int32_t) y, button);
+}
+
+/**
+ * @brief Send a key press to the client
+ *
+ * @param key_down_code The key pressed
+ * @param key_down_state The state of the keyboard
+ */
+void ClientWindow::on_key_down(KeyCode key_down_code, const KeyboardState& key_down_state) {
+	send(window_event_type_t::KEY_DOWN, 0, 0, (uint32_t) key_down_code, modifiers(key_down_state));
+}
+
+/**
+ * @brief Send a key release to the client
+ *
+ * @param key_up_code The key released
+ * @param key_up_state The state of the keyboard
+ */
+void ClientWindow::on_key_up(KeyCode key_up_code, const KeyboardState& key_up_state) {
+	send(window_event_type_t::KEY_UP, 0, 0, (uint32_t) key_up_code, modifiers(key_up_state));
+}
+
+/**
+ * @brief Create the server's request endpoint and start drawing the desktop once there is a scheduler
+ *
+ * @param desktop The desktop to show the windows on
+ */
+WindowServer::WindowServer(Desktop* desktop)
+: m_desktop(desktop)
+{
+
+	// Hold a use of the endpoint so clients closing it don't free it
+	BaseResourceRegistry* endpoints = GlobalResourceRegistry::get_registry(resource_type_t::MESSAGE_ENDPOINT);
+	if(endpoints && endpoints->create_resource(::syscore::gui::WINDOW_SERVER_ENDPOINT, 0))
+		m_requests = (SharedMessageEndpoint*) endpoints->get_resource(::syscore::gui::WINDOW_SERVER_ENDPOINT);
+
+	if(!m_requests) {
+		Logger::WARNING() << "Window server could not create its endpoint\n";
+		return;
+	}
+
+	if(!GlobalScheduler::system_scheduler())
+		return;
+
+	WindowServer* args[] = { this };
+	auto* worker = new Process("Window Server", (void (*)(void*)) (uintptr_t) WindowServer::worker, args, 1, true);
+	GlobalScheduler::system_scheduler()->add_process(worker);
+}
+
+/**
+ * @brief Remove the client windows and stop serving requests
+ */
+WindowServer::~WindowServer() {
+
+	m_desktop->lock();
+	while(!m_windows.empty())
+		destroy_window(*m_windows.begin());
+	m_desktop->unlock();
+
+	if(m_requests)
+		GlobalResourceRegistry::get_registry(resource_type_t::MESSAGE_ENDPOINT)->close_resource(m_requests, 0);
+}
+
+/**
+ * @brief Find a client window by its name
+ *
+ * @param name The name of the window
+ * @return The window or nullptr if there is no window with that name
+ */
+ClientWindow* WindowServer::find_window(const string& name) {
+
+	for(auto& window : m_windows)
+		if(window->name() == name)
+			return window;
+
+	return nullptr;
+}
+
+/**
+ * @brief Show a client's surface on the desktop
+ *
+ * @param request The CREATE request
+ * @param name The name of the window
+ * @param sender The PID of the process that sent the request, it becomes the owner of the window
+ */
+void WindowServer::create_window(const window_request_t& request, const string& name, uint64_t sender) {
+
+	// Names are unique
+	if(find_window(name) || !request.width || !request.height)
+		return;
+
+	BaseResourceRegistry* memory = GlobalResourceRegistry::get_registry(resource_type_t::SHARED_MEMORY);
+	BaseResourceRegistry* endpoints = GlobalResourceRegistry::get_registry(resource_type_t::MESSAGE_ENDPOINT);
+
+	// The surface must be big enough to hold the window
+	string prefix = string("gui:") + name;
+	auto* surface = (SharedMemory*) memory->get_resource(prefix + ":surface");
+	if(!surface)
+		return;
+
+	if(surface->size() < (size_t) request.width * request.height * sizeof(uint32_t)) {
+		memory->close_resource(surface, 0);
+		return;
+	}
+
+	auto* events = (SharedMessageEndpoint*) endpoints->get_resource(prefix + ":events");
+	if(!events) {
+		memory->close_resource(surface, 0);
+		return;
+	}
+
+	auto* window = new ClientWindow(name, sender, surface, events, request.x, request.y, request.width, request.height);
+	m_windows.push_back(window);
+	m_desktop->add_child(window);
+	window->invalidate();
+}
+
+/**
+ * @brief Remove a client window from the desktop and let go of its surface and endpoint
+ *
+ * @param window The window
+ */
+void WindowServer::destroy_window(ClientWindow* window) {
+
+	m_desktop->remove_child(window);
+	m_windows.erase(window);
+
+	GlobalResourceRegistry::get_registry(resource_type_t::SHARED_MEMORY)->close_resource(window->surface(), 0);
+	GlobalResourceRegistry::get_registry(resource_type_t::MESSAGE_ENDPOINT)->close_resource(window->events(), 0);
+	delete window;
+}
+
+/**
+ * @brief Act on a request from a client
+ *
+ * @param request The request
+ * @param sender The PID of the process that sent the request
+ */
+void WindowServer::handle_request(const window_request_t& request, uint64_t sender) {
+
+	// The name may not have been terminated
+	char name_buffer[::syscore::gui::WINDOW_NAME_MAX + 1];
+	for(size_t i = 0; i < ::syscore::gui::WINDOW_NAME_MAX; i++)
+		name_buffer[i] = request.name[i];
+	name_buffer[::syscore::gui::WINDOW_NAME_MAX] = '\0';
+	string name(name_buffer);
+
+	if(request.type == window_request_type_t::CREATE) {
+		create_window(request, name, sender);
+		return;
+	}
+
+	// Other processes can't change a window they didn't create
+	ClientWindow* window = find_window(name);
+	if(!window || window->owner() != sender)
+		return;
+
+	switch(request.type) {
+
+		case window_request_type_t::DAMAGE:
+			window->damage(request.x, request.y, request.width, request.height);
+			break;
+
+		case window_request_type_t::MOVE:
+			window->move(request.x, request.y);
+			break;
+
+		case window_request_type_t::DESTROY:
+			destroy_window(window);
+			break;
+
+		default:
+			break;
+	}
+}
+
+/**
+ * @brief Handle the requests that have arrived since the last frame then draw what they changed
+ *
+ * @note The desktop is locked while the frame is built, input queued by the interrupts since the last frame is applied here
+ */
+void WindowServer::frame() {
+
+	m_desktop->lock();
+
+	// A client flooding the server can't stop the desktop being drawn
+	window_request_t request;
+	uint64_t sender;
+	for(uint32_t i = 0; i < WINDOW_SERVER_MAX_REQUESTS; i++) {
+		if(m_requests->read_message(&request, sizeof(request), sender) != (int) sizeof(request))
+			break;
+
+		handle_request(request, sender);
+	}
+
+	// Copy the damaged parts of the surfaces to the screen
+	Time time {};
+	m_desktop->on_time(time);
+
+	m_desktop->unlock();
+}
+
+/**
+ * @brief (Worker Side) Draw a frame then sleep until the next one
+ *
+ * @param argc Unused
+ * @param argv The server
+ */
+void WindowServer::worker(uint64_t argc, WindowServer** argv) {
+
+	WindowServer* server = argv[0];
+	while(true) {
+
+		server->frame();
+
+		// Sleep until the next frame
+		GlobalScheduler::sleep(WINDOW_SERVER_FRAME_INTERVAL);
+	}
+}
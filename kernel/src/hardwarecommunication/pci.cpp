@@ -12,6 +12,7 @@
 // Divers that need PCI descriptors
 #include <drivers/ethernet/amd_am79c973.h>
 #include <drivers/ethernet/intel_i217.h>
+#include <drivers/ethernet/virtio_net.h>
 #include <drivers/disk/ide.h>
 
 using namespace MaxOS;
@@ -156,6 +157,20 @@ void PCIController::write(uint16_t bus, uint16_t device, uint16_t function,
 	m_data_port.write(value);
 }
 
+/**
+ * @brief Allow the device to read and write memory itself (needed for devices that use DMA rings)
+ *
+ * @param bus Bus number
+ * @param device Device number
+ * @param function Function number
+ */
+void PCIController::enable_bus_mastering(uint16_t bus, uint16_t device, uint16_t function) {
+
+	// Only write back the command register, the status bits above it are cleared by writing 1
+	uint32_t command = read(bus, device, function, 0x04) & 0xFFFF;
+	write(bus, device, function, 0x04, command | (1 << 2));
+}
+
 /**
  * @brief Check if the device has a function
  *
@@ -201,6 +216,7 @@ void PCIController::select_drivers(DriverSelectorEventHandler* handler) {
 				// Select the driver and print information about the device
 				Driver* driver = get_driver(device_descriptor);
 				if (driver != nullptr) {
+					enable_bus_mastering(bus, device, function);
 					handler->on_driver_selected(driver);
 					Logger::Out() << driver->vendor_name() << " " << driver->device_name();
 				} else {
@@ -282,6 +298,20 @@ Driver* PCIController::get_driver(PCIDeviceDescriptor dev) {
 			}
 			break;
 		}//End Intel
+		case 0x1AF4:  //Red Hat (virtio)
+		{
+			switch (dev.device_id) {
+
+				case 0x1000: // Network device (legacy/transitional)
+				{
+					return new VirtioNet(&dev);
+				}
+
+				default:
+					break;
+			}
+			break;
+		}
 	}
 
 	//If there is no driver for the particular device, go into generic devices
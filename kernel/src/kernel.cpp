@@ -17,6 +17,7 @@
 #include <processes/scheduler.h>
 #include <system/cpu.h>
 #include <system/syscalls.h>
+#include <system/debugshell.h>
 #include <memory/memorymanagement.h>
 #include <memory/physical.h>
 #include <memory/virtual.h>
@@ -98,6 +99,7 @@ extern "C" [[noreturn]] void kernel_main(unsigned long addr, unsigned long magic
 	Clock kernel_clock(&cpu.apic, 1);
 	DriverManager driver_manager;
 	driver_manager.add_driver(&kernel_clock);
+	driver_manager.add_driver(&serial_console);
 	driver_manager.find_drivers();
 	uint32_t reset_wait_time = driver_manager.reset_devices();
 
@@ -111,6 +113,8 @@ extern "C" [[noreturn]] void kernel_main(unsigned long addr, unsigned long magic
 
 	Logger::HEADER() << "Stage {4}: System Finalisation\n";
 	GlobalScheduler scheduler(multiboot);
+	logger.start_buffering();
+	DebugShell debug_shell(&serial_console);
 	VFSResourceRegistry vfs_registry(&vfs);
 	SyscallManager syscalls;
 	console.finish();
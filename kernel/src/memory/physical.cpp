@@ -270,9 +270,10 @@ void PhysicalMemoryManager::free_frame(void* address) {
  *
  * @param start_address The start of the block
  * @param size The size to allocate
+ * @param limit The block must end before this physical address (for devices that can't reach all of memory)
  * @return A pointer to the start of the block (physical address)
  */
-void* PhysicalMemoryManager::allocate_area(uint64_t start_address, size_t size) {
+void* PhysicalMemoryManager::allocate_area(uint64_t start_address, size_t size, uint64_t limit) {
 
 	m_lock.lock();
 
@@ -300,6 +301,13 @@ void* PhysicalMemoryManager::allocate_area(uint64_t start_address, size_t size)
 			if(adjacent_frames == 0) {
 				start_row = row;
 				start_column = column;
+
+				// Everything after this is out of reach too
+				if(start_address + ((uint64_t) row * ROW_BITS + column + frame_count) * PAGE_SIZE > limit) {
+					m_lock.unlock();
+					ASSERT(false, "Cannot allocate that much memory\n");
+					return nullptr;
+				}
 			}
 
 			// Make sure there are enough frames in a row found
@@ -654,15 +662,17 @@ void PhysicalMemoryManager::clean_page_table(uint64_t* table) {
  */
 pte_t PhysicalMemoryManager::create_page_table_entry(uintptr_t address, size_t flags) const {
 
+	// The write through, cache disabled and (in a page table) huge page bits select the PAT entry, WRITE_THROUGH is entry 7
+	// and WRITE_COMBINING is entry 1 (see PAT_LAYOUT)
 	pte_t page = (pte_t) {
 	.present            = (flags & PRESENT) != 0,
 	.write              = (flags & WRITE) != 0,
 	.user               = (flags & USER) != 0,
-	.write_through      = (flags & WRITE_THROUGH) != 0,
-	.cache_disabled     = (flags & CACHE_DISABLED) != 0,
+	.write_through      = (flags & (WRITE_THROUGH | WRITE_COMBINING)) != 0,
+	.cache_disabled     = (flags & (WRITE_THROUGH | CACHE_DISABLED)) != 0,
 	.accessed           = (flags & ACCESSED) != 0,
 	.dirty              = (flags & DIRTY) != 0,
-	.huge_page          = (flags & HUGE_PAGE) != 0,
+	.huge_page          = (flags & (WRITE_THROUGH | HUGE_PAGE)) != 0,
 	.global             = (flags & GLOBAL) != 0,
 	.available          = 0,
 	.physical_address   = address >> 12,
@@ -7,16 +7,23 @@
  */
 
 #include <net/arp.h>
+#include <drivers/clock/clock.h>
+#include <processes/scheduler.h>
+#include <hardwarecommunication/interrupts.h>
 
 using namespace MaxOS;
 using namespace MaxOS::common;
 using namespace MaxOS::net;
 using namespace MaxOS::drivers;
 using namespace MaxOS::drivers::ethernet;
+using namespace MaxOS::drivers::clock;
+using namespace MaxOS::processes;
+using namespace MaxOS::system;
+using namespace MaxOS::hardwarecommunication;
 
 
 /**
- * @brief Constructs an AddressResolutionProtocol handler.
+ * @brief Constructs an AddressResolutionProtocol handler, starts the timer worker once there is a scheduler.
  *
  * @param ethernet_frame_handler The Ethernet frame handler to use.
  * @param internet_protocol_handler The Internet protocol handler to use.
@@ -27,6 +34,13 @@ net::AddressResolutionProtocol::AddressResolutionProtocol(EthernetFrameHandler*
 		IPV4AddressResolver(internet_protocol_handler) {
 	this->internet_protocol_handler = internet_protocol_handler;
 	this->error_messages = error_messages;
+
+	if (!GlobalScheduler::system_scheduler())
+		return;
+
+	AddressResolutionProtocol* args[] = { this };
+	auto* worker = new Process("ARP Timer", (void (*)(void*)) (uintptr_t) timer_worker, args, 1, true);
+	GlobalScheduler::system_scheduler()->add_process(worker);
 }
 
 net::AddressResolutionProtocol::~AddressResolutionProtocol() = default;
@@ -34,18 +48,17 @@ net::AddressResolutionProtocol::~AddressResolutionProtocol() = default;
 /**
  * @brief Called when an ARP packet is received.
  *
- * @param ethernetframePayload The payload of the ARP packet.
- * @param size The size of the ARP packet.
+ * @param packet The packet, positioned at the start of the ARP message.
  * @return True if the device should send a response, false otherwise.
  */
-bool AddressResolutionProtocol::handle_ethernetframe_payload(uint8_t* ethernetframePayload, uint32_t size) {
+bool AddressResolutionProtocol::handle_ethernetframe_payload(PacketBuffer* packet) {
 
 	//Check if the size is correct
-	if (size < sizeof(ARPMessage))
+	if (packet->length() < sizeof(ARPMessage))
 		return false;
 
 	//Convert the payload to an ARP message
-	auto* arp_message = (ARPMessage*) ethernetframePayload;
+	auto* arp_message = (ARPMessage*) packet->data();
 
 	//Check if the message hardware type is Ethernet (BigEndian)
 	if (arp_message->hardware_type == 0x100) {
@@ -58,17 +71,18 @@ bool AddressResolutionProtocol::handle_ethernetframe_payload(uint8_t* ethernetfr
 			switch (arp_message->command) {
 				//Request
 				case 0x0100:
+					learn(arp_message->src_ip, arp_message->src_mac, true);                                                  //The sender will be talked to so remember it
 					arp_message->command = 0x0200;                                                                         //Set the command to reply
 					arp_message->dst_mac = arp_message->src_mac;                                                            //Set the destination MAC to the source MAC
 					arp_message->dst_ip = arp_message->src_ip;                                                              //Set the destination IP to the source IP
 					arp_message->src_mac = internet_protocol_handler->get_media_access_control_address();                      //Set the source MAC to this MAC
 					arp_message->src_ip = internet_protocol_handler->get_internet_protocol_address();                         //Set the source IP to this IP
+					packet->trim(sizeof(ARPMessage));                                                                       //Drop any ethernet padding
 					return true;
 
 					//Response
 				case 0x0200:
-					address_cache.insert((InternetProtocolAddress) arp_message->src_ip,
-					                     (MediaAccessControlAddress) arp_message->src_mac);     //Insert the MAC address into the cache
+					learn(arp_message->src_ip, arp_message->src_mac, false);                                                 //Only take replies to addresses that were asked for
 					break;
 
 				default:
@@ -118,32 +132,110 @@ void AddressResolutionProtocol::request_mac_address(InternetProtocolAddress addr
 
 
 /**
- * @brief Get the MAC address from an IP via ARP.
+ * @brief Get the time used for the cache
+ *
+ * @return Milliseconds since the clock started
+ */
+uint64_t AddressResolutionProtocol::now() {
+
+	Clock* clock = Clock::active_clock();
+	return clock ? clock->uptime() : 0;
+}
+
+/**
+ * @brief Get the MAC address from an IP via ARP, waiting for the reply if it isn't cached.
  *
  * @param address The IP address to get the MAC address from.
- * @return The MAC address of the IP address.
+ * @return The MAC address of the IP address, or 0 if there was no reply.
  *
- * @todo Should have a timeout in case the address cannot be resolved and avoid infinite loops
+ * @note Can't be used from the thread that receives the frames as the reply would never be handled, send packets with the
+ * non-blocking resolve() instead
  */
 MediaAccessControlAddress AddressResolutionProtocol::resolve(InternetProtocolAddress address) {
 
-	volatile Map<InternetProtocolAddress, MediaAccessControlAddress>::iterator cache_iterator = address_cache.find(
-			address); //Check if the MAC address is in the cache
+	MediaAccessControlAddress media_access_control_address = 0;
+	uint64_t give_up = now() + ARP_RETRY_INTERVAL * (ARP_MAX_RETRIES + 1);
 
-	//If not, request it
-	if (address_cache.end() == cache_iterator) {
-		request_mac_address(address);
+	//The timer worker asks again while waiting
+	while (!resolve(address, nullptr, media_access_control_address)) {
+		if (now() >= give_up)
+			return 0;
+
+		asm volatile("pause");
+	}
+
+	return media_access_control_address;
+}
+
+/**
+ * @brief Get the MAC address from an IP without waiting. If it isn't known yet the packet is held until the reply arrives
+ * (then sent as an IPv4 frame) or the address is given up on (then dropped).
+ *
+ * @param address The IP address to get the MAC address from.
+ * @param packet The packet to hold if the address isn't known (can be nullptr)
+ * @param media_access_control_address Where to store the MAC address if it is known
+ * @return True if the MAC address is known, false if the packet was taken
+ */
+bool AddressResolutionProtocol::resolve(InternetProtocolAddress address, PacketBuffer* packet, MediaAccessControlAddress& media_access_control_address) {
+
+	uint64_t time = now();
+	bool request = false;
+	PacketBuffer* dropped = nullptr;
+
+	m_lock.lock();
+	auto entry_iterator = address_cache.find(address);
+
+	//Known and not too old to trust
+	if (entry_iterator != address_cache.end() && entry_iterator->second.state == ARPEntryState::REACHABLE && time < entry_iterator->second.deadline) {
+		media_access_control_address = entry_iterator->second.media_access_control_address;
+		m_lock.unlock();
+		return true;
+	}
+
+	//Start resolving the address (again if it aged out)
+	if (entry_iterator == address_cache.end()) {
+
+		//The cache is full, drop the packet rather than waiting for a space
+		if (address_cache.size() >= ARP_MAX_ENTRIES) {
+			m_lock.unlock();
+			if (packet)
+				packet->release();
+			return false;
+		}
+
+		address_cache.insert(address, arp_entry_t());
+		entry_iterator = address_cache.find(address);
+	}
+
+	arp_entry_t& entry = entry_iterator->second;
+	if (entry.state == ARPEntryState::REACHABLE || entry.retries == 0) {
+		entry.state = ARPEntryState::INCOMPLETE;
+		entry.retries = 1;
+		entry.deadline = time + ARP_RETRY_INTERVAL;
+		request = true;
 	}
 
-	//This isn't safe because the MAC address might not be in the cache yet or the machine may not be connected to the network (possible infinite loop) //TODO: TIMEOUT
-	while (cache_iterator == address_cache.end()) {                         //Wait until the MAC address is found
-		cache_iterator = address_cache.find(address);
+	//Hold the packet, making room by dropping the oldest
+	if (packet) {
+		if (entry.pending_count == ARP_MAX_PENDING) {
+			dropped = entry.pending[0];
+			entry.pending_count--;
+			for (uint8_t i = 0; i < entry.pending_count; i++)
+				entry.pending[i] = entry.pending[i + 1];
+		}
+
+		entry.pending[entry.pending_count++] = packet;
 	}
 
-	//Return the MAC address
+	m_lock.unlock();
 
-	return cache_iterator->second;
+	if (dropped)
+		dropped->release();
+
+	if (request)
+		request_mac_address(address);
 
+	return false;
 }
 
 /**
@@ -153,5 +245,109 @@ MediaAccessControlAddress AddressResolutionProtocol::resolve(InternetProtocolAdd
  * @param media_access_control_address The MAC address.
  */
 void AddressResolutionProtocol::store(InternetProtocolAddress internet_protocol_address, drivers::ethernet::MediaAccessControlAddress media_access_control_address) {
-	address_cache.insert(internet_protocol_address, media_access_control_address);
+	learn(internet_protocol_address, media_access_control_address, true);
+}
+
+/**
+ * @brief Record the MAC address of an IP address and send the packets that were waiting for it
+ *
+ * @param internet_protocol_address The IP address.
+ * @param media_access_control_address The MAC address.
+ * @param create Should the address be added if it isn't already in the cache
+ */
+void AddressResolutionProtocol::learn(InternetProtocolAddress internet_protocol_address, MediaAccessControlAddress media_access_control_address, bool create) {
+
+	PacketBuffer* pending[ARP_MAX_PENDING];
+	uint8_t pending_count = 0;
+
+	m_lock.lock();
+	auto entry_iterator = address_cache.find(internet_protocol_address);
+	if (entry_iterator == address_cache.end()) {
+
+		if (!create || address_cache.size() >= ARP_MAX_ENTRIES) {
+			m_lock.unlock();
+			return;
+		}
+
+		address_cache.insert(internet_protocol_address, arp_entry_t());
+		entry_iterator = address_cache.find(internet_protocol_address);
+	}
+
+	arp_entry_t& entry = entry_iterator->second;
+	entry.media_access_control_address = media_access_control_address;
+	entry.state = ARPEntryState::REACHABLE;
+	entry.deadline = now() + ARP_ENTRY_LIFETIME;
+	entry.retries = 0;
+
+	//Take the packets out so they can be sent without holding the lock
+	pending_count = entry.pending_count;
+	for (uint8_t i = 0; i < pending_count; i++)
+		pending[i] = entry.pending[i];
+	entry.pending_count = 0;
+
+	m_lock.unlock();
+
+	for (uint8_t i = 0; i < pending_count; i++)
+		frame_handler->send_ethernet_frame(media_access_control_address, 0x0800, pending[i]);
+}
+
+/**
+ * @brief Ask again for addresses that haven't replied, give up on ones that never do and forget ones that are too old
+ *
+ * @param now The current time (ms)
+ */
+void AddressResolutionProtocol::handle_timers(uint64_t now) {
+
+	Vector<InternetProtocolAddress> requests;
+	Vector<InternetProtocolAddress> expired;
+	Vector<PacketBuffer*> dropped;
+
+	m_lock.lock();
+	for (auto& cached : address_cache) {
+		arp_entry_t& entry = cached.second;
+		if (now < entry.deadline)
+			continue;
+
+		//Still worth asking
+		if (entry.state == ARPEntryState::INCOMPLETE && entry.retries < ARP_MAX_RETRIES) {
+			entry.retries++;
+			entry.deadline = now + ARP_RETRY_INTERVAL;
+			requests.push_back(cached.first);
+			continue;
+		}
+
+		//No reply or too old, the packets waiting for it can't be sent
+		for (uint8_t i = 0; i < entry.pending_count; i++)
+			dropped.push_back(entry.pending[i]);
+		expired.push_back(cached.first);
+	}
+
+	for (auto& address : expired)
+		address_cache.erase(address);
+
+	m_lock.unlock();
+
+	for (auto& packet : dropped)
+		packet->release();
+
+	for (auto& address : requests)
+		request_mac_address(address);
+}
+
+/**
+ * @brief Runs the timers of the cache, sleeping between checks
+ *
+ * @param argc Unused
+ * @param argv The handler
+ */
+void AddressResolutionProtocol::timer_worker(uint64_t argc, AddressResolutionProtocol** argv) {
+
+	AddressResolutionProtocol* handler = argv[0];
+	while (true) {
+
+		handler->handle_timers(now());
+
+		//Sleep until the next check
+		GlobalScheduler::sleep(ARP_TIMER_INTERVAL);
+	}
 }
@@ -0,0 +1,181 @@
+/**
+ * @file checksum.cpp
+ * @brief Implementation of the Internet checksum
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+ */
+
+#include <net/checksum.h>
+#include <net/packetbuffer.h>
+
+using namespace MaxOS;
+using namespace MaxOS::net;
+
+/// Words in a packet aren't always aligned (the IP header follows a 14 byte ethernet header)
+typedef uint64_t __attribute__((may_alias, aligned(1))) unaligned_uint64_t;
+typedef uint32_t __attribute__((may_alias, aligned(1))) unaligned_uint32_t;
+typedef uint16_t __attribute__((may_alias, aligned(1))) unaligned_uint16_t;
+
+/**
+ * @brief Add a word to a 64-bit sum, counting the carry out separately so it can be added back once at the end
+ *
+ * @param sum The sum
+ * @param carries The number of carries out of the sum
+ * @param word The word to add
+ */
+static inline void add_with_carry(uint64_t& sum, uint64_t& carries, uint64_t word) {
+	sum += word;
+	carries += sum < word;
+}
+
+/**
+ * @brief Sum a block of data, 32 bytes per iteration
+ *
+ * @param data The data
+ * @param length The length of the data in bytes, an odd length is padded with a zero byte
+ * @param sum A partial sum to add to (e.g. of a pseudo header)
+ * @return The partial sum, not yet folded to 16 bits
+ *
+ * @note The data is summed as if it started at an even offset, only the last block of a packet can have an odd length
+ */
+uint32_t InternetChecksum::partial(const void* data, size_t length, uint32_t sum) {
+
+	auto* bytes = (const uint8_t*) data;
+	uint64_t total = sum;
+	uint64_t carries = 0;
+
+	// 64 bits at a time, one's complement addition is associative so the 16-bit words can be added four at a time and the
+	// carries folded back in at the end
+	while(length >= 32) {
+		add_with_carry(total, carries, *(const unaligned_uint64_t*) (bytes + 0));
+		add_with_carry(total, carries, *(const unaligned_uint64_t*) (bytes + 8));
+		add_with_carry(total, carries, *(const unaligned_uint64_t*) (bytes + 16));
+		add_with_carry(total, carries, *(const unaligned_uint64_t*) (bytes + 24));
+		bytes += 32;
+		length -= 32;
+	}
+
+	while(length >= 8) {
+		add_with_carry(total, carries, *(const unaligned_uint64_t*) bytes);
+		bytes += 8;
+		length -= 8;
+	}
+
+	if(length >= 4) {
+		add_with_carry(total, carries, *(const unaligned_uint32_t*) bytes);
+		bytes += 4;
+		length -= 4;
+	}
+
+	if(length >= 2) {
+		add_with_carry(total, carries, *(const unaligned_uint16_t*) bytes);
+		bytes += 2;
+		length -= 2;
+	}
+
+	// Pad the last byte with a zero, as the words are read little endian the byte is the low half of its word
+	if(length)
+		add_with_carry(total, carries, *bytes);
+
+	// Add the carries back in (2^64 is 1 in one's complement, the end around carry) and fold down to 32 bits
+	total = (total & 0xFFFFFFFF) + (total >> 32) + carries;
+	total = (total & 0xFFFFFFFF) + (total >> 32);
+	total = (total & 0xFFFFFFFF) + (total >> 32);
+	total = (total & 0xFFFFFFFF) + (total >> 32);
+	return (uint32_t) total;
+}
+
+/**
+ * @brief Sum the pseudo header TCP and UDP include in their checksums
+ *
+ * @param source_ip The source IP address (as stored in the header)
+ * @param destination_ip The destination IP address (as stored in the header)
+ * @param protocol The IP protocol number
+ * @param length The length of the TCP or UDP header and data (host order)
+ * @return The partial sum of the pseudo header
+ */
+uint32_t InternetChecksum::pseudo_header(uint32_t source_ip, uint32_t destination_ip, uint8_t protocol, uint16_t length) {
+
+	uint64_t sum = (uint64_t) source_ip + destination_ip;
+	sum += (uint16_t) protocol << 8;
+	sum += (uint16_t) ((length >> 8) | (length << 8));
+
+	sum = (sum & 0xFFFFFFFF) + (sum >> 32);
+	return (uint32_t) sum;
+}
+
+/**
+ * @brief Fold a partial sum down to 16 bits
+ *
+ * @param sum The partial sum
+ * @return The 16-bit one's complement sum (not inverted)
+ */
+uint16_t InternetChecksum::fold(uint32_t sum) {
+
+	sum = (sum & 0xFFFF) + (sum >> 16);
+	sum = (sum & 0xFFFF) + (sum >> 16);
+	return (uint16_t) sum;
+}
+
+/**
+ * @brief Calculate the checksum of a block of data
+ *
+ * @param data The data, the checksum field must be 0
+ * @param length The length of the data in bytes
+ * @param sum A partial sum to add to (e.g. of a pseudo header)
+ * @return The checksum, ready to be stored in the header
+ */
+uint16_t InternetChecksum::compute(const void* data, size_t length, uint32_t sum) {
+	return ~fold(partial(data, length, sum));
+}
+
+/**
+ * @brief Update a checksum after a 16-bit field it covers has changed, without summing the data again (RFC 1624 eqn. 3)
+ *
+ * @param checksum The checksum as stored in the header
+ * @param old_value The old value of the field (as stored in the header)
+ * @param new_value The new value of the field (as stored in the header)
+ * @return The new checksum
+ */
+uint16_t InternetChecksum::update(uint16_t checksum, uint16_t old_value, uint16_t new_value) {
+
+	uint32_t sum = (uint16_t) ~checksum + (uint16_t) ~old_value + new_value;
+	return ~fold(sum);
+}
+
+/**
+ * @brief Update a checksum after a 32-bit field it covers (e.g. an address) has changed, without summing the data again
+ *
+ * @param checksum The checksum as stored in the header
+ * @param old_value The old value of the field (as stored in the header)
+ * @param new_value The new value of the field (as stored in the header)
+ * @return The new checksum
+ */
+uint16_t InternetChecksum::update(uint16_t checksum, uint32_t old_value, uint32_t new_value) {
+
+	uint32_t sum = (uint16_t) ~checksum;
+	sum += (uint16_t) ~(old_value & 0xFFFF) + (uint16_t) ~(old_value >> 16);
+	sum += (new_value & 0xFFFF) + (new_value >> 16);
+	return ~fold(sum);
+}
+
+/**
+ * @brief Fill in a checksum that was left for the NIC, used when the driver can't offload it
+ *
+ * @param packet The packet, the checksum field must hold the folded pseudo header sum
+ */
+void InternetChecksum::complete(PacketBuffer* packet) {
+
+	if(!packet->checksum_pending())
+		return;
+
+	size_t start = packet->checksum_start();
+	uint8_t* data = packet->data() + start;
+	auto* field = (unaligned_uint16_t*) (data + packet->checksum_offset());
+
+	// The field already holds the pseudo header so is summed along with the data (0 means no checksum to UDP, 0xFFFF is the same value)
+	uint16_t checksum = compute(data, packet->length() - start);
+	*field = checksum ? checksum : 0xFFFF;
+	packet->clear_checksum();
+}
@@ -40,12 +40,11 @@ EthernetFramePayloadHandler::~EthernetFramePayloadHandler() = default;
 /**
  * @brief Handle the received ethernet frame payload
  *
- * @param ethernetframe_payload the payload of the ethernet frame
- * @param size the size of the payload
+ * @param packet the packet, positioned at the start of the payload
  *
- * @return True if the data is to be sent back, false otherwise
+ * @return True if the packet is to be sent back (positioned at the start of the reply payload), false otherwise
  */
-bool EthernetFramePayloadHandler::handle_ethernetframe_payload(uint8_t* ethernetframe_payload, uint32_t size) {
+bool EthernetFramePayloadHandler::handle_ethernetframe_payload(PacketBuffer* packet) {
 
 	//By default, don't handle it, will be handled in the override
 	return false;
@@ -56,12 +55,28 @@ bool EthernetFramePayloadHandler::handle_ethernetframe_payload(uint8_t* ethernet
  * @brief send an packet via the backend driver
  *
  * @param destination the destination MAC address
+ * @param packet the payload to send, ownership is passed on
+ */
+void EthernetFramePayloadHandler::send(uint64_t destination, PacketBuffer* packet) {
+
+	frame_handler->send_ethernet_frame(destination, handled_type, packet);
+}
+
+/**
+ * @brief send an packet via the backend driver, copying the payload into a packet buffer first
+ *
+ * @param destination the destination MAC address
  * @param data the data to send
  * @param size the size of the payload
  */
 void EthernetFramePayloadHandler::send(uint64_t destination, uint8_t* data, uint32_t size) {
 
-	frame_handler->send_ethernet_frame(destination, handled_type, data, size);
+	// No buffers left, drop it
+	PacketBuffer* packet = PacketBufferPool::allocate(data, size);
+	if(!packet)
+		return;
+
+	send(destination, packet);
 }
 
 /**
@@ -78,6 +93,9 @@ EthernetFrameHandler::EthernetFrameHandler(EthernetDriver* driver, OutputStream*
 
 	driver->connect_event_handler(this);
 
+	// Handle frames in a worker thread rather than in the interrupt now that there is a stack to pass them to
+	driver->enable_polling();
+
 }
 
 EthernetFrameHandler::~EthernetFrameHandler() = default;
@@ -95,23 +113,23 @@ drivers::ethernet::MediaAccessControlAddress EthernetFrameHandler::get_mac() {
 /**
  * @brief Handle the received packet
  *
- * @param buffer the buffer with the received data
- * @param size the size of the received data
- * @return True if the data is to be sent back, false otherwise
+ * @param packet the packet that was received
+ * @return True if the packet is to be sent back, false otherwise
  *
  * @todo Future debugging me: the override is not being called in derived classes
  */
-bool EthernetFrameHandler::data_received(uint8_t* buffer, uint32_t size) {
+bool EthernetFrameHandler::data_received(PacketBuffer* packet) {
 
-	error_messages->write("EFH: Data received\n");
+	NET_TRACE(error_messages, "EFH: Data received\n");
 
 
 	//Check if the size is big enough to contain an ethernet frame
-	if(size < sizeof(EthernetFrameHeader))
+	if(packet->length() < sizeof(EthernetFrameHeader))
 		return false;
 
-	//Convert to struct for easier use
-	auto* frame = (EthernetFrameHeader*) buffer;
+	//Convert to struct for easier use, the header stays in the buffer once it's pulled so a reply can reuse it
+	auto* frame = (EthernetFrameHeader*) packet->data();
+	packet->pull(sizeof(EthernetFrameHeader));
 	bool send_back = false;
 
 	//Only handle if it is for this device
@@ -126,17 +144,18 @@ bool EthernetFrameHandler::data_received(uint8_t* buffer, uint32_t size) {
 		if(handler_iterator != frame_handlers.end()) {
 
 			//Handle the data
-			error_messages->write("EFH: Handling ethernet frame payload\n");
-			send_back = handler_iterator->second->handle_ethernetframe_payload(buffer + sizeof(EthernetFrameHeader),
-			                                                                   size - sizeof(EthernetFrameHeader));
-			error_messages->write("..DONE\n");
+			NET_TRACE(error_messages, "EFH: Handling ethernet frame payload\n");
+			send_back = handler_iterator->second->handle_ethernetframe_payload(packet);
+			NET_TRACE(error_messages, "..DONE\n");
 
 		} else {
 
 			//If the handler is not found, print an error message
+#ifdef MAXOS_NET_TRACE
 			error_messages->write("EFH: Unhandled ethernet frame type 0x");
 			error_messages->write_hex(frame->type);
 			error_messages->write("\n");
+#endif
 
 		}
 	}
@@ -144,10 +163,18 @@ bool EthernetFrameHandler::data_received(uint8_t* buffer, uint32_t size) {
 	//If the data is to be sent back again
 	if(send_back) {
 
-		error_messages->write("EFH: Sending back\n");
+		NET_TRACE(error_messages, "EFH: Sending back\n");
+
+		//The payload handler leaves the packet at the start of its reply so the header goes straight in front of it
+		uint64_t sender = frame->source_mac;
+		uint16_t type = frame->type;
+		frame = (EthernetFrameHeader*) packet->prepend(sizeof(EthernetFrameHeader));
+		if(!frame)
+			return false;
 
-		frame->destination_mac = frame->source_mac;                             //Set the new destination to be the device the data was received from
+		frame->destination_mac = sender;                                        //Set the new destination to be the device the data was received from
 		frame->source_mac = ethernet_driver->get_media_access_control_address();      //Set the new source to be this device's MAC address
+		frame->type = type;
 
 	}
 
@@ -176,32 +203,26 @@ void EthernetFrameHandler::connect_handler(EthernetFramePayloadHandler* handler)
  *
  * @param destination_mac the destination MAC address
  * @param frame_type the type of the protocol
- * @param data the data to send
- * @param size the size of the payload
+ * @param packet the payload to send, ownership is passed to the driver
  */
-void EthernetFrameHandler::send_ethernet_frame(uint64_t destination_mac, uint16_t frame_type, uint8_t* data, uint32_t size) {
+void EthernetFrameHandler::send_ethernet_frame(uint64_t destination_mac, uint16_t frame_type, PacketBuffer* packet) {
 
-	error_messages->write("EFH: Sending frame...");
+	NET_TRACE(error_messages, "EFH: Sending frame...");
 
-	//Allocate memory for the buffer
-	auto* buffer = (uint8_t*) MemoryManager::kmalloc(size + sizeof(EthernetFrameHeader));
-	auto* frame = (EthernetFrameHeader*) buffer;
+	//Write the header in front of the payload
+	auto* frame = (EthernetFrameHeader*) packet->prepend(sizeof(EthernetFrameHeader));
+	if(!frame) {
+		packet->release();
+		return;
+	}
 
 	//Put data in the header
 	frame->destination_mac = destination_mac;
 	frame->source_mac = ethernet_driver->get_media_access_control_address();
 	frame->type = (frame_type >> 8) | (frame_type << 8);                        //Convert to big endian
 
-	//Copy the data
-	for(uint8_t* src = data + size - 1, * dst = buffer + sizeof(EthernetFrameHeader) + size - 1; src >= data; --src, --dst)
-		*dst = *src;
-
 	//Send the data
-	ethernet_driver->send(buffer, size + sizeof(EthernetFrameHeader));
-
-	error_messages->write("Done\n");
-
+	ethernet_driver->send(packet);
 
-	//Free the buffer
-	MemoryManager::kfree(buffer);
+	NET_TRACE(error_messages, "Done\n");
 }
@@ -7,6 +7,7 @@
  */
 
 #include <net/icmp.h>
+#include <net/checksum.h>
 
 using namespace  MaxOS;
 using namespace  MaxOS::common;
@@ -32,8 +33,7 @@ InternetControlMessageProtocol::~InternetControlMessageProtocol() = default;
  *
  * @param src_ip_be  The source IP address of the packet
  * @param dst_ip_be  The destination IP address of the packet
- * @param payload_data  The payload of the packet
- * @param size The size of the payload
+ * @param packet  The packet, positioned at the start of the ICMP message
 
  * @return True if the packet is to be sent back to the sender, false otherwise
  *
@@ -42,19 +42,18 @@ InternetControlMessageProtocol::~InternetControlMessageProtocol() = default;
  */
 bool InternetControlMessageProtocol::handle_internet_protocol_payload(net::InternetProtocolAddress src_ip_be,
                                                                       net::InternetProtocolAddress dst_ip_be,
-                                                                      uint8_t *payload_data,
-                                                                      uint32_t size)
+                                                                      PacketBuffer* packet)
 {
 
-    error_messages -> write("ICMP received a packet\n");
+    NET_TRACE(error_messages, "ICMP received a packet\n");
 
     // Check if the size is at least the size of the header
-    if(size < sizeof(ICMPHeader)){
+    if(packet->length() < sizeof(ICMPHeader)){
         return false;
     }
 
     // Cast the payload to the ICMP header
-    auto* icmp = (ICMPHeader*)payload_data;
+    auto* icmp = (ICMPHeader*)packet->data();
 
     switch (icmp -> type) {
 
@@ -63,12 +62,12 @@ bool InternetControlMessageProtocol::handle_internet_protocol_payload(net::Inter
 
         case 8: // Echo request
 
-            // Create a response
+            // Create a response, only the type changes so patch the checksum rather than summing the echoed data again
+            uint16_t old_word = *(uint16_t*) icmp;                                                                                               // Type and code share a word
             icmp -> type = 0;                                                                                                                    // Echo reply
-            icmp -> checksum = 0;                                                                                                                // Reset the checksum
-            icmp -> checksum = InternetProtocolHandler::checksum((uint16_t*) &icmp, sizeof(ICMPHeader));             // Calculate the checksum
+            icmp -> checksum = InternetChecksum::update(icmp -> checksum, old_word, *(uint16_t*) icmp);
 
-            return true;    //Send data back
+            return true;    //Send the request back in place as the reply
 
     }
 
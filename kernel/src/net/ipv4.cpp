@@ -7,6 +7,11 @@
  */
 
 #include <net/ipv4.h>
+#include <net/checksum.h>
+#include <common/hashmap.h>
+#include <drivers/clock/clock.h>
+#include <memory/memoryIO.h>
+#include <system/cpu.h>
 
 using namespace MaxOS;
 using namespace MaxOS::common;
@@ -14,6 +19,18 @@ using namespace MaxOS::net;
 using namespace MaxOS::memory;
 using namespace MaxOS::drivers;
 using namespace MaxOS::drivers::ethernet;
+using namespace MaxOS::drivers::clock;
+using namespace MaxOS::system;
+
+/**
+ * @brief Swap the bytes of a 16-bit value between host and network order
+ *
+ * @param value The value to swap
+ * @return The swapped value
+ */
+static inline uint16_t swap_16(uint16_t value) {
+	return (value >> 8) | (value << 8);
+}
 
 /**
  * @brief Construct a new IPV4 Address Resolver object and register it with the Internet Protocol Handler
@@ -48,6 +65,21 @@ void IPV4AddressResolver::store(InternetProtocolAddress internet_protocol_addres
 
 }
 
+/**
+ * @brief Resolves an IP address to a MAC address for sending a packet. (Default, waits for resolve(), override to send
+ * the packet later rather than waiting)
+ *
+ * @param address The IP address to turn into a MAC address.
+ * @param packet The packet being sent, taken by the resolver if it returns false.
+ * @param media_access_control_address Where to store the MAC address.
+ * @return True if the MAC address is known and the caller should send the packet, false if the resolver has taken it.
+ */
+bool IPV4AddressResolver::resolve(InternetProtocolAddress address, PacketBuffer* packet, MediaAccessControlAddress& media_access_control_address) {
+
+	media_access_control_address = resolve(address);
+	return true;
+}
+
 /**
  * @brief Construct a new IPV4 Payload Handler object and register it with the Internet Protocol Handler
  *
@@ -72,14 +104,12 @@ IPV4PayloadHandler::~IPV4PayloadHandler() = default;
  *
  * @param src_ip_be The source IP address.
  * @param dst_ip_be The destination IP address.
- * @param internetprotocol_payload The payload of the IP packet.
- * @param size The size of the IP packet.
- * @return True if the packet was handled, false otherwise.
+ * @param packet The packet, positioned at the start of the IP payload.
+ * @return True if the packet is to be sent back (positioned at the start of the reply payload), false otherwise.
  */
 bool IPV4PayloadHandler::handle_internet_protocol_payload(net::InternetProtocolAddress src_ip_be,
                                                           net::InternetProtocolAddress dst_ip_be,
-                                                          uint8_t* internetprotocol_payload,
-                                                          uint32_t size) {
+                                                          PacketBuffer* packet) {
 	return false;
 }
 
@@ -87,15 +117,30 @@ bool IPV4PayloadHandler::handle_internet_protocol_payload(net::InternetProtocolA
  * @brief Sends an IP packet.
  *
  * @param destination_ip The destination IP address.
+ * @param packet The payload of the IP packet, ownership is passed on.
+ */
+void IPV4PayloadHandler::send(InternetProtocolAddress destination_ip, PacketBuffer* packet) {
+
+	//Pass to backend
+	internet_protocol_handler->send_internet_protocol_packet(destination_ip, ip_protocol, packet);
+
+}
+
+/**
+ * @brief Sends an IP packet, copying the payload into a packet buffer first.
+ *
+ * @param destination_ip The destination IP address.
  * @param payload_data The payload of the IP packet.
  * @param size The size of the IP packet.
  */
 void IPV4PayloadHandler::send(InternetProtocolAddress destination_ip, uint8_t* payload_data, uint32_t size) {
 
+	// No buffers left, drop it
+	PacketBuffer* packet = PacketBufferPool::allocate(payload_data, size);
+	if(!packet)
+		return;
 
-	//Pass to backend
-	internet_protocol_handler->send_internet_protocol_packet(destination_ip, ip_protocol, payload_data, size);
-
+	send(destination_ip, packet);
 }
 
 /**
@@ -114,6 +159,9 @@ InternetProtocolHandler::InternetProtocolHandler(EthernetFrameHandler* backend,
 	this->default_gateway_internet_protocol_address = default_gateway_internet_protocol_address;
 	this->subnet_mask = subnet_mask;
 	this->error_messages = error_messages;
+
+	// Cleared here rather than with a member initializer, which the compiler turns into a call to the C memset
+	memset(m_reassemblies, 0, sizeof(m_reassemblies));
 }
 
 InternetProtocolHandler::~InternetProtocolHandler() = default;
@@ -121,151 +169,407 @@ InternetProtocolHandler::~InternetProtocolHandler() = default;
 /**
  * @brief Called when an IP packet is received.
  *
- * @param ethernetframe_payload The payload of the IP packet.
- * @param size The size of the IP packet.
+ * @param packet The packet, positioned at the start of the IP header.
  * @return True if the packet is to be sent back, false otherwise.
- *
- * @todo Set the identifier when sending packets back
  */
-bool InternetProtocolHandler::handle_ethernetframe_payload(uint8_t* ethernetframe_payload, uint32_t size) {
+bool InternetProtocolHandler::handle_ethernetframe_payload(PacketBuffer* packet) {
 
-	error_messages->write("IP: Handling packet\n");
+	NET_TRACE(error_messages, "IP: Handling packet\n");
 
 	//Check if the size is big enough to contain an ethernet frame
-	if(size < sizeof(IPV4Header))
+	if(packet->length() < sizeof(IPV4Header))
 		return false;
 
 	//Convert to struct for easier use
-	auto* ip_message = (IPV4Header*) ethernetframe_payload;
+	auto* ip_message = (IPV4Header*) packet->data();
+	uint32_t header_length = ip_message->header_length * 4;
+	if(header_length < sizeof(IPV4Header) || header_length > packet->length())
+		return false;
+
 	bool send_back = false;
 
 	//Only handle if it is for this device
 	if(ip_message->destination_ip == get_internet_protocol_address()) {
-		uint32_t length = ip_message->total_length;                          //Get length of the message
-		if(length >
-		   size)                                               //Check if the length is bigger than the size of the message
-			length = size;                                              //If so, set length to size (this stops heartbleed attacks as it will not read past the end of the message, which the attacker could have filled with data)
+		uint32_t length = ((ip_message->total_length & 0xFF00) >> 8) | ((ip_message->total_length & 0x00FF) << 8);
+		if(length < header_length)
+			return false;
+
+		//Drop the ethernet padding (also stops heartbleed attacks as the payload can't claim to be longer than what was received)
+		packet->trim(length);
+		packet->pull(header_length);
+
+		//Fragments are held until the whole datagram has arrived
+		PacketBuffer* datagram = packet;
+		if(swap_16(ip_message->flags_and_offset) & (IPV4_FLAG_MORE_FRAGMENTS | IPV4_FRAGMENT_OFFSET)) {
+			datagram = reassemble(ip_message, packet);
+			if(!datagram)
+				return false;
+		}
+
+		m_statistics.received++;
 
 		// Get the handler for the protocol
 		Map<uint8_t, IPV4PayloadHandler*>::iterator handler_iterator = ipv_4_payload_handlers.find(ip_message->protocol);
 		if(handler_iterator != ipv_4_payload_handlers.end()) {
 			IPV4PayloadHandler* handler = handler_iterator->second;
 			if(handler != nullptr) {
-				send_back = handler->handle_internet_protocol_payload(ip_message->source_ip, ip_message->destination_ip,
-				                                                      ethernetframe_payload + sizeof(IPV4Header),
-				                                                      length - sizeof(IPV4Header));
+				send_back = handler->handle_internet_protocol_payload(ip_message->source_ip, ip_message->destination_ip, datagram);
 			}
 		}
 
+		//A reply to a reassembled datagram goes out as a new datagram (fragmented again if it has to be), the last fragment is released by the driver
+		if(datagram != packet) {
+			if(send_back)
+				send_internet_protocol_packet(ip_message->source_ip, ip_message->protocol, datagram);
+			else
+				datagram->release();
+
+			return false;
+		}
 
 	}
 
 	//If the data is to be sent back again
 	if(send_back) {
 
+		//The payload handler leaves the packet at the start of its reply so the header goes in front of that (dropping any options)
+		IPV4Header received = *ip_message;
+		ip_message = (IPV4Header*) packet->prepend(sizeof(IPV4Header));
+		if(!ip_message)
+			return false;
+
+		*ip_message = received;
+		ip_message->header_length = sizeof(IPV4Header) / 4;
+		ip_message->total_length = packet->length();
+		ip_message->total_length = ((ip_message->total_length & 0xFF00) >> 8) | ((ip_message->total_length & 0x00FF) << 8);
+
 		//Swap source and destination
 		uint32_t temp = ip_message->destination_ip;                                                                                     //Store destination IP
 		ip_message->destination_ip = ip_message->source_ip;                                                                                //Set destination IP to source IP
 		ip_message->source_ip = temp;                                                                                              //Set source IP to destination IP
 
 		ip_message->time_to_live = 0x40;                                                                                         //Reset TTL
-		ip_message->checksum = checksum((uint16_t*) ip_message, 4 *
-		                                                        ip_message->header_length);                  //Reset checksum as the source and destination IP have changed so has the time to live and therefore there is a different header
+		ip_message->identifier = swap_16(next_identifier(ip_message->destination_ip, ip_message->protocol));
+		ip_message->flags_and_offset = 0;
+
+		//Swapping the addresses doesn't change the sum, so unless the options were dropped only the length, identifier, flags and TTL need patching into the checksum (RFC 1624)
+		if(received.header_length == sizeof(IPV4Header) / 4) {
+			ip_message->checksum = received.checksum;
+			for(int word = 1; word <= 4; word++)
+				ip_message->checksum = InternetChecksum::update(ip_message->checksum, ((uint16_t*) &received)[word], ((uint16_t*) ip_message)[word]);
+		} else {
+			ip_message->checksum = 0;
+			ip_message->checksum = checksum((uint16_t*) ip_message, sizeof(IPV4Header));
+		}
 
 	}
 
-	error_messages->write("IP: Handled packet\n");
+	NET_TRACE(error_messages, "IP: Handled packet\n");
 	return send_back;
 }
 
 
 /**
- * @brief Sends an IP packet.
+ * @brief Sends an IP packet, in fragments if it is too big for one frame.
  *
  * @param dst_ip_be The destination IP address.
  * @param protocol The protocol of the IP packet.
- * @param data The payload of the IP packet.
- * @param size The size of the IP packet.
+ * @param packet The payload of the IP packet, ownership is passed on.
  */
-void InternetProtocolHandler::send_internet_protocol_packet(uint32_t dst_ip_be, uint8_t protocol, const uint8_t* data, uint32_t size) {
+void InternetProtocolHandler::send_internet_protocol_packet(uint32_t dst_ip_be, uint8_t protocol, PacketBuffer* packet) {
 
-	auto* buffer = (uint8_t*) MemoryManager::kmalloc(
-	sizeof(IPV4Header) + size);                           //Allocate memory for the message
-	auto* message = (IPV4Header*) buffer;                                                                            //Convert to struct for easier use
+	//Too big for any datagram
+	if(packet->length() + sizeof(IPV4Header) > IPV4_MAX_DATAGRAM) {
+		packet->release();
+		return;
+	}
 
-	message->version = 4;                                                                                                                           //Set version
-	message->header_length = sizeof(IPV4Header) /
-	                         4;                                                                                     //Set header length
-	message->type_of_service = 0;                                                                                                                     //Set type of service (not private)
+	uint16_t identifier = next_identifier(dst_ip_be, protocol);
+	m_statistics.sent++;
 
-	message->total_length = size +
-	                        sizeof(IPV4Header);                                                                                 //Set total length
-	message->total_length = ((message->total_length & 0xFF00)
-	>> 8)                                                                                 // Convert to big endian (Swap bytes)
-	                        | ((message->total_length & 0x00FF)
-	<< 8);                                                                              // Convert to big endian (Swap bytes)
+	//Too big for one frame (or in a buffer the NIC can't read), split it up
+	if(packet->length() + sizeof(IPV4Header) > IPV4_MTU || !packet->pooled()) {
+		fragment(dst_ip_be, protocol, identifier, packet);
+		return;
+	}
 
-	message->identifier = 0x100;                                                                                                                    //Set identification TODO: do properly
-	message->flags_and_offset = 0x0040;                                                                                                               //Set flags/offset, 0x40 because we are not fragmenting (TODO: doesnt work for packets bigger than 1500 bytes)
+	if(!write_header(packet, dst_ip_be, protocol, identifier, 0)) {
+		packet->release();
+		return;
+	}
 
-	message->time_to_live = 0x40;                                                                                                                     //Set time to live
-	message->protocol = protocol;                                                                                                                   //Set protocol
+	transmit(dst_ip_be, packet);
+}
 
-	message->destination_ip = dst_ip_be;                                                                                                                      //Set destination IP
-	message->source_ip = get_internet_protocol_address();                                                                                                  //Set source IP
+/**
+ * @brief Write the IP header in front of a payload
+ *
+ * @param packet The payload
+ * @param destination_ip The destination IP address
+ * @param protocol The protocol of the payload
+ * @param identifier The identifier of the datagram (host order)
+ * @param flags_and_offset The flags and fragment offset (host order)
+ * @return False if there is no room for the header
+ */
+bool InternetProtocolHandler::write_header(PacketBuffer* packet, InternetProtocolAddress destination_ip, uint8_t protocol, uint16_t identifier, uint16_t flags_and_offset) {
+
+	auto* message = (IPV4Header*) packet->prepend(sizeof(IPV4Header));            //Write the header in front of the payload
+	if(!message)
+		return false;
 
-	message->checksum = 0;                                                                                                                          //Set checksum to 0, init with 0 as checksum funct will also add this value
-	message->checksum = checksum((uint16_t*) message,
-	                             sizeof(IPV4Header));                                             //Calculate checksum
+	message->version = 4;                                                         //Set version
+	message->header_length = sizeof(IPV4Header) / 4;                              //Set header length
+	message->type_of_service = 0;                                                 //Set type of service (not private)
+	message->total_length = swap_16(packet->length());                            //Set total length (big endian)
 
-	//Copy data
-	uint8_t* data_buffer = buffer +
-	                       sizeof(IPV4Header);                                                                                  //Get pointer to the data
-	for(uint32_t i = 0; i <
-	                    size; i++)                                                                                                                            //Loop through data
-		data_buffer[i] = data[i];                                                                                                                             //Copy data
+	message->identifier = swap_16(identifier);                                    //Set identification
+	message->flags_and_offset = swap_16(flags_and_offset);                        //Set flags/offset
+
+	message->time_to_live = 0x40;                                                 //Set time to live
+	message->protocol = protocol;                                                 //Set protocol
+
+	message->destination_ip = destination_ip;                                     //Set destination IP
+	message->source_ip = get_internet_protocol_address();                         //Set source IP
+
+	message->checksum = 0;                                                        //Set checksum to 0, init with 0 as checksum funct will also add this value
+	message->checksum = checksum((uint16_t*) message, sizeof(IPV4Header));        //Calculate checksum
+	return true;
+}
+
+/**
+ * @brief Send a packet that has its IP header to the next hop
+ *
+ * @param destination_ip The destination IP address
+ * @param packet The packet, ownership is passed on
+ */
+void InternetProtocolHandler::transmit(InternetProtocolAddress destination_ip, PacketBuffer* packet) {
 
 	//Check if the destination is on the same subnet, The if condition determines if the destination device is on the same Local network as the source device . and if they are not on the same local network then we resolve the ip address of the gateway .
-	InternetProtocolAddress route = dst_ip_be;                                                                                                                               //Set route to destination IP by default
-	if((dst_ip_be & subnet_mask) != (own_internet_protocol_address &
+	InternetProtocolAddress route = destination_ip;                                                                                                                               //Set route to destination IP by default
+	if((destination_ip & subnet_mask) != (own_internet_protocol_address &
 	                                 subnet_mask))                                                                                             //Check if the destination is on the same subnet
 		route = default_gateway_internet_protocol_address;                                                                                                                                   //If not, set route to gateway IP
-	//Print debug info
-	uint32_t mac = resolver->resolve(route);
+	//If the address isn't known yet the resolver holds the packet and sends it once it is
+	MediaAccessControlAddress mac;
+	if(!resolver->resolve(route, packet, mac))
+		return;
 
 	//Send message
-	frame_handler->send_ethernet_frame(mac, this->handled_type, buffer, size + sizeof(IPV4Header));      //Send message
-	MemoryManager::kfree(
-	buffer);                                                                                                 //Free memory
+	frame_handler->send_ethernet_frame(mac, this->handled_type, packet);      //Send message
 }
 
 /**
- * @brief Creates a checksum for the given data.
+ * @brief Split a datagram into fragments that each fit in a frame
  *
- * @param data The data to create a checksum for.
- * @param length_in_bytes The length of the data in bytes.
- * @return The checksum.
+ * @param destination_ip The destination IP address
+ * @param protocol The protocol of the payload
+ * @param identifier The identifier the fragments share (host order)
+ * @param packet The payload, ownership is passed on
  */
-uint16_t InternetProtocolHandler::checksum(const uint16_t* data, uint32_t length_in_bytes) {
+void InternetProtocolHandler::fragment(InternetProtocolAddress destination_ip, uint8_t protocol, uint16_t identifier, PacketBuffer* packet) {
+
+	//The NIC can't fill in a checksum that is spread over several frames
+	InternetChecksum::complete(packet);
+
+	//Every fragment but the last has to be a multiple of 8 bytes
+	constexpr uint32_t fragment_size = (IPV4_MTU - sizeof(IPV4Header)) & ~7u;
+	uint32_t length = packet->length();
+	bool fragmented = length > fragment_size;
+	if(fragmented)
+		m_statistics.fragmented++;
+
+	for(uint32_t offset = 0; offset < length; offset += fragment_size) {
 
-	uint32_t temp = 0;                                                                             //Init sum
+		uint32_t size = length - offset < fragment_size ? length - offset : fragment_size;
+		bool last = offset + size == length;
+		uint16_t flags_and_offset = (offset / 8) | (last ? 0 : IPV4_FLAG_MORE_FRAGMENTS);
 
-	for(uint32_t i = 0; i < length_in_bytes /
-	                        2; i++)                                                       //Loop through data (/2 bc bytes)
-		temp += ((data[i] & 0xFF00) >> 8) |
-		        ((data[i] & 0x00FF) << 8);                             //Add data to sum in big endian
+		//Without this piece the rest are useless
+		PacketBuffer* part = PacketBufferPool::allocate(packet->data() + offset, size);
+		if(!part || !write_header(part, destination_ip, protocol, identifier, flags_and_offset)) {
+			if(part)
+				part->release();
 
-	if(length_in_bytes %
-	   2)                                                                          //If there is an odd number of bytes
-		temp += ((uint16_t) ((char*) data)[length_in_bytes - 1])
-		<< 8;                                   //Add the last byte to the sum
+			m_statistics.fragmentation_failed++;
+			break;
+		}
+
+		if(fragmented)
+			m_statistics.fragments_sent++;
 
-	while(temp &
-	      0xFFFF0000)                                                                       //While there is a carry
-		temp = (temp & 0xFFFF) +
-		       (temp >> 16);                                                     //Add the carry to the sum
+		transmit(destination_ip, part);
+	}
 
-	return ((~temp & 0xFF00) >> 8) | ((~temp & 0x00FF) << 8);
+	packet->release();
+}
+
+/**
+ * @brief Add a fragment to the datagram it belongs to
+ *
+ * @param header The IP header of the fragment
+ * @param packet The fragment, positioned at its payload (left for the caller to release)
+ * @return The payload of the whole datagram once every fragment has arrived, otherwise nullptr
+ */
+PacketBuffer* InternetProtocolHandler::reassemble(const ipv4_header_t* header, PacketBuffer* packet) {
+
+	uint16_t flags_and_offset = swap_16(header->flags_and_offset);
+	uint32_t offset = (flags_and_offset & IPV4_FRAGMENT_OFFSET) * 8;
+	uint32_t size = packet->length();
+	bool last = !(flags_and_offset & IPV4_FLAG_MORE_FRAGMENTS);
+	m_statistics.fragments_received++;
+
+	//Every fragment but the last carries a multiple of 8 bytes, and none can go past the largest datagram
+	if((!last && (size == 0 || size % 8)) || offset + size > IPV4_MAX_DATAGRAM - sizeof(IPV4Header))
+		return nullptr;
+
+	uint64_t time = now();
+	m_reassembly_lock.lock();
+
+	//Find the datagram the fragment belongs to, giving up on any that have run out of time
+	ipv4_reassembly_t* reassembly = nullptr;
+	ipv4_reassembly_t* empty = nullptr;
+	ipv4_reassembly_t* oldest = nullptr;
+	for(auto& slot : m_reassemblies) {
+
+		if(slot.active && time >= slot.deadline)
+			release_reassembly(slot);
+
+		if(!slot.active) {
+			if(!empty)
+				empty = &slot;
+			continue;
+		}
+
+		if(slot.source_ip == header->source_ip && slot.destination_ip == header->destination_ip
+		   && slot.identifier == header->identifier && slot.protocol == header->protocol)
+			reassembly = &slot;
+
+		if(!oldest || slot.deadline < oldest->deadline)
+			oldest = &slot;
+	}
+
+	//Start a new datagram, pushing out the oldest if the table is full
+	if(!reassembly) {
+		if(!empty) {
+			release_reassembly(*oldest);
+			empty = oldest;
+		}
+
+		PacketBuffer* datagram = PacketBufferPool::allocate_large(IPV4_MAX_DATAGRAM, 0);
+		if(!datagram) {
+			m_reassembly_lock.unlock();
+			return nullptr;
+		}
+		datagram->append(IPV4_MAX_DATAGRAM);
+
+		reassembly = empty;
+		memset(reassembly, 0, sizeof(ipv4_reassembly_t));
+		reassembly->active = true;
+		reassembly->source_ip = header->source_ip;
+		reassembly->destination_ip = header->destination_ip;
+		reassembly->identifier = header->identifier;
+		reassembly->protocol = header->protocol;
+		reassembly->packet = datagram;
+		reassembly->deadline = time + IPV4_REASSEMBLY_TIMEOUT;
+	}
+
+	//Fragments that disagree on where the datagram ends mean it is broken
+	uint32_t end = offset + size;
+	if((last && reassembly->length && reassembly->length != end) || (reassembly->length && end > reassembly->length)) {
+		release_reassembly(*reassembly);
+		m_reassembly_lock.unlock();
+		return nullptr;
+	}
+
+	if(last)
+		reassembly->length = end;
+
+	//Copy the payload in and mark the blocks it covers
+	memcpy(reassembly->packet->data() + offset, packet->data(), size);
+	for(uint32_t block = offset / 8; block < (end + 7) / 8; block++) {
+		uint64_t bit = 1ULL << (block % 64);
+		if(!(reassembly->blocks[block / 64] & bit)) {
+			reassembly->blocks[block / 64] |= bit;
+			reassembly->received_blocks++;
+		}
+	}
+
+	//Wait for the rest (blocks past the end could have been counted before the last fragment arrived so check for gaps)
+	uint32_t needed = (reassembly->length + 7) / 8;
+	bool complete = reassembly->length && reassembly->received_blocks >= needed;
+	for(uint32_t block = 0; complete && block < needed; block++)
+		complete = reassembly->blocks[block / 64] & (1ULL << (block % 64));
+
+	if(!complete) {
+		m_reassembly_lock.unlock();
+		return nullptr;
+	}
+
+	PacketBuffer* datagram = reassembly->packet;
+	datagram->trim(reassembly->length);
+	reassembly->packet = nullptr;
+	reassembly->active = false;
+	m_statistics.reassembled++;
+
+	m_reassembly_lock.unlock();
+	return datagram;
+}
+
+/**
+ * @brief Give up on a datagram being reassembled, the reassembly lock must be held
+ *
+ * @param reassembly The datagram
+ */
+void InternetProtocolHandler::release_reassembly(ipv4_reassembly_t& reassembly) {
+
+	if(reassembly.packet)
+		reassembly.packet->release();
+
+	reassembly.packet = nullptr;
+	reassembly.active = false;
+	m_statistics.reassembly_failed++;
+}
+
+/**
+ * @brief Get the next identifier for a datagram. Each destination (and protocol) hashes to one of a set of counters so
+ * identifiers to one destination don't repeat quickly and can't be used to count the traffic to others (RFC 6864)
+ *
+ * @param destination_ip The destination IP address
+ * @param protocol The protocol of the payload
+ * @return The identifier (host order)
+ */
+uint16_t InternetProtocolHandler::next_identifier(InternetProtocolAddress destination_ip, uint8_t protocol) {
+
+	static uint64_t secret = 0;
+	if(!secret)
+		secret = hash_mix(CPU::read_timestamp()) | 1;
+
+	// The counters start from a different place for each destination
+	uint64_t hash = hash_mix(((uint64_t) destination_ip << 8 | protocol) ^ secret);
+	uint32_t count = __atomic_fetch_add(&s_identifiers[hash % IPV4_IDENTIFIER_BUCKETS], 1, __ATOMIC_RELAXED);
+	return (uint16_t) (count + (hash >> 48));
+}
+
+/**
+ * @brief Get the time used for reassembly timeouts
+ *
+ * @return Milliseconds since the clock started
+ */
+uint64_t InternetProtocolHandler::now() {
+
+	Clock* clock = Clock::active_clock();
+	return clock ? clock->uptime() : 0;
+}
+
+/**
+ * @brief Creates a checksum for the given data.
+ *
+ * @param data The data to create a checksum for.
+ * @param length_in_bytes The length of the data in bytes.
+ * @return The checksum.
+ */
+uint16_t InternetProtocolHandler::checksum(const uint16_t* data, uint32_t length_in_bytes) {
+	return InternetChecksum::compute(data, length_in_bytes);
 }
 
 /**
@@ -346,6 +650,15 @@ InternetProtocolAddress InternetProtocolHandler::get_internet_protocol_address()
 	return own_internet_protocol_address;
 }
 
+/**
+ * @brief Gets the packet counters, including fragmentation and reassembly.
+ *
+ * @return The statistics.
+ */
+const ipv4_statistics_t& InternetProtocolHandler::statistics() const {
+	return m_statistics;
+}
+
 /**
  * @brief Gets the MAC address of this device.
  *
@@ -0,0 +1,348 @@
+/**
+ * @file packetbuffer.cpp
+ * @brief Implementation of the PacketBuffer and PacketBufferPool classes
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+ */
+
+#include <net/packetbuffer.h>
+#include <memory/physical.h>
+#include <memory/memoryIO.h>
+
+using namespace MaxOS;
+using namespace MaxOS::common;
+using namespace MaxOS::memory;
+using namespace MaxOS::net;
+
+PacketBuffer::PacketBuffer() = default;
+
+PacketBuffer::~PacketBuffer() = default;
+
+/**
+ * @brief Get the start of the data currently in the buffer (the outermost header)
+ *
+ * @return A pointer to the data
+ */
+uint8_t* PacketBuffer::data() const {
+	return m_memory + m_head;
+}
+
+/**
+ * @brief Get the physical address of the data, for giving to a device
+ *
+ * @return The physical address of the data
+ */
+uintptr_t PacketBuffer::physical_address() const {
+	return m_physical_address + m_head;
+}
+
+/**
+ * @brief Get how many bytes of data are in the buffer
+ *
+ * @return The length of the data
+ */
+size_t PacketBuffer::length() const {
+	return m_tail - m_head;
+}
+
+/**
+ * @brief Check if the buffer came from the pool, only those can be given to a NIC
+ *
+ * @return True if the buffer is from the pool, false if it is a large buffer
+ */
+bool PacketBuffer::pooled() const {
+	return m_pooled;
+}
+
+/**
+ * @brief Get how much space is free in front of the data
+ *
+ * @return The free space in bytes
+ */
+size_t PacketBuffer::headroom() const {
+	return m_head;
+}
+
+/**
+ * @brief Get how much space is free after the data
+ *
+ * @return The free space in bytes
+ */
+size_t PacketBuffer::tailroom() const {
+	return m_capacity - m_tail;
+}
+
+/**
+ * @brief Grow the data backwards to make room for a header
+ *
+ * @param size The size of the header
+ * @return Where the header should be written or nullptr if there isn't enough headroom
+ */
+uint8_t* PacketBuffer::prepend(size_t size) {
+
+	if(size > m_head)
+		return nullptr;
+
+	m_head -= size;
+	return data();
+}
+
+/**
+ * @brief Grow the data forwards to make room for more of the payload
+ *
+ * @param size How many bytes to add
+ * @return Where the new bytes should be written or nullptr if there isn't enough tailroom
+ */
+uint8_t* PacketBuffer::append(size_t size) {
+
+	if(size > tailroom())
+		return nullptr;
+
+	uint8_t* end = m_memory + m_tail;
+	m_tail += size;
+	return end;
+}
+
+/**
+ * @brief Remove a header from the front of the data once it has been handled
+ *
+ * @param size The size of the header
+ * @return The start of the data after the header or nullptr if the data is shorter than the header
+ */
+uint8_t* PacketBuffer::pull(size_t size) {
+
+	if(size > length())
+		return nullptr;
+
+	m_head += size;
+	return data();
+}
+
+/**
+ * @brief Cut the data down to a length, removing any padding or trailers
+ *
+ * @param length The new length (ignored if longer than the current length)
+ */
+void PacketBuffer::trim(size_t length) {
+
+	if(length < this->length())
+		m_tail = m_head + length;
+}
+
+/**
+ * @brief Empty the buffer
+ *
+ * @param headroom Where the data should start
+ */
+void PacketBuffer::reset(size_t headroom) {
+
+	if(headroom > m_capacity)
+		headroom = m_capacity;
+
+	m_head = headroom;
+	m_tail = headroom;
+	m_checksum_pending = false;
+}
+
+/**
+ * @brief Return the buffer to the pool
+ */
+void PacketBuffer::release() {
+	PacketBufferPool::free(this);
+}
+
+/**
+ * @brief Leave a TCP or UDP checksum for the NIC to fill in (or the driver if the NIC can't)
+ *
+ * @param start Where the checksummed data starts, from the start of the data
+ * @param offset Where the checksum field is, from start
+ *
+ * @note The field must hold the folded pseudo header sum, the position is kept as headers are prepended in front of it
+ */
+void PacketBuffer::request_checksum(size_t start, uint16_t offset) {
+
+	m_checksum_pending = true;
+	m_checksum_start = m_head + start;
+	m_checksum_offset = offset;
+}
+
+/**
+ * @brief Mark the checksum as filled in
+ */
+void PacketBuffer::clear_checksum() {
+	m_checksum_pending = false;
+}
+
+/**
+ * @brief Check if a checksum still has to be filled in
+ *
+ * @return True if request_checksum() was called and the checksum hasn't been filled in
+ */
+bool PacketBuffer::checksum_pending() const {
+	return m_checksum_pending;
+}
+
+/**
+ * @brief Get where the checksummed data starts
+ *
+ * @return The offset from the start of the data
+ */
+size_t PacketBuffer::checksum_start() const {
+	return m_checksum_start - m_head;
+}
+
+/**
+ * @brief Get where the checksum field is
+ *
+ * @return The offset from checksum_start()
+ */
+uint16_t PacketBuffer::checksum_offset() const {
+	return m_checksum_offset;
+}
+
+/**
+ * @brief Allocate the memory for every buffer in the pool
+ */
+void PacketBufferPool::initialise() {
+
+	// One contiguous area so each buffer's physical address is known without a lookup, below 4GB as some cards only take 32 bit addresses
+	auto physical = (uintptr_t) PhysicalMemoryManager::s_current_manager->allocate_area(0, PACKET_BUFFER_SIZE * PACKET_BUFFER_POOL_SIZE, DMA_32_BIT_LIMIT);
+	auto* memory = (uint8_t*) PhysicalMemoryManager::to_dm_region(physical);
+	s_buffers = new PacketBuffer[PACKET_BUFFER_POOL_SIZE];
+
+	// Chain them into the free list
+	for(size_t i = 0; i < PACKET_BUFFER_POOL_SIZE; ++i) {
+		s_buffers[i].m_memory = memory + i * PACKET_BUFFER_SIZE;
+		s_buffers[i].m_physical_address = physical + i * PACKET_BUFFER_SIZE;
+		s_buffers[i].m_next_free = i + 1 < PACKET_BUFFER_POOL_SIZE ? &s_buffers[i + 1] : nullptr;
+	}
+
+	s_free = &s_buffers[0];
+	s_available = PACKET_BUFFER_POOL_SIZE;
+	s_lock.enable_statistics("packet buffers");
+}
+
+/**
+ * @brief Take an empty buffer from the pool
+ *
+ * @param headroom How much space to leave in front of the data for headers
+ * @return The buffer or nullptr if the pool is empty
+ */
+PacketBuffer* PacketBufferPool::allocate(size_t headroom) {
+
+	s_lock.lock();
+
+	if(!s_buffers)
+		initialise();
+
+	// Pool is exhausted
+	PacketBuffer* buffer = s_free;
+	if(!buffer) {
+		s_lock.unlock();
+		return nullptr;
+	}
+
+	s_free = buffer->m_next_free;
+	s_available--;
+	s_lock.unlock();
+
+	buffer->m_next_free = nullptr;
+	buffer->reset(headroom);
+	return buffer;
+}
+
+/**
+ * @brief Take a buffer from the pool and fill it with data
+ *
+ * @param data The data to copy in
+ * @param size The size of the data
+ * @param headroom How much space to leave in front of the data for headers
+ * @return The buffer or nullptr if the pool is empty or the data is too large
+ */
+PacketBuffer* PacketBufferPool::allocate(const uint8_t* data, size_t size, size_t headroom) {
+
+	PacketBuffer* buffer = allocate(headroom);
+	if(!buffer)
+		return nullptr;
+
+	// Too big
+	uint8_t* destination = buffer->append(size);
+	if(!destination) {
+		free(buffer);
+		return nullptr;
+	}
+
+	memcpy(destination, data, size);
+	return buffer;
+}
+
+/**
+ * @brief Allocate a buffer from the heap for a datagram bigger than a pool buffer can hold
+ *
+ * @param size How much data the buffer must hold
+ * @param headroom How much space to leave in front of the data for headers
+ * @return The buffer or nullptr if it is too large
+ */
+PacketBuffer* PacketBufferPool::allocate_large(size_t size, size_t headroom) {
+
+	if(size > PACKET_BUFFER_MAX_LARGE)
+		return nullptr;
+
+	auto* buffer = new PacketBuffer;
+	buffer->m_capacity = headroom + size;
+	buffer->m_memory = new uint8_t[buffer->m_capacity];
+	buffer->m_pooled = false;
+	buffer->reset(headroom);
+	return buffer;
+}
+
+/**
+ * @brief Allocate a buffer from the heap and fill it with data
+ *
+ * @param data The data to copy in
+ * @param size The size of the data
+ * @param headroom How much space to leave in front of the data for headers
+ * @return The buffer or nullptr if the data is too large
+ */
+PacketBuffer* PacketBufferPool::allocate_large(const uint8_t* data, size_t size, size_t headroom) {
+
+	PacketBuffer* buffer = allocate_large(size, headroom);
+	if(!buffer)
+		return nullptr;
+
+	memcpy(buffer->append(size), data, size);
+	return buffer;
+}
+
+/**
+ * @brief Return a buffer to the pool (or the heap for large buffers)
+ *
+ * @param buffer The buffer to free
+ */
+void PacketBufferPool::free(PacketBuffer* buffer) {
+
+	if(!buffer)
+		return;
+
+	if(!buffer->m_pooled) {
+		delete[] buffer->m_memory;
+		delete buffer;
+		return;
+	}
+
+	s_lock.lock();
+	buffer->m_next_free = s_free;
+	s_free = buffer;
+	s_available++;
+	s_lock.unlock();
+}
+
+/**
+ * @brief Get how many buffers are free
+ *
+ * @return The number of free buffers
+ */
+size_t PacketBufferPool::available() {
+	return s_available;
+}
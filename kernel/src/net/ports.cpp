@@ -0,0 +1,82 @@
+/**
+ * @file ports.cpp
+ * @brief Implementation of the PortAllocator class
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+ */
+
+#include <net/ports.h>
+
+using namespace MaxOS;
+using namespace MaxOS::net;
+
+PortAllocator::PortAllocator() = default;
+
+PortAllocator::~PortAllocator() = default;
+
+/**
+ * @brief Check if a port is in use
+ *
+ * @param port The port (host order)
+ * @return True if the port has been reserved or allocated
+ */
+bool PortAllocator::in_use(uint16_t port) const {
+	return m_used[port / 64] & (1ULL << (port % 64));
+}
+
+/**
+ * @brief Mark a port as in use
+ *
+ * @param port The port (host order)
+ * @return True if the port was free, false if it is already in use
+ */
+bool PortAllocator::reserve(uint16_t port) {
+
+	if (!port || in_use(port))
+		return false;
+
+	m_used[port / 64] |= 1ULL << (port % 64);
+	return true;
+}
+
+/**
+ * @brief Mark a port as free
+ *
+ * @param port The port (host order)
+ */
+void PortAllocator::release(uint16_t port) {
+	m_used[port / 64] &= ~(1ULL << (port % 64));
+}
+
+/**
+ * @brief Reserve the next free ephemeral port, starting after the last one handed out so recently closed ports aren't reused straight away
+ *
+ * @return The port (host order), or 0 if every ephemeral port is in use
+ */
+uint16_t PortAllocator::allocate() {
+
+	constexpr uint32_t range = EPHEMERAL_PORT_LAST - EPHEMERAL_PORT_FIRST + 1;
+
+	uint32_t checked = 0;
+	uint16_t port = m_next;
+	while (checked < range) {
+
+		// Skip whole words that are full
+		if (port % 64 == 0 && m_used[port / 64] == UINT64_MAX && checked + 64 <= range) {
+			checked += 64;
+			port = port + 64 > EPHEMERAL_PORT_LAST ? EPHEMERAL_PORT_FIRST : port + 64;
+			continue;
+		}
+
+		if (reserve(port)) {
+			m_next = port == EPHEMERAL_PORT_LAST ? EPHEMERAL_PORT_FIRST : port + 1;
+			return port;
+		}
+
+		checked++;
+		port = port == EPHEMERAL_PORT_LAST ? EPHEMERAL_PORT_FIRST : port + 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,658 @@
+/**
+ * @file socketresource.cpp
+ * @brief Implementation of the SocketResource and SocketResourceRegistry classes
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+ */
+
+#include <net/socketresource.h>
+#include <memory/memoryIO.h>
+#include <processes/scheduler.h>
+
+using namespace MaxOS;
+using namespace MaxOS::net;
+using namespace MaxOS::common;
+using namespace MaxOS::processes;
+
+/**
+ * @brief Turn an error into the value returned by a read or write
+ *
+ * @param error The error
+ * @return The negative error code
+ */
+static inline int as_result(socket_error_t error) {
+	return -1 * (int) error;
+}
+
+/// The value returned when there is nothing to read or no space to write yet
+static const int SHOULD_BLOCK = -1 * (int) resource_error_base_t::SHOULD_BLOCK;
+
+/**
+ * @brief Get the process a socket opened now would belong to
+ *
+ * @return The pid of the current process, 0 for the kernel
+ */
+static uint64_t current_owner() {
+
+	Process* process = GlobalScheduler::current_process();
+	return process ? process->pid() : 0;
+}
+
+/**
+ * @brief Creates a new socket resource, the socket is given to it by the registry once it has been opened
+ *
+ * @param name The name of the resource
+ * @param flags Unused
+ * @param type The type of resource
+ * @param owner The pid of the process the socket belongs to
+ */
+SocketResource::SocketResource(const string& name, size_t flags, resource_type_t type, uint64_t owner)
+: Resource(name, flags, type),
+  m_registry(nullptr),
+  m_owner(owner)
+{
+
+}
+
+/**
+ * @brief Destroys the socket resource and frees anything that wasn't read
+ */
+SocketResource::~SocketResource() {
+
+	delete[] m_receive_buffer;
+	for(auto& datagram : m_datagrams)
+		delete datagram;
+}
+
+/**
+ * @brief Get the process the socket belongs to
+ *
+ * @return The pid of the owner
+ */
+uint64_t SocketResource::owner() const {
+	return m_owner;
+}
+
+/**
+ * @brief Give the resource a TCP socket to expose
+ *
+ * @param registry The registry the resource is in
+ * @param socket The socket
+ * @param listening Is the socket listening for connections
+ */
+void SocketResource::attach(SocketResourceRegistry* registry, TCPSocket* socket, bool listening) {
+
+	m_registry = registry;
+	m_tcp_socket = socket;
+	m_listening = listening;
+
+	if(!listening)
+		m_receive_buffer = new uint8_t[SOCKET_RECEIVE_BUFFER_SIZE];
+
+	// Only let the remote end send what there is room to queue. Connections accepted by a listener start with its space
+	// (less anything that came with the connection), so only sockets opened by this end are given it here
+	if(listening || socket->current_state() == TCPSocketState::SYN_SENT)
+		socket->set_receive_space(SOCKET_RECEIVE_BUFFER_SIZE);
+
+	// The connection may have been made before the handler was bound
+	socket->connect_event_handler(this);
+	if(socket->current_state() == TCPSocketState::ESTABLISHED)
+		m_connected = true;
+}
+
+/**
+ * @brief Give the resource a UDP socket to expose
+ *
+ * @param registry The registry the resource is in
+ * @param socket The socket
+ * @param listening Is the socket waiting for the first datagram to learn its remote end
+ */
+void SocketResource::attach(SocketResourceRegistry* registry, UDPSocket* socket, bool listening) {
+
+	m_registry = registry;
+	m_udp_socket = socket;
+	m_listening = listening;
+	m_connected = !listening;
+
+	socket->connect_event_handler(this);
+}
+
+/**
+ * @brief Close the socket once no process has it open, connections that were never accepted are closed as well
+ *
+ * @param flags Unused
+ */
+void SocketResource::close(size_t flags) {
+
+	// Stop being told about the socket before the resource goes
+	if(m_tcp_socket) {
+		m_tcp_socket->disconnect_event_handler(this);
+		m_tcp_socket->disconnect();
+		m_tcp_socket = nullptr;
+	}
+
+	if(m_udp_socket) {
+		m_udp_socket->disconnect_event_handler(this);
+		m_udp_socket->disconnect();
+		m_udp_socket = nullptr;
+	}
+
+	// Take the connections still waiting to be accepted
+	m_lock.lock();
+	Vector<SocketResource*> backlog;
+	while(!m_backlog.empty())
+		backlog.push_back(m_backlog.pop_front());
+	m_lock.unlock();
+
+	for(auto& connection : backlog)
+		m_registry->discard(connection);
+}
+
+/**
+ * @brief Read from the socket
+ *
+ * @param buffer Where to read into
+ * @param size The size of the buffer
+ * @param flags The socket_flags_t bits, ACCEPT reads the name of a connection waiting on a listener
+ * @return The number of bytes read, 0 once the remote end has closed, SHOULD_BLOCK or a negative socket_error_t
+ */
+int SocketResource::read(void* buffer, size_t size, size_t flags) {
+
+	int result;
+	if(flags & (size_t) socket_flags_t::ACCEPT)
+		result = accept((uint8_t*) buffer, size);
+	else if(m_udp_socket)
+		result = read_datagram((uint8_t*) buffer, size);
+	else
+		result = read_stream((uint8_t*) buffer, size);
+
+	// Let the caller carry on with something else
+	if(result == SHOULD_BLOCK && (flags & (size_t) socket_flags_t::NON_BLOCKING))
+		return as_result(socket_error_t::WOULD_BLOCK);
+
+	return result;
+}
+
+/**
+ * @brief Read what has been received on a TCP connection
+ *
+ * @param buffer Where to read into
+ * @param size The size of the buffer
+ * @return The number of bytes read, 0 once the remote end has closed, SHOULD_BLOCK or a negative socket_error_t
+ */
+int SocketResource::read_stream(uint8_t* buffer, size_t size) {
+
+	if(m_listening)
+		return as_result(socket_error_t::NOT_CONNECTED);
+
+	m_lock.lock();
+
+	// Nothing received yet
+	if(!m_received) {
+		m_lock.unlock();
+		return m_closed || !m_tcp_socket ? 0 : SHOULD_BLOCK;
+	}
+
+	// Copy out of the ring, it may wrap round
+	uint32_t copied = size < m_received ? size : m_received;
+	uint32_t first = copied < SOCKET_RECEIVE_BUFFER_SIZE - m_receive_start ? copied : SOCKET_RECEIVE_BUFFER_SIZE - m_receive_start;
+	memcpy(buffer, m_receive_buffer + m_receive_start, first);
+	memcpy(buffer + first, m_receive_buffer, copied - first);
+
+	m_receive_start = (m_receive_start + copied) % SOCKET_RECEIVE_BUFFER_SIZE;
+	m_received -= copied;
+
+	m_lock.unlock();
+
+	// There is room for more, let the remote end know
+	if(m_tcp_socket)
+		m_tcp_socket->open_receive_window(copied);
+
+	return copied;
+}
+
+/**
+ * @brief Read the oldest datagram received on a UDP socket
+ *
+ * @param buffer Where to read into
+ * @param size The size of the buffer, the rest of a datagram that doesn't fit is lost
+ * @return The number of bytes read or SHOULD_BLOCK
+ */
+int SocketResource::read_datagram(uint8_t* buffer, size_t size) {
+
+	m_lock.lock();
+
+	// Nothing received yet
+	if(m_datagrams.empty()) {
+		m_lock.unlock();
+		return SHOULD_BLOCK;
+	}
+
+	buffer_t* datagram = m_datagrams.pop_front();
+	m_lock.unlock();
+
+	size_t copied = size < datagram->capacity() ? size : datagram->capacity();
+	memcpy(buffer, datagram->raw(), copied);
+	delete datagram;
+
+	return copied;
+}
+
+/**
+ * @brief Take a connection waiting on a listener
+ *
+ * @param buffer Where to write the name of the connection's resource
+ * @param size The size of the buffer
+ * @return The length of the name, SHOULD_BLOCK or a negative socket_error_t
+ */
+int SocketResource::accept(uint8_t* buffer, size_t size) {
+
+	if(!m_listening || !m_tcp_socket)
+		return as_result(socket_error_t::NOT_CONNECTED);
+
+	m_lock.lock();
+
+	// Nothing waiting
+	if(m_backlog.empty()) {
+		m_lock.unlock();
+		return SHOULD_BLOCK;
+	}
+
+	SocketResource* connection = m_backlog.pop_front();
+	m_lock.unlock();
+
+	// The process opens the connection by its name
+	string name = connection->name();
+	size_t length = size < name.length() ? size : name.length();
+	memcpy(buffer, name.c_str(), length);
+	return length;
+}
+
+/**
+ * @brief Write to the socket
+ *
+ * @param buffer The data to write
+ * @param size The size of the data
+ * @param flags The socket_flags_t bits
+ * @return The number of bytes written (TCP may take only part of the data), SHOULD_BLOCK or a negative socket_error_t
+ */
+int SocketResource::write(const void* buffer, size_t size, size_t flags) {
+
+	bool non_blocking = flags & (size_t) socket_flags_t::NON_BLOCKING;
+	auto* data = (uint8_t*) buffer;
+
+	// A listener has no remote end to write to
+	if(!m_connected && m_listening)
+		return as_result(socket_error_t::NOT_CONNECTED);
+
+	if(m_closed || (!m_tcp_socket && !m_udp_socket))
+		return as_result(socket_error_t::CLOSED);
+
+	// A datagram is sent whole
+	if(m_udp_socket) {
+		uint16_t datagram_size = size > UINT16_MAX ? UINT16_MAX : size;
+		m_udp_socket->send(data, datagram_size);
+		return datagram_size;
+	}
+
+	// Still connecting or the send ring is full
+	uint32_t space = m_connected ? m_tcp_socket->send_space() : 0;
+	if(!space)
+		return non_blocking ? as_result(socket_error_t::WOULD_BLOCK) : SHOULD_BLOCK;
+
+	// This end has already started closing
+	TCPSocketState state = m_tcp_socket->current_state();
+	if(state != TCPSocketState::ESTABLISHED && state != TCPSocketState::CLOSE_WAIT)
+		return as_result(socket_error_t::CLOSED);
+
+	// Only write what fits so the socket doesn't wait
+	uint32_t written = size < space ? size : space;
+	written = written < UINT16_MAX ? written : UINT16_MAX;
+	m_tcp_socket->send(data, written);
+	return written;
+}
+
+/**
+ * @brief Check what can be done with the socket without waiting
+ *
+ * @param events The resource_readiness_t bits being waited for
+ * @return The bits that are ready (CLOSED is always reported)
+ */
+size_t SocketResource::poll(size_t events) {
+
+	size_t ready = 0;
+
+	// Something to read (a closed socket reads the end of the stream)
+	m_lock.lock();
+	if(m_received || !m_datagrams.empty() || !m_backlog.empty() || m_closed)
+		ready |= (size_t) resource_readiness_t::READABLE;
+	m_lock.unlock();
+
+	// Space to write
+	if(m_connected && !m_closed && (m_udp_socket || (m_tcp_socket && m_tcp_socket->send_space())))
+		ready |= (size_t) resource_readiness_t::WRITABLE;
+
+	if(m_closed)
+		ready |= (size_t) resource_readiness_t::CLOSED;
+
+	return ready & (events | (size_t) resource_readiness_t::CLOSED);
+}
+
+/**
+ * @brief Queue data received on the TCP connection until it is read
+ *
+ * @param socket The socket the data was received on
+ * @param data The data
+ * @param size The size of the data
+ *
+ * @note The receive window of the socket is kept to the free space in the ring so everything acknowledged fits, anything
+ * that doesn't would be lost
+ */
+void SocketResource::handle_transmission_control_protocol_payload(TCPSocket* socket, uint8_t* data, uint16_t size) {
+
+	m_lock.lock();
+
+	uint32_t space = SOCKET_RECEIVE_BUFFER_SIZE - m_received;
+	uint32_t copied = size < space ? size : space;
+	uint32_t offset = (m_receive_start + m_received) % SOCKET_RECEIVE_BUFFER_SIZE;
+	uint32_t first = copied < SOCKET_RECEIVE_BUFFER_SIZE - offset ? copied : SOCKET_RECEIVE_BUFFER_SIZE - offset;
+	memcpy(m_receive_buffer + offset, data, first);
+	memcpy(m_receive_buffer, data + first, copied - first);
+	m_received += copied;
+
+	m_lock.unlock();
+	Resource::readiness_changed();
+
+	if(copied < size)
+		Logger::WARNING() << "Socket " << name() << " dropped " << (int) (size - copied) << " bytes, it isn't being read\n";
+}
+
+/**
+ * @brief Handle a connection being made, either the socket's own or one accepted by the listener
+ *
+ * @param socket The socket that connected
+ */
+void SocketResource::connected(TCPSocket* socket) {
+
+	if(socket == m_tcp_socket) {
+		m_connected = true;
+		Resource::readiness_changed();
+		return;
+	}
+
+	// A connection on a listener, turn it away if too many are already waiting
+	m_lock.lock();
+	bool full = m_backlog.size() >= SOCKET_MAX_BACKLOG;
+	m_lock.unlock();
+
+	if(full) {
+		socket->disconnect();
+		return;
+	}
+
+	// Queue it to be accepted
+	SocketResource* connection = m_registry->accept(socket, m_owner);
+	m_lock.lock();
+	m_backlog.push_back(connection);
+	m_lock.unlock();
+
+	Resource::readiness_changed();
+}
+
+/**
+ * @brief Handle the remote end closing the connection (or resetting it)
+ *
+ * @param socket The socket that disconnected
+ */
+void SocketResource::disconnected(TCPSocket* socket) {
+
+	if(socket != m_tcp_socket)
+		return;
+
+	m_closed = true;
+	Resource::readiness_changed();
+}
+
+/**
+ * @brief Handle the remote end acknowledging data, the socket can be written to again
+ *
+ * @param socket The socket that has room to send
+ */
+void SocketResource::space_available(TCPSocket* socket) {
+
+	if(socket == m_tcp_socket)
+		Resource::readiness_changed();
+}
+
+/**
+ * @brief Queue a datagram until it is read
+ *
+ * @param socket The socket the datagram was received on
+ * @param data The datagram
+ * @param size The size of the datagram
+ */
+void SocketResource::handle_user_datagram_protocol_message(UDPSocket* socket, uint8_t* data, uint16_t size) {
+
+	m_lock.lock();
+
+	// A listening socket replies to whoever sent the first datagram
+	m_connected = true;
+
+	// Too many waiting, drop it (UDP makes no promises)
+	if(m_datagrams.size() >= SOCKET_MAX_DATAGRAMS) {
+		m_lock.unlock();
+		return;
+	}
+
+	auto* datagram = new buffer_t(size);
+	datagram->copy_from(data, size);
+	m_datagrams.push_back(datagram);
+
+	m_lock.unlock();
+	Resource::readiness_changed();
+}
+
+/**
+ * @brief Construct a new Socket Resource Registry
+ *
+ * @param tcp The TCP handler to open TCP sockets on
+ * @param udp The UDP handler to open UDP sockets on
+ */
+SocketResourceRegistry::SocketResourceRegistry(TransmissionControlProtocolHandler* tcp, UserDatagramProtocolHandler* udp)
+: BaseResourceRegistry(resource_type_t::SOCKET),
+  m_tcp(tcp),
+  m_udp(udp)
+{
+
+}
+
+SocketResourceRegistry::~SocketResourceRegistry() = default;
+
+/**
+ * @brief Check that a string only holds digits (and up to a number of dots)
+ *
+ * @param text The string
+ * @param dots How many dots it must have
+ * @return True if it is made of digits and has exactly that many dots
+ */
+static bool is_numeric(const string& text, int dots) {
+
+	if(!text.length())
+		return false;
+
+	for(size_t i = 0; i < text.length(); i++) {
+		if(text[i] == '.')
+			dots--;
+		else if(text[i] < '0' || text[i] > '9')
+			return false;
+	}
+
+	return dots == 0;
+}
+
+/**
+ * @brief Open a new socket from a name of the form "tcp:IP:PORT" or "udp:IP:PORT"
+ *
+ * @param name The name
+ * @return The resource or nullptr if the name is invalid or the socket couldn't be opened
+ */
+Resource* SocketResourceRegistry::open_socket(const string& name) {
+
+	// Split up the name
+	Vector<string> parts = name.split(":");
+	if(parts.size() != 3 || !is_numeric(parts[1], 3) || !is_numeric(parts[2], 0) || parts[2].length() > 5)
+		return nullptr;
+
+	bool tcp = parts[0] == "tcp";
+	if(!tcp && parts[0] != "udp")
+		return nullptr;
+
+	uint32_t port = 0;
+	for(size_t i = 0; i < parts[2].length(); i++)
+		port = port * 10 + (parts[2][i] - '0');
+
+	if(!port || port > UINT16_MAX)
+		return nullptr;
+
+	// Each socket gets its own name
+	m_lock.lock();
+	uint64_t id = m_next_id++;
+	m_lock.unlock();
+	auto resource = new SocketResource(name + "#" + string(id), 0, resource_type_t::SOCKET, current_owner());
+
+	// No address means listen on the port
+	InternetProtocolAddress address = InternetProtocolHandler::parse(parts[1]);
+	bool listening = address == 0;
+	bool opened = false;
+	if(tcp) {
+		TCPSocket* socket = listening ? m_tcp->listen(port) : m_tcp->connect(address, port);
+		if((opened = socket))
+			resource->attach(this, socket, listening);
+	} else {
+		UDPSocket* socket = listening ? m_udp->listen(port) : m_udp->connect(address, port);
+		if((opened = socket))
+			resource->attach(this, socket, listening);
+	}
+
+	// Couldn't open the socket (e.g. the port is in use)
+	if(!opened || !register_resource(resource)) {
+		resource->close(0);
+		delete resource;
+		return nullptr;
+	}
+
+	// The process opening it is the first user
+	m_lock.lock();
+	Resource* opened_resource = BaseResourceRegistry::get_resource(resource->name());
+	m_lock.unlock();
+
+	return opened_resource;
+}
+
+/**
+ * @brief Get a socket that has already been opened (e.g. an accepted connection) or open a new one
+ *
+ * @param name The name of the socket
+ * @return The resource or nullptr if the socket couldn't be opened or belongs to another process
+ */
+Resource* SocketResourceRegistry::get_resource(const string& name) {
+
+	m_lock.lock();
+
+	// The names are easy to guess, only the owner can open the socket again
+	auto existing = m_resources.find(name);
+	if(existing != m_resources.end() && ((SocketResource*) existing->second)->owner() != current_owner()) {
+		m_lock.unlock();
+		return nullptr;
+	}
+
+	Resource* resource = BaseResourceRegistry::get_resource(name);
+	m_lock.unlock();
+
+	if(resource)
+		return resource;
+
+	return open_socket(name);
+}
+
+/**
+ * @brief Registers a socket in the registry
+ *
+ * @param resource The socket
+ * @return True if the register was successful, false if the name is in use
+ */
+bool SocketResourceRegistry::register_resource(Resource* resource) {
+
+	m_lock.lock();
+	bool registered = BaseResourceRegistry::register_resource(resource);
+	m_lock.unlock();
+
+	return registered;
+}
+
+/**
+ * @brief Close a socket once no process is using it
+ *
+ * @param resource The socket
+ * @param flags Passed on to the socket
+ */
+void SocketResourceRegistry::close_resource(Resource* resource, size_t flags) {
+
+	m_lock.lock();
+
+	// Resource isn't stored in this registry
+	if(m_resources.find(resource->name()) == m_resources.end()) {
+		m_lock.unlock();
+		return;
+	}
+
+	// Still being used
+	if(--m_resource_uses[resource->name()]) {
+		m_lock.unlock();
+		return;
+	}
+
+	m_resources.erase(resource->name());
+	m_resource_uses.erase(resource->name());
+	m_lock.unlock();
+
+	// Closing a listener discards its backlog so it can't be done under the lock
+	resource->close(flags);
+	delete resource;
+}
+
+/**
+ * @brief Register a connection accepted by a listener so that a process can open it
+ *
+ * @param socket The connection
+ * @param owner The pid of the process that owns the listener
+ * @return The resource for the connection
+ */
+SocketResource* SocketResourceRegistry::accept(TCPSocket* socket, uint64_t owner) {
+
+	m_lock.lock();
+	uint64_t id = m_next_id++;
+	m_lock.unlock();
+
+	auto resource = new SocketResource(string("tcp#") + string(id), 0, resource_type_t::SOCKET, owner);
+	resource->attach(this, socket, false);
+	register_resource(resource);
+	return resource;
+}
+
+/**
+ * @brief Close a socket that no process ever opened (a connection that was never accepted)
+ *
+ * @param resource The socket
+ */
+void SocketResourceRegistry::discard(SocketResource* resource) {
+
+	m_lock.lock();
+	m_resources.erase(resource->name());
+	m_resource_uses.erase(resource->name());
+	m_lock.unlock();
+
+	resource->close(0);
+	delete resource;
+}
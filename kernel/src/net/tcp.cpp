@@ -8,12 +8,22 @@
 
 #include <net/tcp.h>
 #include "net/udp.h"
+#include <drivers/clock/clock.h>
+#include <processes/scheduler.h>
+#include <system/cpu.h>
+#include <memory/memoryIO.h>
+#include <hardwarecommunication/interrupts.h>
+#include <net/checksum.h>
 
 
 using namespace MaxOS;
 using namespace MaxOS::net;
 using namespace MaxOS::common;
 using namespace MaxOS::memory;
+using namespace MaxOS::drivers::clock;
+using namespace MaxOS::processes;
+using namespace MaxOS::system;
+using namespace MaxOS::hardwarecommunication;
 
 ///__Handler__///
 
@@ -41,6 +51,15 @@ void TCPPayloadHandler::connected(TCPSocket* socket) {
 
 }
 
+/**
+ * @brief Handle data sent on the socket being acknowledged, there is room to send more
+ *
+ * @param socket The socket that has room to send
+ */
+void TCPPayloadHandler::space_available(TCPSocket* socket) {
+
+}
+
 /**
  * @brief Handle a TCP disconnection on the socket
  *
@@ -70,11 +89,36 @@ Event<TCPPayloadHandlerEvents>* TCPPayloadHandler::on_event(Event<TCPPayloadHand
 			                                             ((DataReceivedEvent*) event)->data,
 			                                             ((DataReceivedEvent*) event)->size);
 			break;
+		case TCPPayloadHandlerEvents::SPACE_AVAILABLE:
+			space_available(((SpaceAvailableEvent*) event)->socket);
+			break;
 	}
 
 	return event;
 }
 
+/**
+ * @brief Check if a sequence number comes before another (allowing for wrap around)
+ *
+ * @param a The first sequence number
+ * @param b The second sequence number
+ * @return True if a is before b
+ */
+static inline bool sequence_before(uint32_t a, uint32_t b) {
+	return (int32_t) (a - b) < 0;
+}
+
+/**
+ * @brief Check if a sequence number comes after another (allowing for wrap around)
+ *
+ * @param a The first sequence number
+ * @param b The second sequence number
+ * @return True if a is after b
+ */
+static inline bool sequence_after(uint32_t a, uint32_t b) {
+	return (int32_t) (a - b) > 0;
+}
+
 /**
  * @brief Construct a new TCP Socket object
  *
@@ -88,7 +132,69 @@ TCPSocket::TCPSocket(TransmissionControlProtocolHandler* transmission_control_pr
 	state = TCPSocketState::CLOSED;
 }
 
-TCPSocket::~TCPSocket() = default;
+TCPSocket::~TCPSocket() {
+	free_buffers();
+}
+
+/**
+ * @brief Allocate the send and receive rings, done once the socket is part of a connection
+ */
+void TCPSocket::allocate_buffers() {
+
+	if(send_buffer == nullptr)
+		send_buffer = new uint8_t[TCP_SEND_BUFFER_SIZE];
+
+	if(receive_buffer == nullptr)
+		receive_buffer = new uint8_t[TCP_RECEIVE_BUFFER_SIZE];
+
+	send_buffer_start = 0;
+	send_buffered = 0;
+	receive_buffer_start = 0;
+	out_of_order_count = 0;
+}
+
+/**
+ * @brief Free the send and receive rings
+ */
+void TCPSocket::free_buffers() {
+
+	delete[] send_buffer;
+	delete[] receive_buffer;
+	send_buffer = nullptr;
+	receive_buffer = nullptr;
+}
+
+/**
+ * @brief Get how much has been sent but not acknowledged
+ *
+ * @return The number of bytes (SYN and FIN count as one)
+ */
+uint32_t TCPSocket::flight_size() const {
+	return highest_sent - unacknowledged;
+}
+
+/**
+ * @brief Get how much the remote end can send past acknowledgement_number
+ *
+ * @return The window in bytes
+ */
+uint32_t TCPSocket::receive_window() const {
+
+	// Data is passed to the handlers as soon as it is in order so the whole ring is free from acknowledgement_number, but
+	// the handlers may not have room for that much
+	return receive_space < TCP_RECEIVE_BUFFER_SIZE ? receive_space : TCP_RECEIVE_BUFFER_SIZE;
+}
+
+/**
+ * @brief Get the window to put in the segments sent by this end
+ *
+ * @return The scaled window
+ */
+uint16_t TCPSocket::advertised_window() const {
+
+	uint32_t window = receive_window() >> receive_window_scale;
+	return window > UINT16_MAX ? UINT16_MAX : window;
+}
 
 /**
  * @brief Handle the TCP message (socket end)
@@ -98,26 +204,114 @@ TCPSocket::~TCPSocket() = default;
  * @return True if the connection is to be terminated after hadnling or false if not
  */
 bool TCPSocket::handle_transmission_control_protocol_payload(uint8_t* data, uint16_t size) {
-	auto* event = new DataReceivedEvent(this, data, size);
-	raise_event(event);
-	MemoryManager::kfree(event);
+	raise_event(new DataReceivedEvent(this, data, size));
 	return true;
 }
 
 /**
- * @brief send data over the socket
+ * @brief Get the key the socket is looked up by once it has a remote end
+ *
+ * @return The addresses and ports of the connection
+ */
+ConnectionKey TCPSocket::connection_key() const {
+	return { local_ip, remote_ip, local_port, remotePort };
+}
+
+/**
+ * @brief Get the state of the connection
+ *
+ * @return The state
+ */
+TCPSocketState TCPSocket::current_state() const {
+	return state;
+}
+
+/**
+ * @brief Get how much can be written without waiting for the remote end to acknowledge data
+ *
+ * @return The free space in the send ring in bytes
+ */
+uint32_t TCPSocket::send_space() const {
+	return send_buffer ? TCP_SEND_BUFFER_SIZE - send_buffered : 0;
+}
+
+/**
+ * @brief Limit the receive window to how much the handlers have room for, the space is used up as data is passed to them
+ * and given back with open_receive_window()
+ *
+ * @param space How many bytes the handlers can take
+ */
+void TCPSocket::set_receive_space(uint32_t space) {
+
+	transmission_control_protocol_handler->m_lock.lock();
+	receive_space = space < UINT32_MAX ? space : UINT32_MAX - 1;
+	transmission_control_protocol_handler->m_lock.unlock();
+}
+
+/**
+ * @brief Give space back to the receive window once the handlers have made room, the remote end is told once the window
+ * has opened by a segment (smaller updates would only get smaller segments sent, RFC 1122 4.2.3.3)
+ *
+ * @param size How many bytes the handlers have made room for
+ */
+void TCPSocket::open_receive_window(uint32_t size) {
+
+	TransmissionControlProtocolHandler* handler = transmission_control_protocol_handler;
+	handler->m_lock.lock();
+
+	if(receive_space != UINT32_MAX)
+		receive_space = size < UINT32_MAX - 1 - receive_space ? receive_space + size : UINT32_MAX - 1;
+
+	bool receiving = state == TCPSocketState::ESTABLISHED || state == TCPSocketState::FIN_WAIT1 || state == TCPSocketState::FIN_WAIT2;
+	uint32_t edge = acknowledgement_number + ((uint32_t) advertised_window() << receive_window_scale);
+	uint32_t threshold = maximum_segment_size < TCP_RECEIVE_BUFFER_SIZE / 2 ? maximum_segment_size : TCP_RECEIVE_BUFFER_SIZE / 2;
+	if(receiving && sequence_after(edge, advertised_edge) && edge - advertised_edge >= threshold)
+		handler->send_segment(this, sequence_number, 0, (uint16_t) TCPFlag::ACK);
+
+	handler->unlock_and_transmit();
+}
+
+/**
+ * @brief send data over the socket, the data is copied into the send ring and sent as the window allows
  *
  * @param data The data to send
  * @param size The size of the data
+ *
+ * @note Sleeps while the connection is being made and while the send ring is full, so must be called from a thread
  */
 void TCPSocket::send(uint8_t* data, uint16_t size) {
-	//Wait for the socket to be connected
-	while(state != TCPSocketState::ESTABLISHED);
 
-	//Pass the data to the backend
-	transmission_control_protocol_handler->send_transmission_control_protocol_packet(this, data, size,
-	                                                                                 (uint16_t) TCPFlag::PSH |
-	                                                                                 (uint16_t) TCPFlag::ACK);
+	TransmissionControlProtocolHandler* handler = transmission_control_protocol_handler;
+	while(size) {
+
+		handler->m_lock.lock();
+
+		//Wait for the socket to be connected or for the remote end to acknowledge some of the ring (the lock is released while waiting)
+		uint32_t space = TCP_SEND_BUFFER_SIZE - send_buffered;
+		if(state == TCPSocketState::SYN_SENT || state == TCPSocketState::SYN_RECEIVED || ((state == TCPSocketState::ESTABLISHED || state == TCPSocketState::CLOSE_WAIT) && !space && !fin_queued)) {
+			send_waiters.wait(handler->m_lock);
+			continue;
+		}
+
+		if((state != TCPSocketState::ESTABLISHED && state != TCPSocketState::CLOSE_WAIT) || fin_queued) {
+			handler->m_lock.unlock();
+			return;
+		}
+
+		//Copy as much as fits into the ring, it stays there until it is acknowledged
+		uint32_t copied = size < space ? size : space;
+		uint32_t offset = (send_buffer_start + send_buffered) % TCP_SEND_BUFFER_SIZE;
+		uint32_t first = copied < TCP_SEND_BUFFER_SIZE - offset ? copied : TCP_SEND_BUFFER_SIZE - offset;
+		memcpy(send_buffer + offset, data, first);
+		memcpy(send_buffer, data + first, copied - first);
+		send_buffered += copied;
+
+		handler->output(this);
+		handler->unlock_and_transmit();
+
+		data += copied;
+		size -= copied;
+	}
 }
 
 /**
@@ -131,28 +325,29 @@ void TCPSocket::disconnect() {
  * @brief Raise the disconnected event
  */
 void TCPSocket::disconnected() {
-	auto* event = new DisconnectedEvent(this);
-	raise_event(event);
-	MemoryManager::kfree(event);
-
+	raise_event(new DisconnectedEvent(this));
 }
 
 /**
  * @brief Raise the connected event
  */
 void TCPSocket::connected() {
-	auto* event = new ConnectedEvent(this);
-	raise_event(event);
-	MemoryManager::kfree(event);
+	raise_event(new ConnectedEvent(this));
+}
 
+/**
+ * @brief Raise the space available event
+ */
+void TCPSocket::space_available() {
+	raise_event(new SpaceAvailableEvent(this));
 }
 
 ///__Handler__///
 
-TransmissionControlProtocolPort TransmissionControlProtocolHandler::free_ports = 0x8000;
+PortAllocator TransmissionControlProtocolHandler::ports;
 
 /**
- * @brief Construct a new Transmission Control Protocol Handler object
+ * @brief Construct a new Transmission Control Protocol Handler object, starts the retransmission timer worker once there is a scheduler
  *
  * @param internet_protocol_handler The Internet protocol handler
  * @param error_messages Where to write error messages
@@ -160,7 +355,14 @@ TransmissionControlProtocolPort TransmissionControlProtocolHandler::free_ports =
 TransmissionControlProtocolHandler::TransmissionControlProtocolHandler(MaxOS::net::InternetProtocolHandler* internet_protocol_handler, OutputStream* error_messages)
 		: IPV4PayloadHandler(internet_protocol_handler, 0x06) {
 	this->error_messages = error_messages;
+	m_lock.enable_statistics("tcp");
+
+	if(!GlobalScheduler::system_scheduler())
+		return;
 
+	TransmissionControlProtocolHandler* args[] = { this };
+	auto* worker = new Process("TCP Timer", (void (*)(void*)) (uintptr_t) timer_worker, args, 1, true);
+	GlobalScheduler::system_scheduler()->add_process(worker);
 }
 
 TransmissionControlProtocolHandler::~TransmissionControlProtocolHandler() = default;
@@ -189,290 +391,914 @@ uint32_t big_endian_16(uint16_t x) {
 	       | ((x & 0x00FF) << 8);
 }
 
+/**
+ * @brief Get the time used for the retransmission timers
+ *
+ * @return Milliseconds since the clock started
+ */
+uint64_t TransmissionControlProtocolHandler::now() {
+
+	Clock* clock = Clock::active_clock();
+	return clock ? clock->uptime() : 0;
+}
+
+/**
+ * @brief Pick the first sequence number of a connection, a clock plus a keyed hash of the addresses so that it can't be guessed (RFC 6528)
+ *
+ * @param key The addresses and ports of the connection
+ * @return The initial sequence number
+ */
+uint32_t TransmissionControlProtocolHandler::initial_sequence_number(const ConnectionKey& key) {
+
+	static uint64_t secret = 0;
+	if(!secret)
+		secret = hash_mix(CPU::read_timestamp()) | 1;
+
+	// The clock part ticks every 4 microseconds
+	return (uint32_t) (now() * 250) + (uint32_t) hash_mix(Hasher<ConnectionKey>::hash(key) ^ secret);
+}
+
+/**
+ * @brief Set up the send side of a socket that is opening a connection
+ *
+ * @param socket The socket, its addresses and ports must be set
+ */
+void TransmissionControlProtocolHandler::start(TCPSocket* socket) {
+
+	socket->allocate_buffers();
+
+	socket->initial_sequence_number = initial_sequence_number(socket->connection_key());
+	socket->unacknowledged = socket->initial_sequence_number;
+	socket->sequence_number = socket->initial_sequence_number + 1;
+	socket->highest_sent = socket->sequence_number;
+	socket->recover = socket->initial_sequence_number;
+	socket->fin_queued = false;
+	socket->fin_sent = false;
+
+	socket->congestion_window = TCP_INITIAL_WINDOW * socket->maximum_segment_size;
+	socket->slow_start_threshold = UINT32_MAX;
+	socket->retransmission_timeout = TCP_INITIAL_RTO;
+	socket->retransmit_deadline = now() + socket->retransmission_timeout;
+	socket->retransmits = 0;
+}
+
+/**
+ * @brief Read the options in a SYN segment
+ *
+ * @param socket The socket the segment is for
+ * @param header The header of the segment
+ */
+void TransmissionControlProtocolHandler::parse_options(TCPSocket* socket, const tcp_header_t* header) {
+
+	socket->maximum_segment_size = TCP_DEFAULT_MSS;
+	socket->send_window_scale = 0;
+	socket->receive_window_scale = 0;
+
+	auto* options = (const uint8_t*) header + sizeof(tcp_header_t);
+	uint32_t size = header->header_size_32 * 4 - sizeof(tcp_header_t);
+	for(uint32_t i = 0; i < size;) {
+
+		auto kind = (TCPOption) options[i];
+		if(kind == TCPOption::END)
+			break;
+
+		if(kind == TCPOption::NOP) {
+			i++;
+			continue;
+		}
+
+		// Every other option has a length (which includes the kind and length bytes)
+		if(i + 1 >= size || options[i + 1] < 2 || i + options[i + 1] > size)
+			break;
+
+		if(kind == TCPOption::MAXIMUM_SEGMENT_SIZE && options[i + 1] == 4) {
+			uint16_t mss = (options[i + 2] << 8) | options[i + 3];
+			socket->maximum_segment_size = mss > TCP_MAX_MSS ? TCP_MAX_MSS : mss;
+		}
+
+		// Scaling is only used if both ends offer it
+		if(kind == TCPOption::WINDOW_SCALE && options[i + 1] == 3) {
+			socket->send_window_scale = options[i + 2] > 14 ? 14 : options[i + 2];
+			socket->receive_window_scale = TCP_WINDOW_SCALE;
+		}
+
+		i += options[i + 1];
+	}
+
+	if(!socket->maximum_segment_size)
+		socket->maximum_segment_size = TCP_DEFAULT_MSS;
+
+	// RFC 6928 initial window
+	uint32_t limit = 2 * socket->maximum_segment_size > 14600 ? 2 * socket->maximum_segment_size : 14600;
+	socket->congestion_window = TCP_INITIAL_WINDOW * socket->maximum_segment_size;
+	if(socket->congestion_window > limit)
+		socket->congestion_window = limit;
+}
+
+/**
+ * @brief Update the round trip time estimate and retransmission timeout with a new measurement (RFC 6298)
+ *
+ * @param socket The socket that was timed
+ * @param rtt The round trip time that was measured (ms)
+ */
+void TransmissionControlProtocolHandler::sample_rtt(TCPSocket* socket, uint32_t rtt) {
+
+	if(!socket->smoothed_rtt) {
+		socket->smoothed_rtt = rtt ? rtt : 1;
+		socket->rtt_variance = rtt / 2;
+	} else {
+		uint32_t delta = socket->smoothed_rtt > rtt ? socket->smoothed_rtt - rtt : rtt - socket->smoothed_rtt;
+		socket->rtt_variance = (3 * socket->rtt_variance + delta) / 4;
+		socket->smoothed_rtt = (7 * socket->smoothed_rtt + rtt) / 8;
+		if(!socket->smoothed_rtt)
+			socket->smoothed_rtt = 1;
+	}
+
+	// The variance term is at least the timer granularity
+	uint32_t variance = 4 * socket->rtt_variance;
+	uint32_t timeout = socket->smoothed_rtt + (variance > TCP_TIMER_INTERVAL ? variance : TCP_TIMER_INTERVAL);
+	if(timeout < TCP_MIN_RTO)
+		timeout = TCP_MIN_RTO;
+	if(timeout > TCP_MAX_RTO)
+		timeout = TCP_MAX_RTO;
+	socket->retransmission_timeout = timeout;
+}
+
 /**
  * @brief Handle the TCP message (provider end)
  *
  * @param source_ip The source IP address
  * @param destination_ip The destination IP address
- * @param payload_data The payload
- * @param size The size of the payload
- * @return True if data is to be sent back or false if not
+ * @param packet The packet, positioned at the start of the TCP header
+ * @return Always false, replies are sent as new segments
  */
-bool TransmissionControlProtocolHandler::handle_internet_protocol_payload(net::InternetProtocolAddress source_ip, net::InternetProtocolAddress destination_ip, uint8_t* payload_data, uint32_t size) {
+bool TransmissionControlProtocolHandler::handle_internet_protocol_payload(net::InternetProtocolAddress source_ip, net::InternetProtocolAddress destination_ip, PacketBuffer* packet) {
 
-	error_messages->write("TCP: Handling TCP message\n");
+	NET_TRACE(error_messages, "TCP: Handling TCP message\n");
 
-	//Check if the size is too small
-	if(size < 13) {
+	//Check the size
+	uint32_t size = packet->length();
+	if(size < sizeof(tcp_header_t))
 		return false;
-	}
 
-	// If it's smaller than the header, return
-	if(size < 4 * payload_data[12] / 16)             // The lower 4 bits of the 13th byte is the header length
-	{
+	auto* msg = (tcp_header_t*) packet->data();
+	uint32_t header_size = msg->header_size_32 * 4;
+	if(header_size < sizeof(tcp_header_t) || header_size > size)
 		return false;
-	}
-
-	//Get the header
-	auto* msg = (TCPHeader*) payload_data;
 
 	//Get the connection values (convert to host endian)
 	uint16_t local_port = big_endian_16(msg->dst_port);
 	uint16_t remote_port = big_endian_16(msg->src_port);
+	uint32_t sequence = big_endian_32(msg->sequence_number);
+	uint32_t acknowledgement = big_endian_32(msg->acknowledgement_number);
+	uint8_t* data = packet->data() + header_size;
+	uint32_t data_size = size - header_size;
+	uint8_t flags = msg->flags;
+
+	tcp_delivery_t delivery;
+	m_lock.lock();
 
-	//Create the socket
+	//Find the connection by its addresses and ports, only segments opening a connection go to the socket listening on the port
 	TCPSocket* socket = nullptr;
+	auto connection = connections.find({ destination_ip, source_ip, local_port, remote_port });
+	if(connection != connections.end()) {
+		socket = connection->second;
+	} else if((flags & ((uint16_t) TCPFlag::SYN | (uint16_t) TCPFlag::ACK)) == (uint16_t) TCPFlag::SYN) {
+		auto listener = listeners.find(local_port);
+		if(listener != listeners.end() && listener->second->local_ip == destination_ip)
+			socket = listener->second;
+	}
 
-	for(auto& current_socket : sockets) {
-		if(current_socket->local_port ==
-		   local_port                               //Check if the local port is the same as the destination port
-		   && current_socket->local_ip ==
-		      destination_ip                                  //Check if the local IP is the same as the destination IP
-		   && current_socket->state ==
-		      TCPSocketState::LISTEN                                           //Check if the socket is in the LISTEN state
-		   && (((msg->flags) & ((uint16_t) TCPFlag::SYN | (uint16_t) TCPFlag::ACK)) ==
-		       (uint16_t) TCPFlag::SYN))                                       //Check if the SYN flag is set (allow for acknoweldgement)
-		{
-			socket = current_socket;
-		} else if(current_socket->local_port ==
-		          local_port                          //Check if the local port is the same as the destination port
-		          && current_socket->local_ip ==
-		             destination_ip                             //Check if the local IP is the same as the destination IP
-		          && current_socket->remotePort ==
-		             remote_port                         //Check if the remote port is the same as the source port
-		          && current_socket->remote_ip ==
-		             destination_ip)                           //Check if the remote IP is the same as the source IP
-		{
-			socket = current_socket;
-		}
+	//Nothing is listening, tell the sender
+	if(socket == nullptr) {
+		if(!(flags & (uint16_t) TCPFlag::RST))
+			send_reset(source_ip, destination_ip, msg, data_size);
+
+		unlock_and_transmit();
+		return false;
 	}
 
+	delivery.socket = socket;
+	if(flags & (uint16_t) TCPFlag::RST) {
 
-	bool reset = false;
+		//The remote end has dropped the connection
+		if(socket->state != TCPSocketState::LISTEN) {
+			socket->state = TCPSocketState::CLOSED;
+			delivery.disconnected = true;
+		}
 
-	//Check if the socket is found and if the socket wants to reset
-	if(socket != nullptr && msg->flags & (uint16_t) TCPFlag::RST) {
-		socket->state = TCPSocketState::CLOSED;
-		socket->disconnected();
-	}
+	} else if(socket->state == TCPSocketState::LISTEN) {
 
-	//Check if the socket is found and if the socket is not closed
-	if(socket != nullptr && socket->state != TCPSocketState::CLOSED) {
-		switch((msg->flags) & ((uint16_t) TCPFlag::SYN | (uint16_t) TCPFlag::ACK | (uint16_t) TCPFlag::FIN)) {
-			/*
-			 * Example for explanation:
-			 * socket -> state = SYN_RECEIVED;                                                  //The state of the socket, e.g. recieved, or established. This is used to know how to handle the socket
-			 * socket -> remotePort = msg -> srcPort;                                           //The remote port, e.g. the port of the server
-			 * socket -> remoteIP = srcIP_BE;                                                   //The remote IP, e.g. the IP of the server
-			 * socket -> acknowledgementNumber = bigEndian32( msg -> sequenceNumber ) + 1;      //The acknowledgement number, the number used to keep track of what has been received, this is just incremented by 1 each time
-			 * socket -> sequenceNumber = 0xbeefcafe;                                           //The sequence number, the number of the next set that is to be sent but in this case sequence isn't enabled so just set it to anything
-			 * Send(socket, 0,0, SYN|ACK);                                                      //The response command, genneraly has to have the acknoledgement flag set
-			 * socket -> sequenceNumber++;                                                      //Increment the sequence number
-			 *
-			 */
-
-			case (uint16_t) TCPFlag::SYN:
-				if(socket->state == TCPSocketState::LISTEN) {
-					socket->state = TCPSocketState::SYN_RECEIVED;
-					socket->remotePort = msg->src_port;
-					socket->remote_ip = source_ip;
-					socket->acknowledgement_number = big_endian_32(msg->sequence_number) + 1;
-					socket->sequence_number = 0xbeefcafe;
-					send_transmission_control_protocol_packet(socket, nullptr, 0,
-					                                          (uint16_t) TCPFlag::SYN | (uint16_t) TCPFlag::ACK);
-					socket->sequence_number++;
-				} else
-					reset = true;
-				break;
+		//Take the connection on a new socket so the listener keeps listening, it has a remote end so is looked up as a connection
+		TCPSocket* listener = socket;
+		socket = (TCPSocket*) MemoryManager::kmalloc(sizeof(TCPSocket));
+		if(socket == nullptr) {
+			unlock_and_transmit();
+			return false;
+		}
 
+		new(socket) TCPSocket(this);
+		socket->accepted = true;
+		socket->local_ip = listener->local_ip;
+		socket->local_port = listener->local_port;
+		socket->remotePort = remote_port;
+		socket->remote_ip = source_ip;
+		socket->receive_space = listener->receive_space;
+		connections.insert(socket->connection_key(), socket);
+		socket->references++;
+		delivery.socket = socket;
+
+		start(socket);
+		parse_options(socket, msg);
+		socket->acknowledgement_number = sequence + 1;
+		socket->send_window = big_endian_16(msg->window_size);
+		socket->window_update_sequence = sequence;
+
+		socket->state = TCPSocketState::SYN_RECEIVED;
+		send_segment(socket, socket->initial_sequence_number, 0, (uint16_t) TCPFlag::SYN | (uint16_t) TCPFlag::ACK);
+
+	} else if(socket->state == TCPSocketState::SYN_SENT) {
+
+		//Only a SYN|ACK for the SYN that was sent completes the connection
+		if((flags & ((uint16_t) TCPFlag::SYN | (uint16_t) TCPFlag::ACK)) == ((uint16_t) TCPFlag::SYN | (uint16_t) TCPFlag::ACK)
+		   && acknowledgement == socket->initial_sequence_number + 1) {
+
+			parse_options(socket, msg);
+			socket->acknowledgement_number = sequence + 1;
+			socket->unacknowledged = acknowledgement;
+			socket->send_window = big_endian_16(msg->window_size);
+			socket->window_update_sequence = sequence;
+			socket->window_update_acknowledgement = acknowledgement;
+			socket->retransmit_deadline = 0;
+			socket->retransmits = 0;
+			if(socket->rtt_timing)
+				sample_rtt(socket, now() - socket->rtt_start);
+			socket->rtt_timing = false;
+
+			socket->state = TCPSocketState::ESTABLISHED;
+			socket->send_waiters.wake(UINT32_MAX);
+			delivery.connected = true;
+			send_segment(socket, socket->sequence_number, 0, (uint16_t) TCPFlag::ACK);
+			output(socket);
+
+		} else if(flags & (uint16_t) TCPFlag::ACK) {
+			send_reset(source_ip, destination_ip, msg, data_size);
+		}
 
-			case (uint16_t) TCPFlag::SYN | (uint16_t) TCPFlag::ACK:
-				if(socket->state == TCPSocketState::SYN_SENT) {
-					socket->state = TCPSocketState::ESTABLISHED;
-					socket->acknowledgement_number = big_endian_32(msg->sequence_number) + 1;
-					socket->sequence_number++;
-					send_transmission_control_protocol_packet(socket, nullptr, 0, (uint16_t) TCPFlag::ACK);
-				} else
-					reset = true;
-				break;
+	} else {
 
+		//The segment has to overlap the receive window, otherwise just tell the sender what is expected (also the reply to a SYN on a synchronised connection)
+		uint32_t offset = sequence - socket->acknowledgement_number;
+		bool acceptable = data_size ? (sequence_before(sequence, socket->acknowledgement_number + TCP_RECEIVE_BUFFER_SIZE)
+		                               && sequence_after(sequence + data_size, socket->acknowledgement_number))
+		                            : offset < TCP_RECEIVE_BUFFER_SIZE;
 
-			case (uint16_t) TCPFlag::SYN | (uint16_t) TCPFlag::FIN:
-			case (uint16_t) TCPFlag::SYN | (uint16_t) TCPFlag::FIN | (uint16_t) TCPFlag::ACK:
-				reset = true;
-				break;
+		if(!acceptable || (flags & (uint16_t) TCPFlag::SYN) || !(flags & (uint16_t) TCPFlag::ACK)) {
+			if(!acceptable || (flags & (uint16_t) TCPFlag::SYN))
+				send_segment(socket, socket->sequence_number, 0, (uint16_t) TCPFlag::ACK);
 
+		} else if(socket->state == TCPSocketState::SYN_RECEIVED && acknowledgement != socket->initial_sequence_number + 1) {
+			send_reset(source_ip, destination_ip, msg, data_size);
 
-			case (uint16_t) TCPFlag::FIN:
-			case (uint16_t) TCPFlag::FIN | (uint16_t) TCPFlag::ACK:
-				if(socket->state == TCPSocketState::ESTABLISHED) {
-					socket->state = TCPSocketState::CLOSE_WAIT;
-					socket->acknowledgement_number++;
-					send_transmission_control_protocol_packet(socket, nullptr, 0, (uint16_t) TCPFlag::ACK);
-					send_transmission_control_protocol_packet(socket, nullptr, 0,
-					                                          (uint16_t) TCPFlag::FIN | (uint16_t) TCPFlag::ACK);
-					socket->disconnected();
-				} else if(socket->state == TCPSocketState::CLOSE_WAIT) {
-					socket->state = TCPSocketState::CLOSED;
-				} else if(socket->state == TCPSocketState::FIN_WAIT1 || socket->state == TCPSocketState::FIN_WAIT2) {
-					socket->state = TCPSocketState::CLOSED;
-					socket->acknowledgement_number++;
-					send_transmission_control_protocol_packet(socket, nullptr, 0, (uint16_t) TCPFlag::ACK);
-					socket->disconnected();
-				} else
-					reset = true;
-				break;
+		} else {
+
+			//The SYN|ACK sent by this end has been acknowledged, the listener is told about the new connection so it can bind it
+			if(socket->state == TCPSocketState::SYN_RECEIVED) {
+				socket->state = TCPSocketState::ESTABLISHED;
+				socket->send_waiters.wake(UINT32_MAX);
+				delivery.connected = true;
+
+				auto listener = listeners.find(socket->local_port);
+				if(listener != listeners.end())
+					delivery.listener = listener->second;
+			}
 
+			uint32_t buffered = socket->send_buffered;
+			handle_acknowledgement(socket, msg, sequence, data_size);
+			delivery.space_available = socket->send_buffered < buffered;
 
-			case (uint16_t) TCPFlag::ACK:
-				if(socket->state == TCPSocketState::SYN_RECEIVED) {
-					socket->state = TCPSocketState::ESTABLISHED;
-					socket->connected();
-					return false;
-				} else if(socket->state == TCPSocketState::FIN_WAIT1) {
+			//The FIN sent by this end has been acknowledged
+			bool fin_acknowledged = socket->fin_sent && socket->send_buffered == 0 && socket->unacknowledged == socket->highest_sent;
+			if(fin_acknowledged) {
+				if(socket->state == TCPSocketState::FIN_WAIT1)
 					socket->state = TCPSocketState::FIN_WAIT2;
-					return false;
-				} else if(socket->state == TCPSocketState::CLOSE_WAIT) {
+				else if(socket->state == TCPSocketState::CLOSING)
+					enter_time_wait(socket);
+				else if(socket->state == TCPSocketState::LAST_ACK)
 					socket->state = TCPSocketState::CLOSED;
-					break;
-				}
+			}
+
+			//Data is only accepted while the remote end hasn't closed
+			bool receiving = socket->state == TCPSocketState::ESTABLISHED || socket->state == TCPSocketState::FIN_WAIT1 || socket->state == TCPSocketState::FIN_WAIT2;
+			if(data_size && receiving)
+				handle_data(socket, sequence, data, data_size, delivery);
+
+			//The remote end has finished sending (only once all its data has been received)
+			if((flags & (uint16_t) TCPFlag::FIN) && receiving && sequence + data_size == socket->acknowledgement_number) {
+				socket->acknowledgement_number++;
+				delivery.disconnected = true;
+
+				if(socket->state == TCPSocketState::ESTABLISHED) {
+
+					//Close this end as well, the FIN goes out after anything still buffered
+					socket->fin_queued = true;
+					socket->state = TCPSocketState::LAST_ACK;
 
-				if(msg->flags == (uint16_t) TCPFlag::ACK)
-					break;
-
-				// no break, because of piggybacking
-				[[fallthrough]];
-
-			default:
-
-				// By default, handle the data
-
-				if(big_endian_32(msg->sequence_number) == socket->acknowledgement_number) {
-
-					reset = !(socket->handle_transmission_control_protocol_payload(
-							payload_data + msg->header_size_32 * 4,
-							size - msg->header_size_32 * 4));
-					if(!reset) {
-						uint32_t x = 0;                                                                      //The number of bytes to send back
-						for(uint32_t i = msg->header_size_32 * 4;
-						    i < size; i++)                          //Loop through the data
-							if(payload_data[i] !=
-							   0)                                                     //Check if the data is not 0
-								x = i;                                                                  //Set the number of bytes to send back to the current index
-						socket->acknowledgement_number += x - msg->header_size_32 * 4 +
-						                                  1;               //Increment the acknowledgement number by the number of bytes to send back
-						send_transmission_control_protocol_packet(socket, nullptr, 0,
-						                                          (uint16_t) TCPFlag::ACK);                                          //Send the acknowledgement
-					}
 				} else {
-					// data in wrong order
-					reset = true;
+					send_segment(socket, socket->sequence_number, 0, (uint16_t) TCPFlag::ACK);
+					if(socket->state == TCPSocketState::FIN_WAIT2 || fin_acknowledged)
+						enter_time_wait(socket);
+					else
+						socket->state = TCPSocketState::CLOSING;
 				}
+			}
+
+			output(socket);
+		}
+	}
+
+	NET_TRACE(error_messages, "TCP: Handled packet\n");
 
+	//Keep the sockets alive until their events have been raised
+	delivery.socket->references++;
+	if(delivery.listener)
+		delivery.listener->references++;
+
+	//If the socket is closed then stop looking it up
+	if(socket->state == TCPSocketState::CLOSED)
+		remove_socket(socket);
+
+	unlock_and_transmit();
+	deliver(delivery);
+	return false;
+}
+
+/**
+ * @brief Handle the acknowledgement and window of a segment: free acknowledged data, time the round trip and run congestion control (NewReno)
+ *
+ * @param socket The socket the segment is for
+ * @param header The header of the segment
+ * @param sequence The sequence number of the segment
+ * @param size The size of the data in the segment
+ */
+void TransmissionControlProtocolHandler::handle_acknowledgement(TCPSocket* socket, const tcp_header_t* header, uint32_t sequence, uint32_t size) {
+
+	uint32_t acknowledgement = big_endian_32(header->acknowledgement_number);
+	uint32_t window = big_endian_16(header->window_size) << socket->send_window_scale;
+	uint16_t mss = socket->maximum_segment_size;
+
+	//Acknowledges something that hasn't been sent
+	if(sequence_after(acknowledgement, socket->highest_sent)) {
+		send_segment(socket, socket->sequence_number, 0, (uint16_t) TCPFlag::ACK);
+		return;
+	}
+
+	if(sequence_after(acknowledgement, socket->unacknowledged)) {
+		uint32_t acknowledged = acknowledgement - socket->unacknowledged;
+
+		//Time the round trip (Karn: timing stops when a segment is retransmitted)
+		if(socket->rtt_timing && !sequence_before(acknowledgement, socket->rtt_sequence)) {
+			sample_rtt(socket, now() - socket->rtt_start);
+			socket->rtt_timing = false;
+		}
+
+		//Free the acknowledged data, whatever is left over is the FIN
+		uint32_t data_acknowledged = acknowledged < socket->send_buffered ? acknowledged : socket->send_buffered;
+		socket->send_buffer_start = (socket->send_buffer_start + data_acknowledged) % TCP_SEND_BUFFER_SIZE;
+		socket->send_buffered -= data_acknowledged;
+		socket->unacknowledged = acknowledgement;
+		if(data_acknowledged)
+			socket->send_waiters.wake(UINT32_MAX);
+		if(sequence_before(socket->sequence_number, acknowledgement))
+			socket->sequence_number = acknowledgement;
+
+		if(socket->fast_recovery) {
+			if(!sequence_before(acknowledgement, socket->recover)) {
+
+				//Everything sent before the loss is acknowledged, deflate the window
+				socket->fast_recovery = false;
+				uint32_t flight = socket->flight_size() + mss;
+				socket->congestion_window = socket->slow_start_threshold < flight ? socket->slow_start_threshold : flight;
+
+			} else {
+
+				//Partial acknowledgement, the next segment was lost as well
+				retransmit(socket);
+				socket->congestion_window = socket->congestion_window > acknowledged ? socket->congestion_window - acknowledged : 0;
+				socket->congestion_window += mss;
+			}
+		} else if(socket->congestion_window < socket->slow_start_threshold) {
+
+			//Slow start
+			socket->congestion_window += acknowledged < mss ? acknowledged : mss;
+
+		} else {
+
+			//Congestion avoidance, about one segment per round trip
+			uint32_t increase = (mss * mss) / socket->congestion_window;
+			socket->congestion_window += increase ? increase : 1;
+		}
+
+		socket->duplicate_acks = 0;
+		socket->retransmits = 0;
+		socket->retransmit_deadline = socket->flight_size() ? now() + socket->retransmission_timeout : 0;
+
+	} else if(acknowledgement == socket->unacknowledged && size == 0 && window == socket->send_window && socket->flight_size()) {
+
+		//A duplicate acknowledgement, the remote end is receiving segments after a missing one
+		socket->duplicate_acks++;
+		if(socket->duplicate_acks == TCP_DUPLICATE_ACK_THRESHOLD && !socket->fast_recovery && sequence_after(acknowledgement, socket->recover)) {
+
+			//Fast retransmit, then fast recovery
+			uint32_t half = socket->flight_size() / 2;
+			socket->slow_start_threshold = half > 2u * mss ? half : 2u * mss;
+			socket->recover = socket->highest_sent;
+			socket->fast_recovery = true;
+			retransmit(socket);
+			socket->congestion_window = socket->slow_start_threshold + 3 * mss;
+
+		} else if(socket->fast_recovery) {
+
+			//Each duplicate means a segment has left the network
+			socket->congestion_window += mss;
 		}
 	}
 
+	//Take the window from the most recent segment
+	if(sequence_before(socket->window_update_sequence, sequence)
+	   || (socket->window_update_sequence == sequence && !sequence_before(acknowledgement, socket->window_update_acknowledgement))) {
+		socket->send_window = window;
+		socket->window_update_sequence = sequence;
+		socket->window_update_acknowledgement = acknowledgement;
+	}
+
+	//A zero window probe was answered, the remote end is still there so keep probing (RFC 1122 4.2.2.17)
+	if(!socket->send_window)
+		socket->retransmits = 0;
+}
+
+/**
+ * @brief Handle the data in a segment, data that is in order is passed to the handlers (along with anything held that now
+ * follows it), data after a missing segment is held in the receive ring
+ *
+ * @param socket The socket the segment is for
+ * @param sequence The sequence number of the data
+ * @param data The data
+ * @param size The size of the data
+ * @param delivery Where to put the data that is now in order
+ */
+void TransmissionControlProtocolHandler::handle_data(TCPSocket* socket, uint32_t sequence, uint8_t* data, uint32_t size, tcp_delivery_t& delivery) {
+
+	//Skip anything that has already been received
+	if(sequence_before(sequence, socket->acknowledgement_number)) {
+		uint32_t overlap = socket->acknowledgement_number - sequence;
+		data += overlap;
+		size -= overlap;
+		sequence = socket->acknowledgement_number;
+	}
+
+	//Drop anything past the ring
+	uint32_t offset = sequence - socket->acknowledgement_number;
+	if(size > TCP_RECEIVE_BUFFER_SIZE - offset)
+		size = TCP_RECEIVE_BUFFER_SIZE - offset;
+
+	if(offset == 0) {
+
+		//In order, pass it straight on. Only what the handlers have room for is taken, the rest isn't acknowledged so it is
+		//sent again once the window opens
+		uint32_t space = socket->receive_window();
+		uint32_t start = socket->acknowledgement_number;
+		if(size > space)
+			size = space;
+
+		delivery.data[0] = data;
+		delivery.size[0] = size;
+		socket->acknowledgement_number += size;
+		socket->receive_buffer_start = (socket->receive_buffer_start + size) % TCP_RECEIVE_BUFFER_SIZE;
+		space -= size;
+
+		//Pass on what was held that now follows it (the ranges have gaps between them so only one can continue on)
+		while(socket->out_of_order_count && !sequence_after(socket->out_of_order[0].start, socket->acknowledgement_number)) {
+			tcp_sequence_range_t& range = socket->out_of_order[0];
+
+			uint32_t length = sequence_after(range.end, socket->acknowledgement_number) ? range.end - socket->acknowledgement_number : 0;
+			if(length > space)
+				length = space;
+
+			if(length) {
+				uint32_t first = length < TCP_RECEIVE_BUFFER_SIZE - socket->receive_buffer_start ? length : TCP_RECEIVE_BUFFER_SIZE - socket->receive_buffer_start;
+				delivery.data[1] = socket->receive_buffer + socket->receive_buffer_start;
+				delivery.size[1] = first;
+				delivery.data[2] = socket->receive_buffer;
+				delivery.size[2] = length - first;
+
+				socket->acknowledgement_number += length;
+				socket->receive_buffer_start = (socket->receive_buffer_start + length) % TCP_RECEIVE_BUFFER_SIZE;
+				space -= length;
+			}
+
+			//Only part of it fitted, the rest stays held
+			if(sequence_after(range.end, socket->acknowledgement_number)) {
+				range.start = socket->acknowledgement_number;
+				break;
+			}
 
-	if(reset)                                                                       //If the socket is to be reset
-	{
-		if(socket !=
-		   nullptr)                                                             //If the socket exists then send a reset flag
-		{
-			send_transmission_control_protocol_packet(socket, nullptr, 0, (uint16_t) TCPFlag::RST);
-		} else                                                                        //If it doesn't exist then create a new socket and send a reset flag
-		{
-			TCPSocket new_socket(this);                     //Create a new socket
-			new_socket.remotePort = msg->src_port;                                         //Set the remote port
-			new_socket.remote_ip = source_ip;                                                 //Set the remote IP
-			new_socket.local_port = msg->dst_port;                                                  //Set the local port
-			new_socket.local_ip = destination_ip;                                                     //Set the local IP
-			new_socket.sequence_number = big_endian_32(
-					msg->acknowledgement_number);              //Set the sequence number
-			new_socket.acknowledgement_number =
-					big_endian_32(msg->sequence_number) + 1;          //Set the acknowledgement number
-			send_transmission_control_protocol_packet(&new_socket, nullptr, 0,
-			                                          (uint16_t) TCPFlag::RST);          //Send the reset flag
+			socket->out_of_order_count--;
+			for(uint8_t i = 0; i < socket->out_of_order_count; i++)
+				socket->out_of_order[i] = socket->out_of_order[i + 1];
+		}
+
+		if(socket->receive_space != UINT32_MAX)
+			socket->receive_space -= socket->acknowledgement_number - start;
+
+	} else {
+
+		//After a missing segment, hold it in the ring
+		uint32_t position = (socket->receive_buffer_start + offset) % TCP_RECEIVE_BUFFER_SIZE;
+		uint32_t first = size < TCP_RECEIVE_BUFFER_SIZE - position ? size : TCP_RECEIVE_BUFFER_SIZE - position;
+		memcpy(socket->receive_buffer + position, data, first);
+		memcpy(socket->receive_buffer, data + first, size - first);
+
+		//Record the range, merging it with any it overlaps or touches
+		tcp_sequence_range_t range = { sequence, sequence + size };
+		tcp_sequence_range_t merged[TCP_MAX_OUT_OF_ORDER + 1];
+		uint8_t count = 0;
+		bool placed = false;
+		for(uint8_t i = 0; i < socket->out_of_order_count; i++) {
+			tcp_sequence_range_t current = socket->out_of_order[i];
+			if(sequence_before(current.end, range.start)) {
+				merged[count++] = current;
+			} else if(sequence_after(current.start, range.end)) {
+				if(!placed)
+					merged[count++] = range;
+				placed = true;
+				merged[count++] = current;
+			} else {
+				range.start = sequence_before(current.start, range.start) ? current.start : range.start;
+				range.end = sequence_after(current.end, range.end) ? current.end : range.end;
+			}
+		}
+		if(!placed)
+			merged[count++] = range;
+
+		//Too many gaps, forget this segment (it will be retransmitted)
+		if(count <= TCP_MAX_OUT_OF_ORDER) {
+			for(uint8_t i = 0; i < count; i++)
+				socket->out_of_order[i] = merged[i];
+			socket->out_of_order_count = count;
 		}
 	}
 
+	//Acknowledge straight away, a repeated acknowledgement tells the sender a segment is missing
+	send_segment(socket, socket->sequence_number, 0, (uint16_t) TCPFlag::ACK);
+}
 
-	error_messages->write("TCP: Handled packet\n");
+/**
+ * @brief Send as much of the send ring as the windows allow, followed by the FIN if the socket is closing
+ *
+ * @param socket The socket to send from
+ */
+void TransmissionControlProtocolHandler::output(TCPSocket* socket) {
+
+	switch(socket->state) {
+		case TCPSocketState::ESTABLISHED:
+		case TCPSocketState::CLOSE_WAIT:
+		case TCPSocketState::FIN_WAIT1:
+		case TCPSocketState::CLOSING:
+		case TCPSocketState::LAST_ACK:
+			break;
 
-	if(socket != nullptr && socket->state ==
-	                        TCPSocketState::CLOSED)                                        //If the socket is closed then remove it from the list
-	{
-		sockets.erase(socket);
-		return true;
+		default:
+			return;
 	}
 
+	uint32_t window = socket->congestion_window < socket->send_window ? socket->congestion_window : socket->send_window;
+	uint32_t fin_sequence = socket->unacknowledged + socket->send_buffered;
+	while(true) {
 
-	return false;
+		uint32_t in_flight = socket->sequence_number - socket->unacknowledged;
+		uint32_t unsent = socket->send_buffered > in_flight ? socket->send_buffered - in_flight : 0;
+		uint32_t usable = window > in_flight ? window - in_flight : 0;
+
+		uint32_t size = unsent < socket->maximum_segment_size ? unsent : socket->maximum_segment_size;
+		if(size > usable)
+			size = usable;
+
+		bool send_fin = socket->fin_queued && socket->sequence_number + size == fin_sequence;
+		if(!size && !send_fin)
+			break;
+
+		uint8_t flags = (uint16_t) TCPFlag::ACK;
+		if(size && size == unsent)
+			flags |= (uint16_t) TCPFlag::PSH;
+		if(send_fin)
+			flags |= (uint16_t) TCPFlag::FIN;
+
+		send_segment(socket, socket->sequence_number, size, flags);
+
+		//Time one segment per round trip
+		if(!socket->rtt_timing && socket->sequence_number == socket->highest_sent) {
+			socket->rtt_timing = true;
+			socket->rtt_sequence = socket->sequence_number + size;
+			socket->rtt_start = now();
+		}
+
+		socket->sequence_number += size + (send_fin ? 1 : 0);
+		socket->fin_sent |= send_fin;
+		if(sequence_after(socket->sequence_number, socket->highest_sent))
+			socket->highest_sent = socket->sequence_number;
+
+		if(!socket->retransmit_deadline)
+			socket->retransmit_deadline = now() + socket->retransmission_timeout;
+
+		if(send_fin)
+			break;
+	}
+
+	//The remote end has closed its window, the timer probes it
+	if(!socket->retransmit_deadline && socket->send_buffered > socket->sequence_number - socket->unacknowledged)
+		socket->retransmit_deadline = now() + socket->retransmission_timeout;
 }
 
 /**
- * @brief send a packet (Throught the provider)
+ * @brief Resend the oldest segment that hasn't been acknowledged
  *
- * @param socket    The socket to send the packet from
- * @param data    The data to send
- * @param size   The size of the data
- * @param flags  The flags to send
+ * @param socket The socket to resend from
  */
-void TransmissionControlProtocolHandler::send_transmission_control_protocol_packet(TCPSocket* socket, const uint8_t* data, uint16_t size, uint16_t flags) {
-	//Get the total size of the packet and the packet with the pseudo header
-	uint16_t total_length = size + sizeof(TCPHeader);
-	uint16_t length_incl_p_hdr = total_length + sizeof(TCPPseudoHeader);
+void TransmissionControlProtocolHandler::retransmit(TCPSocket* socket) {
+
+	if(socket->state == TCPSocketState::SYN_SENT) {
+		send_segment(socket, socket->initial_sequence_number, 0, (uint16_t) TCPFlag::SYN);
+
+	} else if(socket->state == TCPSocketState::SYN_RECEIVED) {
+		send_segment(socket, socket->initial_sequence_number, 0, (uint16_t) TCPFlag::SYN | (uint16_t) TCPFlag::ACK);
 
-	//Create a buffer for the packet
-	auto* buffer = (uint8_t*) MemoryManager::kmalloc(length_incl_p_hdr);
-	uint8_t* buffer2 =
-			buffer + sizeof(TCPHeader) + sizeof(TCPPseudoHeader);
+	} else {
+
+		uint32_t size = socket->send_buffered < socket->maximum_segment_size ? socket->send_buffered : socket->maximum_segment_size;
+		bool send_fin = socket->fin_sent && size == socket->send_buffered;
+		if(!size && !send_fin)
+			return;
+
+		send_segment(socket, socket->unacknowledged, size, (uint16_t) TCPFlag::ACK | (send_fin ? (uint16_t) TCPFlag::FIN : 0));
+	}
 
-	//Create the headers
-	auto* phdr = (TCPPseudoHeader*) buffer;
-	auto* msg = (TCPHeader*) (buffer + sizeof(TCPPseudoHeader));
+	socket->rtt_timing = false;
+	socket->retransmit_deadline = now() + socket->retransmission_timeout;
+}
+
+/**
+ * @brief Handle the retransmission and TIME_WAIT timers of every connection
+ *
+ * @param now The current time (ms)
+ */
+void TransmissionControlProtocolHandler::handle_timers(uint64_t now) {
+
+	Vector<TCPSocket*> closed;
+	m_lock.lock();
+
+	for(auto& connection : connections) {
+		TCPSocket* socket = connection.second;
+
+		if(socket->state == TCPSocketState::TIME_WAIT) {
+			if(now >= socket->time_wait_deadline) {
+				socket->state = TCPSocketState::CLOSED;
+				closed.push_back(socket);
+			}
+			continue;
+		}
+
+		if(!socket->retransmit_deadline || now < socket->retransmit_deadline)
+			continue;
+
+		//The remote end has gone away
+		if(++socket->retransmits > TCP_MAX_RETRANSMITS) {
+			socket->state = TCPSocketState::CLOSED;
+			closed.push_back(socket);
+			continue;
+		}
+
+		//Back off and go back to a single segment (RFC 5681), a zero window probe isn't a loss so the window is left alone
+		uint16_t mss = socket->maximum_segment_size;
+		if(socket->send_window) {
+			uint32_t half = socket->flight_size() / 2;
+			socket->slow_start_threshold = half > 2u * mss ? half : 2u * mss;
+			socket->congestion_window = mss;
+			socket->fast_recovery = false;
+			socket->duplicate_acks = 0;
+			socket->recover = socket->highest_sent;
+		}
+		socket->retransmission_timeout = socket->retransmission_timeout * 2 > TCP_MAX_RTO ? TCP_MAX_RTO : socket->retransmission_timeout * 2;
+
+		//Resend from the oldest unacknowledged byte (a zero window is probed the same way)
+		retransmit(socket);
+		if(socket->state != TCPSocketState::SYN_SENT && socket->state != TCPSocketState::SYN_RECEIVED) {
+			uint32_t resent = socket->send_buffered < mss ? socket->send_buffered : mss;
+			socket->sequence_number = socket->unacknowledged + resent;
+			if(socket->fin_sent && resent == socket->send_buffered)
+				socket->sequence_number++;
+		}
+	}
+
+	for(auto& socket : closed) {
+		socket->references++;
+		remove_socket(socket);
+	}
+
+	unlock_and_transmit();
+
+	//Tell the handlers about connections that were dropped
+	for(auto& socket : closed) {
+		if(socket->retransmits > TCP_MAX_RETRANSMITS)
+			socket->disconnected();
+		release_socket(socket);
+	}
+}
+
+/**
+ * @brief Wait for stray segments from the remote end before forgetting the connection
+ *
+ * @param socket The socket that has closed
+ */
+void TransmissionControlProtocolHandler::enter_time_wait(TCPSocket* socket) {
+
+	socket->state = TCPSocketState::TIME_WAIT;
+	socket->time_wait_deadline = now() + TCP_TIME_WAIT;
+	socket->retransmit_deadline = 0;
+}
+
+/**
+ * @brief Runs the timers of the handler, sleeping between checks
+ *
+ * @param argc Unused
+ * @param argv The handler
+ */
+void TransmissionControlProtocolHandler::timer_worker(uint64_t argc, TransmissionControlProtocolHandler** argv) {
+
+	TransmissionControlProtocolHandler* handler = argv[0];
+	while(true) {
+
+		handler->handle_timers(now());
+
+		//Sleep until the next check
+		GlobalScheduler::sleep(TCP_TIMER_INTERVAL);
+	}
+}
+
+/**
+ * @brief Raise the events a segment caused
+ *
+ * @param delivery The events
+ */
+void TransmissionControlProtocolHandler::deliver(tcp_delivery_t& delivery) {
+
+	TCPSocket* socket = delivery.socket;
+	if(socket == nullptr)
+		return;
+
+	if(delivery.connected) {
+		//raise_event() frees the event once the handlers have seen it
+		if(delivery.listener)
+			delivery.listener->raise_event(new ConnectedEvent(socket));
+		else
+			socket->connected();
+	}
+
+	for(int i = 0; i < 3; i++) {
+		uint8_t* data = delivery.data[i];
+		uint32_t size = delivery.size[i];
+		while(size) {
+			uint16_t part = size > UINT16_MAX ? UINT16_MAX : size;
+			socket->handle_transmission_control_protocol_payload(data, part);
+			data += part;
+			size -= part;
+		}
+	}
+
+	if(delivery.space_available)
+		socket->space_available();
+
+	if(delivery.disconnected)
+		socket->disconnected();
+
+	if(delivery.listener)
+		release_socket(delivery.listener);
+	release_socket(socket);
+}
+
+/**
+ * @brief Build a segment, it is sent once the lock is released
+ *
+ * @param socket The socket to send the segment from
+ * @param sequence The sequence number of the segment
+ * @param size How many bytes of the send ring to send (from sequence)
+ * @param flags The flags to send
+ */
+void TransmissionControlProtocolHandler::send_segment(TCPSocket* socket, uint32_t sequence, uint32_t size, uint8_t flags) {
+
+	PacketBuffer* packet = PacketBufferPool::allocate();
+	if(!packet)
+		return;
+
+	//Copy the data out of the send ring
+	if(size) {
+		uint32_t position = (socket->send_buffer_start + (sequence - socket->unacknowledged)) % TCP_SEND_BUFFER_SIZE;
+		uint32_t first = size < TCP_SEND_BUFFER_SIZE - position ? size : TCP_SEND_BUFFER_SIZE - position;
+		uint8_t* payload = packet->append(size);
+		memcpy(payload, socket->send_buffer + position, first);
+		memcpy(payload + first, socket->send_buffer, size - first);
+	}
+
+	//SYNs say how big the segments can be and offer window scaling (only answered with scaling if it was offered)
+	uint8_t options_size = 0;
+	if(flags & (uint16_t) TCPFlag::SYN) {
+		bool scaling = !(flags & (uint16_t) TCPFlag::ACK) || socket->receive_window_scale;
+		options_size = scaling ? 8 : 4;
+
+		uint8_t* options = packet->prepend(options_size);
+		options[0] = (uint8_t) TCPOption::MAXIMUM_SEGMENT_SIZE;
+		options[1] = 4;
+		options[2] = TCP_MAX_MSS >> 8;
+		options[3] = TCP_MAX_MSS & 0xFF;
+		if(scaling) {
+			options[4] = (uint8_t) TCPOption::NOP;
+			options[5] = (uint8_t) TCPOption::WINDOW_SCALE;
+			options[6] = 3;
+			options[7] = TCP_WINDOW_SCALE;
+		}
+	}
+
+	//Create the header
+	auto* msg = (TCPHeader*) packet->prepend(sizeof(TCPHeader));
 
 	//Size is translated into 32bit
-	msg->header_size_32 = sizeof(TCPHeader) / 4;
+	msg->header_size_32 = (sizeof(TCPHeader) + options_size) / 4;
 
 	//Set the ports
 	msg->src_port = big_endian_16(socket->local_port);
 	msg->dst_port = big_endian_16(socket->remotePort);
 
-	//Set TCP related data
-	msg->acknowledgement_number = big_endian_32(socket->acknowledgement_number);
-	msg->sequence_number = big_endian_32(socket->sequence_number);
+	//Set TCP related data (the window in a SYN is never scaled)
+	msg->acknowledgement_number = (flags & (uint16_t) TCPFlag::ACK) ? big_endian_32(socket->acknowledgement_number) : 0;
+	msg->sequence_number = big_endian_32(sequence);
 	msg->reserved = 0;
 	msg->flags = flags;
-	msg->window_size = 0xFFFF;
+	uint16_t window = (flags & (uint16_t) TCPFlag::SYN) ? (TCP_RECEIVE_BUFFER_SIZE > UINT16_MAX ? UINT16_MAX : TCP_RECEIVE_BUFFER_SIZE) : socket->advertised_window();
+	msg->window_size = big_endian_16(window);
 	msg->urgent_ptr = 0;
 
-	//Through the options allow for the MSS to be set
-	msg->options = ((flags & (uint16_t) TCPFlag::SYN) != 0) ? 0xB4050402 : 0;
+	//Remember how far the remote end can send (the window is never taken back)
+	if((flags & (uint16_t) TCPFlag::ACK) && !(flags & (uint16_t) TCPFlag::SYN)) {
+		uint32_t edge = socket->acknowledgement_number + ((uint32_t) window << socket->receive_window_scale);
+		if(sequence_after(edge, socket->advertised_edge) || socket->advertised_edge == 0)
+			socket->advertised_edge = edge;
+	}
+
+	//Only the pseudo header is summed here, the rest is left for the NIC (or the driver if it can't)
+	msg->checksum = InternetChecksum::fold(InternetChecksum::pseudo_header(socket->local_ip, socket->remote_ip, 0x06, packet->length()));
+	packet->request_checksum(0, offsetof(TCPHeader, checksum));
+
+	m_transmit_queue.push_back({ socket->remote_ip, packet });
+}
+
+/**
+ * @brief Reset a connection that has no socket (RFC 793: the reset takes its numbers from the segment it answers)
+ *
+ * @param source_ip Where the segment came from
+ * @param destination_ip Where the segment was sent to
+ * @param header The header of the segment
+ * @param size The size of the data in the segment
+ */
+void TransmissionControlProtocolHandler::send_reset(InternetProtocolAddress source_ip, InternetProtocolAddress destination_ip, const tcp_header_t* header, uint32_t size) {
 
-	//Increase the sequence number
-	socket->sequence_number += size;
+	TCPSocket socket(this);
+	socket.remotePort = big_endian_16(header->src_port);
+	socket.remote_ip = source_ip;
+	socket.local_port = big_endian_16(header->dst_port);
+	socket.local_ip = destination_ip;
 
-	// Check if the data is not null
-	if(data != nullptr) {
-		//Copy the data into the buffer
-		for(int i = 0; i < size; i++)
-			buffer2[i] = data[i];
+	if(header->flags & (uint16_t) TCPFlag::ACK) {
+		send_segment(&socket, big_endian_32(header->acknowledgement_number), 0, (uint16_t) TCPFlag::RST);
+		return;
 	}
 
-	//Set the pseudo header
-	phdr->src_ip = socket->local_ip;
-	phdr->dst_ip = socket->remote_ip;
-	phdr->protocol = 0x0600;
-	phdr->total_length = ((total_length & 0x00FF) << 8) | ((total_length & 0xFF00) >> 8);
+	uint32_t length = size + ((header->flags & (uint16_t) TCPFlag::SYN) ? 1 : 0) + ((header->flags & (uint16_t) TCPFlag::FIN) ? 1 : 0);
+	socket.acknowledgement_number = big_endian_32(header->sequence_number) + length;
+	send_segment(&socket, 0, 0, (uint16_t) TCPFlag::RST | (uint16_t) TCPFlag::ACK);
+}
 
-	//Calculate the checksum
-	msg->checksum = 0;
-	msg->checksum = InternetProtocolHandler::checksum((uint16_t*) buffer, length_incl_p_hdr);
+/**
+ * @brief Release the lock then send the segments that were built while it was held, so the lock isn't held while they go
+ * down the stack
+ */
+void TransmissionControlProtocolHandler::unlock_and_transmit() {
 
+	Vector<Pair<InternetProtocolAddress, PacketBuffer*>> segments = m_transmit_queue;
+	m_transmit_queue.clear();
+	m_lock.unlock();
 
-	//Send and then free the data
-	send(socket->remote_ip, (uint8_t*) msg, total_length);
-	MemoryManager::kfree(buffer);
+	for(auto& segment : segments)
+		send(segment.first, segment.second);
 }
 
 /**
@@ -491,25 +1317,34 @@ TCPSocket* TransmissionControlProtocolHandler::connect(InternetProtocolAddress i
 		//Set the socket
 		new(socket) TCPSocket(this);
 
+		m_lock.lock();
+
 		//Set local and remote addresses
 		socket->remotePort = port;
 		socket->remote_ip = ip;
-		socket->local_port = free_ports++;
+		socket->local_port = ports.allocate();
 		socket->local_ip = internet_protocol_handler->get_internet_protocol_address();
 
-		//Convert into big endian
-		socket->remotePort = ((socket->remotePort & 0xFF00) >> 8) | ((socket->remotePort & 0x00FF) << 8);
-		socket->local_port = ((socket->local_port & 0xFF00) >> 8) | ((socket->local_port & 0x00FF) << 8);
+		//Every ephemeral port is in use
+		if(socket->local_port == 0) {
+			m_lock.unlock();
+			MemoryManager::kfree(socket);
+			return nullptr;
+		}
 
-		//Set the socket into the socket array and then set its state
-		sockets.push_back(socket);
+		//Add the socket to the connections and then set its state
+		connections.insert(socket->connection_key(), socket);
+		socket->references++;
 		socket->state = TCPSocketState::SYN_SENT;
 
-		//Dummy sequence number
-		socket->sequence_number = 0xbeefcafe;
-
 		//Send a sync packet
-		send_transmission_control_protocol_packet(socket, nullptr, 0, (uint16_t) TCPFlag::SYN);
+		start(socket);
+		send_segment(socket, socket->initial_sequence_number, 0, (uint16_t) TCPFlag::SYN);
+		socket->rtt_timing = true;
+		socket->rtt_sequence = socket->sequence_number;
+		socket->rtt_start = now();
+
+		unlock_and_transmit();
 	}
 
 	return socket;
@@ -530,25 +1365,68 @@ TCPSocket* TransmissionControlProtocolHandler::connect(const string& address) {
 }
 
 /**
- * @brief Begin the disconnect process
+ * @brief Begin the disconnect process, the FIN is sent once everything buffered has been sent. The socket must not be used
+ * afterwards, it is freed once it has closed
  *
  * @param socket The socket to disconnect
  */
 void TransmissionControlProtocolHandler::disconnect(TCPSocket* socket) {
 
-	socket->state = TCPSocketState::FIN_WAIT1;                            //Begin fin wait sequence
-	send_transmission_control_protocol_packet(socket, nullptr, 0, (uint16_t) TCPFlag::FIN +
-	                                                              (uint16_t) TCPFlag::ACK);            //Send FIN|ACK packet
-	socket->sequence_number++;                             //Increase the sequence number
+	m_lock.lock();
+
+	//Only the first call gives the socket up
+	if(socket->released) {
+		m_lock.unlock();
+		return;
+	}
+
+	socket->released = true;
+	socket->send_waiters.wake(UINT32_MAX);
+	switch(socket->state) {
+		case TCPSocketState::ESTABLISHED:
+			socket->fin_queued = true;
+			socket->state = TCPSocketState::FIN_WAIT1;                            //Begin fin wait sequence
+			output(socket);
+			break;
+
+		case TCPSocketState::CLOSE_WAIT:
+			socket->fin_queued = true;
+			socket->state = TCPSocketState::LAST_ACK;
+			output(socket);
+			break;
+
+		case TCPSocketState::LISTEN:
+		case TCPSocketState::SYN_SENT:
+		case TCPSocketState::SYN_RECEIVED:
+			socket->state = TCPSocketState::CLOSED;
+			remove_socket(socket);
+			break;
+
+		default:
+			break;
+	}
+
+	unlock_and_transmit();
+	release_socket(socket);
 }
 
 /**
- * @brief Begin listening on a port
+ * @brief Begin listening on a port, each connection is accepted on a new socket which is passed to the handlers of the
+ * listener in a ConnectedEvent so they can bind to it
  *
  * @param port The port to listen on
- * @return The socket that will handle the connection
+ * @return The listening socket, nullptr if the port is already in use
  */
 TCPSocket* TransmissionControlProtocolHandler::listen(uint16_t port) {
+
+	m_lock.lock();
+
+	//The port is already in use
+	if(!ports.reserve(port)) {
+		m_lock.unlock();
+		return nullptr;
+	}
+
 	//Create a new socket
 	auto* socket = (TCPSocket*) MemoryManager::kmalloc(
 			sizeof(TCPSocket));
@@ -561,16 +1439,63 @@ TCPSocket* TransmissionControlProtocolHandler::listen(uint16_t port) {
 		//Configure the socket
 		socket->state = TCPSocketState::LISTEN;
 		socket->local_ip = internet_protocol_handler->get_internet_protocol_address();
-		socket->local_port = ((port & 0xFF00) >> 8) | ((port & 0x00FF) << 8);
+		socket->local_port = port;
 
-		//Add the socket to the socket array
-		sockets.push_back(socket);
+		//Add the socket to the listeners
+		listeners.insert(port, socket);
+		socket->references++;
+	} else {
+		ports.release(port);
 	}
 
+	m_lock.unlock();
+
 	//Return the socket
 	return socket;
 }
 
+/**
+ * @brief Stop looking up a socket, free its local port and rings and drop the reference the tables held
+ *
+ * @param socket The socket to remove
+ */
+void TransmissionControlProtocolHandler::remove_socket(TCPSocket* socket) {
+
+	auto listener = listeners.find(socket->local_port);
+	if(listener != listeners.end() && listener->second == socket)
+		listeners.erase(listener);
+	else
+		connections.erase(socket->connection_key());
+
+	//Accepted sockets share the port of the listener
+	if(!socket->accepted)
+		ports.release(socket->local_port);
+	socket->retransmit_deadline = 0;
+	socket->free_buffers();
+
+	//Wake anything waiting to send, there is nothing to send to anymore
+	socket->send_waiters.wake(UINT32_MAX);
+	socket->references--;
+}
+
+/**
+ * @brief Drop a reference to a socket, freeing it once nothing is using it
+ *
+ * @param socket The socket to release
+ */
+void TransmissionControlProtocolHandler::release_socket(TCPSocket* socket) {
+
+	m_lock.lock();
+	bool unused = --socket->references == 0;
+	m_lock.unlock();
+
+	if(!unused)
+		return;
+
+	socket->~TCPSocket();
+	MemoryManager::kfree(socket);
+}
+
 
 /**
  * @brief bind a data handler to this socket
@@ -622,4 +1547,16 @@ DisconnectedEvent::DisconnectedEvent(TCPSocket* socket)
 	this->socket = socket;
 }
 
-DisconnectedEvent::~DisconnectedEvent() = default;
\ No newline at end of file
+DisconnectedEvent::~DisconnectedEvent() = default;
+
+/**
+ * @brief Construct a new space available Event object
+ *
+ * @param socket The socket that has room to send
+ */
+SpaceAvailableEvent::SpaceAvailableEvent(TCPSocket* socket)
+		: Event(TCPPayloadHandlerEvents::SPACE_AVAILABLE) {
+	this->socket = socket;
+}
+
+SpaceAvailableEvent::~SpaceAvailableEvent() = default;
\ No newline at end of file
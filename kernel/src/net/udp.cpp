@@ -71,10 +71,8 @@ UDPSocket::~UDPSocket() = default;
  */
 void UDPSocket::handle_user_datagram_protocol_payload(uint8_t *data, uint16_t size) {
 
-    // Create the event
-    auto* event = new UDPDataReceivedEvent(this, data, size);
-    raise_event(event);
-    MemoryManager::kfree(event);
+    // Raise the event (raise_event() frees it)
+    raise_event(new UDPDataReceivedEvent(this, data, size));
 
 }
 
@@ -99,9 +97,18 @@ void UDPSocket::disconnect() {
 
 }
 
+/**
+ * @brief Get the key the socket is looked up by once it has a remote end
+ *
+ * @return The addresses and ports of the connection
+ */
+ConnectionKey UDPSocket::connection_key() const {
+    return { local_ip, remote_ip, local_port, remote_port };
+}
+
 ///__Provider__
 
-UserDatagramProtocolPort UserDatagramProtocolHandler::free_ports = 0x8000;
+PortAllocator UserDatagramProtocolHandler::ports;
 
 /**
  * @brief Construct a new User Datagram Protocol Handler object
@@ -122,49 +129,44 @@ UserDatagramProtocolHandler::~UserDatagramProtocolHandler() = default;
  *
  * @param source_ip The source IP address in big endian
  * @param destination_ip  The destination IP address in big endian
- * @param payload_data The UDP payload
- * @param size The size of the UDP payload
+ * @param packet The packet, positioned at the start of the UDP header
  * @return True if the packet is to be sent back to the sender
  */
-bool UserDatagramProtocolHandler::handle_internet_protocol_payload(net::InternetProtocolAddress source_ip, net::InternetProtocolAddress destination_ip, uint8_t* payload_data, uint32_t size) {
+bool UserDatagramProtocolHandler::handle_internet_protocol_payload(net::InternetProtocolAddress source_ip, net::InternetProtocolAddress destination_ip, PacketBuffer* packet) {
 
     //Check the size
-    if(size < sizeof(UDPHeader)) {
+    if(packet->length() < sizeof(UDPHeader)) {
         return false;
     }
 
     //Get the header
-    auto* header = (UDPHeader*)payload_data;
-
-    //Set the local and remote ports
-    uint16_t local_port = header -> destination_port;
-    uint16_t remote_port = header -> source_port;
-
-    UDPSocket* socket = nullptr;                     //The socket that will be used
-    for(auto & current_socket : sockets) {
-        if(current_socket->local_port == local_port                  //If the local port (header dst, our port) is the same as the local port of the socket
-        && current_socket->local_ip == destination_ip                     //If the local IP (packet dst, our IP) is the same as the local IP of the socket
-        && current_socket->listening)                              //If the socket is listening
-        {
-
-            socket = current_socket;                               //Set the socket to the socket that is being checked
+    auto* header = (UDPHeader*)packet->data();
+    packet->pull(sizeof(UDPHeader));
+
+    //Set the local and remote ports (convert to host endian)
+    uint16_t local_port = ((header -> destination_port & 0x00FF) << 8) | ((header -> destination_port & 0xFF00) >> 8);
+    uint16_t remote_port = ((header -> source_port & 0x00FF) << 8) | ((header -> source_port & 0xFF00) >> 8);
+
+    //Find the connection by its addresses and ports, otherwise the socket listening on the port takes the sender as its remote end
+    UDPSocket* socket = nullptr;
+    auto connection = connections.find({ destination_ip, source_ip, local_port, remote_port });
+    if(connection != connections.end()) {
+        socket = connection->second;
+    } else {
+        auto listener = listeners.find(local_port);
+        if(listener != listeners.end() && listener->second->local_ip == destination_ip) {
+            socket = listener->second;
             socket->listening = false;                         //Set the socket to not listening, as it is now in use
             socket->remote_port = remote_port;                   //Set the remote port of the socket to the remote port of the packet
             socket->remote_ip = source_ip;                       //Set the remote IP of the socket to the remote IP of the packet
 
-        }else if(current_socket->local_port == local_port            //If the local port (header dst, our port) is the same as the local port of the socket
-              && current_socket->local_ip == destination_ip              //If the local IP (packet dst, our IP) is the same as the local IP of the socket
-              && current_socket->remote_port == remote_port         //If the remote port (header src, their port) is the same as the remote port of the socket
-              && current_socket->remote_ip == source_ip)            //If the remote IP (packet src, their IP) is the same as the remote IP of the socket
-        {
-            socket = current_socket;                               //Set the socket to the current socket
+            listeners.erase(listener);
+            connections.insert(socket->connection_key(), socket);
         }
-
     }
 
     if(socket != nullptr) {                                          //If the socket is not null then pass the data to the socket
-	    socket->handle_user_datagram_protocol_payload(payload_data + sizeof(UDPHeader),
-	                                                  size - sizeof(UDPHeader));
+	    socket->handle_user_datagram_protocol_payload(packet->data(), packet->length());
     }
 
     //UDP doesn't send back packets, so always return false
@@ -190,11 +192,17 @@ UDPSocket *UserDatagramProtocolHandler::connect(uint32_t ip, uint16_t port) {
         //Configure the socket
         socket -> remote_port = port;                                    //Port to that application wants to connect to
         socket -> remote_ip = ip;                                        //IP to that application wants to connect to
-        socket -> local_port = free_ports++;                               //Port that we will use to connect to the remote application  (note, local port doesnt have to be the same as remote)
+        socket -> local_port = ports.allocate();                           //Port that we will use to connect to the remote application  (note, local port doesnt have to be the same as remote)
         socket -> local_ip = internet_protocol_handler->get_internet_protocol_address();    //IP that we will use to connect to the remote application
         socket -> user_datagram_protocol_handler = this;                    //Set the UDP handler
 
-        sockets.push_back(socket);                                       //Add the socket to the list of sockets
+        //Every ephemeral port is in use
+        if(socket -> local_port == 0) {
+            MemoryManager::kfree(socket);
+            return nullptr;
+        }
+
+        connections.insert(socket -> connection_key(), socket);          //Add the socket to the connections
     }
 
     return socket;                                        //Return the socket
@@ -217,10 +225,14 @@ UDPSocket *UserDatagramProtocolHandler::connect(const string& address) {
  * @brief Listens for incoming packets on the port
  *
  * @param port The port to listen on
- * @return The socket that is listening
+ * @return The socket that is listening, nullptr if the port is already in use
  */
 UDPSocket *UserDatagramProtocolHandler::listen(uint16_t port) {
 
+    //The port is already in use
+    if(!ports.reserve(port))
+        return nullptr;
+
     auto* socket = (UDPSocket*)MemoryManager::kmalloc(sizeof(UDPSocket));   //Allocate memory for the socket
 
     if(socket != nullptr) //If the socket was created
@@ -233,7 +245,9 @@ UDPSocket *UserDatagramProtocolHandler::listen(uint16_t port) {
         socket -> local_ip = internet_protocol_handler->get_internet_protocol_address();    //IP that we will use to connect to the remote application
         socket -> user_datagram_protocol_handler = this;                    //Set the UDP handler
 
-        sockets.push_back(socket);                                       //Add the socket to the list of sockets
+        listeners.insert(port, socket);                                  //Add the socket to the listeners
+    } else {
+        ports.release(port);
     }
 
     return socket;                                        //Return the socket
@@ -248,14 +262,14 @@ UDPSocket *UserDatagramProtocolHandler::listen(uint16_t port) {
 void UserDatagramProtocolHandler::disconnect(UDPSocket *socket) {
 
 
-    for(Vector<UDPSocket*>::iterator current_socket = sockets.begin(); current_socket != sockets.end(); current_socket++) {
-        if((*current_socket) == socket)                               //If the socket is the same as the socket that is being checked
-        {
-            sockets.erase(current_socket);                            //Remove the socket from the list of sockets
-            MemoryManager::kfree(socket);      //Free the socket
-            break;                                                   //Break out of the loop
-        }
-    }
+    //Stop looking the socket up
+    if(socket -> listening)
+        listeners.erase(socket -> local_port);
+    else
+        connections.erase(socket -> connection_key());
+
+    ports.release(socket -> local_port);
+    MemoryManager::kfree(socket);      //Free the socket
 
 }
 
@@ -269,10 +283,14 @@ void UserDatagramProtocolHandler::disconnect(UDPSocket *socket) {
 void UserDatagramProtocolHandler::send(UDPSocket *socket, const uint8_t *data, uint16_t size) {
 
     uint16_t total_size = sizeof(UDPHeader) + size;                                 //Get the total size of the packet
-    auto* buffer = (uint8_t*)MemoryManager::kmalloc(total_size);          //Allocate memory for the packet
-    uint8_t* buffer2 = buffer + sizeof(UDPHeader);                                 //Get the buffer that will be used to store the data
 
-    auto* header = (UDPHeader*)buffer;                       //Create the header of the packet
+    //Copy the data into a packet buffer, the only copy made on the way to the NIC (datagrams bigger than a pooled buffer are fragmented by IP)
+    bool fits = size + sizeof(UDPHeader) + PACKET_BUFFER_HEADROOM <= PACKET_BUFFER_SIZE;
+    PacketBuffer* packet = fits ? PacketBufferPool::allocate(data, size) : PacketBufferPool::allocate_large(data, size);
+    if(!packet)
+        return;
+
+    auto* header = (UDPHeader*)packet->prepend(sizeof(UDPHeader));                       //Create the header of the packet
 
     //Set the header
     header -> source_port = socket -> local_port;                                                    //Set the source port to the local port of the socket    (this is the port that the packet will be sent from)
@@ -283,19 +301,11 @@ void UserDatagramProtocolHandler::send(UDPSocket *socket, const uint8_t *data, u
     header -> source_port = ((header -> source_port & 0x00FF) << 8) | ((header -> source_port & 0xFF00) >> 8);
     header -> destination_port = ((header -> destination_port & 0x00FF) << 8) | ((header -> destination_port & 0xFF00) >> 8);
 
-    //Copy the data to the buffer
-    for (int i = 0; i < size; ++i) {                                                               //Loop through the data
-        buffer2[i] = data[i];                                                                      //Copy the data to the buffer
-    }
-
     //Set the checksum
     header -> checksum = 0;                                                                        //Set the checksum to 0, this is becuase UDP doesnt have to have a checksum
 
     //Send the packet
-	IPV4PayloadHandler::send(socket->remote_ip, buffer, total_size);
-
-    //Free the buffer
-    MemoryManager::kfree(buffer);
+	IPV4PayloadHandler::send(socket->remote_ip, packet);
 
 }
 
@@ -122,7 +122,7 @@ SharedMessageEndpoint::~SharedMessageEndpoint() {
 
 	// Free the messages
 	for(auto& message : m_queue)
-		delete message;
+		delete message.second;
 }
 
 /**
@@ -135,14 +135,35 @@ SharedMessageEndpoint::~SharedMessageEndpoint() {
  */
 int SharedMessageEndpoint::read(void* buffer, size_t size, size_t flags) {
 
+	uint64_t sender;
+	return read_message(buffer, size, sender);
+}
+
+/**
+ * @brief Reads the first message from the endpoint along with the process that wrote it
+ *
+ * @param buffer Where to write the message to
+ * @param size Max size of the message to be read
+ * @param sender Set to the PID of the process that wrote the message (0 if it was written by the kernel)
+ * @return The amount of bytes read
+ */
+int SharedMessageEndpoint::read_message(void* buffer, size_t size, uint64_t& sender) {
+
+	m_message_lock.lock();
+
 	// Wait for a message
-	if(m_queue.empty())
+	if(m_queue.empty()) {
+		m_message_lock.unlock();
 		return -1 * (int)resource_error_base_t::SHOULD_BLOCK;
+	}
 
 	// Read the message into the buffer
-	buffer_t* message = m_queue.pop_front();
-	size_t readable = size > message->capacity() ? message->capacity() : size;
-	memcpy(buffer, message -> raw(), readable);
+	Pair<uint64_t, buffer_t*> message = m_queue.pop_front();
+	m_message_lock.unlock();
+	size_t readable = size > message.second->capacity() ? message.second->capacity() : size;
+	memcpy(buffer, message.second -> raw(), readable);
+	sender = message.first;
+	delete message.second;
 
 	return readable;
 }
@@ -157,13 +178,120 @@ int SharedMessageEndpoint::read(void* buffer, size_t size, size_t flags) {
  */
 int SharedMessageEndpoint::write(void const* buffer, size_t size, size_t flags) {
 
+	// Remember who sent it
+	Process* process = GlobalScheduler::current_process();
+	uint64_t sender = process ? process->pid() : 0;
+
 	m_message_lock.lock();
 
 	// Create the message
 	auto* new_message = new buffer_t(size);
 	new_message->copy_from(buffer, size);
-	m_queue.push_back(new_message);
+	m_queue.push_back({ sender, new_message });
 
 	m_message_lock.unlock();
+	Resource::readiness_changed();
 	return size;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Check if there is a message waiting, writing never has to wait
+ *
+ * @param events The resource_readiness_t bits being waited for
+ * @return The bits that are ready
+ */
+size_t SharedMessageEndpoint::poll(size_t events) {
+
+	size_t ready = (size_t)resource_readiness_t::WRITABLE;
+	if(!m_queue.empty())
+		ready |= (size_t)resource_readiness_t::READABLE;
+
+	return events & ready;
+}
+
+/**
+ * @brief Gets the key a word of user memory is waited on by
+ *
+ * @param address The address of the word in the current process
+ * @return The physical address of the word or 0 if it is not a valid futex address
+ */
+uintptr_t FutexManager::physical_key(uintptr_t address) {
+
+	// Must be a aligned word in user memory
+	if(!address || address % sizeof(uint32_t) || PhysicalMemoryManager::in_higher_region(address))
+		return 0;
+
+	// Must be mapped
+	auto pml4 = GlobalScheduler::current_process()->memory_manager->vmm()->pml4_root_address();
+	auto frame = (uintptr_t)PhysicalMemoryManager::s_current_manager->get_physical_address((virtual_address_t*)address, pml4);
+	if(!frame)
+		return 0;
+
+	return frame | (address & (PAGE_SIZE - 1));
+}
+
+/**
+ * @brief Queue the current thread on a futex if the word still holds the expected value. The caller must switch away from the thread if this succeeds
+ *
+ * @param address The address of the word in the current process
+ * @param expected The value the word must hold for the thread to sleep
+ * @return True if the thread was queued, false if the value had changed or the address is invalid
+ */
+bool FutexManager::wait(uintptr_t address, uint32_t expected) {
+
+	uintptr_t key = physical_key(address);
+	if(!key)
+		return false;
+
+	s_lock.lock();
+
+	// Value changed before the lock was held, the waker has already been and gone
+	if(__atomic_load_n((uint32_t*)address, __ATOMIC_ACQUIRE) != expected) {
+		s_lock.unlock();
+		return false;
+	}
+
+	// Get the queue for this word
+	auto queue = s_waiters.find(key);
+	if(queue == s_waiters.end()) {
+		s_waiters.insert(key, new WaitQueue());
+		queue = s_waiters.find(key);
+	}
+
+	queue->second->enqueue_current();
+	s_lock.unlock();
+	return true;
+}
+
+/**
+ * @brief Wake threads waiting on a futex
+ *
+ * @param address The address of the word in the current process
+ * @param count The maximum number of threads to wake
+ * @return How many threads were woken
+ */
+size_t FutexManager::wake(uintptr_t address, size_t count) {
+
+	uintptr_t key = physical_key(address);
+	if(!key)
+		return 0;
+
+	s_lock.lock();
+
+	// Nobody waiting
+	auto queue = s_waiters.find(key);
+	if(queue == s_waiters.end()) {
+		s_lock.unlock();
+		return 0;
+	}
+
+	// Wake them and forget the queue once it is empty
+	size_t woken = queue->second->wake(count);
+	if(queue->second->empty()) {
+		delete queue->second;
+		s_waiters.erase(queue);
+	}
+
+	s_lock.unlock();
+	return woken;
+}
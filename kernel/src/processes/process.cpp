@@ -67,6 +67,7 @@ Thread::Thread(void (* _entry_point)(void*), void* args, int arg_amount, Process
 	//execution_state->rdx = (uint64_t)env_args;
 
 	parent_pid = parent->pid();
+	this->parent = parent;
 }
 
 /**
@@ -260,6 +261,7 @@ void Process::add_thread(Thread* thread) {
 	// Store the thread
 	m_threads.push_back(thread);
 	thread->parent_pid = m_pid;
+	thread->parent = this;
 
 	m_lock.unlock();
 }
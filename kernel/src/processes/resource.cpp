@@ -71,6 +71,69 @@ int Resource::write(void const* buffer, size_t size, size_t flags) {
 	return 0;
 }
 
+/**
+ * @brief Check which operations can be done on the resource without waiting
+ *
+ * @param events The resource_readiness_t bits being waited for
+ * @return The bits that are ready (by default the resource is always readable and writable)
+ */
+size_t Resource::poll(size_t events) {
+
+	return events & ((size_t) resource_readiness_t::READABLE | (size_t) resource_readiness_t::WRITABLE);
+}
+
+/**
+ * @brief Get how many times resources have said their readiness changed, taken before polling so that a change made while
+ * polling isn't missed
+ *
+ * @return The count
+ */
+uint64_t Resource::poll_generation() {
+
+	s_poll_lock.lock();
+	uint64_t generation = s_poll_generation;
+	s_poll_lock.unlock();
+
+	return generation;
+}
+
+/**
+ * @brief Sleep the current thread until a resource's readiness changes
+ *
+ * @param generation The poll_generation() from before the resources were polled, returns straight away if it has moved on
+ * @param milliseconds How long to wait at most (RESOURCE_POLL_FOREVER to never give up)
+ * @return True if something changed, false if the time ran out
+ */
+bool Resource::wait_for_change(uint64_t generation, uint64_t milliseconds) {
+
+	s_poll_lock.lock();
+
+	// Changed while the resources were being polled
+	if(s_poll_generation != generation) {
+		s_poll_lock.unlock();
+		return true;
+	}
+
+	if(milliseconds == ::syscore::RESOURCE_POLL_FOREVER) {
+		s_poll_waiters.wait(s_poll_lock);
+		return true;
+	}
+
+	return s_poll_waiters.wait_for(s_poll_lock, milliseconds);
+}
+
+/**
+ * @brief Wake the threads polling resources so they check again, called by resources once they can be read or written or
+ * have closed
+ */
+void Resource::readiness_changed() {
+
+	s_poll_lock.lock();
+	s_poll_generation++;
+	s_poll_waiters.wake(UINT32_MAX);
+	s_poll_lock.unlock();
+}
+
 /**
  * @brief Gets the name of this resource
  *
@@ -253,17 +316,24 @@ void GlobalResourceRegistry::remove_registry(BaseResourceRegistry* registry) {
 
 }
 
-ResourceManager::ResourceManager() = default;
+/**
+ * @brief Constructs a new ResourceManager with slot 0 reserved so that a 0 handle is never valid
+ */
+ResourceManager::ResourceManager() {
+
+	m_handles.push_back(resource_handle_slot_t());
+}
 
 /**
  * @brief Destructor for ResourceManager, closes all open resources
  */
 ResourceManager::~ResourceManager(){
 
-	// Collect all resources (as closing will break iteration)
+	// Collect all handles (as closing will modify the table)
 	common::Vector<uint64_t> handles;
-	for (const auto& kv : m_resources)
-		handles.push_back(kv.first);
+	for (uint32_t i = 1; i < m_handles.size(); ++i)
+		if(m_handles[i].resource)
+			handles.push_back(make_handle(i, m_handles[i].generation));
 
 	// Close the resources
 	for (auto h : handles)
@@ -271,6 +341,87 @@ ResourceManager::~ResourceManager(){
 
 }
 
+/**
+ * @brief Packs a table index and slot generation into a handle
+ *
+ * @param index The index of the slot in the handle table
+ * @param generation The generation of the slot
+ * @return The handle
+ */
+uint64_t ResourceManager::make_handle(uint32_t index, uint32_t generation) {
+
+	return ((uint64_t)generation << RESOURCE_HANDLE_INDEX_BITS) | index;
+}
+
+/**
+ * @brief Finds the slot a handle refers to
+ *
+ * @param handle The handle to look up
+ * @return The slot or nullptr if the handle is out of range, stale or closed
+ */
+resource_handle_slot_t* ResourceManager::lookup(uint64_t handle) const {
+
+	// Out of range (also rejects the reserved slot 0)
+	auto index = (uint32_t)handle;
+	if(index == 0 || index >= m_handles.size())
+		return nullptr;
+
+	// Slot has been reused or closed since this handle was given out
+	resource_handle_slot_t* slot = &m_handles[index];
+	if(slot->generation != (uint32_t)(handle >> RESOURCE_HANDLE_INDEX_BITS) || !slot->resource)
+		return nullptr;
+
+	return slot;
+}
+
+/**
+ * @brief Records that a handle has a resource of a name open
+ *
+ * @param name The name of the resource
+ * @param handle The handle it is open as
+ */
+void ResourceManager::index_name(string const& name, uint64_t handle) {
+
+	auto entry = m_name_index.find(name);
+	if(entry == m_name_index.end()) {
+		m_name_index.insert(name, { handle, 1 });
+		return;
+	}
+
+	entry->second.count++;
+}
+
+/**
+ * @brief Removes a handle from the name index, pointing the entry at another handle with the same name if there is one
+ *
+ * @param name The name of the resource
+ * @param handle The handle being closed
+ */
+void ResourceManager::unindex_name(string const& name, uint64_t handle) {
+
+	auto entry = m_name_index.find(name);
+	if(entry == m_name_index.end())
+		return;
+
+	// Last handle with this name
+	if(--entry->second.count == 0) {
+		m_name_index.erase(entry);
+		return;
+	}
+
+	// Still other handles open but the indexed one is going away, find a replacement
+	if(entry->second.handle != handle)
+		return;
+
+	for (uint32_t i = 1; i < m_handles.size(); ++i) {
+		uint64_t other = make_handle(i, m_handles[i].generation);
+		if(m_handles[i].resource && other != handle && m_handles[i].resource->name() == name) {
+			entry->second.handle = other;
+			return;
+		}
+	}
+}
+
 /**
  * @brief Get the resources currently open
  *
@@ -278,7 +429,12 @@ ResourceManager::~ResourceManager(){
  */
 common::Map<uint64_t, Resource*> ResourceManager::resources() {
 
-	return m_resources;
+	common::Map<uint64_t, Resource*> resources;
+	for (uint32_t i = 1; i < m_handles.size(); ++i)
+		if(m_handles[i].resource)
+			resources.push_back(make_handle(i, m_handles[i].generation), m_handles[i].resource);
+
+	return resources;
 }
 
 /**
@@ -292,16 +448,33 @@ common::Map<uint64_t, Resource*> ResourceManager::resources() {
 uint64_t ResourceManager::open_resource(resource_type_t type, string const& name, size_t flags) {
 
 	// Get the resource
-	auto resource = GlobalResourceRegistry::get_registry(type) -> get_resource(name);
+	auto registry = GlobalResourceRegistry::get_registry(type);
+	if(!registry)
+		return 0;
+
+	auto resource = registry -> get_resource(name);
 	if(!resource)
 		return 0;
 
+	// Reuse a free slot if there is one
+	uint32_t index = m_free_head;
+	if(index) {
+		m_free_head = m_handles[index].next_free;
+	} else {
+		index = m_handles.size();
+		m_handles.push_back(resource_handle_slot_t());
+	}
+
 	// Store it
-	m_resources.insert(m_next_handle, resource);
+	resource_handle_slot_t& slot = m_handles[index];
+	slot.resource = resource;
+	slot.next_free = 0;
+	uint64_t handle = make_handle(index, slot.generation);
+	index_name(resource->name(), handle);
 
 	// Open it
 	resource->open(flags);
-	return m_next_handle++;
+	return handle;
 }
 
 /**
@@ -312,13 +485,20 @@ uint64_t ResourceManager::open_resource(resource_type_t type, string const& name
  */
 void ResourceManager::close_resource(uint64_t handle, size_t flags) {
 
-	auto it = m_resources.find(handle);
-	if(it == m_resources.end())
+	resource_handle_slot_t* slot = lookup(handle);
+	if(!slot)
 		return;
 
 	// Remove it
-	Resource* resource = it->second;
-	m_resources.erase(handle);
+	Resource* resource = slot->resource;
+	unindex_name(resource->name(), handle);
+
+	// Invalidate any copies of the handle and put the slot on the free list
+	auto index = (uint32_t)handle;
+	slot->resource = nullptr;
+	slot->generation++;
+	slot->next_free = m_free_head;
+	m_free_head = index;
 
 	// Close it
 	GlobalResourceRegistry::get_registry(resource->type()) -> close_resource(resource, flags);
@@ -330,12 +510,10 @@ void ResourceManager::close_resource(uint64_t handle, size_t flags) {
  * @param handle The handle number of the resource
  * @return The resource or nullptr if not found
  */
-Resource* ResourceManager::get_resource(uint64_t handle) {
-
-	if(m_resources.find(handle) == m_resources.end())
-		return nullptr;
+Resource* ResourceManager::get_resource(uint64_t handle) const {
 
-	return m_resources[handle];
+	resource_handle_slot_t* slot = lookup(handle);
+	return slot ? slot->resource : nullptr;
 }
 
 /**
@@ -344,13 +522,11 @@ Resource* ResourceManager::get_resource(uint64_t handle) {
  * @param name The name of the resource
  * @return The resource or nullptr if not found
  */
-Resource* ResourceManager::get_resource(string const& name) {
+Resource* ResourceManager::get_resource(string const& name) const {
 
-	for(const auto& resource : m_resources)
-		if(resource.second->name() == name)
-			return resource.second;
+	auto entry = m_name_index.find(name);
+	if(entry == m_name_index.end())
+		return nullptr;
 
-	return nullptr;
+	return get_resource(entry->second.handle);
 }
-
-
@@ -32,6 +32,7 @@ GlobalScheduler::GlobalScheduler(Multiboot& multiboot)
 	// Set up the global scheduler
 	Logger::INFO() << "Setting up global Scheduler\n";
 	s_instance = this;
+	m_lock.enable_statistics("scheduler");
 
 	// Set up the per core scheduler
 	for(const auto& core : CPU::cores)
@@ -81,6 +82,25 @@ system::cpu_status_t* GlobalScheduler::yield(cpu_status_t* current) {
 	return core_scheduler()->yield();
 }
 
+/**
+ * @brief Puts the current kernel thread to sleep and runs the next thread until it is woken
+ *
+ * @param milliseconds How long to sleep for
+ */
+void GlobalScheduler::sleep(size_t milliseconds) {
+
+	// Interrupts are off so the scheduler can't switch away while the state is saved
+	asm volatile("cli");
+	Thread* thread = current_thread();
+	thread->sleep(milliseconds);
+	thread->save_cpu_state();
+	if(thread->thread_state == ThreadState::SLEEPING) {
+		cpu_status_t* next = core_scheduler()->schedule_next(&thread->execution_state);
+		InterruptManager::ForceInterruptReturn(next);
+	}
+	asm volatile("sti");
+}
+
 /**
  * @brief Destroys the global scheduler and frees the per core schedulers
  */
@@ -164,8 +184,10 @@ void GlobalScheduler::load_multiboot_elfs(Multiboot* multiboot) {
 
 /**
  * @brief Print the header for the running processes in the form ({name}:t{tid}c{core})
+ *
+ * @param stream Where to print the header
  */
-void GlobalScheduler::print_running_header() {
+void GlobalScheduler::print_running_header(common::OutputStream& stream) {
 
 	// No threads or processes to get
 	if(!s_instance || !s_instance->m_active)
@@ -174,7 +196,7 @@ void GlobalScheduler::print_running_header() {
 	auto process = current_process();
 	auto thread   = current_thread();
 
-	Logger::Out() << "(" << process->name << ":t" << thread->tid  << "c" << CPU::executing_core()->id << ") ";
+	stream << "(" << process->name << ":t" << thread->tid  << "c" << CPU::executing_core()->id << ") ";
 }
 
 /**
@@ -356,7 +378,7 @@ Scheduler* GlobalScheduler::core_scheduler() {
  * @return True if the scheduler is active, false otherwise
  */
 bool GlobalScheduler::is_active() {
-	return s_instance->m_active;
+	return s_instance && s_instance->m_active;
 }
 
 /**
@@ -646,16 +668,8 @@ cpu_status_t* Scheduler::force_remove_process(Process* process) {
  */
 Process* Scheduler::current_process() {
 
-	Process* current_process = nullptr;
-
-	// Find the process that has the thread being executed
-	for (auto process: m_processes)
-		if (process->pid() == current_thread()->parent_pid) {
-			current_process = process;
-			break;
-		}
-
-	return current_process;
+	// Threads are owned by their process so the back pointer is always valid
+	return current_thread()->parent;
 }
 
 /**
@@ -223,7 +223,33 @@ void Core::init_sse() {
 }
 
 /**
- * @brief Initialises the core by setting up the GDT, IDT, TSS, SSE and APIC
+ * @brief Programs the Page Attribute Table so pages can be mapped write combining (entry 1, selected by the write through
+ * bit alone) and write through (entry 7). The entries the page flags selected before are otherwise unchanged.
+ *
+ * @note Every core must use the same layout
+ */
+void Core::init_pat() {
+
+	// Without a PAT, WRITE_COMBINING mappings fall back to the default entry 1 (write through)
+	if(!CPU::check_cpu_feature(CPU_FEATURE_EDX::PAT)) {
+		Logger::WARNING() << "PAT not supported, write combining unavailable\n";
+		return;
+	}
+
+	// Flush the caches and TLB around the change so no line or translation is kept with the old memory type
+	asm volatile("wbinvd" : : : "memory");
+	CPU::write_msr(PAT_MSR, PAT_LAYOUT);
+	asm volatile("wbinvd" : : : "memory");
+
+	uint64_t cr3;
+	asm volatile("mov %%cr3, %0" : "=r" (cr3));
+	asm volatile("mov %0, %%cr3" : : "r" (cr3) : "memory");
+
+	Logger::DEBUG() << "PAT Enabled\n";
+}
+
+/**
+ * @brief Initialises the core by setting up the GDT, IDT, TSS, SSE, PAT and APIC
  */
 void Core::init() {
 
@@ -238,6 +264,7 @@ void Core::init() {
 	// Delegate large initiation
 	init_sse();
 	init_tss();
+	init_pat();
 
 	active = true;
 }
@@ -265,6 +292,7 @@ CPU::CPU(GlobalDescriptorTable* gdt, Multiboot* multiboot)
 	bsp -> local_apic = apic.local_apic();
 	bsp -> init_tss();
 	bsp -> init_sse();
+	bsp -> init_pat();
 
 }
 
@@ -391,6 +419,18 @@ void CPU::write_msr(uint32_t msr, uint64_t value) {
 	asm volatile("wrmsr" : : "a" ((uint32_t) value), "d" ((uint32_t) (value >> 32)), "c" (msr));
 }
 
+/**
+ * @brief Reads the time stamp counter of the executing core
+ *
+ * @return The number of cycles since the core was reset
+ */
+uint64_t CPU::read_timestamp() {
+
+	uint32_t low, high;
+	asm volatile("rdtsc" : "=a" (low), "=d" (high));
+	return (uint64_t) low | ((uint64_t) high << 32);
+}
+
 /**
  * @brief Executes the CPUID instruction with the specified leaf and returns the results in the provided pointers
  *
@@ -443,6 +483,9 @@ void CPU::PANIC(char const* message, cpu_status_t* status) {
 	prepare_for_panic();
 	panic_lock.lock();
 
+	// Write out what was logged before the panic, then log straight to the writers
+	Logger::active_logger()->stop_buffering();
+
 	// Get the current process
 	Process* process = GlobalScheduler::current_process();
 
@@ -0,0 +1,171 @@
+/**
+ * @file debugshell.cpp
+ * @brief Implements a shell over the serial port for inspecting the kernel
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+ */
+
+#include <system/debugshell.h>
+#include <system/cpu.h>
+#include <processes/scheduler.h>
+#include <hardwarecommunication/interrupts.h>
+#include <memory/physical.h>
+
+using namespace MaxOS;
+using namespace MaxOS::common;
+using namespace MaxOS::drivers;
+using namespace MaxOS::hardwarecommunication;
+using namespace MaxOS::memory;
+using namespace MaxOS::processes;
+using namespace MaxOS::system;
+
+/**
+ * @brief Starts the thread that reads commands from the serial port
+ *
+ * @param serial The serial port to read from and write to
+ *
+ * @note Needs the scheduler, without it the shell does nothing
+ */
+DebugShell::DebugShell(SerialConsole* serial)
+: m_serial(serial)
+{
+
+	if (!GlobalScheduler::system_scheduler())
+		return;
+
+	DebugShell* args[] = { this };
+	auto* shell = new Process("Debug Shell", (void (*)(void*)) (uintptr_t) worker, args, 1, true);
+	GlobalScheduler::system_scheduler()->add_process(shell);
+}
+
+DebugShell::~DebugShell() = default;
+
+/**
+ * @brief Handles the characters that have been received since the last poll
+ */
+void DebugShell::poll() {
+
+	char received[SERIAL_RECEIVE_BUFFER_SIZE];
+	size_t count = m_serial->read(received, sizeof(received));
+	for (size_t i = 0; i < count; i++)
+		receive(received[i]);
+}
+
+/**
+ * @brief Writes the prompt for the next command
+ */
+void DebugShell::prompt() {
+	m_serial->write("debug> ");
+}
+
+/**
+ * @brief Adds a character to the line, running it once it ends
+ *
+ * @param c The character received
+ */
+void DebugShell::receive(char c) {
+
+	switch (c) {
+
+		// Terminals send either
+		case '\r':
+		case '\n':
+			m_serial->write("\n");
+			m_line[m_length] = '\0';
+			run(m_line);
+			m_length = 0;
+			prompt();
+			break;
+
+		// Backspace or delete
+		case '\b':
+		case 0x7F:
+			if (!m_length)
+				break;
+
+			m_length--;
+			m_serial->write("\b \b");
+			break;
+
+		default:
+
+			// Leave room for the terminator and ignore control characters
+			if (m_length >= DEBUG_SHELL_LINE_MAX - 1 || c < ' ')
+				break;
+
+			m_line[m_length++] = c;
+			m_serial->write_char(c);
+			break;
+	}
+}
+
+/**
+ * @brief Runs a command
+ *
+ * @param command The line that was entered
+ */
+void DebugShell::run(const char* command) {
+
+	if (!command[0])
+		return;
+
+	if (strcmp(command, "help")) {
+		m_serial->write("help    - list the commands\n");
+		m_serial->write("uptime  - ticks since the scheduler started on this core\n");
+		m_serial->write("memory  - physical memory in use\n");
+		m_serial->write("cores   - the cores and whether they are running\n");
+		m_serial->write("locks   - contention of the tracked locks\n");
+		return;
+	}
+
+	if (strcmp(command, "uptime")) {
+		m_serial->write(itoa(10, (int64_t) GlobalScheduler::core_scheduler()->ticks()));
+		m_serial->write(" ticks\n");
+		return;
+	}
+
+	if (strcmp(command, "memory")) {
+		m_serial->write(itoa(10, (int64_t) (PhysicalMemoryManager::s_current_manager->memory_used() / 1024)));
+		m_serial->write(" KB used\n");
+		return;
+	}
+
+	if (strcmp(command, "cores")) {
+		for (auto core : CPU::cores) {
+			m_serial->write("Core ");
+			m_serial->write(itoa(10, core->id));
+			m_serial->write(core->active ? ": active\n" : ": inactive\n");
+		}
+		return;
+	}
+
+	// These are logged, write them out before the next prompt
+	if (strcmp(command, "locks")) {
+		LockStatistics::print_all();
+		Logger::active_logger()->flush();
+		return;
+	}
+
+	m_serial->write("Unknown command: ");
+	m_serial->write(command);
+	m_serial->write("\n");
+}
+
+/**
+ * @brief Checks for input then sleeps, forever
+ *
+ * @param argc The number of arguments (1)
+ * @param argv The shell to poll
+ */
+void DebugShell::worker(uint64_t argc, DebugShell** argv) {
+
+	DebugShell* shell = argv[0];
+	shell->prompt();
+	while (true) {
+
+		shell->poll();
+
+		GlobalScheduler::sleep(DEBUG_SHELL_POLL_INTERVAL);
+	}
+}
@@ -8,6 +8,7 @@
 
 #include <system/syscalls.h>
 #include <common/logger.h>
+#include <drivers/clock/clock.h>
 
 using namespace syscore;
 using namespace MaxOS;
@@ -16,6 +17,7 @@ using namespace MaxOS::hardwarecommunication;
 using namespace MaxOS::system;
 using namespace MaxOS::processes;
 using namespace MaxOS::memory;
+using namespace MaxOS::drivers::clock;
 
 /**
  * @brief Construct a new Syscall Manager object and register the syscall handlers. Registers to interrupt 0x80
@@ -38,6 +40,9 @@ SyscallManager::SyscallManager()
 	set_syscall_handler(SyscallType::THREAD_YIELD, syscall_thread_yield);
 	set_syscall_handler(SyscallType::THREAD_SLEEP, syscall_thread_sleep);
 	set_syscall_handler(SyscallType::THREAD_CLOSE, syscall_thread_close);
+	set_syscall_handler(SyscallType::FUTEX_WAIT, syscall_futex_wait);
+	set_syscall_handler(SyscallType::FUTEX_WAKE, syscall_futex_wake);
+	set_syscall_handler(SyscallType::RESOURCE_POLL, syscall_resource_poll);
 
 }
 
@@ -300,6 +305,58 @@ syscall_args_t* SyscallManager::syscall_resource_read(syscall_args_t* args) {
 	return args;
 }
 
+/**
+ * @brief System call to wait for any of a set of resources to become ready, sleeping until one of them changes
+ *
+ * @param args Arg0 = Entries Arg1 = Count Arg2 = Timeout (ms, 0 to just check, RESOURCE_POLL_FOREVER to never give up)
+ * @return The number of entries that are ready, 0 if the timeout passed
+ */
+syscall_args_t* SyscallManager::syscall_resource_poll(syscall_args_t* args) {
+
+	// Parse params
+	auto entries = (resource_poll_entry_t*)args->arg0;
+	auto count 	= (size_t)args->arg1;
+	auto timeout = (uint64_t)args->arg2;
+
+	Clock* clock = Clock::active_clock();
+	uint64_t start = clock ? clock->uptime() : 0;
+
+	size_t ready = 0;
+	while (true) {
+
+		// Check each resource, a closed or invalid handle is always ready so the caller notices
+		uint64_t generation = Resource::poll_generation();
+		ready = 0;
+		for (size_t i = 0; i < count; ++i) {
+
+			auto resource = GlobalScheduler::current_process()->resource_manager.get_resource(entries[i].handle);
+			entries[i].ready = resource ? resource->poll(entries[i].events) : (size_t)resource_readiness_t::CLOSED;
+
+			if(entries[i].ready)
+				ready++;
+		}
+
+		if(ready || !timeout)
+			break;
+
+		// Sleep until one of the resources (or any other) changes
+		uint64_t remaining = timeout;
+		if(timeout != RESOURCE_POLL_FOREVER && clock) {
+			uint64_t waited = clock->uptime() - start;
+			if(waited >= timeout)
+				break;
+			remaining = timeout - waited;
+		}
+
+		// Out of time, check one last time
+		if(!Resource::wait_for_change(generation, remaining))
+			timeout = 0;
+	}
+
+	args->return_value = ready;
+	return args;
+}
+
 /**
  * @brief System call to yield the current process
  *
@@ -357,4 +414,45 @@ syscall_args_t* SyscallManager::syscall_thread_close(syscall_args_t* args) {
 
 	// Done
 	return args;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief System call to sleep the current thread on a futex
+ *
+ * @param args Arg0 = address Arg1 = expected value
+ * @return 1 if the thread slept and was woken, 0 if the value had already changed
+ */
+syscall_args_t* SyscallManager::syscall_futex_wait(syscall_args_t* args) {
+
+	// Get the args
+	auto address = (uintptr_t)args->arg0;
+	auto expected = (uint32_t)args->arg1;
+
+	// Value changed, don't sleep
+	if(!FutexManager::wait(address, expected)){
+		args->return_value = 0;
+		return args;
+	}
+
+	// Thread will resume with this return value once woken
+	args->return_state->rax = 1;
+	args->return_state = GlobalScheduler::core_scheduler()->schedule_next(args->return_state);
+	return args;
+}
+
+/**
+ * @brief System call to wake threads sleeping on a futex
+ *
+ * @param args Arg0 = address Arg1 = max threads to wake
+ * @return The number of threads woken
+ */
+syscall_args_t* SyscallManager::syscall_futex_wake(syscall_args_t* args) {
+
+	// Get the args
+	auto address = (uintptr_t)args->arg0;
+	auto count = (size_t)args->arg1;
+
+	// Wake the threads
+	args->return_value = FutexManager::wake(address, count);
+	return args;
+}
@@ -10,11 +10,14 @@
 #include <common/buffer.h>
 #include <common/colour.h>
 #include <common/graphicsContext.h>
+#include <common/hashmap.h>
 #include <common/inputStream.h>
 #include <common/logger.h>
 #include <common/map.h>
 #include <common/outputStream.h>
 #include <common/rectangle.h>
+#include <common/region.h>
+#include <common/spinlock.h>
 #include <common/string.h>
 #include <common/time.h>
 #include <common/vector.h>
@@ -304,6 +307,56 @@ void register_colour_tests() {
 
 }
 
+/**
+ * @brief Registers all log ring tests
+ */
+void register_log_ring_tests() {
+
+	MAXOS_CONDITIONAL_TEST(LogRing_Read_OnlyWholeLines, TestType::COMMON)
+	{
+		auto* ring = new LogRing;
+		const char* text = "first\nsecond";
+		for(const char* c = text; *c; c++)
+			ring->append(*c);
+
+		// The unfinished line stays in the ring
+		char buffer[32] = { };
+		bool passed = compare((int) ring->read(buffer, sizeof(buffer)), 6) && strncmp(buffer, "first\n", 6);
+
+		ring->append('\n');
+		passed = passed && compare((int) ring->read(buffer, sizeof(buffer)), 7) && strncmp(buffer, "second\n", 7);
+
+		delete ring;
+		return passed;
+	});
+
+	MAXOS_CONDITIONAL_TEST(LogRing_Full_DropsAndWraps, TestType::COMMON)
+	{
+		auto* ring = new LogRing;
+		char buffer[LOG_DRAIN_CHUNK];
+
+		// Fill past the end, the extra characters are counted
+		for(uint32_t i = 0; i < LOG_RING_SIZE + 10; i++)
+			ring->append((char) ('a' + i % 26));
+		bool passed = compare((int) ring->take_dropped(), 10) && compare((int) ring->take_dropped(), 0);
+
+		// A full ring can be read without a new line, then its space reused across the end of the buffer
+		uint32_t drained = 0;
+		size_t read;
+		while((read = ring->read(buffer, sizeof(buffer))) > 0)
+			drained += read;
+		passed = passed && compare((int) drained, (int) LOG_RING_SIZE);
+
+		const char* text = "wrapped\n";
+		for(const char* c = text; *c; c++)
+			passed = passed && ring->append(*c);
+		passed = passed && compare((int) ring->read(buffer, sizeof(buffer)), 8) && strncmp(buffer, text, 8);
+
+		delete ring;
+		return passed;
+	});
+}
+
 /**
  * @brief Registers all map tests
  */
@@ -453,6 +506,95 @@ void register_map_tests() {
 	});
 }
 
+/**
+ * @brief Registers all hash map tests
+ */
+void register_hashmap_tests() {
+
+	MAXOS_CONDITIONAL_TEST(HashMap_EmptyOnConstruct, TestType::COMMON)
+	{
+		HashMap<int, int> m;
+		if(!compare(m.empty(), true)) return false;
+		return m.find(1) == m.end();
+	});
+
+	MAXOS_CONDITIONAL_TEST(HashMap_Insert_AddAndUpdate, TestType::COMMON)
+	{
+		// Add then update the same key
+		HashMap<int, int> m;
+		m.insert(5, 50);
+		m.insert(5, 55);
+
+		// Verify only one element with the new value
+		if(!compare((int)m.size(), 1)) return false;
+		return compare(m[5], 55);
+	});
+
+	MAXOS_CONDITIONAL_TEST(HashMap_Grow_KeepsAllElements, TestType::COMMON)
+	{
+		// Insert enough to force several rehashes
+		HashMap<uint64_t, uint64_t> m;
+		for(uint64_t i = 0; i < 200; i++)
+			m.insert(i * 7, i);
+
+		if(!compare((int)m.size(), 200)) return false;
+
+		// Every element should still be found
+		for(uint64_t i = 0; i < 200; i++) {
+			auto it = m.find(i * 7);
+			if(it == m.end() || !compare(it->second, i))
+				return false;
+		}
+
+		return true;
+	});
+
+	MAXOS_CONDITIONAL_TEST(HashMap_Erase_KeepsProbeChain, TestType::COMMON)
+	{
+		// Fill and then remove every other element
+		HashMap<int, int> m;
+		for(int i = 0; i < 32; i++)
+			m.insert(i, i * 2);
+		for(int i = 0; i < 32; i += 2)
+			m.erase(i);
+
+		if(!compare((int)m.size(), 16)) return false;
+
+		// Removed elements are gone, the rest can still be reached past the deleted slots
+		for(int i = 0; i < 32; i++) {
+			bool present = m.contains(i);
+			if(!compare(present, i % 2 == 1))
+				return false;
+		}
+
+		return true;
+	});
+
+	MAXOS_CONDITIONAL_TEST(HashMap_StringKeys, TestType::COMMON)
+	{
+		HashMap<string, int> m;
+		m.insert("alpha", 1);
+		m.insert("beta", 2);
+
+		if(!compare(m[string("beta")], 2)) return false;
+		return compare(m.contains(string("gamma")), false);
+	});
+
+	MAXOS_CONDITIONAL_TEST(HashMap_Iterate_VisitsAll, TestType::COMMON)
+	{
+		HashMap<int, int> m;
+		for(int i = 1; i <= 10; i++)
+			m.insert(i, i);
+
+		// Sum the values through iteration
+		int total = 0;
+		for(auto& pair : m)
+			total += pair.second;
+
+		return compare(total, 55);
+	});
+}
+
 /**
  * @brief Registers all rectangle tests
  */
@@ -581,6 +723,164 @@ void register_rectangle_tests() {
 
 }
 
+/**
+ * @brief Registers all region tests
+ */
+void register_region_tests() {
+
+	MAXOS_CONDITIONAL_TEST(Region_Unite_Overlapping_SplitsIntoBands, TestType::COMMON)
+	{
+		Region region(Rectangle<int32_t>(0, 0, 10, 10));
+		region.unite(Rectangle<int32_t>(5, 5, 10, 10));
+
+		// Top, middle and bottom bands, the overlap is only counted once
+		if(!compare((int) region.rectangles().size(), 3)) return false;
+		if(!compare((int) region.area(), 175)) return false;
+		if(!compare(region.contains(12, 2), false)) return false;
+		if(!compare(region.contains(12, 7), true)) return false;
+
+		Rectangle<int32_t> extents = region.extents();
+		if(!compare(extents.width, 15)) return false;
+		return compare(extents.height, 15);
+	});
+
+	MAXOS_CONDITIONAL_TEST(Region_Unite_Adjacent_Coalesces, TestType::COMMON)
+	{
+		// Stacked rectangles with the same spans merge into one band, side by side ones into one span
+		Region region(Rectangle<int32_t>(0, 0, 10, 5));
+		region.unite(Rectangle<int32_t>(0, 5, 10, 5));
+		region.unite(Rectangle<int32_t>(10, 0, 5, 10));
+
+		if(!compare((int) region.rectangles().size(), 1)) return false;
+		const Rectangle<int32_t>& rectangle = region.rectangles()[0];
+		if(!compare(rectangle.width, 15)) return false;
+		return compare(rectangle.height, 10);
+	});
+
+	MAXOS_CONDITIONAL_TEST(Region_Subtract_Hole, TestType::COMMON)
+	{
+		Region region(Rectangle<int32_t>(0, 0, 10, 10));
+		region.subtract(Rectangle<int32_t>(3, 3, 4, 4));
+
+		// Above, left of, right of and below the hole
+		if(!compare((int) region.rectangles().size(), 4)) return false;
+		if(!compare((int) region.area(), 84)) return false;
+		if(!compare(region.contains(4, 4), false)) return false;
+
+		// Filling the hole back in makes it one rectangle again
+		region.unite(Rectangle<int32_t>(3, 3, 4, 4));
+		return compare((int) region.rectangles().size(), 1);
+	});
+
+	MAXOS_CONDITIONAL_TEST(Region_Intersect_KeepsOverlap, TestType::COMMON)
+	{
+		Region region(Rectangle<int32_t>(0, 0, 10, 10));
+		region.unite(Rectangle<int32_t>(20, 0, 10, 10));
+		region.intersect(Rectangle<int32_t>(5, 5, 20, 20));
+
+		if(!compare((int) region.rectangles().size(), 2)) return false;
+		if(!compare((int) region.area(), 50)) return false;
+
+		// Nothing is left after intersecting with somewhere else
+		region.intersect(Rectangle<int32_t>(100, 100, 5, 5));
+		return compare(region.empty(), true);
+	});
+
+	MAXOS_CONDITIONAL_TEST(Region_Include_MergesNearbyDamage, TestType::COMMON)
+	{
+		// A window moved diagonally redraws its old and new position as one rectangle
+		Region region;
+		region.include(Rectangle<int32_t>(100, 100, 300, 200), 4096, 32);
+		region.include(Rectangle<int32_t>(110, 105, 300, 200), 4096, 32);
+		if(!compare((int) region.rectangles().size(), 1)) return false;
+
+		// Damage far away is kept apart
+		region.include(Rectangle<int32_t>(600, 600, 10, 10), 4096, 32);
+		return compare((int) region.rectangles().size(), 2);
+	});
+
+	MAXOS_CONDITIONAL_TEST(Region_Include_Bounded, TestType::COMMON)
+	{
+		// Scattered damage past the limit is replaced by its bounds
+		Region region;
+		for(int32_t i = 0; i < 5; i++)
+			region.include(Rectangle<int32_t>(i * 100, i * 100, 10, 10), 0, 4);
+
+		if(!compare((int) region.rectangles().size(), 1)) return false;
+		return compare((int) region.area(), 410 * 410);
+	});
+
+}
+
+/**
+ * @brief Registers all lock tests
+ */
+void register_spinlock_tests() {
+
+	MAXOS_CONDITIONAL_TEST(Spinlock_AcquireRelease, TestType::COMMON)
+	{
+		Spinlock lock;
+		if(!compare(lock.is_locked(), false)) return false;
+
+		lock.acquire();
+		if(!compare(lock.is_locked(), true)) return false;
+
+		lock.release();
+		return compare(lock.is_locked(), false);
+	});
+
+	MAXOS_CONDITIONAL_TEST(Spinlock_TryAcquire_FailsWhenHeld, TestType::COMMON)
+	{
+		// Free lock can be taken
+		Spinlock lock;
+		if(!compare(lock.try_acquire(), true)) return false;
+
+		// Held lock can't
+		if(!compare(lock.try_acquire(), false)) return false;
+
+		// Queue must not have moved on from the failed attempt
+		lock.release();
+		return compare(lock.is_locked(), false);
+	});
+
+	MAXOS_CONDITIONAL_TEST(Spinlock_Statistics_CountAcquisitions, TestType::COMMON)
+	{
+		Spinlock lock;
+		lock.enable_statistics("test");
+
+		for(int i = 0; i < 3; i++) {
+			lock.acquire();
+			lock.release();
+		}
+
+		return compare((int)lock.statistics()->acquisitions, 3) && compare((int)lock.statistics()->contended, 0);
+	});
+
+	MAXOS_CONDITIONAL_TEST(ReadWriteLock_SharedReaders, TestType::COMMON)
+	{
+		// Many readers at once
+		ReadWriteLock lock;
+		lock.read_lock();
+		lock.read_lock();
+		if(!compare(lock.is_locked(), true)) return false;
+		if(!compare(lock.is_write_locked(), false)) return false;
+
+		lock.read_unlock();
+		lock.read_unlock();
+		return compare(lock.is_locked(), false);
+	});
+
+	MAXOS_CONDITIONAL_TEST(ReadWriteLock_Writer, TestType::COMMON)
+	{
+		ReadWriteLock lock;
+		lock.write_lock();
+		if(!compare(lock.is_write_locked(), true)) return false;
+
+		lock.write_unlock();
+		return compare(lock.is_locked(), false);
+	});
+}
+
 /**
  * @brief Registers all string tests
  */
@@ -910,8 +1210,12 @@ void register_vector_tests() {
 void MaxOS::tests::register_tests_common() {
 	register_buffer_tests();
 	register_colour_tests();
+	register_hashmap_tests();
+	register_log_ring_tests();
 	register_map_tests();
 	register_rectangle_tests();
+	register_region_tests();
+	register_spinlock_tests();
 	register_string_tests();
 	register_time_tests();
 	register_vector_tests();
@@ -0,0 +1,76 @@
+/**
+ * @file drivers.cpp
+ * @brief Implements the tests for the device drivers of MaxOS
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+*/
+
+#include <tests/drivers.h>
+#include <common/logger.h>
+#include <drivers/clock/clock.h>
+#include <drivers/console/serial.h>
+
+using namespace ::MaxOS;
+using namespace ::MaxOS::tests;
+using namespace ::MaxOS::common;
+using namespace ::MaxOS::drivers;
+using namespace ::MaxOS::drivers::clock;
+
+/// How long (ms) the serial port gets to send a burst (a 16 character FIFO takes about 4ms at 38400 baud)
+constexpr uint32_t SERIAL_DRAIN_TIMEOUT = 1000;
+
+/**
+ * @brief Waits for everything queued on the serial port to be sent
+ *
+ * @param serial The serial console
+ * @param clock The clock to time out against
+ * @return True if the queue emptied before the timeout
+ */
+static bool wait_for_serial_drain(SerialConsole* serial, Clock* clock) {
+
+	uint64_t deadline = clock->uptime() + SERIAL_DRAIN_TIMEOUT;
+	while(serial->queued()) {
+		if(clock->uptime() > deadline)
+			return false;
+
+		asm volatile("pause");
+	}
+
+	return true;
+}
+
+/**
+ * @brief Registers the serial console tests
+ */
+static void register_serial_tests() {
+
+	MAXOS_CONDITIONAL_TEST(Serial_Transmit_KeepsFlowingAfterIdle, TestType::DRIVER)
+	{
+		auto* serial = SerialConsole::active_console();
+		Clock* clock = Clock::active_clock();
+		if(!serial || !clock) {
+			Logger::TEST() << "No serial port or clock, skipping\n";
+			return true;
+		}
+
+		// Every burst after the first is queued once the port has gone idle and the last transmitter empty interrupt found
+		// nothing to send, which is when output used to stop
+		for(int burst = 0; burst < 3; ++burst) {
+			serial->write("Serial transmit test burst, this line is longer than the 16 character FIFO\n");
+			if(!wait_for_serial_drain(serial, clock))
+				return false;
+
+			clock->delay(10);
+		}
+
+		return true;
+	});
+}
+
+/**
+ * @brief Registers all driver tests with the test runner
+ */
+void MaxOS::tests::register_tests_drivers() {
+	register_serial_tests();
+}
@@ -0,0 +1,210 @@
+/**
+ * @file filesystem.cpp
+ * @brief Implements the tests for the filesystems of MaxOS
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+*/
+
+#include <tests/filesystem.h>
+#include <common/logger.h>
+#include <filesystem/format/ext2.h>
+
+using namespace ::MaxOS;
+using namespace ::MaxOS::tests;
+using namespace ::MaxOS::common;
+using namespace ::MaxOS::drivers::disk;
+using namespace ::MaxOS::filesystem;
+using namespace ::MaxOS::filesystem::format::ext2;
+
+/// How many 1KB blocks the test ext2 image has (block 0 is the boot block)
+constexpr uint32_t TEST_EXT2_BLOCKS = 65;
+
+/// The test ext2 image, large enough that it has to be static
+static uint8_t s_ext2_image[TEST_EXT2_BLOCKS * 1024];
+
+/**
+ * @class MemoryDisk
+ * @brief A disk stored in memory that counts the requests made to it
+ */
+class MemoryDisk final : public Disk {
+
+	public:
+		uint8_t* data;          ///< The contents of the disk
+		uint32_t requests = 0;  ///< How many read requests have been made
+
+		explicit MemoryDisk(uint8_t* data) : data(data) { }
+		~MemoryDisk() = default;
+
+		void read(uint32_t sector, buffer_t* data_buffer, size_t amount) final {
+			requests++;
+			for(size_t i = 0; i < amount; ++i)
+				data_buffer->write(data[sector * 512 + i]);
+		}
+
+		void read_sectors(uint32_t sector, uint32_t count, buffer_t* data_buffer) final {
+			requests++;
+			for(size_t i = 0; i < count * 512; ++i)
+				data_buffer->write(data[sector * 512 + i]);
+		}
+
+		void write(uint32_t sector, buffer_t* data_buffer, size_t count) final {
+			for(size_t i = 0; i < count; ++i)
+				data[sector * 512 + i] = data_buffer->read();
+		}
+};
+
+/// Where each logical block of the test file is stored (0 is a hole), the file is 16 blocks long
+static const uint32_t s_sparse_layout[16] = { 10, 11, 12, 0, 0, 15, 16, 17, 0, 0, 0, 0, 0, 22, 23, 0 };
+
+/**
+ * @brief Build an ext2 image with one group of 1KB blocks, inode 2 is a file with holes in its direct and indirect blocks
+ * and after its last block. Every data block is filled with its block number
+ */
+static void build_sparse_image() {
+
+	memset(s_ext2_image, 0, sizeof(s_ext2_image));
+
+	// Superblock (block 1)
+	auto* superblock = (superblock_t*) (s_ext2_image + 1024);
+	superblock->total_inodes = 8;
+	superblock->total_blocks = TEST_EXT2_BLOCKS;
+	superblock->unallocated_blocks = 34;
+	superblock->starting_block = 1;
+	superblock->blocks_per_group = 64;
+	superblock->inodes_per_group = 8;
+	superblock->signature = 0xEF53;
+
+	// Block group descriptor table (block 2)
+	auto* group = (block_group_descriptor_t*) (s_ext2_image + 2 * 1024);
+	group->block_usage_bitmap = 3;
+	group->block_inode_bitmap = 4;
+	group->inode_table_address = 5;
+	group->free_blocks = 34;
+
+	// Blocks 1 to 30 and every inode are used
+	memset(s_ext2_image + 3 * 1024, 0xFF, 30 / 8);
+	s_ext2_image[3 * 1024 + 30 / 8] = (1 << (30 % 8)) - 1;
+	s_ext2_image[4 * 1024] = 0xFF;
+
+	// The file's inode (inode 2 is the second in the table at block 5)
+	auto* inode = (inode_t*) (s_ext2_image + 5 * 1024 + 128);
+	inode->type_permissions = (uint16_t) InodeType::FILE | (uint16_t) InodePermissionsDefaults::FILE;
+	inode->size_lower = 16 * 1024;
+	for(uint32_t i = 0; i < 12; ++i)
+		inode->block_pointers[i] = s_sparse_layout[i];
+
+	// The indirect pointers (block 20)
+	inode->l1_indirect = 20;
+	auto* pointers = (uint32_t*) (s_ext2_image + 20 * 1024);
+	for(uint32_t i = 12; i < 16; ++i)
+		pointers[i - 12] = s_sparse_layout[i];
+
+	// The data
+	for(auto block : s_sparse_layout)
+		if(block)
+			memset(s_ext2_image + block * 1024, (int) block, 1024);
+}
+
+/**
+ * @brief Check that the data read from the test file matches the layout
+ *
+ * @param data The data read from the start of the file
+ * @param size How much was read
+ * @return True if every byte matches
+ */
+static bool check_sparse_data(buffer_t* data, size_t size) {
+
+	for(size_t i = 0; i < size; ++i) {
+		uint8_t expected = (uint8_t) s_sparse_layout[i / 1024];
+		if(!compare(data->raw()[i], expected))
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Registers all ext2 tests
+ */
+void register_ext2_tests() {
+
+	MAXOS_CONDITIONAL_TEST(Ext2_Inode_HolesInBlockMap, TestType::FILESYSTEM)
+	{
+		build_sparse_image();
+		MemoryDisk disk(s_ext2_image);
+		Ext2Volume volume(&disk, 0);
+		InodeHandler handler(&volume, 2);
+
+		// The trailing hole isn't counted but the ones before the last block are
+		if(!compare((int) handler.block_count(), 15))
+			return false;
+
+		// Runs, holes and past the end
+		uint32_t length = 0;
+		if(!compare((int) handler.extent(0, length), 10) || !compare((int) length, 3)) return false;
+		if(!compare((int) handler.extent(3, length), 0) || !compare((int) length, 1)) return false;
+		if(!compare((int) handler.extent(6, length), 16) || !compare((int) length, 2)) return false;
+		if(!compare((int) handler.extent(12, length), 0) || !compare((int) length, 1)) return false;
+		if(!compare((int) handler.extent(13, length), 22) || !compare((int) length, 2)) return false;
+		return compare((int) handler.extent(15, length), 0) && compare((int) length, 1);
+	});
+
+	MAXOS_CONDITIONAL_TEST(Ext2_File_HolesReadAsZero, TestType::FILESYSTEM)
+	{
+		build_sparse_image();
+		MemoryDisk disk(s_ext2_image);
+		Ext2Volume volume(&disk, 0);
+		Ext2File file(&volume, 2, "sparse");
+
+		// Read the whole file, including the hole after the last block
+		buffer_t data(16 * 1024);
+		disk.requests = 0;
+		file.read(&data, 16 * 1024);
+
+		// Each run is one request: 10-12, 15-17, the pointer block and then 22-23
+		if(!compare((int) disk.requests, 4))
+			return false;
+
+		return check_sparse_data(&data, 16 * 1024);
+	});
+
+	MAXOS_CONDITIONAL_TEST(Ext2_File_WriteFillsHole, TestType::FILESYSTEM)
+	{
+		build_sparse_image();
+		MemoryDisk disk(s_ext2_image);
+		Ext2Volume volume(&disk, 0);
+
+		// Write into the middle of the indirect hole
+		{
+			Ext2File file(&volume, 2, "sparse");
+			uint8_t bytes[] = { 0xAB, 0xCD };
+			buffer_t data(bytes, sizeof(bytes));
+			file.seek(SeekType::SET, 12 * 1024 + 100);
+			file.write(&data, sizeof(bytes));
+		}
+
+		// Open it again so the block map comes from the disk
+		Ext2File file(&volume, 2, "sparse");
+		buffer_t data(16 * 1024);
+		file.read(&data, 16 * 1024);
+
+		// The new block is zeroed apart from what was written and the rest of the file is unchanged
+		for(size_t i = 0; i < 16 * 1024; ++i) {
+			uint8_t expected = (uint8_t) s_sparse_layout[i / 1024];
+			if(i == 12 * 1024 + 100) expected = 0xAB;
+			if(i == 12 * 1024 + 101) expected = 0xCD;
+			if(!compare(data.raw()[i], expected))
+				return false;
+		}
+
+		return compare((int) file.size(), 16 * 1024);
+	});
+}
+
+/**
+ * @brief Registers all filesystem tests with the test runner
+ */
+void MaxOS::tests::register_tests_filesystem() {
+	register_ext2_tests();
+}
@@ -0,0 +1,622 @@
+/**
+ * @file gui.cpp
+ * @brief Implements the tests for the graphics and GUI components of MaxOS
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+*/
+
+#include <tests/gui.h>
+#include <common/graphicsContext.h>
+#include <common/logger.h>
+#include <common/region.h>
+#include <drivers/clock/clock.h>
+#include <drivers/video/vesa.h>
+#include <gui/desktop.h>
+#include <gui/font.h>
+#include <gui/font/amiga_font.h>
+#include <gui/window.h>
+#include <gui/windowserver.h>
+#include <memory/memoryIO.h>
+#include <memory/physical.h>
+#include <system/cpu.h>
+
+using namespace ::MaxOS;
+using namespace ::MaxOS::tests;
+using namespace ::MaxOS::common;
+using namespace ::MaxOS::drivers::clock;
+using namespace ::MaxOS::drivers::video;
+using namespace ::MaxOS::memory;
+using namespace ::MaxOS::gui;
+using namespace ::MaxOS::processes;
+using namespace ::MaxOS::system;
+
+/**
+ * @class MemoryGraphicsContext
+ * @brief A 32 bit graphics context drawing into memory instead of a screen
+ */
+class MemoryGraphicsContext : public GraphicsContext {
+
+	public:
+		uint32_t* pixels;   ///< The pixels of the context, one row after another
+
+		/**
+		 * @brief Creates a context of the given size, cleared to 0
+		 *
+		 * @param width The width in pixels
+		 * @param height The height in pixels
+		 * @param mirror Should the y axis be mirrored
+		 * @param linear Can rows be written directly, if not every pixel is drawn with render_pixel()
+		 */
+		MemoryGraphicsContext(uint32_t width, uint32_t height, bool mirror, bool linear = true) {
+
+			m_width = width;
+			m_height = height;
+			m_color_depth = 32;
+			mirror_y_axis = mirror;
+
+			pixels = new uint32_t[width * height];
+			memset(pixels, 0, width * height * sizeof(uint32_t));
+
+			if(linear) {
+				m_framebuffer_address = (uint64_t*) pixels;
+				m_pitch = width * sizeof(uint32_t);
+			}
+			select_span_functions();
+		}
+
+		~MemoryGraphicsContext() {
+			delete[] pixels;
+		}
+
+		/**
+		 * @brief Checks if two contexts hold the same pixels
+		 *
+		 * @param other The context to compare with, must be the same size
+		 * @return True if every pixel matches
+		 */
+		bool matches(const MemoryGraphicsContext& other) const {
+			return memcmp(pixels, other.pixels, m_width * m_height * sizeof(uint32_t)) == 0;
+		}
+
+	protected:
+		void render_pixel_32_bit(uint32_t x, uint32_t y, uint32_t colour) final {
+			((uint32_t*) (m_framebuffer_address ? m_framebuffer_address : (uint64_t*) pixels))[y * m_width + x] = colour;
+		}
+
+		uint32_t get_rendered_pixel_32_bit(uint32_t x, uint32_t y) final {
+			return ((uint32_t*) (m_framebuffer_address ? m_framebuffer_address : (uint64_t*) pixels))[y * m_width + x];
+		}
+};
+
+/// Each test runs with and without the option being tested
+static const bool ENABLED_AND_DISABLED[] = { false, true };
+
+/**
+ * @brief Measures how many timestamp counter cycles there are per second
+ *
+ * @return The frequency of the timestamp counter, 0 if there is no running clock to measure it against
+ */
+static uint64_t timestamp_frequency() {
+
+	Clock* clock = Clock::active_clock();
+	if(!clock)
+		return 0;
+
+	uint64_t start_time = clock->uptime();
+	uint64_t start = CPU::read_timestamp();
+	clock->delay(50);
+
+	uint64_t cycles = CPU::read_timestamp() - start;
+	uint64_t elapsed = clock->uptime() - start_time;
+	return elapsed ? cycles * 1000 / elapsed : 0;
+}
+
+/**
+ * @brief Registers all graphics context tests
+ */
+void register_graphics_context_tests() {
+
+	MAXOS_CONDITIONAL_TEST(GraphicsContext_FillRect_MatchesPutPixel, TestType::GUI)
+	{
+		for(bool mirror : ENABLED_AND_DISABLED) {
+
+			MemoryGraphicsContext fast(64, 48, mirror);
+			MemoryGraphicsContext reference(64, 48, mirror);
+
+			// Inside the screen, hanging off each edge and completely off the screen
+			const int32_t rectangles[][4] = { { 3, 4, 20, 10 }, { -5, 10, 12, 6 }, { 50, -3, 30, 8 }, { 60, 40, 10, 20 }, { 70, 0, 5, 5 } };
+			uint32_t colour = 0x00112233;
+			for(auto& rectangle : rectangles) {
+
+				fast.fill_rect(rectangle[0], rectangle[1], rectangle[2], rectangle[3], colour);
+				for(int32_t y = rectangle[1]; y < rectangle[1] + rectangle[3]; ++y)
+					for(int32_t x = rectangle[0]; x < rectangle[0] + rectangle[2]; ++x)
+						reference.put_pixel(x, y, colour);
+
+				colour += 0x00101010;
+			}
+
+			// Lines go through the same path
+			fast.draw_line(2, 30, 40, 30, colour);
+			fast.draw_line(45, 2, 45, 46, colour);
+			for(int32_t x = 2; x <= 40; ++x)
+				reference.put_pixel(x, 30, colour);
+			for(int32_t y = 2; y <= 46; ++y)
+				reference.put_pixel(45, y, colour);
+
+			if(!compare(fast.matches(reference), true))
+				return false;
+		}
+
+		return true;
+	});
+
+	MAXOS_CONDITIONAL_TEST(GraphicsContext_Blit_MatchesPutPixel, TestType::GUI)
+	{
+		uint32_t source[16 * 8];
+		for(uint32_t i = 0; i < 16 * 8; ++i)
+			source[i] = i * 0x01020304;
+
+		for(bool mirror : ENABLED_AND_DISABLED) {
+
+			MemoryGraphicsContext fast(32, 24, mirror);
+			MemoryGraphicsContext reference(32, 24, mirror);
+
+			// Part of the source, clipped by the top left of the screen
+			fast.blit(-3, -2, source + 1, 12, 8, 16);
+			for(int32_t y = 0; y < 8; ++y)
+				for(int32_t x = 0; x < 12; ++x)
+					reference.put_pixel(x - 3, y - 2, source[y * 16 + x + 1]);
+
+			if(!compare(fast.matches(reference), true))
+				return false;
+		}
+
+		return true;
+	});
+
+	MAXOS_CONDITIONAL_TEST(GraphicsContext_CopyRect_Overlapping, TestType::GUI)
+	{
+		for(bool linear : ENABLED_AND_DISABLED) {
+
+			MemoryGraphicsContext context(32, 24, false, linear);
+			MemoryGraphicsContext expected(32, 24, false);
+
+			// Give every pixel its own value
+			for(uint32_t y = 0; y < 24; ++y)
+				for(uint32_t x = 0; x < 32; ++x) {
+					context.put_pixel(x, y, y * 32 + x);
+					expected.put_pixel(x, y, y * 32 + x);
+				}
+
+			// Move a block down and to the right over itself, then up and to the left
+			const int32_t moves[][6] = { { 4, 4, 16, 12, 7, 9 }, { 8, 10, 20, 10, 2, 3 } };
+			for(auto& move : moves) {
+
+				MemoryGraphicsContext before(32, 24, false);
+				memcpy(before.pixels, expected.pixels, 32 * 24 * sizeof(uint32_t));
+
+				context.copy_rect(move[0], move[1], move[2], move[3], move[4], move[5]);
+				for(int32_t y = 0; y < move[3]; ++y)
+					for(int32_t x = 0; x < move[2]; ++x)
+						if(move[4] + x < 32 && move[5] + y < 24)
+							expected.put_pixel(move[4] + x, move[5] + y, before.pixels[(move[1] + y) * 32 + move[0] + x]);
+			}
+
+			if(!compare(context.matches(expected), true))
+				return false;
+		}
+
+		return true;
+	});
+
+	MAXOS_CONDITIONAL_TEST(GraphicsContext_Present_CompositesCursor, TestType::GUI)
+	{
+		for(bool mirror : ENABLED_AND_DISABLED) {
+
+			MemoryGraphicsContext context(32, 24, mirror);
+			if(!compare(context.enable_back_buffer(), true))
+				return false;
+
+			// Nothing reaches the screen until it is presented
+			context.fill_rect(0, 0, 32, 24, 0x00102030);
+			context.move_cursor(10, 12);
+			if(!compare((int) context.pixels[0], 0))
+				return false;
+
+			// Present the top half then the rest, the cursor straddles the two
+			context.present(0, 0, 32, 12);
+			context.present(0, 12, 32, 12);
+
+			for(uint32_t y = 0; y < 24; ++y)
+				for(uint32_t x = 0; x < 32; ++x) {
+
+					// A plus sign 7 pixels across is inverted, the back buffer is left as it was
+					bool cursor = (x == 10 && y >= 9 && y <= 15) || (y == 12 && x >= 7 && x <= 13);
+					uint32_t row = mirror ? 23 - y : y;
+					if(!compare((int) context.pixels[row * 32 + x], cursor ? 0x00EFDFCF : 0x00102030))
+						return false;
+
+					if(!compare((int) context.get_pixel(x, y).red, 0x10))
+						return false;
+				}
+		}
+
+		return true;
+	});
+
+	MAXOS_CONDITIONAL_TEST(GraphicsContext_FillRate_Benchmark, TestType::GUI)
+	{
+		const uint32_t width = 640;
+		const uint32_t height = 480;
+		const uint32_t frames = 8;
+		const uint64_t pixels = (uint64_t) width * height * frames;
+		MemoryGraphicsContext context(width, height, false);
+
+		// One pixel at a time
+		uint64_t start = CPU::read_timestamp();
+		for(uint32_t frame = 0; frame < frames; ++frame)
+			for(uint32_t y = 0; y < height; ++y)
+				for(uint32_t x = 0; x < width; ++x)
+					context.put_pixel(x, y, frame);
+		uint64_t pixel_cycles = CPU::read_timestamp() - start;
+
+		// A row at a time
+		start = CPU::read_timestamp();
+		for(uint32_t frame = 0; frame < frames; ++frame)
+			context.fill_rect(0, 0, width, height, frame);
+		uint64_t rect_cycles = CPU::read_timestamp() - start;
+
+		Logger::TEST() << "Fill rate: " << (int) (pixel_cycles * 1000 / pixels) << " cycles per 1000 pixels (put_pixel), "
+		               << (int) (rect_cycles * 1000 / pixels) << " cycles per 1000 pixels (fill_rect)\n";
+
+		uint64_t frequency = timestamp_frequency();
+		if(frequency && pixel_cycles && rect_cycles)
+			Logger::TEST() << "Fill rate: " << (int) (pixels * frequency / pixel_cycles / 1000) << "K pixels/second (put_pixel), "
+			               << (int) (pixels * frequency / rect_cycles / 1000) << "K pixels/second (fill_rect)\n";
+
+		return compare((int) context.pixels[width * height - 1], (int) frames - 1);
+	});
+}
+
+/**
+ * @brief Registers all framebuffer tests
+ */
+void register_framebuffer_tests() {
+
+	MAXOS_CONDITIONAL_TEST(Framebuffer_WriteCombining_Benchmark, TestType::GUI)
+	{
+		auto* vesa = VideoElectronicsStandardsAssociation::active_driver();
+		if(!vesa || vesa->has_back_buffer()) {
+			Logger::TEST() << "No framebuffer being drawn to directly, skipping\n";
+			return true;
+		}
+
+		// The framebuffer used to be mapped with no caching flags, leaving its type to the MTRRs. CACHE_DISABLED alone is UC- which
+		// a WC MTRR turns into write combining, so it wouldn't show the difference
+		const size_t cachings[] = { NONE, WRITE_COMBINING };
+		const char* names[] = { "previous mapping", "write combining" };
+		auto width = (int32_t) vesa->width();
+		auto height = (int32_t) vesa->height();
+		uint32_t black = vesa->colour_to_int(Colour(0, 0, 0));
+
+		for(int i = 0; i < 2; ++i) {
+			vesa->set_framebuffer_caching(cachings[i]);
+
+			uint64_t start = CPU::read_timestamp();
+			vesa->fill_rect(0, 0, width, height, black);
+			uint64_t fill_cycles = CPU::read_timestamp() - start;
+
+			// Moves the rows the way VESABootConsole::scroll_up used to, by one line of text
+			start = CPU::read_timestamp();
+			vesa->copy_rect(0, gui::FONT_HEIGHT, width, height - gui::FONT_HEIGHT, 0, 0);
+			uint64_t scroll_cycles = CPU::read_timestamp() - start;
+
+			Logger::TEST() << "Framebuffer " << names[i] << ": full screen fill " << (int) (fill_cycles / 1000) << "K cycles, scroll "
+			               << (int) (scroll_cycles / 1000) << "K cycles\n";
+		}
+
+		return true;
+	});
+}
+
+/**
+ * @brief Draws text the way the font used to, one put_pixel per bit of the font
+ *
+ * @param context The context to draw on
+ * @param x The x coordinate of the text
+ * @param y The y coordinate of the text
+ * @param text The text
+ * @param length The number of characters
+ * @param limit The part of the text to draw (left, top, width, height), already within the text
+ * @param foreground The letter colour
+ * @param background The background colour
+ */
+static void reference_draw_text(GraphicsContext& context, int32_t x, int32_t y, const char* text, const int32_t limit[4], uint32_t foreground, uint32_t background) {
+
+	for(int32_t row = limit[1]; row < limit[1] + limit[3]; ++row)
+		for(int32_t column = limit[0]; column < limit[0] + limit[2]; ++column) {
+			uint8_t character = text[column / 8];
+			bool set = AMIGA_FONT[character * 8 + row] & (128 >> (column % 8));
+			context.put_pixel(x + column, y + row, set ? foreground : background);
+		}
+}
+
+/**
+ * @brief Registers all font tests
+ */
+void register_font_tests() {
+
+	MAXOS_CONDITIONAL_TEST(Font_DrawText_MatchesBitmap, TestType::GUI)
+	{
+		Font font(AMIGA_FONT);
+		MemoryGraphicsContext cached(96, 32, false);
+		MemoryGraphicsContext reference(96, 32, false);
+		const char* text = "MaxOS glyphs";
+
+		// All of the text, part of it starting mid character and it hanging off the left of the screen
+		const int32_t limits[][4] = { { 0, 0, 96, 8 }, { 3, 2, 37, 5 }, { 0, 0, 40, 8 } };
+		const int32_t positions[][2] = { { 0, 0 }, { 4, 12 }, { -11, 22 } };
+
+		for(int i = 0; i < 3; ++i) {
+
+			// Each draw swaps the colours so the tile sets are replaced and reused
+			Colour foreground = i % 2 ? Colour(0xFF, 0xFF, 0xFF) : Colour(0x20, 0x40, 0x60);
+			Colour background = i % 2 ? Colour(0x00, 0x00, 0x00) : Colour(0xA8, 0xA8, 0xA8);
+
+			Rectangle<int32_t> area(limits[i][0], limits[i][1], limits[i][2], limits[i][3]);
+			font.draw_text(positions[i][0], positions[i][1], foreground, background, &cached, text, area);
+			reference_draw_text(reference, positions[i][0], positions[i][1], text, limits[i], cached.colour_to_int(foreground), cached.colour_to_int(background));
+		}
+
+		// A lone character, with more colour combinations than there are cache slots
+		for(uint32_t colour = 0; colour < GLYPH_CACHE_SLOTS + 2; ++colour) {
+			const int32_t whole[4] = { 0, 0, 8, 8 };
+			font.draw_character(colour * 8, 24, colour, 0xFFFFFF - colour, &cached, 'A');
+			reference_draw_text(reference, colour * 8, 24, "A", whole, colour, 0xFFFFFF - colour);
+		}
+
+		return compare(cached.matches(reference), true);
+	});
+
+	MAXOS_CONDITIONAL_TEST(Font_DrawText_Benchmark, TestType::GUI)
+	{
+		Font font(AMIGA_FONT);
+		MemoryGraphicsContext context(640, 480, false);
+		const char* line = "The quick brown fox jumps over the lazy dog 0123456789 !?#@$%&*(";
+		const int32_t limit[4] = { 0, 0, 64 * 8, 8 };
+		const uint32_t lines = 200;
+		const uint64_t characters = lines * 64;
+
+		// One pixel at a time
+		uint64_t start = CPU::read_timestamp();
+		for(uint32_t i = 0; i < lines; ++i)
+			reference_draw_text(context, 0, (i % 60) * 8, line, limit, 0xFFFFFF, 0);
+		uint64_t pixel_cycles = CPU::read_timestamp() - start;
+
+		// From the glyph cache
+		start = CPU::read_timestamp();
+		for(uint32_t i = 0; i < lines; ++i)
+			font.draw_text(0, (i % 60) * 8, Colour(0xFF, 0xFF, 0xFF), Colour(0, 0, 0), &context, line);
+		uint64_t cached_cycles = CPU::read_timestamp() - start;
+
+		Logger::TEST() << "Text: " << (int) (pixel_cycles / characters) << " cycles per character (put_pixel), "
+		               << (int) (cached_cycles / characters) << " cycles per character (glyph cache)\n";
+
+		uint64_t frequency = timestamp_frequency();
+		if(frequency && pixel_cycles && cached_cycles)
+			Logger::TEST() << "Text: " << (int) (characters * frequency / pixel_cycles) << " characters/second (put_pixel), "
+			               << (int) (characters * frequency / cached_cycles) << " characters/second (glyph cache)\n";
+
+		return true;
+	});
+
+	MAXOS_CONDITIONAL_TEST(Console_Logger_Benchmark, TestType::GUI)
+	{
+		// Goes to every log writer (serial, and the boot console when debugging), the same as boot logging
+		const char* line = "Console throughput test line, 64 characters long ..............\n";
+		const uint32_t lines = 100;
+		const uint64_t characters = lines * 64;
+
+		uint64_t start = CPU::read_timestamp();
+		for(uint32_t i = 0; i < lines; ++i)
+			Logger::TEST() << line;
+		uint64_t cycles = CPU::read_timestamp() - start;
+
+		Logger::TEST() << "Logger: " << (int) (cycles / characters) << " cycles per character\n";
+
+		uint64_t frequency = timestamp_frequency();
+		if(frequency && cycles)
+			Logger::TEST() << "Logger: " << (int) (characters * frequency / cycles) << " characters/second\n";
+
+		return true;
+	});
+}
+
+/**
+ * @brief Adds an area to a list of damage by splitting it around what is already there (how the desktop used to track it)
+ *
+ * @param damage The list of damage
+ * @param area The area to add
+ * @param start The first rectangle in the list the area hasn't been checked against
+ */
+static void reference_invalidate(Vector<Rectangle<int32_t>>& damage, Rectangle<int32_t>& area, uint32_t start) {
+
+	for(uint32_t i = start; i < damage.size(); i++) {
+		if(!area.intersects(damage[i]))
+			continue;
+
+		for(auto& part : area.subtract(damage[i]))
+			reference_invalidate(damage, part, i + 1);
+		return;
+	}
+
+	damage.push_back(area);
+}
+
+/**
+ * @brief Registers all damage tracking tests
+ */
+void register_damage_tests() {
+
+	MAXOS_CONDITIONAL_TEST(Desktop_WindowDrag_Damage, TestType::GUI)
+	{
+		// Drag a window across the screen, each step invalidates the cursor and the window before and after moving
+		Rectangle<int32_t> window(100, 100, 300, 200);
+		uint64_t reference_area = 0, reference_calls = 0;
+		uint64_t region_area = 0, region_calls = 0;
+
+		for(int32_t step = 0; step < 64; step++) {
+
+			Vector<Rectangle<int32_t>> reference;
+			Vector<Rectangle<int32_t>> damaged;
+			Region region;
+
+			for(int32_t move = 0; move < 4; move++) {
+				Rectangle<int32_t> old_position = window;
+				Rectangle<int32_t> old_cursor(window.left + 20, window.top + 5, CURSOR_SIZE, CURSOR_SIZE);
+				window.left += 3 + step % 5;
+				window.top += 2;
+				Rectangle<int32_t> new_cursor(window.left + 20, window.top + 5, CURSOR_SIZE, CURSOR_SIZE);
+
+				Rectangle<int32_t> areas[] = { old_cursor, new_cursor, old_position, window };
+				for(auto& area : areas) {
+					damaged.push_back(area);
+					reference_invalidate(reference, area, 0);
+					region.include(area, DAMAGE_MERGE_SLACK, DAMAGE_MAX_RECTANGLES);
+				}
+			}
+
+			// Everything damaged must still be redrawn
+			for(auto& area : damaged) {
+				Region missed(area);
+				missed.subtract(region);
+				if(!compare(missed.empty(), true))
+					return false;
+			}
+
+			for(auto& area : reference)
+				reference_area += (uint64_t) area.width * area.height;
+
+			reference_calls += reference.size();
+			region_area += region.area();
+			region_calls += region.rectangles().size();
+		}
+
+		Logger::TEST() << "Window drag: " << (int) reference_calls << " draws of " << (int) reference_area << " pixels (split), "
+		               << (int) region_calls << " draws of " << (int) region_area << " pixels (region)\n";
+
+		return region_calls <= reference_calls;
+	});
+}
+
+/**
+ * @brief Registers all window surface tests
+ */
+void register_window_tests() {
+
+	MAXOS_CONDITIONAL_TEST(Window_Move_CopiesSurface, TestType::GUI)
+	{
+		MemoryGraphicsContext before(320, 240, false);
+		MemoryGraphicsContext after(320, 240, false);
+		Window window(20, 30, 120, 80, "Surface");
+
+		// Draw, move and draw again from the same surface
+		Rectangle<int32_t> area(0, 0, 120, 80);
+		window.draw(&before, area);
+		window.move(60, 90);
+		window.draw(&after, area);
+
+		for(int32_t y = 0; y < 80; y++)
+			for(int32_t x = 0; x < 120; x++)
+				if(!compare((int) before.pixels[(30 + y) * 320 + 20 + x], (int) after.pixels[(90 + y) * 320 + 60 + x]))
+					return false;
+
+		return true;
+	});
+
+	MAXOS_CONDITIONAL_TEST(Window_Drag_Benchmark, TestType::GUI)
+	{
+		MemoryGraphicsContext context(640, 480, false);
+		Window window(0, 0, 300, 200, "Dragged");
+		Rectangle<int32_t> area(0, 0, 300, 200);
+		const uint32_t steps = 64;
+
+		// Everything is drawn again each step, how a drag used to be
+		uint64_t start = CPU::read_timestamp();
+		for(uint32_t i = 0; i < steps; i++) {
+			window.move(i * 4, i * 2);
+			window.Widget::invalidate();
+			window.draw(&context, area);
+		}
+		uint64_t redraw_cycles = CPU::read_timestamp() - start;
+
+		// Only the surface is copied
+		start = CPU::read_timestamp();
+		for(uint32_t i = 0; i < steps; i++) {
+			window.move(i * 4, i * 2);
+			window.draw(&context, area);
+		}
+		uint64_t surface_cycles = CPU::read_timestamp() - start;
+
+		Logger::TEST() << "Window drag: " << (int) (redraw_cycles / steps) << " cycles per step (redrawn), "
+		               << (int) (surface_cycles / steps) << " cycles per step (surface)\n";
+
+		return true;
+	});
+}
+
+/**
+ * @brief Registers all window server tests
+ */
+void register_window_server_tests() {
+
+	MAXOS_CONDITIONAL_TEST(ClientWindow_Draw_MatchesSurface, TestType::GUI)
+	{
+		const uint32_t width = 64;
+		const uint32_t height = 48;
+		SharedMemory memory("gui:test:surface", width * height * sizeof(uint32_t), resource_type_t::SHARED_MEMORY);
+		SharedMessageEndpoint events("gui:test:events", 0, resource_type_t::MESSAGE_ENDPOINT);
+
+		// Draw a pattern as the client would
+		auto* pixels = (uint32_t*) PhysicalMemoryManager::to_dm_region(memory.physical_address());
+		for(uint32_t y = 0; y < height; y++)
+			for(uint32_t x = 0; x < width; x++)
+				pixels[y * width + x] = (x * 4) << 16 | (y * 5) << 8 | ((x + y) & 0xFF);
+
+		MemoryGraphicsContext context(320, 240, false);
+		ClientWindow window("test", 0, &memory, &events, 10, 20, width, height);
+		Rectangle<int32_t> area(0, 0, width, height);
+		window.draw(&context, area);
+
+		bool passed = true;
+		for(uint32_t y = 0; y < height; y++)
+			for(uint32_t x = 0; x < width; x++)
+				if((context.pixels[(20 + y) * 320 + 10 + x] & 0xFFFFFF) != pixels[y * width + x])
+					passed = false;
+
+		// Input goes back to the client
+		window_event_t event {};
+		window.on_mouse_button_pressed(5, 6, 1);
+		if(events.read(&event, sizeof(event), 0) != (int) sizeof(event))
+			passed = false;
+		else if(event.type != window_event_type_t::MOUSE_DOWN || event.x != 5 || event.y != 6 || event.value != 1)
+			passed = false;
+
+		memory.close(0);
+		return passed;
+	});
+}
+
+/**
+ * @brief Registers all graphics and GUI tests with the test runner
+ */
+void MaxOS::tests::register_tests_gui() {
+	register_graphics_context_tests();
+	register_framebuffer_tests();
+	register_font_tests();
+	register_damage_tests();
+	register_window_tests();
+	register_window_server_tests();
+}
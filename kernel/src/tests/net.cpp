@@ -0,0 +1,511 @@
+/**
+ * @file net.cpp
+ * @brief Implements the tests for the network stack of MaxOS
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+*/
+
+#include <tests/net.h>
+#include <common/logger.h>
+#include <net/checksum.h>
+#include <net/tcp.h>
+#include <system/cpu.h>
+
+using namespace ::MaxOS;
+using namespace ::MaxOS::tests;
+using namespace ::MaxOS::common;
+using namespace ::MaxOS::net;
+using namespace ::MaxOS::system;
+using namespace ::MaxOS::drivers::ethernet;
+
+/// Data for the checksum tests, large enough for the biggest IP packet
+static uint8_t s_checksum_data[65536];
+
+/**
+ * @brief Fill the checksum test data with a repeatable pattern
+ */
+static void fill_checksum_data() {
+
+	uint32_t state = 0x12345678;
+	for(auto& byte : s_checksum_data) {
+		state = state * 1103515245 + 12345;
+		byte = state >> 24;
+	}
+}
+
+/**
+ * @brief The checksum as RFC 1071 describes it, one big endian word at a time
+ *
+ * @param data The data to sum
+ * @param length The length of the data in bytes
+ * @return The checksum, as stored in a header
+ */
+static uint16_t reference_checksum(const uint8_t* data, uint32_t length) {
+
+	uint32_t sum = 0;
+	for(uint32_t i = 0; i + 1 < length; i += 2)
+		sum += (data[i] << 8) | data[i + 1];
+
+	if(length % 2)
+		sum += data[length - 1] << 8;
+
+	while(sum >> 16)
+		sum = (sum & 0xFFFF) + (sum >> 16);
+
+	sum = ~sum & 0xFFFF;
+	return (sum >> 8) | ((sum & 0xFF) << 8);
+}
+
+/**
+ * @brief Registers all checksum tests
+ */
+void register_checksum_tests() {
+
+	MAXOS_CONDITIONAL_TEST(Checksum_MatchesReference, TestType::NETWORK)
+	{
+		fill_checksum_data();
+
+		// Every length up to a few 64-bit words, from aligned and unaligned starts
+		for(uint32_t offset = 0; offset < 8; offset++)
+			for(uint32_t length = 0; length < 100; length++)
+				if(!compare(InternetChecksum::compute(s_checksum_data + offset, length), reference_checksum(s_checksum_data + offset, length)))
+					return false;
+
+		// Data that is all ones makes every addition carry
+		uint8_t ones[64];
+		for(auto& byte : ones)
+			byte = 0xFF;
+
+		return compare(InternetChecksum::compute(ones, sizeof(ones)), reference_checksum(ones, sizeof(ones)));
+	});
+
+	MAXOS_CONDITIONAL_TEST(Checksum_PartialSumsCombine, TestType::NETWORK)
+	{
+		fill_checksum_data();
+
+		// Summing two blocks one after the other is the same as summing them together
+		uint32_t sum = InternetChecksum::partial(s_checksum_data, 1000);
+		uint16_t combined = InternetChecksum::compute(s_checksum_data + 1000, 501, sum);
+		return compare(combined, InternetChecksum::compute(s_checksum_data, 1501));
+	});
+
+	MAXOS_CONDITIONAL_TEST(Checksum_Update_MatchesRecompute, TestType::NETWORK)
+	{
+		fill_checksum_data();
+
+		// Change a 16-bit field
+		uint8_t header[20];
+		for(int i = 0; i < 20; i++)
+			header[i] = s_checksum_data[i];
+
+		uint16_t checksum = InternetChecksum::compute(header, sizeof(header));
+		uint16_t old_word = *(uint16_t*) (header + 8);
+		*(uint16_t*) (header + 8) = 0x1140;
+		checksum = InternetChecksum::update(checksum, old_word, *(uint16_t*) (header + 8));
+		if(!compare(checksum, InternetChecksum::compute(header, sizeof(header))))
+			return false;
+
+		// Change a 32-bit field
+		uint32_t old_address = *(uint32_t*) (header + 12);
+		*(uint32_t*) (header + 12) = 0x0A00020F;
+		checksum = InternetChecksum::update(checksum, old_address, *(uint32_t*) (header + 12));
+		return compare(checksum, InternetChecksum::compute(header, sizeof(header)));
+	});
+
+	MAXOS_CONDITIONAL_TEST(Checksum_Benchmark, TestType::NETWORK)
+	{
+		fill_checksum_data();
+
+		// From a bare header up to the biggest IP packet
+		const uint32_t sizes[] = { 20, 64, 576, 1500, 9000, 65535 };
+		for(uint32_t size : sizes) {
+
+			// Enough rounds that each size sums roughly the same amount of data
+			uint32_t rounds = 1000000 / size + 1;
+			uint16_t expected = 0;
+			uint16_t result = 0;
+
+			uint64_t start = CPU::read_timestamp();
+			for(uint32_t i = 0; i < rounds; i++)
+				expected ^= reference_checksum(s_checksum_data, size);
+			uint64_t reference_cycles = CPU::read_timestamp() - start;
+
+			start = CPU::read_timestamp();
+			for(uint32_t i = 0; i < rounds; i++)
+				result ^= InternetChecksum::compute(s_checksum_data, size);
+			uint64_t fast_cycles = CPU::read_timestamp() - start;
+
+			Logger::TEST() << "Checksum " << (int) size << " bytes: " << (int) (reference_cycles / rounds) << " cycles (16-bit), "
+			               << (int) (fast_cycles / rounds) << " cycles (64-bit)\n";
+
+			if(!compare(result, expected))
+				return false;
+		}
+
+		return true;
+	});
+}
+
+/**
+ * @class LoopbackDriver
+ * @brief A network card wired straight to another, the frames it sends are held until the test passes them across so
+ * that the stacks are never re-entered
+ */
+class LoopbackDriver : public EthernetDriver {
+
+	private:
+		MediaAccessControlAddress m_address;
+		Spinlock m_lock;
+		Vector<PacketBuffer*> m_wire;
+
+	protected:
+		void do_send(PacketBuffer* packet) override {
+			m_lock.lock();
+			m_wire.push_back(packet);
+			m_lock.unlock();
+		}
+
+	public:
+		LoopbackDriver* peer = nullptr;   ///< The card on the other end of the wire
+
+		explicit LoopbackDriver(MediaAccessControlAddress address)
+		: m_address(address) {
+		}
+
+		MediaAccessControlAddress get_media_access_control_address() override {
+			return m_address;
+		}
+
+		/**
+		 * @brief Take the frames sent so far off the wire
+		 *
+		 * @return The frames, oldest first
+		 */
+		Vector<PacketBuffer*> take() {
+			m_lock.lock();
+			Vector<PacketBuffer*> frames = m_wire;
+			m_wire.clear();
+			m_lock.unlock();
+			return frames;
+		}
+
+		/**
+		 * @brief Pass a frame to the stack of this card as if it had been received
+		 *
+		 * @param packet The frame
+		 */
+		void receive(PacketBuffer* packet) {
+			fire_data_received(packet);
+		}
+};
+
+/**
+ * @class TestTCP
+ * @brief TCP with its timers run by the test instead of waiting for them
+ */
+class TestTCP : public TransmissionControlProtocolHandler {
+	public:
+		using TransmissionControlProtocolHandler::TransmissionControlProtocolHandler;
+		using TransmissionControlProtocolHandler::handle_timers;
+};
+
+/**
+ * @struct TestStack
+ * @brief A network stack on a loopback card
+ */
+struct TestStack {
+	LoopbackDriver driver;                        ///< The card
+	EthernetFrameHandler ethernet;                ///< Ethernet on the card
+	InternetProtocolHandler internet_protocol;    ///< IPv4 over ethernet
+	IPV4AddressResolver resolver;                 ///< Sends everything to the broadcast address
+	TestTCP tcp;                                  ///< TCP over IPv4
+
+	TestStack(MediaAccessControlAddress mac, InternetProtocolAddress ip)
+	: driver(mac),
+	  ethernet(&driver, nullptr),
+	  internet_protocol(&ethernet, ip, 0, InternetProtocolHandler::create_subnet_mask(255, 255, 255, 0), nullptr),
+	  resolver(&internet_protocol),
+	  tcp(&internet_protocol, nullptr) {
+	}
+};
+
+/**
+ * @class TestTCPHandler
+ * @brief Records what happens on the sockets it is bound to, binding itself to connections accepted by a listener
+ */
+class TestTCPHandler : public TCPPayloadHandler {
+	public:
+		TransmissionControlProtocolHandler* tcp = nullptr;   ///< The handler sockets are bound through
+		TCPSocket* accepted = nullptr;                       ///< The last connection accepted
+		uint8_t received[4096] = {};                         ///< The data received
+		uint32_t received_size = 0;                          ///< How much data has been received
+		bool closed = false;                                 ///< Has the remote end closed
+		uint32_t receive_space = UINT32_MAX;                 ///< What to limit the receive window of accepted sockets to
+
+		void handle_transmission_control_protocol_payload(TCPSocket* socket, uint8_t* data, uint16_t size) override {
+			for(uint16_t i = 0; i < size && received_size < sizeof(received); i++)
+				received[received_size++] = data[i];
+		}
+
+		void connected(TCPSocket* socket) override {
+			accepted = socket;
+			tcp->bind(socket, this);
+			if(receive_space != UINT32_MAX)
+				socket->set_receive_space(receive_space);
+		}
+
+		void disconnected(TCPSocket* socket) override {
+			closed = true;
+		}
+};
+
+/// Stacks are never freed as their handlers start workers that keep running
+static TestStack* s_client = nullptr;
+static TestStack* s_server = nullptr;
+
+/**
+ * @brief Create the two stacks the TCP tests run between, the first time they are needed
+ */
+static void create_test_stacks() {
+
+	if(s_client)
+		return;
+
+	s_client = new TestStack(0x0200000000AA, InternetProtocolHandler::create_internet_protocol_address(10, 0, 0, 1));
+	s_server = new TestStack(0x0200000000BB, InternetProtocolHandler::create_internet_protocol_address(10, 0, 0, 2));
+	s_client->driver.peer = &s_server->driver;
+	s_server->driver.peer = &s_client->driver;
+}
+
+/**
+ * @brief Pass frames between the stacks until both have nothing left to send
+ */
+static void pump_test_stacks() {
+
+	bool sent = true;
+	while(sent) {
+		sent = false;
+		TestStack* stacks[] = { s_client, s_server };
+		for(TestStack* stack : stacks) {
+			for(auto& frame : stack->driver.take()) {
+				stack->driver.peer->receive(frame);
+				sent = true;
+			}
+		}
+	}
+}
+
+/**
+ * @brief Pass the frames one stack has sent to the other, finding the window of the last TCP segment
+ *
+ * @param stack The stack whose wire to look at
+ * @return The (unscaled) window, -1 if no segment was sent
+ */
+static int32_t pump_last_window(TestStack* stack) {
+
+	int32_t window = -1;
+	for(auto& frame : stack->driver.take()) {
+		auto* ip = (ipv4_header_t*) (frame->data() + sizeof(ethernet_frame_header_t));
+		auto* tcp = (tcp_header_t*) ((uint8_t*) ip + ip->header_length * 4);
+		window = (tcp->window_size >> 8) | ((tcp->window_size & 0xFF) << 8);
+		stack->driver.peer->receive(frame);
+	}
+
+	return window;
+}
+
+/**
+ * @brief Unbind a handler from a socket of a test and give it up, a connection left open is finished by the timers of the
+ * stack once the test has gone
+ *
+ * @param handler The handler to unbind
+ * @param socket The socket
+ */
+static void close_test_socket(TestTCPHandler* handler, TCPSocket* socket) {
+
+	socket->disconnect_event_handler(handler);
+	socket->disconnect();
+	pump_test_stacks();
+}
+
+/**
+ * @brief Registers the TCP tests
+ */
+static void register_tcp_tests() {
+
+	MAXOS_CONDITIONAL_TEST(TCP_Connection_TransfersAndCloses, TestType::NETWORK)
+	{
+		create_test_stacks();
+
+		TestTCPHandler server_handler;
+		TestTCPHandler client_handler;
+		server_handler.tcp = &s_server->tcp;
+		client_handler.tcp = &s_client->tcp;
+
+		TCPSocket* listener = s_server->tcp.listen(7000);
+		if(!listener)
+			return false;
+		s_server->tcp.bind(listener, &server_handler);
+
+		// Handshake
+		TCPSocket* client = s_client->tcp.connect(s_server->internet_protocol.get_internet_protocol_address(), 7000);
+		if(!client)
+			return false;
+		s_client->tcp.bind(client, &client_handler);
+		pump_test_stacks();
+
+		TCPSocket* server = server_handler.accepted;
+		if(!compare((int) client->current_state(), (int) TCPSocketState::ESTABLISHED) || !server || !compare((int) server->current_state(), (int) TCPSocketState::ESTABLISHED))
+			return false;
+
+		// Data both ways
+		uint8_t request[] = "request";
+		uint8_t reply[] = "reply";
+		client->send(request, sizeof(request));
+		pump_test_stacks();
+		server->send(reply, sizeof(reply));
+		pump_test_stacks();
+
+		if(!compare((int) server_handler.received_size, (int) sizeof(request)) || memcmp(server_handler.received, request, sizeof(request)) != 0)
+			return false;
+		if(!compare((int) client_handler.received_size, (int) sizeof(reply)) || memcmp(client_handler.received, reply, sizeof(reply)) != 0)
+			return false;
+
+		// The client closes, the server closes its end in reply and stops looking the connection up
+		close_test_socket(&client_handler, client);
+		if(!server_handler.closed || !compare((int) server->current_state(), (int) TCPSocketState::CLOSED))
+			return false;
+
+		// The tables hold on to the client until its TIME_WAIT is over
+		if(!compare((int) client->current_state(), (int) TCPSocketState::TIME_WAIT))
+			return false;
+
+		close_test_socket(&server_handler, server);
+		close_test_socket(&server_handler, listener);
+
+		// The listener gave its port back
+		listener = s_server->tcp.listen(7000);
+		if(!listener)
+			return false;
+
+		listener->disconnect();
+		return true;
+	});
+
+	MAXOS_CONDITIONAL_TEST(TCP_ReceiveWindow_FollowsReceiveSpace, TestType::NETWORK)
+	{
+		create_test_stacks();
+
+		TestTCPHandler server_handler;
+		TestTCPHandler client_handler;
+		server_handler.tcp = &s_server->tcp;
+		server_handler.receive_space = 1000;
+		client_handler.tcp = &s_client->tcp;
+
+		TCPSocket* listener = s_server->tcp.listen(7001);
+		if(!listener)
+			return false;
+		s_server->tcp.bind(listener, &server_handler);
+
+		TCPSocket* client = s_client->tcp.connect(s_server->internet_protocol.get_internet_protocol_address(), 7001);
+		if(!client)
+			return false;
+		s_client->tcp.bind(client, &client_handler);
+		pump_test_stacks();
+
+		TCPSocket* server = server_handler.accepted;
+		if(!server)
+			return false;
+
+		// Only what the handler has room for is taken, the rest is left unacknowledged and the window closes
+		uint8_t data[3000];
+		for(uint32_t i = 0; i < sizeof(data); i++)
+			data[i] = i;
+
+		client->send(data, sizeof(data));
+		pump_last_window(s_client);
+		if(!compare(pump_last_window(s_server), 0))
+			return false;
+
+		pump_test_stacks();
+		if(!compare((int) server_handler.received_size, 1000) || memcmp(server_handler.received, data, 1000) != 0)
+			return false;
+		if(!compare((int) client->send_space(), (int) TCP_SEND_BUFFER_SIZE - 2000))
+			return false;
+
+		// Making room for less than a segment doesn't update the window, making room for more does
+		server->open_receive_window(100);
+		if(!compare(pump_last_window(s_server), -1))
+			return false;
+
+		server->open_receive_window(1900);
+		if(!compare(pump_last_window(s_server), 2000 >> TCP_WINDOW_SCALE))
+			return false;
+
+		close_test_socket(&client_handler, client);
+		close_test_socket(&server_handler, server);
+		close_test_socket(&server_handler, listener);
+		return true;
+	});
+
+	MAXOS_CONDITIONAL_TEST(TCP_ZeroWindow_ProbesKeepConnection, TestType::NETWORK)
+	{
+		create_test_stacks();
+
+		TestTCPHandler server_handler;
+		TestTCPHandler client_handler;
+		server_handler.tcp = &s_server->tcp;
+		server_handler.receive_space = 0;
+		client_handler.tcp = &s_client->tcp;
+
+		TCPSocket* listener = s_server->tcp.listen(7002);
+		if(!listener)
+			return false;
+		s_server->tcp.bind(listener, &server_handler);
+
+		TCPSocket* client = s_client->tcp.connect(s_server->internet_protocol.get_internet_protocol_address(), 7002);
+		if(!client)
+			return false;
+		s_client->tcp.bind(client, &client_handler);
+		pump_test_stacks();
+
+		TCPSocket* server = server_handler.accepted;
+		if(!server)
+			return false;
+
+		// The window is closed so the data can only be probed, a reader that answers every probe is never given up on
+		uint8_t data[100] = {};
+		client->send(data, sizeof(data));
+		pump_test_stacks();
+
+		for(uint32_t probe = 0; probe < TCP_MAX_RETRANSMITS * 2; probe++) {
+			s_client->tcp.handle_timers(UINT64_MAX);
+			pump_test_stacks();
+		}
+
+		if(!compare((int) client->current_state(), (int) TCPSocketState::ESTABLISHED) || client_handler.closed)
+			return false;
+
+		// Once the reader makes room the data goes through
+		server->open_receive_window(sizeof(data));
+		pump_test_stacks();
+		s_client->tcp.handle_timers(UINT64_MAX);
+		pump_test_stacks();
+		if(!compare((int) server_handler.received_size, (int) sizeof(data)))
+			return false;
+
+		close_test_socket(&client_handler, client);
+		close_test_socket(&server_handler, server);
+		close_test_socket(&server_handler, listener);
+		return true;
+	});
+}
+
+/**
+ * @brief Registers all network tests with the test runner
+ */
+void MaxOS::tests::register_tests_net() {
+	register_checksum_tests();
+	register_tcp_tests();
+}
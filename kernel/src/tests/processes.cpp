@@ -0,0 +1,115 @@
+/**
+ * @file processes.cpp
+ * @brief Implements the tests for the process management of MaxOS
+ *
+ * @date 19th October 2026
+ * @author Max Tyson
+*/
+
+#include <tests/processes.h>
+#include <common/logger.h>
+#include <processes/resource.h>
+
+using namespace ::MaxOS;
+using namespace ::MaxOS::tests;
+using namespace ::MaxOS::common;
+using namespace ::MaxOS::processes;
+
+/// The registry the handle table tests store their resource in (created by the scheduler)
+constexpr resource_type_t TEST_RESOURCE_TYPE = resource_type_t::MESSAGE_ENDPOINT;
+
+/**
+ * @brief Adds a plain resource to the test registry, it is deleted once the last handle to it is closed
+ *
+ * @param name The name of the resource
+ * @return The resource or nullptr if there is no registry or the name is taken
+ */
+static Resource* register_test_resource(const char* name) {
+
+	BaseResourceRegistry* registry = GlobalResourceRegistry::get_registry(TEST_RESOURCE_TYPE);
+	if(!registry)
+		return nullptr;
+
+	auto resource = new Resource(name, 0, TEST_RESOURCE_TYPE);
+	if(!registry->register_resource(resource)) {
+		delete resource;
+		return nullptr;
+	}
+
+	return resource;
+}
+
+/**
+ * @brief Registers all handle table tests
+ */
+void register_resource_manager_tests() {
+
+	MAXOS_CONDITIONAL_TEST(ResourceManager_StaleHandle_Rejected, TestType::PROCESSES)
+	{
+		Resource* resource = register_test_resource("test:stale_handle");
+		if(!resource)
+			return false;
+
+		// Keep a second handle open so the resource outlives the first
+		ResourceManager manager;
+		uint64_t first = manager.open_resource(TEST_RESOURCE_TYPE, "test:stale_handle", 0);
+		uint64_t second = manager.open_resource(TEST_RESOURCE_TYPE, "test:stale_handle", 0);
+		manager.close_resource(first, 0);
+		if(!compare(manager.get_resource(first) == nullptr, true))
+			return false;
+
+		// The slot is reused but the old handle must still be rejected
+		uint64_t reopened = manager.open_resource(TEST_RESOURCE_TYPE, "test:stale_handle", 0);
+		bool same_slot = (uint32_t)reopened == (uint32_t)first;
+		bool stale_rejected = manager.get_resource(first) == nullptr;
+		bool reopened_found = manager.get_resource(reopened) == resource;
+
+		// Closing twice through the stale handle must not touch the new one
+		manager.close_resource(first, 0);
+		bool still_open = manager.get_resource(reopened) == resource;
+
+		manager.close_resource(second, 0);
+		manager.close_resource(reopened, 0);
+
+		return compare(same_slot, true) && compare(reopened != first, true) && compare(stale_rejected, true)
+			&& compare(reopened_found, true) && compare(still_open, true);
+	});
+
+	MAXOS_CONDITIONAL_TEST(ResourceManager_FreeList_ReusesSlots, TestType::PROCESSES)
+	{
+		Resource* resource = register_test_resource("test:free_list");
+		if(!resource)
+			return false;
+
+		ResourceManager manager;
+		uint64_t handles[3];
+		for(auto& handle : handles)
+			handle = manager.open_resource(TEST_RESOURCE_TYPE, "test:free_list", 0);
+
+		// Free the first and last slots
+		manager.close_resource(handles[0], 0);
+		manager.close_resource(handles[2], 0);
+
+		// The most recently freed slot is used first and the table doesn't grow
+		uint64_t reused_last = manager.open_resource(TEST_RESOURCE_TYPE, "test:free_list", 0);
+		uint64_t reused_first = manager.open_resource(TEST_RESOURCE_TYPE, "test:free_list", 0);
+		bool reuse_order = (uint32_t)reused_last == (uint32_t)handles[2] && (uint32_t)reused_first == (uint32_t)handles[0];
+		bool table_size = compare((int)manager.resources().size(), 3);
+
+		// The name index follows the handles that are still open
+		manager.close_resource(handles[1], 0);
+		manager.close_resource(reused_last, 0);
+		bool name_found = manager.get_resource(string("test:free_list")) == resource;
+		manager.close_resource(reused_first, 0);
+		bool name_gone = manager.get_resource(string("test:free_list")) == nullptr;
+
+		return compare(reuse_order, true) && table_size && compare(name_found, true) && compare(name_gone, true);
+	});
+}
+
+/**
+ * @brief Registers all process tests with the test runner
+ */
+void MaxOS::tests::register_tests_processes() {
+	register_resource_manager_tests();
+}
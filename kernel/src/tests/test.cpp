@@ -8,6 +8,11 @@
 
 #include <tests/test.h>
 #include <tests/common.h>
+#include <tests/drivers.h>
+#include <tests/filesystem.h>
+#include <tests/gui.h>
+#include <tests/net.h>
+#include <tests/processes.h>
 
 using namespace MaxOS;
 using namespace MaxOS::tests;
@@ -144,6 +149,11 @@ void TestRunner::add_test(Test* test) {
  */
 void TestRunner::add_all_tests() {
 	register_tests_common();
+	register_tests_drivers();
+	register_tests_filesystem();
+	register_tests_gui();
+	register_tests_net();
+	register_tests_processes();
 }
 
 /**
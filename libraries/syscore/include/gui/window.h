@@ -0,0 +1,84 @@
+//
+// Created by 98max on 10/19/2026.
+//
+
+#ifndef SYSCORE_GUI_WINDOW_H
+#define SYSCORE_GUI_WINDOW_H
+
+#include <cstdint>
+#include <cstddef>
+#include <common.h>
+#include <syscalls.h>
+
+
+namespace syscore::gui {
+
+	/// The endpoint the window server reads requests from
+	constexpr char WINDOW_SERVER_ENDPOINT[] = "gui:server";
+
+	/// Longest name of a window, its surface is "gui:NAME:surface" and its events are sent to "gui:NAME:events"
+	constexpr size_t WINDOW_NAME_MAX = 32;
+
+	/// Longest name of a resource belonging to a window
+	constexpr size_t WINDOW_RESOURCE_NAME_MAX = WINDOW_NAME_MAX + 16;
+
+	enum class WindowRequestType : uint32_t {
+		CREATE,		// Show the surface on the desktop at x, y
+		DAMAGE,		// The client has drawn to x, y, width, height of the surface
+		MOVE,		// Move the window to x, y
+		DESTROY,	// Remove the window, the server stops using the surface and endpoint
+	};
+
+	typedef struct WindowRequest {
+		WindowRequestType type;
+		int32_t x;
+		int32_t y;
+		uint32_t width;
+		uint32_t height;
+		char name[WINDOW_NAME_MAX];
+	} window_request_t;
+
+	enum class WindowEventType : uint32_t {
+		MOUSE_MOVE,		// x, y is the new position of the mouse (relative to the window)
+		MOUSE_DOWN,		// value is the button
+		MOUSE_UP,		// value is the button
+		KEY_DOWN,		// value is the key code, modifiers the WindowModifiers held
+		KEY_UP,			// value is the key code, modifiers the WindowModifiers held
+		FOCUS,
+		FOCUS_LOST,
+	};
+
+	enum class WindowModifiers : uint32_t {
+		SHIFT = 1 << 0,
+		CONTROL = 1 << 1,
+		ALT = 1 << 2,
+		CAPS_LOCK = 1 << 3,
+	};
+
+	typedef struct WindowEvent {
+		WindowEventType type;
+		int32_t x;
+		int32_t y;
+		uint32_t value;
+		uint32_t modifiers;
+	} window_event_t;
+
+	typedef struct Window {
+		uint64_t server;		// The server's request endpoint
+		uint64_t events;		// Where the server sends input for this window
+		uint64_t surface;		// The handle of the shared memory the window is drawn into
+		uint32_t* pixels;		// The surface, 0xRRGGBB one row after another
+		uint32_t width;
+		uint32_t height;
+		char name[WINDOW_NAME_MAX];
+	} window_t;
+
+	bool window_create(window_t* window, const char* name, int32_t x, int32_t y, uint32_t width, uint32_t height);
+	void window_damage(window_t* window, int32_t x, int32_t y, uint32_t width, uint32_t height);
+	void window_move(window_t* window, int32_t x, int32_t y);
+	bool window_next_event(window_t* window, window_event_t* event, bool non_blocking);
+	void window_destroy(window_t* window);
+}
+
+
+#endif //SYSCORE_GUI_WINDOW_H
@@ -0,0 +1,47 @@
+//
+// Created by 98max on 10/19/2026.
+//
+
+#ifndef SYSCORE_NET_SOCKET_H
+#define SYSCORE_NET_SOCKET_H
+
+#include <cstdint>
+#include <cstddef>
+#include <common.h>
+#include <syscalls.h>
+
+
+namespace syscore::net {
+
+	enum class SocketFlags {
+		DEFAULT = 0,
+		NON_BLOCKING = 1 << 0,	// Return WOULD_BLOCK instead of waiting
+		ACCEPT = 1 << 1,		// Read the name of a connection waiting on a listener
+	};
+
+	enum class SocketError {
+		WOULD_BLOCK = (int)ResourceErrorBase::_END,
+		NOT_CONNECTED,
+		CLOSED,
+	};
+	int as_error(SocketError code);
+
+	/// Longest name of a socket resource (e.g. "tcp:255.255.255.255:65535#4294967295")
+	constexpr size_t SOCKET_NAME_MAX = 64;
+
+	uint64_t tcp_connect(const char* address);
+	uint64_t tcp_listen(uint16_t port);
+	uint64_t tcp_accept(uint64_t listener, bool non_blocking);
+
+	uint64_t udp_connect(const char* address);
+	uint64_t udp_listen(uint16_t port);
+
+	int socket_read(uint64_t socket, void* buffer, size_t size, bool non_blocking);
+	int socket_write(uint64_t socket, const void* buffer, size_t size, bool non_blocking);
+	void socket_close(uint64_t socket);
+
+	size_t socket_wait(resource_poll_entry_t* sockets, size_t count, uint64_t timeout);
+}
+
+
+#endif //SYSCORE_NET_SOCKET_H
@@ -14,6 +14,7 @@ namespace syscore{
 		MESSAGE_ENDPOINT,
 		SHARED_MEMORY,
 		FILESYSTEM,
+		SOCKET,
 	};
 
 	enum class ResourceErrorBase{
@@ -23,6 +24,20 @@ namespace syscore{
 	};
 	int as_error(ResourceErrorBase code);
 
+	enum class ResourceReadiness{
+		READABLE = 1 << 0,
+		WRITABLE = 1 << 1,
+		CLOSED = 1 << 2,
+	};
+
+	typedef struct ResourcePollEntry{
+		uint64_t handle;
+		size_t events;		// The ResourceReadiness bits to wait for
+		size_t ready;		// Set to the ResourceReadiness bits that are ready
+	} resource_poll_entry_t;
+
+	constexpr uint64_t RESOURCE_POLL_FOREVER = UINT64_MAX;
+
 	enum class SyscallType{
 		CLOSE_PROCESS,
 		KLOG,	// TODO: Turn into open proc
@@ -36,6 +51,9 @@ namespace syscore{
 		THREAD_YIELD,
 		THREAD_SLEEP,
 		THREAD_CLOSE,
+		FUTEX_WAIT,
+		FUTEX_WAKE,
+		RESOURCE_POLL,
 	};
 
 	void* make_syscall(SyscallType type, uint64_t arg0, uint64_t arg1, uint64_t arg2, uint64_t arg3, uint64_t arg4, uint64_t arg5);
@@ -51,10 +69,14 @@ namespace syscore{
 	void resource_close(uint64_t handle, size_t flags);
 	size_t resource_write(uint64_t handle, const void* buffer, size_t size, size_t flags);
 	size_t resource_read(uint64_t handle, void* buffer, size_t size, size_t flags);
+	size_t resource_poll(resource_poll_entry_t* entries, size_t count, uint64_t timeout);
 
 	void thread_yield();
 	void thread_sleep(uint64_t time);
 	void thread_exit();
+
+	bool futex_wait(uint32_t* address, uint32_t expected);
+	size_t futex_wake(uint32_t* address, size_t count);
 }
 
 #endif //SYSCORE_SYSCALLS_H
@@ -0,0 +1,35 @@
+//
+// Created by 98max on 10/19/2026.
+//
+
+#ifndef SYSCORE_THREADING_CONDITION_H
+#define SYSCORE_THREADING_CONDITION_H
+
+#include <cstdint>
+#include <cstddef>
+#include <syscalls.h>
+#include <threading/mutex.h>
+
+
+namespace syscore::threading {
+
+	/**
+	 * @class ConditionVariable
+	 * @brief Lets threads sleep until another thread signals that a condition protected by a Mutex may have changed
+	 */
+	class ConditionVariable {
+
+		private:
+			uint32_t m_sequence = 0;
+			uint32_t m_waiters = 0;
+
+		public:
+			void wait(Mutex& mutex);
+
+			void signal();
+			void broadcast();
+	};
+}
+
+
+#endif //SYSCORE_THREADING_CONDITION_H
@@ -0,0 +1,46 @@
+//
+// Created by 98max on 10/19/2026.
+//
+
+#ifndef SYSCORE_THREADING_MUTEX_H
+#define SYSCORE_THREADING_MUTEX_H
+
+#include <cstdint>
+#include <cstddef>
+#include <syscalls.h>
+
+
+namespace syscore::threading {
+
+	/**
+	 * @enum MutexState
+	 * @brief The values the word of a Mutex can hold
+	 */
+	enum class MutexState : uint32_t {
+		UNLOCKED,
+		LOCKED,
+		CONTENDED,      // Locked and there may be threads sleeping in the kernel
+	};
+
+	/**
+	 * @class Mutex
+	 * @brief A lock that is taken with a single atomic instruction when free and only enters the kernel to sleep or wake
+	 *
+	 * @note The mutex is a single word so it can be placed in shared memory to lock between processes
+	 */
+	class Mutex {
+
+		private:
+			uint32_t m_state = (uint32_t)MutexState::UNLOCKED;
+
+		public:
+			void lock();
+			bool try_lock();
+			void unlock();
+
+			[[nodiscard]] bool is_locked() const;
+	};
+}
+
+
+#endif //SYSCORE_THREADING_MUTEX_H
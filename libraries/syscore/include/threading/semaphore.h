@@ -0,0 +1,37 @@
+//
+// Created by 98max on 10/19/2026.
+//
+
+#ifndef SYSCORE_THREADING_SEMAPHORE_H
+#define SYSCORE_THREADING_SEMAPHORE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <syscalls.h>
+
+
+namespace syscore::threading {
+
+	/**
+	 * @class Semaphore
+	 * @brief A counter that threads can take from, sleeping while it is zero
+	 */
+	class Semaphore {
+
+		private:
+			uint32_t m_count;
+			uint32_t m_waiters = 0;
+
+		public:
+			explicit Semaphore(uint32_t initial = 0);
+
+			void wait();
+			bool try_wait();
+			void post();
+
+			[[nodiscard]] uint32_t count() const;
+	};
+}
+
+
+#endif //SYSCORE_THREADING_SEMAPHORE_H
@@ -0,0 +1,170 @@
+//
+// Created by 98max on 10/19/2026.
+//
+
+#include <gui/window.h>
+#include <ipc/messages.h>
+
+
+namespace syscore::gui {
+
+	/**
+	 * @brief Write "gui:NAME:SUFFIX" into a buffer
+	 *
+	 * @param buffer Where to write the name (WINDOW_RESOURCE_NAME_MAX bytes)
+	 * @param name The name of the window
+	 * @param suffix What the resource is ("surface" or "events")
+	 */
+	static void resource_name(char* buffer, const char* name, const char* suffix){
+
+		const char prefix[] = "gui:";
+		size_t length = 0;
+
+		for(size_t i = 0; prefix[i]; i++)
+			buffer[length++] = prefix[i];
+
+		for(; *name && length < WINDOW_RESOURCE_NAME_MAX - 2; name++)
+			buffer[length++] = *name;
+
+		buffer[length++] = ':';
+		for(; *suffix && length < WINDOW_RESOURCE_NAME_MAX - 1; suffix++)
+			buffer[length++] = *suffix;
+
+		buffer[length] = '\0';
+	}
+
+	/**
+	 * @brief Send a request about a window to the server
+	 *
+	 * @param window The window
+	 * @param type The request
+	 * @param x The x coordinate
+	 * @param y The y coordinate
+	 * @param width The width
+	 * @param height The height
+	 */
+	static void send_request(window_t* window, WindowRequestType type, int32_t x, int32_t y, uint32_t width, uint32_t height){
+
+		window_request_t request = { type, x, y, width, height, {} };
+		for(size_t i = 0; i < WINDOW_NAME_MAX; i++)
+			request.name[i] = window->name[i];
+
+		ipc::send_message(window->server, &request, sizeof(request));
+	}
+
+	/**
+	 * @brief Create a window, the surface starts black and isn't shown until it is damaged
+	 *
+	 * @param window The window to fill in
+	 * @param name A name for the window that no other window is using
+	 * @param x Where the window goes on the desktop
+	 * @param y Where the window goes on the desktop
+	 * @param width The width of the surface
+	 * @param height The height of the surface
+	 * @return True if the window was created
+	 */
+	bool window_create(window_t* window, const char* name, int32_t x, int32_t y, uint32_t width, uint32_t height){
+
+		if(strlen(name) >= (int)WINDOW_NAME_MAX)
+			return false;
+
+		size_t i = 0;
+		for(; name[i]; i++)
+			window->name[i] = name[i];
+		for(; i < WINDOW_NAME_MAX; i++)
+			window->name[i] = '\0';
+
+		window->width = width;
+		window->height = height;
+
+		// Find the server
+		window->server = ipc::open_endpoint(WINDOW_SERVER_ENDPOINT);
+		if(!window->server)
+			return false;
+
+		// The server reads the pixels straight from here, the handle is kept so the surface can be let go of
+		char resource[WINDOW_RESOURCE_NAME_MAX];
+		resource_name(resource, name, "surface");
+		window->surface = resource_create(ResourceType::SHARED_MEMORY, resource, (size_t)width * height * sizeof(uint32_t)) ? resource_open(ResourceType::SHARED_MEMORY, resource, 0) : 0;
+		window->pixels = window->surface ? (uint32_t*)resource_read(window->surface, nullptr, 0, 0) : nullptr;
+		if(!window->pixels){
+			if(window->surface)
+				resource_close(window->surface, 0);
+			ipc::close_endpoint(window->server);
+			return false;
+		}
+
+		// Input comes back here
+		resource_name(resource, name, "events");
+		window->events = ipc::create_endpoint(resource);
+		if(!window->events){
+			resource_close(window->surface, 0);
+			ipc::close_endpoint(window->server);
+			return false;
+		}
+
+		send_request(window, WindowRequestType::CREATE, x, y, width, height);
+		return true;
+	}
+
+	/**
+	 * @brief Tell the server part of the surface has been drawn to, it is copied to the screen on the next frame
+	 *
+	 * @param window The window
+	 * @param x The left of the area drawn to
+	 * @param y The top of the area drawn to
+	 * @param width The width of the area drawn to
+	 * @param height The height of the area drawn to
+	 */
+	void window_damage(window_t* window, int32_t x, int32_t y, uint32_t width, uint32_t height){
+		send_request(window, WindowRequestType::DAMAGE, x, y, width, height);
+	}
+
+	/**
+	 * @brief Move the window on the desktop
+	 *
+	 * @param window The window
+	 * @param x The new left of the window
+	 * @param y The new top of the window
+	 */
+	void window_move(window_t* window, int32_t x, int32_t y){
+		send_request(window, WindowRequestType::MOVE, x, y, window->width, window->height);
+	}
+
+	/**
+	 * @brief Get the next input event for the window
+	 *
+	 * @param window The window
+	 * @param event Where to write the event
+	 * @param non_blocking Return straight away if there isn't an event waiting
+	 * @return True if an event was read
+	 */
+	bool window_next_event(window_t* window, window_event_t* event, bool non_blocking){
+
+		// Check without waiting
+		if(non_blocking){
+			resource_poll_entry_t entry = { window->events, (size_t)ResourceReadiness::READABLE, 0 };
+			if(!resource_poll(&entry, 1, 0))
+				return false;
+		}
+
+		return (int)resource_read(window->events, event, sizeof(window_event_t), 0) == (int)sizeof(window_event_t);
+	}
+
+	/**
+	 * @brief Remove the window from the desktop and close its resources
+	 *
+	 * @param window The window
+	 */
+	void window_destroy(window_t* window){
+
+		send_request(window, WindowRequestType::DESTROY, 0, 0, 0, 0);
+		ipc::close_endpoint(window->events);
+		ipc::close_endpoint(window->server);
+		resource_close(window->surface, 0);
+		window->events = 0;
+		window->server = 0;
+		window->surface = 0;
+		window->pixels = nullptr;
+	}
+}
@@ -0,0 +1,178 @@
+//
+// Created by 98max on 10/19/2026.
+//
+
+#include <net/socket.h>
+
+
+namespace syscore::net {
+
+	int as_error(SocketError code){
+		return -1 * (int)code;
+	}
+
+	/**
+	 * @brief Open a socket resource by its name ("tcp:IP:PORT" or "udp:IP:PORT", an IP of 0.0.0.0 listens on the port)
+	 *
+	 * @param protocol The protocol prefix ("tcp:" or "udp:")
+	 * @param address The address ("IP:PORT")
+	 * @return The handle of the socket or 0 if it failed
+	 */
+	static uint64_t open_socket(const char* protocol, const char* address){
+
+		char name[SOCKET_NAME_MAX];
+		size_t length = 0;
+
+		for(; *protocol && length < SOCKET_NAME_MAX - 1; protocol++)
+			name[length++] = *protocol;
+
+		for(; *address && length < SOCKET_NAME_MAX - 1; address++)
+			name[length++] = *address;
+
+		name[length] = '\0';
+		return resource_open(ResourceType::SOCKET, name, 0);
+	}
+
+	/**
+	 * @brief Write "0.0.0.0:PORT" into a buffer
+	 *
+	 * @param buffer Where to write the address (at least 14 bytes)
+	 * @param port The port
+	 */
+	static void any_address(char* buffer, uint16_t port){
+
+		const char prefix[] = "0.0.0.0:";
+		size_t length = 0;
+		for(; prefix[length]; length++)
+			buffer[length] = prefix[length];
+
+		// Write the digits backwards then swap them round
+		size_t start = length;
+		do{
+			buffer[length++] = (char)('0' + port % 10);
+			port /= 10;
+		} while (port);
+		buffer[length] = '\0';
+
+		for(size_t i = start, j = length - 1; i < j; i++, j--){
+			char digit = buffer[i];
+			buffer[i] = buffer[j];
+			buffer[j] = digit;
+		}
+	}
+
+	/**
+	 * @brief Open a TCP connection
+	 *
+	 * @param address The address to connect to ("IP:PORT")
+	 * @return The handle of the socket or 0 if it failed, reads and writes wait until it has connected
+	 */
+	uint64_t tcp_connect(const char* address){
+		return open_socket("tcp:", address);
+	}
+
+	/**
+	 * @brief Listen for TCP connections on a port
+	 *
+	 * @param port The port
+	 * @return The handle of the listener or 0 if the port is in use
+	 */
+	uint64_t tcp_listen(uint16_t port){
+
+		char address[16];
+		any_address(address, port);
+		return open_socket("tcp:", address);
+	}
+
+	/**
+	 * @brief Take a connection waiting on a listener
+	 *
+	 * @param listener The handle of the listener
+	 * @param non_blocking Return straight away if there is no connection waiting
+	 * @return The handle of the connection or 0 if there isn't one
+	 */
+	uint64_t tcp_accept(uint64_t listener, bool non_blocking){
+
+		// Get the name of the connection
+		char name[SOCKET_NAME_MAX];
+		size_t flags = (size_t)SocketFlags::ACCEPT | (non_blocking ? (size_t)SocketFlags::NON_BLOCKING : 0);
+		int length = (int)resource_read(listener, name, sizeof(name) - 1, flags);
+		if(length <= 0)
+			return 0;
+
+		name[length] = '\0';
+		return resource_open(ResourceType::SOCKET, name, 0);
+	}
+
+	/**
+	 * @brief Open a UDP socket that sends to and receives from one address
+	 *
+	 * @param address The address ("IP:PORT")
+	 * @return The handle of the socket or 0 if it failed
+	 */
+	uint64_t udp_connect(const char* address){
+		return open_socket("udp:", address);
+	}
+
+	/**
+	 * @brief Open a UDP socket on a port, it replies to whoever sends the first datagram
+	 *
+	 * @param port The port
+	 * @return The handle of the socket or 0 if the port is in use
+	 */
+	uint64_t udp_listen(uint16_t port){
+
+		char address[16];
+		any_address(address, port);
+		return open_socket("udp:", address);
+	}
+
+	/**
+	 * @brief Read from a socket, a TCP socket returns what has been received and a UDP socket returns one datagram
+	 *
+	 * @param socket The handle of the socket
+	 * @param buffer Where to read into
+	 * @param size The size of the buffer
+	 * @param non_blocking Return WOULD_BLOCK instead of waiting for data
+	 * @return The number of bytes read, 0 once the remote end has closed or a negative SocketError
+	 */
+	int socket_read(uint64_t socket, void* buffer, size_t size, bool non_blocking){
+		return (int)resource_read(socket, buffer, size, non_blocking ? (size_t)SocketFlags::NON_BLOCKING : 0);
+	}
+
+	/**
+	 * @brief Write to a socket
+	 *
+	 * @param socket The handle of the socket
+	 * @param buffer The data to write
+	 * @param size The size of the data
+	 * @param non_blocking Return WOULD_BLOCK instead of waiting for space (TCP may accept only part of the data)
+	 * @return The number of bytes written or a negative SocketError
+	 */
+	int socket_write(uint64_t socket, const void* buffer, size_t size, bool non_blocking){
+		return (int)resource_write(socket, buffer, size, non_blocking ? (size_t)SocketFlags::NON_BLOCKING : 0);
+	}
+
+	/**
+	 * @brief Close a socket (a TCP connection sends what is still buffered first)
+	 *
+	 * @param socket The handle of the socket
+	 */
+	void socket_close(uint64_t socket){
+
+		if(socket)
+			resource_close(socket, 0);
+	}
+
+	/**
+	 * @brief Wait until any of a set of sockets is ready, lets one thread serve many connections
+	 *
+	 * @param sockets The sockets and what to wait for on each (ResourceReadiness bits), ready is filled in
+	 * @param count The number of sockets
+	 * @param timeout How long to wait in milliseconds (0 to just check, RESOURCE_POLL_FOREVER to never give up)
+	 * @return How many of the sockets are ready, 0 if the timeout passed
+	 */
+	size_t socket_wait(resource_poll_entry_t* sockets, size_t count, uint64_t timeout){
+		return resource_poll(sockets, count, timeout);
+	}
+}
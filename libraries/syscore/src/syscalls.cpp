@@ -164,6 +164,20 @@ namespace syscore{
 		return response;
 	}
 
+	/**
+	 * @brief Wait for any of a set of resources to become ready
+	 *
+	 * @param entries The resources and what to wait for on each, ready is filled in
+	 * @param count The number of entries
+	 * @param timeout How long to wait in milliseconds (0 to just check, RESOURCE_POLL_FOREVER to never give up)
+	 * @return How many of the resources are ready, 0 if the timeout passed
+	 */
+	size_t resource_poll(resource_poll_entry_t* entries, size_t count, uint64_t timeout){
+
+		// The kernel sleeps the thread until one of the resources changes
+		return (size_t)make_syscall(SyscallType::RESOURCE_POLL, (uint64_t)entries, count, timeout, 0, 0, 0);
+	}
+
 	/**
 	 * @brief Yield the current thread's execution
 	 *
@@ -188,4 +202,26 @@ namespace syscore{
 	void thread_exit(){
 		make_syscall(SyscallType::THREAD_CLOSE, 0, 0, 0, 0, 0, 0);
 	}
+
+	/**
+	 * @brief Sleep until woken by futex_wake, if the value at an address still equals the expected value
+	 *
+	 * @param address The address of the value (may be in shared memory)
+	 * @param expected The value that must still be at the address for the thread to sleep
+	 * @return True if the thread slept, false if the value had already changed
+	 */
+	bool futex_wait(uint32_t* address, uint32_t expected){
+		return (bool)make_syscall(SyscallType::FUTEX_WAIT, (uint64_t)address, expected, 0, 0, 0, 0);
+	}
+
+	/**
+	 * @brief Wake threads sleeping in futex_wait on an address
+	 *
+	 * @param address The address of the value (may be in shared memory)
+	 * @param count The maximum amount of threads to wake
+	 * @return How many threads were woken
+	 */
+	size_t futex_wake(uint32_t* address, size_t count){
+		return (size_t)make_syscall(SyscallType::FUTEX_WAKE, (uint64_t)address, count, 0, 0, 0, 0);
+	}
 }
\ No newline at end of file
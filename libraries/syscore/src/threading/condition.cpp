@@ -0,0 +1,48 @@
+//
+// Created by 98max on 10/19/2026.
+//
+
+#include <threading/condition.h>
+
+namespace syscore::threading {
+
+	/**
+	 * @brief Release the mutex and sleep until signalled, the mutex is held again when this returns
+	 *
+	 * @param mutex The mutex protecting the condition, must be held by the caller
+	 *
+	 * @note Wake ups can be spurious so the condition should be checked again in a loop
+	 */
+	void ConditionVariable::wait(Mutex& mutex) {
+
+		// Any signal after this point changes the sequence so the futex won't sleep through it
+		uint32_t sequence = __atomic_load_n(&m_sequence, __ATOMIC_ACQUIRE);
+		__atomic_fetch_add(&m_waiters, 1, __ATOMIC_RELAXED);
+		mutex.unlock();
+
+		futex_wait(&m_sequence, sequence);
+
+		__atomic_fetch_sub(&m_waiters, 1, __ATOMIC_RELAXED);
+		mutex.lock();
+	}
+
+	/**
+	 * @brief Wake one thread waiting on the condition, does not enter the kernel if none are waiting
+	 */
+	void ConditionVariable::signal() {
+
+		__atomic_fetch_add(&m_sequence, 1, __ATOMIC_RELEASE);
+		if(__atomic_load_n(&m_waiters, __ATOMIC_RELAXED))
+			futex_wake(&m_sequence, 1);
+	}
+
+	/**
+	 * @brief Wake every thread waiting on the condition, does not enter the kernel if none are waiting
+	 */
+	void ConditionVariable::broadcast() {
+
+		__atomic_fetch_add(&m_sequence, 1, __ATOMIC_RELEASE);
+		if(__atomic_load_n(&m_waiters, __ATOMIC_RELAXED))
+			futex_wake(&m_sequence, UINT32_MAX);
+	}
+}
@@ -0,0 +1,57 @@
+//
+// Created by 98max on 10/19/2026.
+//
+
+#include <threading/mutex.h>
+
+namespace syscore::threading {
+
+	/**
+	 * @brief Take the lock, sleeping in the kernel if it is held by another thread
+	 */
+	void Mutex::lock() {
+
+		// Free, take it without entering the kernel
+		auto state = (uint32_t)MutexState::UNLOCKED;
+		if(__atomic_compare_exchange_n(&m_state, &state, (uint32_t)MutexState::LOCKED, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			return;
+
+		// Mark as contended so that the holder knows to wake someone, then sleep until it is free
+		if(state != (uint32_t)MutexState::CONTENDED)
+			state = __atomic_exchange_n(&m_state, (uint32_t)MutexState::CONTENDED, __ATOMIC_ACQUIRE);
+
+		while (state != (uint32_t)MutexState::UNLOCKED) {
+			futex_wait(&m_state, (uint32_t)MutexState::CONTENDED);
+			state = __atomic_exchange_n(&m_state, (uint32_t)MutexState::CONTENDED, __ATOMIC_ACQUIRE);
+		}
+	}
+
+	/**
+	 * @brief Take the lock if it is free
+	 *
+	 * @return True if the lock was taken
+	 */
+	bool Mutex::try_lock() {
+
+		auto state = (uint32_t)MutexState::UNLOCKED;
+		return __atomic_compare_exchange_n(&m_state, &state, (uint32_t)MutexState::LOCKED, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+	}
+
+	/**
+	 * @brief Release the lock, only entering the kernel if there may be a thread sleeping on it
+	 */
+	void Mutex::unlock() {
+
+		if(__atomic_exchange_n(&m_state, (uint32_t)MutexState::UNLOCKED, __ATOMIC_RELEASE) == (uint32_t)MutexState::CONTENDED)
+			futex_wake(&m_state, 1);
+	}
+
+	/**
+	 * @brief Check if the lock is held
+	 *
+	 * @return True if a thread holds the lock
+	 */
+	bool Mutex::is_locked() const {
+		return __atomic_load_n(&m_state, __ATOMIC_RELAXED) != (uint32_t)MutexState::UNLOCKED;
+	}
+}
@@ -0,0 +1,67 @@
+//
+// Created by 98max on 10/19/2026.
+//
+
+#include <threading/semaphore.h>
+
+namespace syscore::threading {
+
+	/**
+	 * @brief Create a semaphore
+	 *
+	 * @param initial The starting count
+	 */
+	Semaphore::Semaphore(uint32_t initial)
+	: m_count(initial)
+	{
+
+	}
+
+	/**
+	 * @brief Take one from the count, sleeping until it is above zero
+	 */
+	void Semaphore::wait() {
+
+		while (!try_wait()) {
+
+			// Sleep while still empty
+			__atomic_fetch_add(&m_waiters, 1, __ATOMIC_RELAXED);
+			futex_wait(&m_count, 0);
+			__atomic_fetch_sub(&m_waiters, 1, __ATOMIC_RELAXED);
+		}
+	}
+
+	/**
+	 * @brief Take one from the count if it is above zero
+	 *
+	 * @return True if the count was decremented
+	 */
+	bool Semaphore::try_wait() {
+
+		uint32_t count = __atomic_load_n(&m_count, __ATOMIC_RELAXED);
+		while (count)
+			if(__atomic_compare_exchange_n(&m_count, &count, count - 1, true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+				return true;
+
+		return false;
+	}
+
+	/**
+	 * @brief Add one to the count, waking a waiting thread if there is one
+	 */
+	void Semaphore::post() {
+
+		__atomic_fetch_add(&m_count, 1, __ATOMIC_RELEASE);
+		if(__atomic_load_n(&m_waiters, __ATOMIC_ACQUIRE))
+			futex_wake(&m_count, 1);
+	}
+
+	/**
+	 * @brief Get the current count
+	 *
+	 * @return The count
+	 */
+	uint32_t Semaphore::count() const {
+		return __atomic_load_n(&m_count, __ATOMIC_RELAXED);
+	}
+}